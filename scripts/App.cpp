@@ -2,11 +2,19 @@
 #include "Log.h"
 #include "RayTrace/Scene.h"
 #include "Random/Random.h"
+#include "RayTrace/Trace.h"
+#include <cstring>
+#include <iostream>
 
-App::App() {
+App::App(const std::string& outputPath, bool heatmaps) {
+    outputPath_ = outputPath;
+    scene_.EnableCostMap(heatmaps);
     running_ = false;
     windowWidth_ = WINDOW_WIDTH;
     windowHeight_ = WINDOW_HEIGHT;
+    redraw_ = true;
+    rendering_ = false;
+    renderFinishedEvent_ = 0;
 }
 
 int App::Execute() {
@@ -18,11 +26,14 @@ int App::Execute() {
 
     SDL_Event event;
     while (running_){
-        while(SDL_PollEvent(&event) != 0){
+        // While rendering the window is refreshed periodically, afterwards it sleeps until an event arrives
+        int received = rendering_ ? SDL_WaitEventTimeout(&event, FRAME_TIME_MS) : SDL_WaitEvent(&event);
+        while (received != 0){
             Event(&event);
             if (event.type == SDL_QUIT) {
                 running_ = false;
             }
+            received = SDL_PollEvent(&event);
         }
         // Currently unused, preparing everything during init
         Loop();
@@ -35,6 +46,7 @@ int App::Execute() {
 }
 
 bool App::Init() {
+    TRACE_SCOPE("App::Init");
     if (SDL_Init(SDL_INIT_EVERYTHING) < 0) return false;
 
     if((pWindow_ = SDL_CreateWindow("RealChess RayTracer",SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
@@ -43,22 +55,84 @@ bool App::Init() {
     if ((pRenderer_ = SDL_CreateRenderer(pWindow_, -1,
                                         SDL_RENDERER_ACCELERATED)) == NULL) return false;
 
-    // SDL_SetRenderDrawColor(pRenderer, 0x00, 0x00, 0x00, 0xFF);
-    scene_.Initialize(windowWidth_, windowHeight_, pRenderer_);
-
-    SDL_RenderClear(pRenderer_);
-    scene_.Render();
-    scene_.Display();
-    SDL_RenderPresent(pRenderer_);
+    // Pixels are packed as 0xAARRGGBB by the tone mapper
+    if ((pTexture_ = SDL_CreateTexture(pRenderer_, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                       windowWidth_, windowHeight_)) == NULL) return false;
+
+    if ((renderFinishedEvent_ = SDL_RegisterEvents(1)) == (uint32_t)-1) return false;
+
+    scene_.Initialize(windowWidth_, windowHeight_);
+    staging_.assign(windowWidth_ * windowHeight_, 0);
+
+    rendering_ = true;
+    renderThread_ = std::thread([this]() {
+        RT::Trace::SetThreadName("render");
+        if (scene_.Render()) {
+            scene_.GetRenderStats().WriteSummary(std::cout);
+            try {
+                scene_.SaveImage(outputPath_);
+                if (!scene_.GetCostMap().IsEmpty()) scene_.GetCostMap().SaveHeatmaps(outputPath_);
+            } catch (const std::exception& exception) {
+                Log("Saving the image failed: %s", exception.what());
+            }
+        }
+        rendering_ = false;
+        // Wakes up the event loop so the last tiles get displayed
+        SDL_Event event{};
+        event.type = renderFinishedEvent_;
+        SDL_PushEvent(&event);
+    });
 
     return true;
 }
 
 void App::Render() {
-    // Currently the rendering happens only once during initialization
+    // Nothing is drawn unless new tiles were uploaded or the window needs to be repainted
+    if (!Display() && !redraw_) return;
     SDL_RenderClear(pRenderer_);
-    scene_.Display();
+    SDL_RenderCopy(pRenderer_, pTexture_, nullptr, nullptr);
     SDL_RenderPresent(pRenderer_);
+    redraw_ = false;
+}
+
+bool App::Display() {
+    const RT::Framebuffer& framebuffer = scene_.GetFramebuffer();
+    size_t width = framebuffer.GetWidth();
+    size_t height = framebuffer.GetHeight();
+
+    dirtyTiles_.clear();
+    for (size_t tile = 0; tile < framebuffer.GetTileCount(); ++tile){
+        if (framebuffer.TakeDirtyTile(tile)){
+            toneMapper_.ResolveTile(framebuffer, tile, staging_.data(), width);
+            dirtyTiles_.push_back(tile);
+        }
+    }
+    if (dirtyTiles_.empty()) return false;
+    TRACE_SCOPE_DETAIL("Display upload", std::to_string(dirtyTiles_.size()) + " tiles");
+
+    // Locked pixels are write only, so every locked row is copied whole from the staging buffer
+    auto upload = [this, width](const SDL_Rect& rect) {
+        void* pPixels;
+        int pitch;
+        if (SDL_LockTexture(pTexture_, &rect, &pPixels, &pitch) != 0) return;
+        for (int row = 0; row < rect.h; ++row){
+            std::memcpy(static_cast<char*>(pPixels) + row * pitch, staging_.data() + (rect.y + row) * width + rect.x,
+                        rect.w * sizeof(uint32_t));
+        }
+        SDL_UnlockTexture(pTexture_);
+    };
+
+    if (dirtyTiles_.size() * 2 > framebuffer.GetTileCount()){
+        upload(SDL_Rect{0, 0, (int)width, (int)height});
+    } else{
+        for (size_t tile : dirtyTiles_){
+            size_t x0, y0, x1, y1;
+            framebuffer.GetTileBounds(tile, x0, y0, x1, y1);
+            // Texture rows go from the top, framebuffer rows from the bottom
+            upload(SDL_Rect{(int)x0, (int)(height - y1), (int)(x1 - x0), (int)(y1 - y0)});
+        }
+    }
+    return true;
 }
 
 void App::Loop() {
@@ -66,6 +140,14 @@ void App::Loop() {
 }
 
 void App::Cleanup() {
+    scene_.RequestStop();
+    if (renderThread_.joinable()) {
+        renderThread_.join();
+    }
+    if(pTexture_) {
+        SDL_DestroyTexture(pTexture_);
+        pTexture_ = NULL;
+    }
     if(pRenderer_) {
         SDL_DestroyRenderer(pRenderer_);
         pRenderer_ = NULL;
@@ -78,5 +160,15 @@ void App::Cleanup() {
 }
 
 void App::Event(SDL_Event *event) {
-
+    if (event->type == SDL_WINDOWEVENT) {
+        switch (event->window.event) {
+            case SDL_WINDOWEVENT_EXPOSED:
+            case SDL_WINDOWEVENT_SIZE_CHANGED:
+            case SDL_WINDOWEVENT_RESTORED:
+                redraw_ = true;
+                break;
+            default:
+                break;
+        }
+    }
 }
\ No newline at end of file
@@ -2,14 +2,25 @@
 #define MAIN_CPP_APP_H
 
 #include <SDL.h>
+#include <atomic>
+#include <thread>
+#include <vector>
 #include "RayTrace/Scene.h"
+#include "RayTrace/ToneMapper.h"
 
 constexpr const int WINDOW_WIDTH = 1280;
 constexpr const int WINDOW_HEIGHT = 720;
+/// \brief Window refresh period while the scene is being rendered
+constexpr const int FRAME_TIME_MS = 33;
 
 class App{
 public:
-    App();
+    /**
+     * @brief outputPath is where the finished render is saved, its extension selects the image format.
+     *
+     * With heatmaps the per-pixel cost of the render is saved next to it (see RT::CostMap).
+     */
+    explicit App(const std::string& outputPath = "output.bmp", bool heatmaps = false);
 
     int Execute();
 
@@ -17,17 +28,33 @@ private:
     // SDL2 stuff
     SDL_Window* pWindow_ = NULL;
     SDL_Renderer* pRenderer_ = NULL;
+    SDL_Texture* pTexture_ = NULL;
 
     // Scene parameters
     RT::Scene scene_;
     size_t windowWidth_;
     size_t windowHeight_;
+    std::string outputPath_;
+
+    // Display, staging keeps the converted image between frames, so only dirty tiles are converted again
+    RT::ToneMapper toneMapper_;
+    std::vector<uint32_t> staging_;
+    std::vector<size_t> dirtyTiles_;
+    bool redraw_;
+
+    // Scene is rendered on its own thread, the window shows finished tiles meanwhile
+    std::thread renderThread_;
+    std::atomic<bool> rendering_;
+    uint32_t renderFinishedEvent_;
 
     bool running_;
 private:
     bool Init();
     void Event(SDL_Event* event);
+    /// \brief Presents the window, only if the image or the window changed
     void Render();
+    /// \brief Converts tiles finished since the last call and uploads them into the texture
+    bool Display();
     void Loop();
     void Cleanup();
 };
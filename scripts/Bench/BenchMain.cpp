@@ -0,0 +1,120 @@
+#include "ImageBench.h"
+#include "KernelBench.h"
+#include "LayoutBench.h"
+#include "ReplayBench.h"
+#include "SceneBench.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    void PrintUsage(const char* program) {
+        std::cout << "Usage: " << program << " [--suite kernels|images|scenes|layout|all] [--filter TEXT]\n"
+                  << "       [--min-time SECONDS] [--json PATH] [--compare BASELINE.json] [--width N] [--height N]\n"
+                  << "       [--samples N] [--references DIR] [--update-references] [--replay RAYS] [--mesh OBJ]\n"
+                  << "--min-time applies to every kernel and every image benchmark, --width, --height and\n"
+                  << "--samples set up the image rendered for the image benchmarks. Scenes are compared with\n"
+                  << "reference images in DIR (default ../BenchReferences), --update-references renders them\n"
+                  << "again (slow) instead of benchmarking. --replay measures the traversal kernels on rays\n"
+                  << "captured by RealChess-Render --capture-rays and reports hits that differ from the render.\n"
+                  << "The layout suite (not in all) reports simulated cache misses of mesh traversal in file order\n"
+                  << "and in the preprocessed Morton order for every piece, --mesh OBJ adds another mesh"
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]){
+    Bench::ImageBenchOptions imageOptions;
+    Bench::KernelBenchOptions kernelOptions;
+    Bench::SceneBenchOptions sceneOptions;
+    Bench::ReplayBenchOptions replayOptions;
+    Bench::LayoutBenchOptions layoutOptions;
+    std::string suite = "all";
+    std::string jsonPath;
+    std::string comparePath;
+    for (int i = 1; i < argc; ++i){
+        std::string argument = argv[i];
+        if (argument == "--help"){
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        if (argument == "--update-references"){
+            sceneOptions.updateReferences = true;
+            suite = "scenes";
+            continue;
+        }
+        if (i + 1 >= argc){
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        // std::stoi, std::stoul and std::stod throw std::invalid_argument or std::out_of_range on bad numbers
+        try {
+            if (argument == "--width") imageOptions.width = std::stoul(value);
+            else if (argument == "--height") imageOptions.height = std::stoul(value);
+            else if (argument == "--samples") imageOptions.sqrtSamples = std::stoi(value);
+            else if (argument == "--min-time"){
+                imageOptions.minSeconds = kernelOptions.minSeconds = replayOptions.minSeconds =
+                        layoutOptions.minSeconds = std::stod(value);
+            }
+            else if (argument == "--suite") suite = value;
+            else if (argument == "--filter"){
+                kernelOptions.filter = sceneOptions.filter = replayOptions.filter = layoutOptions.filter = value;
+            }
+            else if (argument == "--replay"){
+                replayOptions.path = value;
+                suite = "replay";
+            }
+            else if (argument == "--mesh"){
+                layoutOptions.meshPaths.push_back(value);
+                suite = "layout";
+            }
+            else if (argument == "--references") sceneOptions.referenceDirectory = value;
+            else if (argument == "--json") jsonPath = value;
+            else if (argument == "--compare") comparePath = value;
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::logic_error&) {
+            std::cerr << "Invalid value of " << argument << ": " << value << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    bool knownSuite = suite == "kernels" || suite == "images" || suite == "scenes" || suite == "layout" || suite == "all" ||
+                      (suite == "replay" && !replayOptions.path.empty());
+    if (!knownSuite){
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::vector<Bench::KernelResult> kernels;
+        std::vector<Bench::Result> images;
+        std::vector<Bench::SceneResult> scenes;
+        if (suite == "kernels" || suite == "all"){
+            kernels = Bench::RunKernelBenchmarks(kernelOptions);
+            std::cout << std::endl;
+        }
+        if (suite == "images" || suite == "all"){
+            images = Bench::RunImageBenchmarks(imageOptions);
+            std::cout << std::endl;
+        }
+        if (suite == "scenes" || suite == "all"){
+            scenes = Bench::RunSceneBenchmarks(sceneOptions);
+        }
+        if (suite == "replay"){
+            kernels = Bench::RunReplayBenchmarks(replayOptions);
+        }
+        if (suite == "layout"){
+            kernels = Bench::RunLayoutBenchmarks(layoutOptions);
+        }
+        if (!jsonPath.empty()) Bench::WriteJson(jsonPath, kernels, images, scenes);
+        if (!comparePath.empty()) Bench::PrintComparison(comparePath, kernels, scenes);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
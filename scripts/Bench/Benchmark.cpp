@@ -0,0 +1,207 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+Bench::Result Bench::Measure(const std::string &name, size_t bytes, double minSeconds,
+                             const std::function<void()> &function) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> times;
+    double total = 0.;
+    // Warm up caches and lazily initialized tables
+    function();
+    while (total < minSeconds || times.size() < 3){
+        auto start = Clock::now();
+        function();
+        double time = std::chrono::duration<double>(Clock::now() - start).count();
+        times.push_back(time);
+        total += time;
+    }
+    std::sort(times.begin(), times.end());
+
+    Result result;
+    result.name = name;
+    result.iterations = times.size();
+    result.median = times[times.size() / 2];
+    result.fastest = times.front();
+    result.bytes = bytes;
+    return result;
+}
+
+void Bench::PrintTable(const std::vector<Result> &results) {
+    std::printf("%-28s %10s %12s %12s %10s\n", "benchmark", "iterations", "median ms", "fastest ms", "MB/s");
+    for (const Result& result : results){
+        double throughput = result.bytes > 0 ? result.bytes / result.median / 1e6 : 0.;
+        std::printf("%-28s %10zu %12.3f %12.3f %10.1f\n", result.name.c_str(), result.iterations,
+                    result.median * 1e3, result.fastest * 1e3, throughput);
+    }
+}
+
+namespace {
+    /// \brief Two-sided 95% quantile of Student's t-distribution for df degrees of freedom
+    double StudentT95(size_t df) {
+        static const double TABLE[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                       2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                       2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        if (df == 0) return 0.;
+        if (df <= sizeof(TABLE) / sizeof(TABLE[0])) return TABLE[df - 1];
+        return df < 120 ? 2.0 : 1.96;
+    }
+
+    /// \brief Number after "key": in a JSON line written by WriteJson, NaN if missing
+    double FindNumber(const std::string& line, const std::string& key) {
+        size_t position = line.find("\"" + key + "\":");
+        if (position == std::string::npos) return std::nan("");
+        return std::strtod(line.c_str() + position + key.size() + 3, nullptr);
+    }
+
+    std::string FindString(const std::string& line, const std::string& key) {
+        size_t position = line.find("\"" + key + "\": \"");
+        if (position == std::string::npos) return "";
+        position += key.size() + 5;
+        return line.substr(position, line.find('"', position) - position);
+    }
+}
+
+Bench::KernelResult Bench::MeasureKernel(const std::string &name, double minSeconds,
+                                         const std::function<void(size_t)> &function) {
+    using Clock = std::chrono::steady_clock;
+    constexpr double BATCH_SECONDS = 1e-3;
+    constexpr size_t MIN_SAMPLES = 10;
+    auto time = [&](size_t count) {
+        auto start = Clock::now();
+        function(count);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    size_t batch = 1;
+    while (time(batch) < BATCH_SECONDS && batch < (size_t(1) << 40)){
+        batch *= 2;
+    }
+    std::vector<double> perOperation;
+    double total = 0.;
+    while (total < minSeconds || perOperation.size() < MIN_SAMPLES){
+        double seconds = time(batch);
+        perOperation.push_back(seconds / batch * 1e9);
+        total += seconds;
+    }
+
+    KernelResult result;
+    result.name = name;
+    result.samples = perOperation.size();
+    result.batch = batch;
+    double sum = 0.;
+    for (double value : perOperation) sum += value;
+    result.mean = sum / perOperation.size();
+    double variance = 0.;
+    for (double value : perOperation) variance += (value - result.mean) * (value - result.mean);
+    variance /= perOperation.size() - 1;
+    result.confidence = StudentT95(perOperation.size() - 1) * std::sqrt(variance / perOperation.size());
+    std::sort(perOperation.begin(), perOperation.end());
+    result.median = perOperation[perOperation.size() / 2];
+    return result;
+}
+
+void Bench::PrintKernelTable(const std::vector<KernelResult> &results) {
+    std::printf("%-32s %10s %12s %10s %12s\n", "kernel", "samples", "ns/op", "+-95%", "median ns");
+    for (const KernelResult& result : results){
+        std::printf("%-32s %10zu %12.2f %10.2f %12.2f\n", result.name.c_str(), result.samples, result.mean,
+                    result.confidence, result.median);
+    }
+}
+
+double Bench::SceneResult::GetSecondsTo(double targetPsnr) const {
+    return seconds * std::pow(10., (targetPsnr - psnr) / 10.);
+}
+
+void Bench::PrintSceneTable(const std::vector<SceneResult> &results) {
+    std::printf("%-28s %6s %10s %10s %10s %10s %12s\n", "scene", "spp", "seconds", "Mrays/s", "RMSE", "PSNR dB",
+                "s to 40 dB");
+    for (const SceneResult& result : results){
+        std::printf("%-28s %6zu %10.3f %10.3f %10.5f %10.2f %12.1f\n", result.name.c_str(), result.samplesPerPixel,
+                    result.seconds, result.mraysPerSecond, result.rmse, result.psnr, result.GetSecondsTo(40.));
+    }
+}
+
+void Bench::WriteJson(const std::string &path, const std::vector<KernelResult> &kernels,
+                      const std::vector<Result> &images, const std::vector<SceneResult> &scenes) {
+    std::ofstream file(path);
+    if (!file.is_open()) throw std::runtime_error("Error opening file: " + path);
+#ifdef __VERSION__
+    file << "{\n  \"compiler\": \"" << __VERSION__ << "\",\n";
+#else
+    file << "{\n  \"compiler\": \"unknown\",\n";
+#endif
+    file << "  \"kernels\": [";
+    for (size_t i = 0; i < kernels.size(); ++i){
+        const KernelResult& result = kernels[i];
+        file << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"ns_per_op\": " << result.mean
+             << ", \"ci95_ns\": " << result.confidence << ", \"median_ns\": " << result.median
+             << ", \"samples\": " << result.samples << ", \"batch\": " << result.batch << "}";
+    }
+    file << "\n  ],\n  \"images\": [";
+    for (size_t i = 0; i < images.size(); ++i){
+        const Result& result = images[i];
+        double throughput = result.bytes > 0 ? result.bytes / result.median / 1e6 : 0.;
+        file << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"median_ms\": "
+             << result.median * 1e3 << ", \"fastest_ms\": " << result.fastest * 1e3 << ", \"mb_per_s\": "
+             << throughput << "}";
+    }
+    file << "\n  ],\n  \"scenes\": [";
+    for (size_t i = 0; i < scenes.size(); ++i){
+        const SceneResult& result = scenes[i];
+        file << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"spp\": "
+             << result.samplesPerPixel << ", \"seconds\": " << result.seconds << ", \"mrays_per_s\": "
+             << result.mraysPerSecond << ", \"rmse\": " << result.rmse << ", \"psnr_db\": " << result.psnr << "}";
+    }
+    file << "\n  ]\n}\n";
+    if (!file) throw std::runtime_error("Writing failed: " + path);
+}
+
+void Bench::PrintComparison(const std::string &baselinePath, const std::vector<KernelResult> &kernels,
+                            const std::vector<SceneResult> &scenes) {
+    std::ifstream file(baselinePath);
+    if (!file.is_open()) throw std::runtime_error("Error opening file: " + baselinePath);
+    // name -> (ns/op, confidence) of kernels and (seconds, PSNR) of scenes
+    std::map<std::string, std::pair<double, double>> baselineKernels;
+    std::map<std::string, std::pair<double, double>> baselineScenes;
+    std::string line;
+    while (std::getline(file, line)){
+        std::string name = FindString(line, "name");
+        if (name.empty()) continue;
+        double mean = FindNumber(line, "ns_per_op");
+        double seconds = FindNumber(line, "seconds");
+        if (!std::isnan(mean)) baselineKernels[name] = {mean, FindNumber(line, "ci95_ns")};
+        else if (!std::isnan(seconds)) baselineScenes[name] = {seconds, FindNumber(line, "psnr_db")};
+    }
+
+    if (!kernels.empty()){
+        std::printf("\n%-32s %12s %12s %9s\n", "kernel", "baseline ns", "ns/op", "change");
+    }
+    for (const KernelResult& result : kernels){
+        auto it = baselineKernels.find(result.name);
+        if (it == baselineKernels.end()) continue;
+        auto [mean, confidence] = it->second;
+        double change = (result.mean - mean) / mean * 100.;
+        bool significant = std::abs(result.mean - mean) > result.confidence + confidence;
+        std::printf("%-32s %12.2f %12.2f %+8.1f%%%s\n", result.name.c_str(), mean, result.mean, change,
+                    significant ? (change < 0. ? "  faster" : "  slower") : "");
+    }
+
+    if (!scenes.empty()){
+        std::printf("\n%-28s %12s %10s %9s %12s %10s\n", "scene", "baseline s", "seconds", "change", "baseline dB",
+                    "PSNR dB");
+    }
+    for (const SceneResult& result : scenes){
+        auto it = baselineScenes.find(result.name);
+        if (it == baselineScenes.end()) continue;
+        auto [seconds, psnr] = it->second;
+        std::printf("%-28s %12.3f %10.3f %+8.1f%% %12.2f %10.2f\n", result.name.c_str(), seconds, result.seconds,
+                    (result.seconds - seconds) / seconds * 100., psnr, result.psnr);
+    }
+}
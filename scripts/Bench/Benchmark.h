@@ -0,0 +1,108 @@
+/**
+ * @file Benchmark.h
+ * @brief Timing helpers shared by the benchmarks of the RealChess-Bench tool.
+ */
+#ifndef MAIN_CPP_BENCHMARK_H
+#define MAIN_CPP_BENCHMARK_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Bench{
+    /// \brief Timings of one benchmark
+    struct Result{
+        std::string name;
+        size_t iterations = 0;
+        /// \brief Median and fastest wall time of one iteration in seconds
+        double median = 0.;
+        double fastest = 0.;
+        /// \brief Bytes processed by one iteration, 0 if throughput makes no sense
+        size_t bytes = 0;
+    };
+
+    /**
+     * @brief Runs function repeatedly for at least minSeconds (and at least 3 times), timing every call.
+     *
+     * The median is reported rather than the mean, so a single preempted iteration doesn't skew the result.
+     */
+    Result Measure(const std::string& name, size_t bytes, double minSeconds, const std::function<void()>& function);
+
+    /// \brief Prints results as an aligned table with MB/s of the median iteration
+    void PrintTable(const std::vector<Result>& results);
+
+    /// \brief Timings of a microbenchmark, per single operation
+    struct KernelResult{
+        std::string name;
+        /// \brief Amount of timed batches and operations in one batch
+        size_t samples = 0;
+        size_t batch = 0;
+        /// \brief Mean and median time of one operation over the batches in nanoseconds
+        double mean = 0.;
+        double median = 0.;
+        /// \brief Half width of the 95% confidence interval of the mean
+        double confidence = 0.;
+    };
+
+    /**
+     * @brief Measures a kernel, function(count) has to run the kernel count times.
+     *
+     * The batch size is doubled until one batch takes about a millisecond, so clock overhead and the call through
+     * std::function don't show up in the result. Batches are then timed for at least minSeconds (and at least
+     * 10 of them), the confidence interval uses Student's t-distribution over the batch means.
+     */
+    KernelResult MeasureKernel(const std::string& name, double minSeconds, const std::function<void(size_t)>& function);
+
+    /// \brief Prints kernel results as an aligned table of ns/op
+    void PrintKernelTable(const std::vector<KernelResult>& results);
+
+    /// \brief Render of a benchmark scene at one sample budget, compared with the reference image
+    struct SceneResult{
+        std::string name;
+        size_t samplesPerPixel = 0;
+        double seconds = 0.;
+        double mraysPerSecond = 0.;
+        /// \brief Root mean square error of the 8-bit channels scaled to [0, 1] and the matching PSNR in dB
+        double rmse = 0.;
+        double psnr = 0.;
+
+        /// \brief Estimated render time to reach given PSNR, assuming the error variance falls with 1 / time
+        double GetSecondsTo(double psnr) const;
+    };
+
+    /// \brief Prints scene results as an aligned table
+    void PrintSceneTable(const std::vector<SceneResult>& results);
+
+    /**
+     * @brief Writes all results as JSON, one result per line, so runs of different commits can be compared.
+     *
+     * Format: `{"compiler": ..., "kernels": [{"name": ..., "ns_per_op": ..., "ci95_ns": ..., "median_ns": ...,
+     * "samples": ..., "batch": ...}, ...], "images": [{"name": ..., "median_ms": ..., "fastest_ms": ...,
+     * "mb_per_s": ...}, ...], "scenes": [{"name": ..., "spp": ..., "seconds": ..., "mrays_per_s": ...,
+     * "rmse": ..., "psnr_db": ...}, ...]}`
+     */
+    void WriteJson(const std::string& path, const std::vector<KernelResult>& kernels,
+                   const std::vector<Result>& images, const std::vector<SceneResult>& scenes);
+    /**
+     * @brief Prints the change of every kernel and scene against a JSON file written by WriteJson().
+     *
+     * A kernel change is marked significant when the confidence intervals of the two runs don't overlap. Scenes
+     * are compared by render time and PSNR, the renders are deterministic so a PSNR change means the image changed.
+     */
+    void PrintComparison(const std::string& baselinePath, const std::vector<KernelResult>& kernels,
+                         const std::vector<SceneResult>& scenes);
+
+    /// \brief Keeps the compiler from optimizing away a computed value
+    template <typename T>
+    inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+}
+
+#endif
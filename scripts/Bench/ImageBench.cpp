@@ -0,0 +1,77 @@
+#include "ImageBench.h"
+#include "Benchmark.h"
+#include "../Image/ImageWriter.h"
+#include "../Image/PngWriter.h"
+#include "../RayTrace/Scene.h"
+#include "../RayTrace/ToneMapper.h"
+#include "../Threading/ThreadPool.h"
+#include <cstdio>
+#include <streambuf>
+#include <ostream>
+
+namespace {
+    /// \brief Stream buffer which only counts bytes, so the benchmark measures encoding and not the disk
+    class CountingBuffer : public std::streambuf{
+    public:
+        size_t GetCount() const { return count_; }
+        void Reset() { count_ = 0; }
+
+    protected:
+        std::streamsize xsputn(const char*, std::streamsize count) override {
+            count_ += static_cast<size_t>(count);
+            return count;
+        }
+        int_type overflow(int_type character) override {
+            if (!traits_type::eq_int_type(character, traits_type::eof())) ++count_;
+            return traits_type::not_eof(character);
+        }
+
+    private:
+        size_t count_ = 0;
+    };
+}
+
+std::vector<Bench::Result> Bench::RunImageBenchmarks(const Bench::ImageBenchOptions &options) {
+    // Encoders are measured on a real render, synthetic images compress very differently
+    RT::Scene scene;
+    RT::RenderSettings settings;
+    settings.sqrtSamples = options.sqrtSamples;
+    scene.SetRenderSettings(settings);
+    scene.Initialize(options.width, options.height);
+    std::printf("Rendering %zux%zu test image...\n", options.width, options.height);
+    scene.Render();
+
+    std::vector<uint32_t> pixels(options.width * options.height);
+    RT::ToneMapper().Resolve(scene.GetFramebuffer(), pixels.data(), options.width);
+    const size_t rawBytes = pixels.size() * 3;
+
+    CountingBuffer buffer;
+    std::ostream stream(&buffer);
+    std::vector<Bench::Result> results;
+    std::vector<size_t> sizes;
+    auto run = [&](const std::string& name, const std::function<std::unique_ptr<RT::ImageWriter>()>& create) {
+        results.push_back(Bench::Measure(name, rawBytes, options.minSeconds, [&]() {
+            buffer.Reset();
+            auto pWriter = create();
+            pWriter->WriteRows(pixels.data(), options.height);
+            pWriter->Finish();
+        }));
+        sizes.push_back(buffer.GetCount());
+    };
+
+    run("encode/bmp", [&]() { return RT::ImageWriter::Create(RT::ImageFormat::BMP, stream, options.width, options.height); });
+    run("encode/qoi", [&]() { return RT::ImageWriter::Create(RT::ImageFormat::QOI, stream, options.width, options.height); });
+    run("encode/png/1-thread", [&]() {
+        return std::make_unique<RT::PngWriter>(stream, options.width, options.height, nullptr);
+    });
+    run("encode/png/" + std::to_string(ThreadPool::Shared().GetThreadCount()) + "-threads", [&]() {
+        return std::make_unique<RT::PngWriter>(stream, options.width, options.height, &ThreadPool::Shared());
+    });
+
+    Bench::PrintTable(results);
+    std::printf("\n%-28s %12s %8s\n", "format", "bytes", "ratio");
+    for (size_t i = 0; i < results.size(); ++i){
+        std::printf("%-28s %12zu %8.3f\n", results[i].name.c_str(), sizes[i], static_cast<double>(sizes[i]) / rawBytes);
+    }
+    return results;
+}
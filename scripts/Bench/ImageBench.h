@@ -0,0 +1,24 @@
+/**
+ * @file ImageBench.h
+ * @brief Throughput benchmarks of the image encoders.
+ */
+#ifndef MAIN_CPP_IMAGEBENCH_H
+#define MAIN_CPP_IMAGEBENCH_H
+
+#include "Benchmark.h"
+#include <cstddef>
+#include <vector>
+
+namespace Bench{
+    struct ImageBenchOptions{
+        size_t width = 640;
+        size_t height = 360;
+        int sqrtSamples = 1;
+        double minSeconds = 1.;
+    };
+
+    /// \brief Renders a test image, measures encoding speed and output size of every format and prints them
+    std::vector<Result> RunImageBenchmarks(const ImageBenchOptions& options);
+}
+
+#endif
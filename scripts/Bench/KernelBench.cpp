@@ -0,0 +1,302 @@
+#include "KernelBench.h"
+#include "../ObjectLoader/MeshFile.h"
+#include "../ObjectLoader/MeshPreprocess.h"
+#include "../Random/Random.h"
+#include "../RayTrace/Material.h"
+#include "../RayTrace/PDF.h"
+#include "../RayTrace/Scene.h"
+#include <cstdio>
+#include <filesystem>
+#include <tuple>
+
+namespace {
+    constexpr size_t INPUT_COUNT = 1024;
+    constexpr uint64_t SEED = 42;
+
+    /// \brief Rays from random points around the board aimed at random points on it, most of them hit something
+    std::vector<RT::Ray> RandomSceneRays() {
+        std::vector<RT::Ray> rays;
+        for (size_t i = 0; i < INPUT_COUNT; ++i){
+            Vec3D start = Vec3D{4., 4., 5.} + Rand::RandomUnitVector() * 6.;
+            Vec3D target{Rand::RandomDouble() * 8., Rand::RandomDouble() * 8., Rand::RandomDouble() * 1.5};
+            rays.emplace_back(start, target);
+        }
+        return rays;
+    }
+
+    /// \brief Rays from a ring around the origin aimed at a point near the origin
+    std::vector<RT::Ray> RaysAround(const Vec3D& center, double distance, double spread) {
+        std::vector<RT::Ray> rays;
+        for (size_t i = 0; i < INPUT_COUNT; ++i){
+            Vec3D start = center + Rand::RandomUnitVector() * distance;
+            Vec3D target = center + Rand::RandomUnitVector() * spread;
+            rays.emplace_back(start, target);
+        }
+        return rays;
+    }
+
+    /// \brief Unit sphere of about 50k triangles with three levels of detail, a stand-in for a sculpted piece
+    std::shared_ptr<RT::TriangleMesh> DetailedSphere() {
+        constexpr int RINGS = 160;
+        std::vector<Vec3D> vertices;
+        std::vector<Vector<int, 3>> triangles;
+        for (int ring = 0; ring <= RINGS; ++ring){
+            double theta = M_PI * ring / RINGS;
+            for (int segment = 0; segment < RINGS; ++segment){
+                double phi = 2. * M_PI * segment / RINGS;
+                vertices.push_back(Vec3D{std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)});
+            }
+        }
+        for (int ring = 0; ring < RINGS; ++ring){
+            for (int segment = 0; segment < RINGS; ++segment){
+                int a = ring * RINGS + segment, b = ring * RINGS + (segment + 1) % RINGS;
+                if (ring > 0) triangles.push_back(Vector<int, 3>{a, b, a + RINGS});
+                if (ring < RINGS - 1) triangles.push_back(Vector<int, 3>{b, b + RINGS, a + RINGS});
+            }
+        }
+        size_t count = triangles.size();
+        std::vector<std::shared_ptr<RT::TriangleMesh>> lods;
+        for (auto& level : MeshPreprocess::Simplify(vertices, triangles, {count / 4, count / 16, count / 64})){
+            lods.push_back(std::make_shared<RT::TriangleMesh>(level.vertices, level.triangles));
+        }
+        auto pMesh = std::make_shared<RT::TriangleMesh>(vertices, triangles);
+        pMesh->SetLods(std::move(lods));
+        return pMesh;
+    }
+
+    std::vector<Vec3D> RandomVectors() {
+        std::vector<Vec3D> vectors;
+        for (size_t i = 0; i < INPUT_COUNT; ++i){
+            vectors.push_back(Rand::RandomUnitVector() * (0.5 + Rand::RandomDouble()));
+        }
+        return vectors;
+    }
+}
+
+std::vector<Bench::KernelResult> Bench::RunKernelBenchmarks(const Bench::KernelBenchOptions &options) {
+    std::vector<KernelResult> results;
+    auto run = [&](const std::string& name, const std::function<void(size_t)>& function) {
+        if (name.find(options.filter) == std::string::npos) return;
+        results.push_back(MeasureKernel(name, options.minSeconds, function));
+    };
+    Rand::Seed(SEED, 0);
+
+    // Vector operations, inputs cycle through a small array that stays in L1
+    const std::vector<Vec3D> vectors = RandomVectors();
+    const size_t mask = INPUT_COUNT - 1;
+    run("vector/add", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            Vec3D sum = vectors[i & mask] + vectors[(i + 1) & mask];
+            DoNotOptimize(sum);
+        }
+    });
+    run("vector/dot", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            double dot = vectors[i & mask].dot(vectors[(i + 1) & mask]);
+            DoNotOptimize(dot);
+        }
+    });
+    run("vector/cross", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            Vec3D cross = vectors[i & mask].cross(vectors[(i + 1) & mask]);
+            DoNotOptimize(cross);
+        }
+    });
+    run("vector/normalized", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            Vec3D normalized = vectors[i & mask].normalized();
+            DoNotOptimize(normalized);
+        }
+    });
+
+    // Random numbers and sampling
+    run("rand/double", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            double value = Rand::RandomDouble();
+            DoNotOptimize(value);
+        }
+    });
+    run("rand/unit-vector", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            Vec3D value = Rand::RandomUnitVector();
+            DoNotOptimize(value);
+        }
+    });
+    run("pdf/cosine-generate", [&](size_t count) {
+        RT::CosinePDF pdf(Vec3D{0., 0., 1.});
+        for (size_t i = 0; i < count; ++i){
+            Vec3D direction = pdf.Generate();
+            DoNotOptimize(direction);
+        }
+    });
+
+    // Ray-triangle intersection goes through Ray::RayIntersect, the only public entry point
+    auto pTriangle = std::make_shared<RT::Triangle>(Vec3D{-1., -1., 0.}, Vec3D{1., -1., 0.}, Vec3D{0., 1., 0.});
+    std::shared_ptr<RT::Object> pTriangleObject = pTriangle;
+    std::vector<RT::Ray> triangleRays = RaysAround(Vec3D{0., 0., 0.}, 3., 1.);
+    run("ray/triangle", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            RT::HitPayload payload;
+            triangleRays[i & mask].RayIntersect(pTriangleObject, payload);
+            DoNotOptimize(payload.hitDist);
+        }
+    });
+
+    // Analytic primitives on the rays of ray/triangle: a board square, a plane through it and a unit sphere, the
+    // shape of the detailed mesh of ray/mesh-lod
+    for (const auto& [name, pObject] : {
+            std::make_pair("quad", std::shared_ptr<RT::Object>(std::make_shared<RT::Quad>(
+                    Vec3D{-0.5, -0.5, 0.}, Vec3D{1., 0., 0.}, Vec3D{0., 1., 0.}))),
+            std::make_pair("plane", std::shared_ptr<RT::Object>(std::make_shared<RT::Plane>(
+                    Vec3D{0., 0., 0.}, Vec3D{0., 0., 1.}))),
+            std::make_pair("sphere", std::shared_ptr<RT::Object>(std::make_shared<RT::Sphere>(Vec3D{0., 0., 0.}, 1.)))}){
+        run(std::string("ray/") + name, [&, pObject = pObject](size_t count) {
+            for (size_t i = 0; i < count; ++i){
+                RT::HitPayload payload;
+                triangleRays[i & mask].RayIntersect(pObject, payload);
+                DoNotOptimize(payload.hitDist);
+            }
+        });
+    }
+
+    // Parsing with normals and texture coordinates, the largest bundled mesh
+    std::string objPath = std::string(Utils::OBJECTS_DIRECTORY) + "knight.obj";
+    run("obj/load/knight", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            DoNotOptimize(ObjLoader::loadTriangleMeshObj(objPath)->GetTriangleNum());
+        }
+    });
+
+    // The same mesh converted, only mapping and header checks
+    std::string meshPath = (std::filesystem::temp_directory_path() / "realchess-bench-knight.rtmesh").string();
+    MeshFile::Convert(objPath, meshPath);
+    run("rtmesh/load/knight", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            DoNotOptimize(MeshFile::Load(meshPath)->GetTriangleNum());
+        }
+    });
+    std::filesystem::remove(meshPath);
+
+    // Whole meshes of every piece, fitted into a unit square like on the board
+    for (const char* piece : {"pawn", "rook", "knight", "bishop", "queen", "king"}){
+        auto pMesh = std::make_shared<RT::TriangleMesh>(*RT::Chessboard::LoadPiece(piece));
+        pMesh->SetCenter(Vec3D{0., 0., 0.});
+        std::shared_ptr<RT::Object> pMeshObject = pMesh;
+        std::vector<RT::Ray> meshRays = RaysAround(Vec3D{0., 0., 0.}, 3., 0.4);
+        run(std::string("ray/mesh/") + piece, [&](size_t count) {
+            for (size_t i = 0; i < count; ++i){
+                RT::HitPayload payload;
+                meshRays[i & mask].RayIntersect(pMeshObject, payload);
+                DoNotOptimize(payload.hitDist);
+            }
+        });
+    }
+
+    // Lathe-shaped pieces as fitted surfaces of revolution, the same rays as ray/mesh of the piece
+    for (const char* piece : {"pawn", "rook", "queen", "king"}){
+        auto pFitted = RT::Chessboard::LoadPieceSurface(piece);
+        if (!pFitted) continue;
+        std::shared_ptr<RT::Object> pSurfaceObject = std::make_shared<RT::SurfaceOfRevolution>(*pFitted);
+        pSurfaceObject->SetCenter(Vec3D{0., 0., 0.});
+        std::vector<RT::Ray> surfaceRays = RaysAround(Vec3D{0., 0., 0.}, 3., 0.4);
+        run(std::string("ray/revolution/") + piece, [&](size_t count) {
+            for (size_t i = 0; i < count; ++i){
+                RT::HitPayload payload;
+                surfaceRays[i & mask].RayIntersect(pSurfaceObject, payload);
+                DoNotOptimize(payload.hitDist);
+            }
+        });
+    }
+
+    // A detailed mesh seen by camera rays (full detail) and by diffuse bounces, which pick a level of detail
+    std::shared_ptr<RT::Object> pDetailedObject = DetailedSphere();
+    std::vector<RT::Ray> detailedRays = RaysAround(Vec3D{0., 0., 0.}, 3., 0.8);
+    std::vector<RT::Ray> diffuseRays = detailedRays;
+    for (auto& ray : diffuseRays){
+        ray.SetCone(0., Utils::DIFFUSE_CONE_SPREAD);
+    }
+    for (const auto& [name, pRays] : {std::make_pair("full", &detailedRays), std::make_pair("diffuse", &diffuseRays)}){
+        run(std::string("ray/mesh-lod/") + name, [&, pRays = pRays](size_t count) {
+            for (size_t i = 0; i < count; ++i){
+                RT::HitPayload payload;
+                (*pRays)[i & mask].RayIntersect(pDetailedObject, payload);
+                DoNotOptimize(payload.hitDist);
+            }
+        });
+    }
+
+    // The knight and the detailed mesh quantised, compare with ray/mesh/knight and ray/mesh-lod/full
+    auto pCompactKnight = std::make_shared<RT::TriangleMesh>(*RT::Chessboard::LoadPiece("knight"));
+    pCompactKnight->SetCenter(Vec3D{0., 0., 0.});
+    pCompactKnight->Compact();
+    auto pCompactSphere = std::make_shared<RT::TriangleMesh>(static_cast<const RT::TriangleMesh&>(*pDetailedObject));
+    pCompactSphere->Compact();
+    std::vector<RT::Ray> knightRays = RaysAround(Vec3D{0., 0., 0.}, 3., 0.4);
+    for (const auto& [name, pObject, pRays] : {std::make_tuple("knight", std::shared_ptr<RT::Object>(pCompactKnight), &knightRays),
+                                               std::make_tuple("sphere", std::shared_ptr<RT::Object>(pCompactSphere), &detailedRays)}){
+        run(std::string("ray/mesh-compact/") + name, [&, pObject = pObject, pRays = pRays](size_t count) {
+            for (size_t i = 0; i < count; ++i){
+                RT::HitPayload payload;
+                (*pRays)[i & mask].RayIntersect(pObject, payload);
+                DoNotOptimize(payload.hitDist);
+            }
+        });
+    }
+
+    // Closest hit search over the default scene, camera rays through a grid and random rays through the board
+    RT::Scene scene;
+    std::vector<RT::Ray> primaryRays;
+    for (size_t i = 0; i < INPUT_COUNT; ++i){
+        double xNorm = static_cast<double>(i % 32) / 32. - 0.5;
+        double yNorm = static_cast<double>(i / 32) / 32. - 0.5;
+        primaryRays.push_back(scene.GetCamera().GetRay(xNorm, yNorm));
+    }
+    std::vector<RT::Ray> randomRays = RandomSceneRays();
+    run("scene/raytrace/primary", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            RT::HitPayload payload;
+            bool hit = scene.RayTrace(primaryRays[i & mask], payload);
+            DoNotOptimize(hit);
+        }
+    });
+    run("scene/raytrace/random", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            RT::HitPayload payload;
+            bool hit = scene.RayTrace(randomRays[i & mask], payload);
+            DoNotOptimize(hit);
+        }
+    });
+
+    // Building a full board, pieces come from the mesh cache
+    run("scene/build", [&](size_t count) {
+        for (size_t i = 0; i < count; ++i){
+            RT::Scene built;
+            DoNotOptimize(built.GetWidth());
+        }
+    });
+
+    // Material scattering on hits of the random scene rays
+    std::vector<std::pair<RT::Ray, RT::HitPayload>> hits;
+    for (RT::Ray& ray : randomRays){
+        RT::HitPayload payload;
+        if (scene.RayTrace(ray, payload)) hits.emplace_back(ray, payload);
+    }
+    if (hits.empty()) throw std::runtime_error("No scene ray hit anything");
+    RT::Lambertian lambertian(Vec3D{0.8, 0.6, 0.4});
+    RT::Metal metal(Vec3D{0.9, 0.9, 0.9}, 0.05);
+    RT::Dielectric dielectric;
+    for (const auto& [name, pMaterial] : std::vector<std::pair<std::string, const RT::Material*>>{
+            {"lambertian", &lambertian}, {"metal", &metal}, {"dielectric", &dielectric}}){
+        run("material/scatter/" + name, [&, pMaterial = pMaterial](size_t count) {
+            for (size_t i = 0; i < count; ++i){
+                const auto& [ray, payload] = hits[i % hits.size()];
+                RT::ScatterPayload scatterPayload;
+                bool scattered = pMaterial->Scatter(ray, payload, scatterPayload, 1);
+                DoNotOptimize(scattered);
+            }
+        });
+    }
+
+    PrintKernelTable(results);
+    return results;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file KernelBench.h
+ * @brief Microbenchmarks of the ray tracing kernels (vectors, intersections, sampling, materials).
+ */
+#ifndef MAIN_CPP_KERNELBENCH_H
+#define MAIN_CPP_KERNELBENCH_H
+
+#include "Benchmark.h"
+#include <string>
+#include <vector>
+
+namespace Bench{
+    struct KernelBenchOptions{
+        double minSeconds = 0.5;
+        /// \brief Only kernels whose name contains this string are run
+        std::string filter;
+    };
+
+    /**
+     * @brief Measures every kernel in ns/op and prints the table.
+     *
+     * Inputs (rays, hit points) are generated from a fixed seed before timing, so runs of different commits
+     * measure the same work.
+     */
+    std::vector<KernelResult> RunKernelBenchmarks(const KernelBenchOptions& options);
+}
+
+#endif
@@ -0,0 +1,245 @@
+#include "LayoutBench.h"
+#include "../ObjectLoader/ObjLoader.h"
+#include "../Random/Random.h"
+#include "../RayTrace/Chessboard.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <unordered_set>
+
+namespace {
+    constexpr size_t VIEW_COUNT = 4;
+    constexpr size_t VIEW_SIZE = 128;
+    constexpr uint64_t SEED = 45;
+    constexpr size_t LINE_SIZE = 64;
+
+    /// \brief Set associative cache with LRU replacement, only tracks which lines it holds
+    class CacheModel{
+    public:
+        CacheModel(size_t bytes, size_t ways) : ways_(ways), sets_(bytes / LINE_SIZE / ways),
+                                                lines_(sets_ * ways, UINTPTR_MAX) {}
+
+        /// \brief Reads the line, returns true on a miss
+        bool Access(uintptr_t line) {
+            // Ways of a set are kept most recently used first
+            uintptr_t* pSet = &lines_[(line % sets_) * ways_];
+            size_t way = 0;
+            while (way < ways_ && pSet[way] != line) ++way;
+            bool miss = way == ways_;
+            if (miss){
+                way = ways_ - 1;
+                pSet[way] = line;
+            }
+            std::rotate(pSet, pSet + way, pSet + way + 1);
+            return miss;
+        }
+
+    private:
+        size_t ways_;
+        size_t sets_;
+        std::vector<uintptr_t> lines_;
+    };
+
+    struct CacheCounts{
+        uint64_t l1Misses = 0;
+        uint64_t l2Misses = 0;
+        uint64_t lines = 0;
+    };
+
+    /// \brief Feeds the reads of a traversal through the caches
+    class AccessRecorder{
+    public:
+        void Touch(const void* pData, size_t size) {
+            auto first = reinterpret_cast<uintptr_t>(pData) / LINE_SIZE;
+            auto last = (reinterpret_cast<uintptr_t>(pData) + size - 1) / LINE_SIZE;
+            for (uintptr_t line = first; line <= last; ++line){
+                if (rayLines_.insert(line).second) ++counts_.lines;
+                if (l1_.Access(line)){
+                    ++counts_.l1Misses;
+                    if (l2_.Access(line)) ++counts_.l2Misses;
+                }
+            }
+        }
+        void NextRay() { rayLines_.clear(); }
+        const CacheCounts& GetCounts() const { return counts_; }
+
+    private:
+        CacheModel l1_{32 << 10, 8};
+        CacheModel l2_{1 << 20, 16};
+        std::unordered_set<uintptr_t> rayLines_;
+        CacheCounts counts_;
+    };
+
+    /**
+     * Same walk and reads as Ray::RayTriangleMeshIntersect: nodes nearer child first, per tested triangle its
+     * indices, first vertex, edges and face normal, and the vertex normals of triangles the ray hits.
+     */
+    void RecordTraversal(const RT::TriangleMesh& mesh, const RT::Ray& ray, AccessRecorder& recorder) {
+        const auto& nodes = mesh.GetBvh();
+        const auto& triangles = mesh.GetTriangles();
+        const auto& vertices = mesh.GetVertices();
+        const auto& edges = mesh.GetEdges();
+        const auto& normals = mesh.GetNormals();
+        const auto& vertexNormals = mesh.GetVertexNormals();
+        if (nodes.empty()) return;
+        Vec3D start = ray.GetStartPoint(), direction = ray.GetDirection();
+        double origin[3], inverseDirection[3];
+        for (size_t axis = 0; axis < 3; ++axis){
+            origin[axis] = start[axis];
+            inverseDirection[axis] = 1. / (std::fabs(direction[axis]) > 1e-300 ? direction[axis] : 1e-300);
+        }
+
+        double closest = DBL_MAX;
+        auto enter = [&](uint32_t index) {
+            recorder.Touch(&nodes[index], sizeof(RT::MeshBvhNode));
+            return RT::MeshBvh::Enter(nodes[index], origin, inverseDirection, closest);
+        };
+        std::vector<std::pair<uint32_t, double>> stack;
+        uint32_t nodeIndex = 0;
+        if (enter(0) < 0.) return;
+        while (true){
+            const RT::MeshBvhNode& node = nodes[nodeIndex];
+            if (node.IsLeaf()){
+                for (size_t i = node.first; i < node.first + node.count; ++i){
+                    const auto& triangle = triangles[i];
+                    recorder.Touch(&triangle, sizeof(triangle));
+                    recorder.Touch(&vertices[triangle[0]], sizeof(Vec3D));
+                    recorder.Touch(&edges[i], sizeof(edges[i]));
+                    recorder.Touch(&normals[i], sizeof(Vec3D));
+                    const Vec3D& edgeAB = edges[i].first;
+                    const Vec3D& edgeAC = edges[i].second;
+                    Vec3D pVec = cross(direction, edgeAC);
+                    double det = edgeAB.dot(pVec);
+                    if (std::fabs(det) < Utils::PARALLEL_PRECISION) continue;
+                    double invDet = 1. / det;
+                    Vec3D tVec = start - vertices[triangle[0]];
+                    double u = tVec.dot(pVec) * invDet;
+                    if (u < 0 || u > 1) continue;
+                    Vec3D qVec = cross(tVec, edgeAB);
+                    double v = direction.dot(qVec) * invDet;
+                    if (v < 0 || u + v > 1) continue;
+                    double distance = edgeAC.dot(qVec) * invDet;
+                    if (distance < 0.01) continue;
+#ifdef __SMOOTHING__
+                    for (size_t corner = 0; corner < 3; ++corner){
+                        recorder.Touch(&vertexNormals[triangle[corner]], sizeof(Vec3D));
+                    }
+#endif
+                    closest = std::min(closest, distance);
+                }
+            } else{
+                uint32_t left = nodeIndex + 1, right = node.first;
+                double leftDistance = enter(left);
+                double rightDistance = enter(right);
+                if (leftDistance >= 0. && rightDistance >= 0.){
+                    if (rightDistance < leftDistance){
+                        std::swap(left, right);
+                        std::swap(leftDistance, rightDistance);
+                    }
+                    stack.emplace_back(right, rightDistance);
+                    nodeIndex = left;
+                    continue;
+                }
+                if (leftDistance >= 0. || rightDistance >= 0.){
+                    nodeIndex = leftDistance >= 0. ? left : right;
+                    continue;
+                }
+            }
+            while (!stack.empty() && stack.back().second > closest) stack.pop_back();
+            if (stack.empty()) break;
+            nodeIndex = stack.back().first;
+            stack.pop_back();
+        }
+    }
+
+    /// \brief Primary rays of random views around the mesh, row by row of a square image covering its box
+    std::vector<RT::Ray> RaysAt(const RT::TriangleMesh& mesh) {
+        auto [low, high] = mesh.GetBoundingPoints();
+        Vec3D center = (low + high) / 2.;
+        Vec3D extent = high - low;
+        double radius = std::sqrt(extent.dot(extent));
+        std::vector<RT::Ray> rays;
+        for (size_t view = 0; view < VIEW_COUNT; ++view){
+            Vec3D eye = center + Rand::RandomUnitVector() * (2. * radius);
+            Vec3D forward = (center - eye) / (2. * radius);
+            Vec3D side = cross(forward, std::fabs(forward[1]) < 0.9 ? Vec3D{0., 1., 0.} : Vec3D{1., 0., 0.});
+            side = side / std::sqrt(side.dot(side));
+            Vec3D up = cross(side, forward);
+            for (size_t y = 0; y < VIEW_SIZE; ++y){
+                for (size_t x = 0; x < VIEW_SIZE; ++x){
+                    double u = (static_cast<double>(x) + 0.5) / VIEW_SIZE - 0.5;
+                    double v = 0.5 - (static_cast<double>(y) + 0.5) / VIEW_SIZE;
+                    rays.emplace_back(eye, center + (side * u + up * v) * radius);
+                }
+            }
+        }
+        return rays;
+    }
+
+    CacheCounts SimulateCaches(const RT::TriangleMesh& mesh, const std::vector<RT::Ray>& rays) {
+        AccessRecorder recorder;
+        for (const auto& ray : rays){
+            RecordTraversal(mesh, ray, recorder);
+            recorder.NextRay();
+        }
+        return recorder.GetCounts();
+    }
+}
+
+std::vector<Bench::KernelResult> Bench::RunLayoutBenchmarks(const Bench::LayoutBenchOptions &options) {
+    struct Input{
+        std::string name;
+        std::string path;
+        ObjLoadOptions loadOptions;
+    };
+    std::vector<Input> inputs;
+    for (const char* piece : {"pawn", "rook", "knight", "bishop", "queen", "king"}){
+        // Loaded like Chessboard::LoadPiece
+        ObjLoadOptions loadOptions;
+        loadOptions.normals = false;
+        loadOptions.texCoords = false;
+        inputs.push_back({piece, Utils::OBJECTS_DIRECTORY + std::string(piece) + ".obj", loadOptions});
+    }
+    for (const auto& path : options.meshPaths){
+        inputs.push_back({path.substr(path.find_last_of("/\\") + 1), path, {}});
+    }
+
+    std::vector<KernelResult> results;
+    std::printf("%-16s %-7s %9s %9s %11s %11s %11s\n", "mesh", "layout", "vertices", "triangles", "lines/ray",
+                "L1 miss/ray", "L2 miss/ray");
+    for (const auto& input : inputs){
+        if (input.name.find(options.filter) == std::string::npos) continue;
+        ObjLoadOptions fileOrder = input.loadOptions;
+        fileOrder.weldTolerance = -1.;
+        fileOrder.optimizeLayout = false;
+        const std::pair<const char*, ObjLoadOptions> layouts[] = {{"file", fileOrder}, {"morton", input.loadOptions}};
+
+        std::vector<RT::Ray> rays;
+        for (const auto& [layout, loadOptions] : layouts){
+            std::shared_ptr<RT::Object> pMesh = ObjLoader::loadTriangleMeshObj(input.path, loadOptions);
+            const auto& mesh = static_cast<const RT::TriangleMesh&>(*pMesh);
+            if (rays.empty()){
+                Rand::Seed(SEED, 0);
+                rays = RaysAt(mesh);
+            }
+            CacheCounts counts = SimulateCaches(mesh, rays);
+            double perRay = 1. / static_cast<double>(rays.size());
+            std::printf("%-16s %-7s %9zu %9zu %11.2f %11.3f %11.3f\n", input.name.c_str(), layout,
+                        mesh.GetVertices().size(), mesh.GetTriangleNum(), counts.lines * perRay,
+                        counts.l1Misses * perRay, counts.l2Misses * perRay);
+
+            results.push_back(MeasureKernel("layout/" + input.name + "/" + layout, options.minSeconds,
+                                            [&](size_t count) {
+                for (size_t i = 0; i < count; ++i){
+                    RT::HitPayload payload;
+                    rays[i % rays.size()].RayIntersect(pMesh, payload);
+                    DoNotOptimize(payload.hitDist);
+                }
+            }));
+        }
+    }
+    std::printf("\n");
+    PrintKernelTable(results);
+    return results;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file LayoutBench.h
+ * @brief Compares mesh traversal in file order with the welded, Morton ordered layout of MeshPreprocess.
+ */
+#ifndef MAIN_CPP_LAYOUTBENCH_H
+#define MAIN_CPP_LAYOUTBENCH_H
+
+#include "Benchmark.h"
+#include <string>
+#include <vector>
+
+namespace Bench{
+    struct LayoutBenchOptions{
+        /// \brief OBJ files measured besides the pieces, loaded with normals and texture coordinates
+        std::vector<std::string> meshPaths;
+        double minSeconds = 0.5;
+        /// \brief Only meshes whose name contains this string are measured
+        std::string filter;
+    };
+
+    /**
+     * @brief Loads every mesh with and without preprocessing and prints cache misses and ns per ray.
+     *
+     * Hardware counters aren't portable (and often unavailable in VMs), so misses come from a model: the mesh
+     * traversal is replayed on the same rays, every node, triangle, vertex, edge and normal it reads is fed through
+     * a simulated 32 KiB 8-way L1 and 1 MiB 16-way L2 with 64 byte lines and LRU replacement, both cold at the
+     * start of a mesh. Lines per ray counts the distinct lines one ray reads, the misses of a cold cache.
+     * @return Timings of both layouts, named layout/<mesh>/file and layout/<mesh>/morton.
+     */
+    std::vector<KernelResult> RunLayoutBenchmarks(const LayoutBenchOptions& options);
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "ReplayBench.h"
+#include "../RayTrace/RayCapture.h"
+#include "../Server/RenderJob.h"
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+namespace {
+    /// \brief Closest hit search of one traversal kernel, returns whether the ray hit anything
+    using Backend = std::function<bool(RT::Ray&, RT::HitPayload&)>;
+
+    /// \brief Relative difference of hit distances still counted as the same hit
+    constexpr double DISTANCE_TOLERANCE = 1e-9;
+
+    bool SameHit(const RT::CapturedRay& captured, bool hit, double hitDistance) {
+        if (hit != captured.IsHit()) return false;
+        return !hit || std::abs(hitDistance - captured.hitDistance) <= DISTANCE_TOLERANCE * std::max(1., captured.hitDistance);
+    }
+}
+
+std::vector<Bench::KernelResult> Bench::RunReplayBenchmarks(const Bench::ReplayBenchOptions &options) {
+    std::string description;
+    std::vector<RT::CapturedRay> captured = RT::RayCapture::Load(options.path, description);
+    if (captured.empty()) throw std::runtime_error("Ray capture " + options.path + " has no rays");
+    RT::RenderJob job = RT::RenderJob::Parse(description);
+    RT::Scene scene(job.GetFigures());
+    std::printf("Replaying %zu rays of %s\n", captured.size(), description.c_str());
+
+    // New traversal kernels are compared with the current one by adding them here
+    const std::vector<std::pair<std::string, Backend>> backends = {
+            {"scene", [&scene](RT::Ray& ray, RT::HitPayload& payload) { return scene.RayTrace(ray, payload); }},
+    };
+
+    // Rays of each kind, the last group holds all of them
+    constexpr size_t KIND_COUNT = static_cast<size_t>(RT::RayKind::COUNT);
+    std::vector<RT::Ray> groups[KIND_COUNT + 1];
+    for (const RT::CapturedRay& ray : captured){
+        groups[static_cast<size_t>(ray.kind)].push_back(ray.ToRay());
+        groups[KIND_COUNT].push_back(ray.ToRay());
+    }
+
+    std::vector<KernelResult> results;
+    std::printf("%-12s %-10s %10s %8s %12s\n", "backend", "rays", "count", "hit %", "mismatches");
+    for (const auto& [name, backend] : backends){
+        if (name.find(options.filter) == std::string::npos) continue;
+        size_t hits[KIND_COUNT + 1] = {};
+        size_t mismatches[KIND_COUNT + 1] = {};
+        for (const RT::CapturedRay& ray : captured){
+            RT::Ray replayed = ray.ToRay();
+            RT::HitPayload payload;
+            bool hit = backend(replayed, payload);
+            bool same = SameHit(ray, hit, payload.hitDist);
+            for (size_t group : {static_cast<size_t>(ray.kind), KIND_COUNT}){
+                hits[group] += hit;
+                mismatches[group] += !same;
+            }
+        }
+        for (size_t group = 0; group <= KIND_COUNT; ++group){
+            if (groups[group].empty()) continue;
+            const char* groupName = group == KIND_COUNT ? "all" : RT::RayKindName(static_cast<RT::RayKind>(group));
+            std::printf("%-12s %-10s %10zu %8.1f %12zu\n", name.c_str(), groupName, groups[group].size(),
+                        100. * hits[group] / groups[group].size(), mismatches[group]);
+        }
+
+        for (size_t group = 0; group <= KIND_COUNT; ++group){
+            std::vector<RT::Ray>& rays = groups[group];
+            if (rays.empty()) continue;
+            const char* groupName = group == KIND_COUNT ? "all" : RT::RayKindName(static_cast<RT::RayKind>(group));
+            results.push_back(MeasureKernel("replay/" + name + "/" + groupName, options.minSeconds, [&](size_t count) {
+                for (size_t i = 0, index = 0; i < count; ++i){
+                    RT::HitPayload payload;
+                    bool hit = backend(rays[index], payload);
+                    DoNotOptimize(hit);
+                    if (++index == rays.size()) index = 0;
+                }
+            }));
+        }
+    }
+    std::printf("\n");
+    PrintKernelTable(results);
+    return results;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file ReplayBench.h
+ * @brief Replays rays captured from a render (RayCapture) through the traversal kernels.
+ */
+#ifndef MAIN_CPP_REPLAYBENCH_H
+#define MAIN_CPP_REPLAYBENCH_H
+
+#include "Benchmark.h"
+#include <string>
+#include <vector>
+
+namespace Bench{
+    struct ReplayBenchOptions{
+        /// \brief Capture written by RealChess-Render --capture-rays
+        std::string path;
+        double minSeconds = 0.5;
+        /// \brief Only backends whose name contains this string are run
+        std::string filter;
+    };
+
+    /**
+     * @brief Rebuilds the captured scene and measures every traversal backend on the captured rays.
+     *
+     * Every backend first traces all rays once and its closest hits are compared with the ones found during the
+     * render, then ns/ray is measured separately for primary, secondary and shadow rays and for all of them.
+     */
+    std::vector<KernelResult> RunReplayBenchmarks(const ReplayBenchOptions& options);
+}
+
+#endif
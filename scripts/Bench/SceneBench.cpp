@@ -0,0 +1,148 @@
+#include "SceneBench.h"
+#include "../RayTrace/Scene.h"
+#include "../RayTrace/ToneMapper.h"
+#include "../Server/RenderJob.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+    /// \brief Small resolution, so references at a high sample count can be rendered in minutes
+    constexpr size_t WIDTH = 128;
+    constexpr size_t HEIGHT = 72;
+    constexpr uint64_t SEED = 1;
+
+    struct BenchScene{
+        const char* name;
+        /// \brief Piece placement, empty means Config::FIGURE_CONFIGURATION
+        const char* fen;
+        RT::SceneOptions options;
+    };
+
+    RT::SceneOptions MakeOptions(bool mirrors, bool glassPieces) {
+        RT::SceneOptions options;
+        options.mirrors = mirrors;
+        options.glassPieces = glassPieces;
+        return options;
+    }
+
+    const BenchScene SCENES[] = {
+            {"empty-board", "8/8/8/8/8/8/8/8", {}},
+            {"default", "", {}},
+            {"start-position", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR", {}},
+            {"glass-pieces", "", MakeOptions(true, true)},
+            {"no-mirrors", "", MakeOptions(false, false)},
+    };
+
+    /// \brief Renders the scene and tone maps it, pixels are 0xAARRGGBB with the top row first
+    std::vector<uint32_t> Render(const BenchScene& benchScene, int sqrtSamples, RT::RenderStats& stats) {
+        RT::RenderJob job;
+        job.fen = benchScene.fen;
+        job.width = WIDTH;
+        job.height = HEIGHT;
+        job.settings.sqrtSamples = sqrtSamples;
+        job.settings.seed = SEED;
+        RT::Scene scene(job.GetFigures(), benchScene.options);
+        job.Configure(scene);
+        scene.Render();
+        stats = scene.GetRenderStats();
+
+        std::vector<uint32_t> pixels(WIDTH * HEIGHT);
+        RT::ToneMapper().Resolve(scene.GetFramebuffer(), pixels.data(), WIDTH);
+        return pixels;
+    }
+
+    std::string ReferencePath(const Bench::SceneBenchOptions& options, const BenchScene& benchScene) {
+        return options.referenceDirectory + "/" + benchScene.name + ".bmp";
+    }
+
+    uint32_t ReadUint32(const std::vector<uint8_t>& data, size_t offset) {
+        return data[offset] | data[offset + 1] << 8 | data[offset + 2] << 16 | static_cast<uint32_t>(data[offset + 3]) << 24;
+    }
+
+    /// \brief Reads a 24-bit BMP as written by BmpWriter, throws std::runtime_error for anything else
+    std::vector<uint32_t> ReadBmp(const std::string& path, size_t width, size_t height) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()){
+            throw std::runtime_error("Missing reference " + path + ", render the references with --update-references");
+        }
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (data.size() < 54 || data[0] != 'B' || data[1] != 'M' || (data[28] | data[29] << 8) != 24){
+            throw std::runtime_error("Reference is not a 24-bit BMP: " + path);
+        }
+        auto fileHeight = static_cast<int32_t>(ReadUint32(data, 22));
+        size_t offset = ReadUint32(data, 10);
+        size_t rowBytes = (width * 3 + 3) / 4 * 4;
+        if (ReadUint32(data, 18) != width || static_cast<size_t>(std::abs(fileHeight)) != height ||
+            data.size() < offset + rowBytes * height){
+            throw std::runtime_error("Reference " + path + " doesn't match the benchmark resolution, update it");
+        }
+
+        std::vector<uint32_t> pixels(width * height);
+        for (size_t y = 0; y < height; ++y){
+            // Positive height stores the bottom row first
+            size_t fileRow = fileHeight < 0 ? y : height - 1 - y;
+            const uint8_t* pRow = data.data() + offset + fileRow * rowBytes;
+            for (size_t x = 0; x < width; ++x){
+                pixels[y * width + x] = RT::ToneMapper::Pack(pRow[3 * x + 2], pRow[3 * x + 1], pRow[3 * x]);
+            }
+        }
+        return pixels;
+    }
+
+    void WriteBmp(std::ostream& file, const std::vector<uint32_t>& pixels) {
+        auto pWriter = RT::ImageWriter::Create(RT::ImageFormat::BMP, file, WIDTH, HEIGHT);
+        pWriter->WriteRows(pixels.data(), HEIGHT);
+        pWriter->Finish();
+    }
+
+    /// \brief Root mean square difference of all color channels, scaled to [0, 1]
+    double Rmse(const std::vector<uint32_t>& image, const std::vector<uint32_t>& reference) {
+        double sum = 0.;
+        for (size_t i = 0; i < image.size(); ++i){
+            for (int shift = 0; shift < 24; shift += 8){
+                double difference = static_cast<int>(image[i] >> shift & 0xFF) - static_cast<int>(reference[i] >> shift & 0xFF);
+                sum += difference * difference;
+            }
+        }
+        return std::sqrt(sum / (image.size() * 3)) / 255.;
+    }
+}
+
+std::vector<Bench::SceneResult> Bench::RunSceneBenchmarks(const Bench::SceneBenchOptions &options) {
+    std::vector<SceneResult> results;
+    RT::RenderStats stats;
+    for (const BenchScene& benchScene : SCENES){
+        std::string name = benchScene.name;
+        if (name.find(options.filter) == std::string::npos) continue;
+        std::string referencePath = ReferencePath(options, benchScene);
+
+        if (options.updateReferences){
+            std::printf("Rendering reference %s at %d spp...\n", referencePath.c_str(),
+                        options.referenceSqrtSamples * options.referenceSqrtSamples);
+            std::fflush(stdout);
+            // Opened first, so a wrong directory fails before minutes of rendering
+            std::ofstream file(referencePath, std::ios::binary);
+            if (!file.is_open()) throw std::runtime_error("Error opening file: " + referencePath);
+            WriteBmp(file, Render(benchScene, options.referenceSqrtSamples, stats));
+            continue;
+        }
+
+        std::vector<uint32_t> reference = ReadBmp(referencePath, WIDTH, HEIGHT);
+        for (int sqrtSamples : options.sqrtSamples){
+            std::vector<uint32_t> image = Render(benchScene, sqrtSamples, stats);
+            SceneResult result;
+            result.name = "scene/" + name + "/" + std::to_string(sqrtSamples * sqrtSamples) + "spp";
+            result.samplesPerPixel = sqrtSamples * sqrtSamples;
+            result.seconds = stats.seconds;
+            result.mraysPerSecond = stats.GetMraysPerSecond();
+            result.rmse = Rmse(image, reference);
+            result.psnr = result.rmse > 0. ? -20. * std::log10(result.rmse) : INFINITY;
+            results.push_back(result);
+        }
+    }
+    if (!options.updateReferences) PrintSceneTable(results);
+    return results;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file SceneBench.h
+ * @brief End-to-end benchmark of canonical scenes, render time against error to stored reference images.
+ */
+#ifndef MAIN_CPP_SCENEBENCH_H
+#define MAIN_CPP_SCENEBENCH_H
+
+#include "Benchmark.h"
+#include <string>
+#include <vector>
+
+namespace Bench{
+    struct SceneBenchOptions{
+        /// \brief Directory with the reference images, relative paths start in the working directory
+        std::string referenceDirectory = "../BenchReferences";
+        /// \brief Only scenes whose name contains this string are run
+        std::string filter;
+        /// \brief Square roots of the sample budgets every scene is rendered with
+        std::vector<int> sqrtSamples = {1, 2, 4};
+        /// \brief Renders the references instead of benchmarking
+        bool updateReferences = false;
+        int referenceSqrtSamples = 16;
+    };
+
+    /**
+     * @brief Renders every canonical scene at every budget and compares it with its reference image.
+     *
+     * Scenes are fixed (pieces, materials, camera, resolution and seed), so results of different commits are
+     * comparable. References are tone-mapped BMPs rendered with SceneBenchOptions::referenceSqrtSamples, they have
+     * to be updated with updateReferences whenever the expected image changes, not when only speed changes.
+     */
+    std::vector<SceneResult> RunSceneBenchmarks(const SceneBenchOptions& options);
+}
+
+#endif
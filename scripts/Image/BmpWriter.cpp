@@ -0,0 +1,57 @@
+#include "BmpWriter.h"
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    void PutUint16(std::vector<uint8_t>& buffer, uint16_t value) {
+        buffer.push_back(static_cast<uint8_t>(value));
+        buffer.push_back(static_cast<uint8_t>(value >> 8));
+    }
+
+    void PutUint32(std::vector<uint8_t>& buffer, uint32_t value) {
+        PutUint16(buffer, static_cast<uint16_t>(value));
+        PutUint16(buffer, static_cast<uint16_t>(value >> 16));
+    }
+}
+
+RT::BmpWriter::BmpWriter(std::ostream &output, size_t width, size_t height) : ImageWriter(output, width, height) {
+    const uint32_t fileHeaderSize = 14;
+    const uint32_t informationHeaderSize = 40;
+    rowBytes_ = (width * 3 + 3) / 4 * 4;
+    uint64_t fileSize = fileHeaderSize + informationHeaderSize + static_cast<uint64_t>(rowBytes_) * height;
+    if (fileSize > std::numeric_limits<uint32_t>::max() || height > static_cast<size_t>(std::numeric_limits<int32_t>::max())){
+        throw std::invalid_argument("Image is too large for BMP");
+    }
+
+    std::vector<uint8_t> header;
+    header.reserve(fileHeaderSize + informationHeaderSize);
+    // File header
+    header.push_back('B');
+    header.push_back('M');
+    PutUint32(header, static_cast<uint32_t>(fileSize));
+    PutUint32(header, 0);
+    PutUint32(header, fileHeaderSize + informationHeaderSize);
+    // Information header, negative height means the first row is the top one
+    PutUint32(header, informationHeaderSize);
+    PutUint32(header, static_cast<uint32_t>(width));
+    PutUint32(header, static_cast<uint32_t>(-static_cast<int32_t>(height)));
+    PutUint16(header, 1);
+    PutUint16(header, 24);
+    for (int i = 0; i < 6; ++i) PutUint32(header, 0);
+    Flush(header);
+}
+
+void RT::BmpWriter::EncodeRows(const uint32_t *pPixels, size_t rows, size_t pitch) {
+    buffer_.assign(rowBytes_ * rows, 0);
+    for (size_t y = 0; y < rows; ++y){
+        const uint32_t* pRow = pPixels + y * pitch;
+        uint8_t* pOut = buffer_.data() + y * rowBytes_;
+        for (size_t x = 0; x < width_; ++x){
+            // 0xAARRGGBB in BGR byte order
+            *pOut++ = static_cast<uint8_t>(pRow[x]);
+            *pOut++ = static_cast<uint8_t>(pRow[x] >> 8);
+            *pOut++ = static_cast<uint8_t>(pRow[x] >> 16);
+        }
+    }
+    Flush(buffer_);
+}
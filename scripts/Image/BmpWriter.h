@@ -0,0 +1,28 @@
+/**
+ * @file BmpWriter.h
+ * @brief Defines the BmpWriter class, uncompressed 24-bit BMP output.
+ */
+#ifndef MAIN_CPP_BMPWRITER_H
+#define MAIN_CPP_BMPWRITER_H
+
+#include "ImageWriter.h"
+
+namespace RT{
+    /**
+     * @class BmpWriter
+     * @brief 24-bit BMP, stored top-down (negative height) so rows can be written in the order they come.
+     */
+    class BmpWriter : public ImageWriter{
+    public:
+        BmpWriter(std::ostream& output, size_t width, size_t height);
+
+    private:
+        void EncodeRows(const uint32_t* pPixels, size_t rows, size_t pitch) override;
+
+        /// \brief Row size in bytes including the padding to a multiple of 4
+        size_t rowBytes_;
+        std::vector<uint8_t> buffer_;
+    };
+}
+
+#endif
@@ -0,0 +1,389 @@
+#include "Deflate.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <cstring>
+#include <queue>
+
+namespace {
+    constexpr size_t WINDOW_SIZE = 32768;
+    constexpr size_t HASH_BITS = 15;
+    constexpr size_t MIN_MATCH = 3;
+    constexpr size_t MAX_MATCH = 258;
+    /// \brief Searched candidates per position, higher compresses better and slower
+    constexpr int MAX_CHAIN = 8;
+    /// \brief Match long enough to stop searching
+    constexpr size_t GOOD_MATCH = 32;
+    /// \brief Only the start of longer matches is added to the hash chains
+    constexpr size_t MAX_INSERT_LENGTH = 16;
+    /// \brief Symbols per block, each block gets its own Huffman codes
+    constexpr size_t BLOCK_SYMBOLS = 32768;
+
+    constexpr int LITLEN_CODES = 286;
+    constexpr int DIST_CODES = 30;
+    constexpr int CODELEN_CODES = 19;
+    constexpr int END_OF_BLOCK = 256;
+
+    constexpr uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+                                          67, 83, 99, 115, 131, 163, 195, 227, 258};
+    constexpr uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+                                          5, 5, 5, 5, 0};
+    constexpr uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+                                        769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    constexpr uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+                                        11, 11, 12, 12, 13, 13};
+    constexpr uint8_t CODELEN_ORDER[CODELEN_CODES] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1,
+                                                      15};
+
+    /// \brief Literal (dist == 0) or a back reference
+    struct Symbol{
+        uint16_t value;
+        uint16_t dist;
+    };
+
+    class BitWriter{
+    public:
+        explicit BitWriter(std::vector<uint8_t>& output) : output_(output) {}
+
+        /// \brief Writes the lowest count bits of value, least significant bit first
+        void Write(uint32_t value, int count) {
+            buffer_ |= static_cast<uint64_t>(value) << bits_;
+            bits_ += count;
+            while (bits_ >= 8){
+                output_.push_back(static_cast<uint8_t>(buffer_));
+                buffer_ >>= 8;
+                bits_ -= 8;
+            }
+        }
+        void AlignToByte() {
+            if (bits_ > 0) Write(0, 8 - bits_);
+        }
+
+    private:
+        std::vector<uint8_t>& output_;
+        uint64_t buffer_ = 0;
+        int bits_ = 0;
+    };
+
+    struct HuffmanCode{
+        std::vector<uint8_t> lengths;
+        /// \brief Bit reversed codes, ready to be written least significant bit first
+        std::vector<uint16_t> codes;
+    };
+
+    /// \brief Code lengths of a Huffman code limited to maxBits, based on symbol frequencies
+    std::vector<uint8_t> BuildLengths(const std::vector<uint32_t>& frequencies, int maxBits) {
+        std::vector<uint8_t> lengths(frequencies.size(), 0);
+        std::vector<int> used;
+        for (size_t i = 0; i < frequencies.size(); ++i){
+            if (frequencies[i] > 0) used.push_back(static_cast<int>(i));
+        }
+        // A code needs at least two symbols to be complete
+        for (int i = 0; used.size() < 2; ++i){
+            if (frequencies[i] == 0) used.push_back(i);
+        }
+        std::sort(used.begin(), used.end(), [&frequencies](int a, int b) {
+            return frequencies[a] != frequencies[b] ? frequencies[a] < frequencies[b] : a < b;
+        });
+
+        // Plain Huffman tree, nodes past used.size() are internal
+        std::vector<uint64_t> weights;
+        std::vector<int> parents(used.size() * 2, -1);
+        for (int symbol : used) weights.push_back(frequencies[symbol]);
+        using Node = std::pair<uint64_t, int>;
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+        for (size_t i = 0; i < used.size(); ++i) queue.emplace(weights[i], static_cast<int>(i));
+        while (queue.size() > 1){
+            Node first = queue.top();
+            queue.pop();
+            Node second = queue.top();
+            queue.pop();
+            int parent = static_cast<int>(weights.size());
+            weights.push_back(first.first + second.first);
+            parents[first.second] = parent;
+            parents[second.second] = parent;
+            queue.emplace(weights.back(), parent);
+        }
+
+        // Counts of codes per length, lengths over the limit are clipped and the Kraft sum is repaired
+        // by lengthening the deepest codes that still fit
+        std::vector<int> counts(std::max<size_t>(used.size(), maxBits) + 1, 0);
+        for (size_t i = 0; i < used.size(); ++i){
+            int depth = 0;
+            for (int node = static_cast<int>(i); parents[node] != -1; node = parents[node]) ++depth;
+            ++counts[std::min(depth, maxBits)];
+        }
+        uint64_t total = 0;
+        for (int length = 1; length <= maxBits; ++length) total += static_cast<uint64_t>(counts[length]) << (maxBits - length);
+        while (total > (1ull << maxBits)){
+            --counts[maxBits];
+            for (int length = maxBits - 1; length > 0; --length){
+                if (counts[length] > 0){
+                    --counts[length];
+                    counts[length + 1] += 2;
+                    break;
+                }
+            }
+            --total;
+        }
+
+        // Most frequent symbols (end of the sorted list) get the shortest codes
+        auto symbol = used.rbegin();
+        for (int length = 1; length <= maxBits; ++length){
+            for (int i = 0; i < counts[length]; ++i, ++symbol){
+                lengths[*symbol] = static_cast<uint8_t>(length);
+            }
+        }
+        return lengths;
+    }
+
+    HuffmanCode BuildCode(const std::vector<uint32_t>& frequencies, int maxBits) {
+        HuffmanCode code;
+        code.lengths = BuildLengths(frequencies, maxBits);
+        code.codes.assign(frequencies.size(), 0);
+        std::array<uint16_t, 16> nextCode{};
+        std::array<uint16_t, 16> lengthCounts{};
+        for (uint8_t length : code.lengths) ++lengthCounts[length];
+        lengthCounts[0] = 0;
+        uint16_t value = 0;
+        for (int length = 1; length < 16; ++length){
+            value = static_cast<uint16_t>((value + lengthCounts[length - 1]) << 1);
+            nextCode[length] = value;
+        }
+        for (size_t symbol = 0; symbol < code.lengths.size(); ++symbol){
+            int length = code.lengths[symbol];
+            if (length == 0) continue;
+            uint16_t canonical = nextCode[length]++;
+            uint16_t reversed = 0;
+            for (int bit = 0; bit < length; ++bit) reversed |= ((canonical >> bit) & 1) << (length - bit - 1);
+            code.codes[symbol] = reversed;
+        }
+        return code;
+    }
+
+    int LengthCode(size_t length) {
+        return static_cast<int>(std::upper_bound(LENGTH_BASE, LENGTH_BASE + 29, length) - LENGTH_BASE) - 1;
+    }
+
+    int DistanceCode(size_t dist) {
+        return static_cast<int>(std::upper_bound(DIST_BASE, DIST_BASE + 30, dist) - DIST_BASE) - 1;
+    }
+
+    /// \brief Writes one non-final block with dynamic Huffman codes
+    void WriteBlock(const std::vector<Symbol>& symbols, BitWriter& writer) {
+        std::vector<uint32_t> litlenFrequencies(LITLEN_CODES, 0);
+        std::vector<uint32_t> distFrequencies(DIST_CODES, 0);
+        for (const Symbol& symbol : symbols){
+            if (symbol.dist == 0){
+                ++litlenFrequencies[symbol.value];
+            } else{
+                ++litlenFrequencies[257 + LengthCode(symbol.value)];
+                ++distFrequencies[DistanceCode(symbol.dist)];
+            }
+        }
+        litlenFrequencies[END_OF_BLOCK] = 1;
+        HuffmanCode litlen = BuildCode(litlenFrequencies, 15);
+        HuffmanCode dist = BuildCode(distFrequencies, 15);
+
+        int litlenCount = LITLEN_CODES;
+        while (litlenCount > 257 && litlen.lengths[litlenCount - 1] == 0) --litlenCount;
+        int distCount = DIST_CODES;
+        while (distCount > 1 && dist.lengths[distCount - 1] == 0) --distCount;
+
+        // Both code length sequences are run length encoded together with codes 16 (repeat), 17 and 18 (zeros)
+        std::vector<uint8_t> lengths(litlen.lengths.begin(), litlen.lengths.begin() + litlenCount);
+        lengths.insert(lengths.end(), dist.lengths.begin(), dist.lengths.begin() + distCount);
+        std::vector<std::pair<uint8_t, uint8_t>> runs;
+        std::vector<uint32_t> codelenFrequencies(CODELEN_CODES, 0);
+        for (size_t i = 0; i < lengths.size();){
+            uint8_t length = lengths[i];
+            size_t run = 1;
+            while (i + run < lengths.size() && lengths[i + run] == length) ++run;
+            i += run;
+            if (length == 0){
+                while (run >= 11){
+                    size_t count = std::min<size_t>(run, 138);
+                    runs.emplace_back(18, static_cast<uint8_t>(count - 11));
+                    run -= count;
+                }
+                if (run >= 3){
+                    runs.emplace_back(17, static_cast<uint8_t>(run - 3));
+                    run = 0;
+                }
+            } else{
+                runs.emplace_back(length, 0);
+                --run;
+                while (run >= 3){
+                    size_t count = std::min<size_t>(run, 6);
+                    runs.emplace_back(16, static_cast<uint8_t>(count - 3));
+                    run -= count;
+                }
+            }
+            for (; run > 0; --run) runs.emplace_back(length, 0);
+        }
+        for (const auto& run : runs) ++codelenFrequencies[run.first];
+        HuffmanCode codelen = BuildCode(codelenFrequencies, 7);
+        int codelenCount = CODELEN_CODES;
+        while (codelenCount > 4 && codelen.lengths[CODELEN_ORDER[codelenCount - 1]] == 0) --codelenCount;
+
+        writer.Write(0, 1);
+        writer.Write(2, 2);
+        writer.Write(litlenCount - 257, 5);
+        writer.Write(distCount - 1, 5);
+        writer.Write(codelenCount - 4, 4);
+        for (int i = 0; i < codelenCount; ++i) writer.Write(codelen.lengths[CODELEN_ORDER[i]], 3);
+        for (const auto& run : runs){
+            writer.Write(codelen.codes[run.first], codelen.lengths[run.first]);
+            if (run.first == 16) writer.Write(run.second, 2);
+            else if (run.first == 17) writer.Write(run.second, 3);
+            else if (run.first == 18) writer.Write(run.second, 7);
+        }
+
+        for (const Symbol& symbol : symbols){
+            if (symbol.dist == 0){
+                writer.Write(litlen.codes[symbol.value], litlen.lengths[symbol.value]);
+            } else{
+                int lengthCode = LengthCode(symbol.value);
+                writer.Write(litlen.codes[257 + lengthCode], litlen.lengths[257 + lengthCode]);
+                writer.Write(symbol.value - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+                int distCode = DistanceCode(symbol.dist);
+                writer.Write(dist.codes[distCode], dist.lengths[distCode]);
+                writer.Write(symbol.dist - DIST_BASE[distCode], DIST_EXTRA[distCode]);
+            }
+        }
+        writer.Write(litlen.codes[END_OF_BLOCK], litlen.lengths[END_OF_BLOCK]);
+    }
+
+    /// \brief Length of the common prefix, compared 8 bytes at a time
+    size_t MatchLength(const uint8_t* pA, const uint8_t* pB, size_t maxLength) {
+        size_t length = 0;
+        while (length + 8 <= maxLength){
+            uint64_t a, b;
+            std::memcpy(&a, pA + length, 8);
+            std::memcpy(&b, pB + length, 8);
+            if (a != b) return length + (__builtin_ctzll(a ^ b) >> 3);
+            length += 8;
+        }
+        while (length < maxLength && pA[length] == pB[length]) ++length;
+        return length;
+    }
+
+    uint32_t Hash(const uint8_t* pData) {
+        uint32_t value = pData[0] | (pData[1] << 8) | (pData[2] << 16);
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+}
+
+void RT::Deflate::CompressSegment(const uint8_t *pData, size_t size, std::vector<uint8_t> &output) {
+    output.reserve(output.size() + size / 2 + 64);
+    BitWriter writer(output);
+    // Hash chains over a sliding window, positions are stored +1 so that 0 means empty
+    std::vector<uint32_t> head(size_t(1) << HASH_BITS, 0);
+    std::vector<uint32_t> previous(WINDOW_SIZE, 0);
+    std::vector<Symbol> symbols;
+    symbols.reserve(BLOCK_SYMBOLS);
+
+    auto insert = [&](size_t position) {
+        uint32_t hash = Hash(pData + position);
+        previous[position % WINDOW_SIZE] = head[hash];
+        head[hash] = static_cast<uint32_t>(position + 1);
+    };
+
+    size_t position = 0;
+    while (position < size){
+        size_t bestLength = 0;
+        size_t bestDist = 0;
+        if (position + MIN_MATCH <= size){
+            size_t maxLength = std::min(MAX_MATCH, size - position);
+            uint32_t candidate = head[Hash(pData + position)];
+            for (int chain = 0; chain < MAX_CHAIN && candidate != 0; ++chain){
+                size_t start = candidate - 1;
+                size_t dist = position - start;
+                if (dist > WINDOW_SIZE - 1) break;
+                if (pData[start + bestLength] == pData[position + bestLength]){
+                    size_t length = MatchLength(pData + start, pData + position, maxLength);
+                    if (length > bestLength){
+                        bestLength = length;
+                        bestDist = dist;
+                        if (length >= GOOD_MATCH || length == maxLength) break;
+                    }
+                }
+                uint32_t next = previous[start % WINDOW_SIZE];
+                // Stale entries point forward after the ring buffer wrapped around
+                if (next == 0 || next - 1 >= start) break;
+                candidate = next;
+            }
+        }
+
+        if (bestLength >= MIN_MATCH){
+            symbols.push_back(Symbol{static_cast<uint16_t>(bestLength), static_cast<uint16_t>(bestDist)});
+            size_t inserted = std::min(bestLength, MAX_INSERT_LENGTH);
+            for (size_t i = 0; i < inserted; ++i){
+                if (position + i + MIN_MATCH <= size) insert(position + i);
+            }
+            position += bestLength;
+        } else{
+            symbols.push_back(Symbol{pData[position], 0});
+            if (position + MIN_MATCH <= size) insert(position);
+            ++position;
+        }
+
+        if (symbols.size() == BLOCK_SYMBOLS){
+            WriteBlock(symbols, writer);
+            symbols.clear();
+        }
+    }
+    if (!symbols.empty()) WriteBlock(symbols, writer);
+
+    // Empty stored block aligns the segment end to a byte boundary
+    writer.Write(0, 3);
+    writer.AlignToByte();
+    output.insert(output.end(), {0x00, 0x00, 0xFF, 0xFF});
+}
+
+void RT::Deflate::AppendFinalBlock(std::vector<uint8_t> &output) {
+    // BFINAL = 1, fixed Huffman codes, end of block code 0000000
+    output.insert(output.end(), {0x03, 0x00});
+}
+
+uint32_t RT::Deflate::Crc32(const uint8_t *pData, size_t size, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> result{};
+        for (uint32_t i = 0; i < 256; ++i){
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            result[i] = value;
+        }
+        return result;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t RT::Deflate::Adler32(const uint8_t *pData, size_t size, uint32_t adler) {
+    constexpr uint32_t BASE = 65521;
+    // Largest amount of bytes summed before the 32-bit sums could overflow
+    constexpr size_t MAX_RUN = 5552;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (size > 0){
+        size_t run = std::min(size, MAX_RUN);
+        size -= run;
+        for (size_t i = 0; i < run; ++i){
+            a += *pData++;
+            b += a;
+        }
+        a %= BASE;
+        b %= BASE;
+    }
+    return (b << 16) | a;
+}
+
+uint32_t RT::Deflate::Adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2) {
+    constexpr uint64_t BASE = 65521;
+    uint64_t remainder = size2 % BASE;
+    uint64_t a = (adler1 & 0xFFFF) + (adler2 & 0xFFFF) + BASE - 1;
+    uint64_t b = (remainder * (adler1 & 0xFFFF)) % BASE + (adler1 >> 16) + (adler2 >> 16) + BASE - remainder;
+    return static_cast<uint32_t>(((b % BASE) << 16) | (a % BASE));
+}
@@ -0,0 +1,34 @@
+/**
+ * @file Deflate.h
+ * @brief Deflate compression (RFC 1951) and the checksums used by PNG.
+ */
+#ifndef MAIN_CPP_DEFLATE_H
+#define MAIN_CPP_DEFLATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RT{
+    namespace Deflate{
+        /**
+         * @brief Compresses data into non-final deflate blocks with dynamic Huffman codes.
+         *
+         * The output ends with an empty stored block (like zlib's sync flush), so it's byte aligned and segments
+         * compressed independently (e.g. on different threads) can be concatenated into one stream. Matches never
+         * reach outside of the segment. The stream has to be terminated with AppendFinalBlock().
+         */
+        void CompressSegment(const uint8_t* pData, size_t size, std::vector<uint8_t>& output);
+        /// \brief Appends an empty final block, which ends the deflate stream
+        void AppendFinalBlock(std::vector<uint8_t>& output);
+
+        /// \brief CRC-32 (ISO 3309) of data, continuing from crc
+        uint32_t Crc32(const uint8_t* pData, size_t size, uint32_t crc = 0);
+        /// \brief Adler-32 of data, continuing from adler
+        uint32_t Adler32(const uint8_t* pData, size_t size, uint32_t adler = 1);
+        /// \brief Adler-32 of two concatenated parts from their separate checksums and the length of the second one
+        uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2);
+    }
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include "ImageWriter.h"
+#include "BmpWriter.h"
+#include "QoiWriter.h"
+#include "PngWriter.h"
+#include <algorithm>
+#include <stdexcept>
+
+RT::ImageFormat RT::ImageFormatFromPath(const std::string &path) {
+    size_t dot = path.find_last_of('.');
+    size_t separator = path.find_last_of("/\\");
+    if (dot == std::string::npos || (separator != std::string::npos && dot < separator)){
+        throw std::invalid_argument("Missing image extension (.bmp, .qoi or .png): " + path);
+    }
+    return ImageFormatFromName(path.substr(dot + 1));
+}
+
+RT::ImageFormat RT::ImageFormatFromName(const std::string &name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "bmp") return ImageFormat::BMP;
+    if (lower == "qoi") return ImageFormat::QOI;
+    if (lower == "png") return ImageFormat::PNG;
+    throw std::invalid_argument("Unknown image format " + name + ", expected bmp, qoi or png");
+}
+
+const char* RT::ImageFormatName(RT::ImageFormat format) {
+    switch (format) {
+        case ImageFormat::BMP:
+            return "bmp";
+        case ImageFormat::QOI:
+            return "qoi";
+        case ImageFormat::PNG:
+            return "png";
+    }
+    return "";
+}
+
+RT::ImageWriter::ImageWriter(std::ostream &output, size_t width, size_t height)
+    : width_(width), height_(height), output_(output) {
+    if (width == 0 || height == 0) throw std::invalid_argument("Image must not be empty");
+}
+
+std::unique_ptr<RT::ImageWriter> RT::ImageWriter::Create(RT::ImageFormat format, std::ostream &output, size_t width,
+                                                         size_t height) {
+    switch (format) {
+        case ImageFormat::BMP:
+            return std::make_unique<BmpWriter>(output, width, height);
+        case ImageFormat::QOI:
+            return std::make_unique<QoiWriter>(output, width, height);
+        case ImageFormat::PNG:
+            return std::make_unique<PngWriter>(output, width, height);
+    }
+    throw std::invalid_argument("Unknown image format");
+}
+
+void RT::ImageWriter::WriteRows(const uint32_t *pPixels, size_t rows, size_t pitch) {
+    if (finished_ || rowsWritten_ + rows > height_) throw std::logic_error("More rows written than the image has");
+    if (rows == 0) return;
+    EncodeRows(pPixels, rows, pitch == 0 ? width_ : pitch);
+    rowsWritten_ += rows;
+}
+
+void RT::ImageWriter::Finish() {
+    if (finished_) return;
+    if (rowsWritten_ != height_){
+        throw std::runtime_error("Image is incomplete, " + std::to_string(rowsWritten_) + " of " +
+                                 std::to_string(height_) + " rows written");
+    }
+    EncodeEnd();
+    finished_ = true;
+    output_.flush();
+    if (!output_) throw std::runtime_error("Writing the image failed");
+}
+
+void RT::ImageWriter::Flush(const std::vector<uint8_t> &buffer) {
+    output_.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    if (!output_) throw std::runtime_error("Writing the image failed");
+}
@@ -0,0 +1,70 @@
+/**
+ * @file ImageWriter.h
+ * @brief Defines the ImageWriter interface, incremental encoding of images into BMP, QOI or PNG.
+ */
+#ifndef MAIN_CPP_IMAGEWRITER_H
+#define MAIN_CPP_IMAGEWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace RT{
+    enum class ImageFormat{
+        BMP,
+        QOI,
+        PNG
+    };
+
+    /// \brief Format chosen by the file extension (.bmp, .qoi, .png), throws std::invalid_argument otherwise
+    ImageFormat ImageFormatFromPath(const std::string& path);
+    /// \brief Format by its name, same as the extension without the dot
+    ImageFormat ImageFormatFromName(const std::string& name);
+    /// \brief Lowercase name of the format, also used as the file extension
+    const char* ImageFormatName(ImageFormat format);
+
+    /**
+     * @class ImageWriter
+     * @brief Encodes an image row by row into a stream.
+     *
+     * Pixels are packed as 0xAARRGGBB (the output of ToneMapper), rows go from the top of the image. Every
+     * WriteRows() call encodes its rows into memory and hands them to the stream with a single write, so the
+     * whole image can be passed at once or in bands as they are finished.
+     */
+    class ImageWriter{
+    public:
+        ImageWriter(std::ostream& output, size_t width, size_t height);
+        virtual ~ImageWriter() = default;
+
+        /// \brief Creates the writer of given format, writes the file header right away
+        static std::unique_ptr<ImageWriter> Create(ImageFormat format, std::ostream& output, size_t width,
+                                                   size_t height);
+
+        /// \brief Encodes following rows, pitch is distance between rows in pixels (0 means width)
+        void WriteRows(const uint32_t* pPixels, size_t rows, size_t pitch = 0);
+        /// \brief Ends the file, throws std::runtime_error if some rows are missing
+        void Finish();
+
+        size_t GetWidth() const { return width_; }
+        size_t GetHeight() const { return height_; }
+
+    protected:
+        virtual void EncodeRows(const uint32_t* pPixels, size_t rows, size_t pitch) = 0;
+        virtual void EncodeEnd() {}
+        /// \brief Writes the whole buffer to the stream
+        void Flush(const std::vector<uint8_t>& buffer);
+
+        size_t width_;
+        size_t height_;
+
+    private:
+        std::ostream& output_;
+        size_t rowsWritten_ = 0;
+        bool finished_ = false;
+    };
+}
+
+#endif
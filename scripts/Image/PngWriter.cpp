@@ -0,0 +1,179 @@
+#include "PngWriter.h"
+#include "Deflate.h"
+#include "../Threading/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    constexpr size_t MIN_SEGMENT_ROWS = 8;
+
+    void PutUint32BigEndian(uint8_t* pOut, uint32_t value) {
+        pOut[0] = static_cast<uint8_t>(value >> 24);
+        pOut[1] = static_cast<uint8_t>(value >> 16);
+        pOut[2] = static_cast<uint8_t>(value >> 8);
+        pOut[3] = static_cast<uint8_t>(value);
+    }
+
+    void ToRgb(const uint32_t* pRow, size_t width, uint8_t* pOut) {
+        for (size_t x = 0; x < width; ++x){
+            *pOut++ = static_cast<uint8_t>(pRow[x] >> 16);
+            *pOut++ = static_cast<uint8_t>(pRow[x] >> 8);
+            *pOut++ = static_cast<uint8_t>(pRow[x]);
+        }
+    }
+
+    uint8_t Paeth(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = std::abs(p - a);
+        int pb = std::abs(p - b);
+        int pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+        return static_cast<uint8_t>(pb <= pc ? b : c);
+    }
+
+    /// \brief Filtered value of byte i of the row with filter type 0-4
+    uint8_t Filter(int filter, const uint8_t* pRow, const uint8_t* pPrior, size_t i) {
+        constexpr size_t BPP = 3;
+        int left = i >= BPP ? pRow[i - BPP] : 0;
+        int up = pPrior[i];
+        switch (filter) {
+            case 1:
+                return static_cast<uint8_t>(pRow[i] - left);
+            case 2:
+                return static_cast<uint8_t>(pRow[i] - up);
+            case 3:
+                return static_cast<uint8_t>(pRow[i] - ((left + up) >> 1));
+            case 4:
+                return static_cast<uint8_t>(pRow[i] - Paeth(left, up, i >= BPP ? pPrior[i - BPP] : 0));
+            default:
+                return pRow[i];
+        }
+    }
+
+    /**
+     * Writes filter type and filtered row to pOut, the filter is chosen by the usual heuristic of the smallest
+     * sum of absolute values (bytes taken as signed), which tends to give the best compression.
+     */
+    void FilterRow(const uint8_t* pRow, const uint8_t* pPrior, size_t size, uint8_t* pOut) {
+        constexpr size_t BPP = 3;
+        std::array<uint32_t, 5> costs{};
+        for (size_t i = 0; i < size; ++i){
+            int left = i >= BPP ? pRow[i - BPP] : 0;
+            int up = pPrior[i];
+            int upLeft = i >= BPP ? pPrior[i - BPP] : 0;
+            costs[0] += std::abs(static_cast<int8_t>(pRow[i]));
+            costs[1] += std::abs(static_cast<int8_t>(pRow[i] - left));
+            costs[2] += std::abs(static_cast<int8_t>(pRow[i] - up));
+            costs[3] += std::abs(static_cast<int8_t>(pRow[i] - ((left + up) >> 1)));
+            costs[4] += std::abs(static_cast<int8_t>(pRow[i] - Paeth(left, up, upLeft)));
+        }
+        int bestFilter = static_cast<int>(std::min_element(costs.begin(), costs.end()) - costs.begin());
+        pOut[0] = static_cast<uint8_t>(bestFilter);
+        for (size_t i = 0; i < size; ++i) pOut[i + 1] = Filter(bestFilter, pRow, pPrior, i);
+    }
+
+    struct Segment{
+        std::vector<uint8_t> compressed;
+        uint32_t adler = 1;
+        size_t size = 0;
+    };
+}
+
+RT::PngWriter::PngWriter(std::ostream &output, size_t width, size_t height)
+    : PngWriter(output, width, height, &ThreadPool::Shared()) {}
+
+RT::PngWriter::PngWriter(std::ostream &output, size_t width, size_t height, ThreadPool *pPool)
+    : ImageWriter(output, width, height), pPool_(pPool) {
+    if (width > static_cast<size_t>(std::numeric_limits<int32_t>::max()) ||
+        height > static_cast<size_t>(std::numeric_limits<int32_t>::max())){
+        throw std::invalid_argument("Image is too large for PNG");
+    }
+    rowBytes_ = width * 3;
+    previousRow_.assign(rowBytes_, 0);
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    buffer_.assign(signature, signature + 8);
+    uint8_t header[13];
+    PutUint32BigEndian(header, static_cast<uint32_t>(width));
+    PutUint32BigEndian(header + 4, static_cast<uint32_t>(height));
+    header[8] = 8;  // bit depth
+    header[9] = 2;  // RGB
+    header[10] = 0; // deflate
+    header[11] = 0; // adaptive filtering
+    header[12] = 0; // no interlace
+    AppendChunk("IHDR", header, sizeof(header));
+    Flush(buffer_);
+}
+
+void RT::PngWriter::EncodeRows(const uint32_t *pPixels, size_t rows, size_t pitch) {
+    size_t segmentRows = std::max(MIN_SEGMENT_ROWS, SEGMENT_BYTES / (rowBytes_ + 1));
+    size_t segmentCount = (rows + segmentRows - 1) / segmentRows;
+    std::vector<Segment> segments(segmentCount);
+
+    auto encodeSegment = [&](size_t index) {
+        size_t firstRow = index * segmentRows;
+        size_t lastRow = std::min(firstRow + segmentRows, rows);
+        std::vector<uint8_t> prior(rowBytes_), current(rowBytes_);
+        if (firstRow == 0) prior = previousRow_;
+        else ToRgb(pPixels + (firstRow - 1) * pitch, width_, prior.data());
+
+        std::vector<uint8_t> filtered((lastRow - firstRow) * (rowBytes_ + 1));
+        for (size_t row = firstRow; row < lastRow; ++row){
+            ToRgb(pPixels + row * pitch, width_, current.data());
+            FilterRow(current.data(), prior.data(), rowBytes_, filtered.data() + (row - firstRow) * (rowBytes_ + 1));
+            std::swap(prior, current);
+        }
+
+        Segment& segment = segments[index];
+        segment.size = filtered.size();
+        segment.adler = Deflate::Adler32(filtered.data(), filtered.size());
+        Deflate::CompressSegment(filtered.data(), filtered.size(), segment.compressed);
+    };
+    if (pPool_ && segmentCount > 1){
+        pPool_->ParallelFor(segmentCount, encodeSegment);
+    } else{
+        for (size_t i = 0; i < segmentCount; ++i) encodeSegment(i);
+    }
+
+    buffer_.clear();
+    for (size_t i = 0; i < segmentCount; ++i){
+        Segment& segment = segments[i];
+        if (!headerWritten_){
+            // zlib header: deflate with 32 KiB window, no dictionary
+            segment.compressed.insert(segment.compressed.begin(), {0x78, 0x01});
+            headerWritten_ = true;
+        }
+        adler_ = Deflate::Adler32Combine(adler_, segment.adler, segment.size);
+        AppendChunk("IDAT", segment.compressed.data(), segment.compressed.size());
+    }
+    ToRgb(pPixels + (rows - 1) * pitch, width_, previousRow_.data());
+    Flush(buffer_);
+}
+
+void RT::PngWriter::EncodeEnd() {
+    std::vector<uint8_t> data;
+    if (!headerWritten_) data = {0x78, 0x01};
+    Deflate::AppendFinalBlock(data);
+    uint8_t adler[4];
+    PutUint32BigEndian(adler, adler_);
+    data.insert(data.end(), adler, adler + 4);
+
+    buffer_.clear();
+    AppendChunk("IDAT", data.data(), data.size());
+    AppendChunk("IEND", nullptr, 0);
+    Flush(buffer_);
+}
+
+void RT::PngWriter::AppendChunk(const char *type, const uint8_t *pData, size_t size) {
+    size_t start = buffer_.size();
+    buffer_.resize(start + 12 + size);
+    uint8_t* pChunk = buffer_.data() + start;
+    PutUint32BigEndian(pChunk, static_cast<uint32_t>(size));
+    std::copy_n(type, 4, pChunk + 4);
+    if (size > 0) std::copy_n(pData, size, pChunk + 8);
+    // CRC covers the type and the data
+    PutUint32BigEndian(pChunk + 8 + size, Deflate::Crc32(pChunk + 4, size + 4));
+}
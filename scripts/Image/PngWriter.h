@@ -0,0 +1,47 @@
+/**
+ * @file PngWriter.h
+ * @brief Defines the PngWriter class, PNG output with deflate compression spread over threads.
+ */
+#ifndef MAIN_CPP_PNGWRITER_H
+#define MAIN_CPP_PNGWRITER_H
+
+#include "ImageWriter.h"
+
+class ThreadPool;
+
+namespace RT{
+    /**
+     * @class PngWriter
+     * @brief 8-bit RGB PNG encoder.
+     *
+     * Rows passed to WriteRows() are split into segments of roughly SEGMENT_BYTES, every segment is filtered and
+     * compressed by its own task (see Deflate::CompressSegment()) and written as one IDAT chunk. The Adler-32
+     * checksums of segments are combined, so only the final block and the checksum are written in Finish().
+     */
+    class PngWriter : public ImageWriter{
+    public:
+        /// \brief Uncompressed size of one independently compressed segment
+        static constexpr size_t SEGMENT_BYTES = 256 * 1024;
+
+        /// \brief pPool == nullptr compresses on the calling thread only
+        PngWriter(std::ostream& output, size_t width, size_t height, ThreadPool* pPool);
+        PngWriter(std::ostream& output, size_t width, size_t height);
+
+    private:
+        void EncodeRows(const uint32_t* pPixels, size_t rows, size_t pitch) override;
+        void EncodeEnd() override;
+        /// \brief Appends chunk length, type, data and CRC to buffer_
+        void AppendChunk(const char* type, const uint8_t* pData, size_t size);
+
+        ThreadPool* pPool_;
+        /// \brief Bytes of one RGB row without the filter byte
+        size_t rowBytes_;
+        /// \brief Last row of the previous WriteRows() call, the first filtered row depends on it
+        std::vector<uint8_t> previousRow_;
+        uint32_t adler_ = 1;
+        bool headerWritten_ = false;
+        std::vector<uint8_t> buffer_;
+    };
+}
+
+#endif
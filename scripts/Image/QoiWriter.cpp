@@ -0,0 +1,94 @@
+#include "QoiWriter.h"
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    constexpr uint8_t QOI_OP_INDEX = 0x00;
+    constexpr uint8_t QOI_OP_DIFF = 0x40;
+    constexpr uint8_t QOI_OP_LUMA = 0x80;
+    constexpr uint8_t QOI_OP_RUN = 0xC0;
+    constexpr uint8_t QOI_OP_RGB = 0xFE;
+    constexpr int MAX_RUN = 62;
+
+    void PutUint32BigEndian(std::vector<uint8_t>& buffer, uint32_t value) {
+        buffer.push_back(static_cast<uint8_t>(value >> 24));
+        buffer.push_back(static_cast<uint8_t>(value >> 16));
+        buffer.push_back(static_cast<uint8_t>(value >> 8));
+        buffer.push_back(static_cast<uint8_t>(value));
+    }
+}
+
+RT::QoiWriter::QoiWriter(std::ostream &output, size_t width, size_t height) : ImageWriter(output, width, height) {
+    if (width > std::numeric_limits<uint32_t>::max() || height > std::numeric_limits<uint32_t>::max()){
+        throw std::invalid_argument("Image is too large for QOI");
+    }
+    std::vector<uint8_t> header = {'q', 'o', 'i', 'f'};
+    PutUint32BigEndian(header, static_cast<uint32_t>(width));
+    PutUint32BigEndian(header, static_cast<uint32_t>(height));
+    // RGB, sRGB with linear alpha
+    header.push_back(3);
+    header.push_back(0);
+    Flush(header);
+}
+
+void RT::QoiWriter::EncodeRows(const uint32_t *pPixels, size_t rows, size_t pitch) {
+    // Worst case is 4 bytes per pixel (QOI_OP_RGB)
+    buffer_.resize(width_ * rows * 4);
+    uint8_t* pOut = buffer_.data();
+    for (size_t y = 0; y < rows; ++y){
+        const uint32_t* pRow = pPixels + y * pitch;
+        for (size_t x = 0; x < width_; ++x){
+            uint32_t pixel = pRow[x] | 0xFF000000;
+            if (pixel == previous_){
+                if (++run_ == MAX_RUN){
+                    *pOut++ = QOI_OP_RUN | (run_ - 1);
+                    run_ = 0;
+                }
+                continue;
+            }
+            if (run_ > 0){
+                *pOut++ = QOI_OP_RUN | (run_ - 1);
+                run_ = 0;
+            }
+
+            uint8_t r = static_cast<uint8_t>(pixel >> 16);
+            uint8_t g = static_cast<uint8_t>(pixel >> 8);
+            uint8_t b = static_cast<uint8_t>(pixel);
+            int hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+            if (index_[hash] == pixel){
+                *pOut++ = QOI_OP_INDEX | hash;
+            } else{
+                index_[hash] = pixel;
+                int8_t dr = static_cast<int8_t>(r - static_cast<uint8_t>(previous_ >> 16));
+                int8_t dg = static_cast<int8_t>(g - static_cast<uint8_t>(previous_ >> 8));
+                int8_t db = static_cast<int8_t>(b - static_cast<uint8_t>(previous_));
+                int8_t drg = static_cast<int8_t>(dr - dg);
+                int8_t dbg = static_cast<int8_t>(db - dg);
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1){
+                    *pOut++ = QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+                } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7){
+                    *pOut++ = QOI_OP_LUMA | (dg + 32);
+                    *pOut++ = static_cast<uint8_t>(((drg + 8) << 4) | (dbg + 8));
+                } else{
+                    *pOut++ = QOI_OP_RGB;
+                    *pOut++ = r;
+                    *pOut++ = g;
+                    *pOut++ = b;
+                }
+            }
+            previous_ = pixel;
+        }
+    }
+    buffer_.resize(pOut - buffer_.data());
+    Flush(buffer_);
+}
+
+void RT::QoiWriter::EncodeEnd() {
+    buffer_.clear();
+    if (run_ > 0){
+        buffer_.push_back(QOI_OP_RUN | (run_ - 1));
+        run_ = 0;
+    }
+    buffer_.insert(buffer_.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    Flush(buffer_);
+}
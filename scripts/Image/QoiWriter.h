@@ -0,0 +1,33 @@
+/**
+ * @file QoiWriter.h
+ * @brief Defines the QoiWriter class, "Quite OK Image" lossless output.
+ */
+#ifndef MAIN_CPP_QOIWRITER_H
+#define MAIN_CPP_QOIWRITER_H
+
+#include <array>
+#include "ImageWriter.h"
+
+namespace RT{
+    /**
+     * @class QoiWriter
+     * @brief QOI encoder (https://qoiformat.org) with 3 channels, single pass with no lookahead, so it's fast
+     * and the encoder state simply continues between WriteRows() calls.
+     */
+    class QoiWriter : public ImageWriter{
+    public:
+        QoiWriter(std::ostream& output, size_t width, size_t height);
+
+    private:
+        void EncodeRows(const uint32_t* pPixels, size_t rows, size_t pitch) override;
+        void EncodeEnd() override;
+
+        /// \brief Previously seen pixels, indexed by their hash
+        std::array<uint32_t, 64> index_{};
+        uint32_t previous_ = 0xFF000000;
+        int run_ = 0;
+        std::vector<uint8_t> buffer_;
+    };
+}
+
+#endif
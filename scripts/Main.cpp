@@ -1,12 +1,58 @@
 #include "App.h"
+#include "RayTrace/Trace.h"
 #include "LinearAlgebra/Vector.h"
 #include <iostream>
 #include <vector>
 #include <sstream>
+#include <string>
 
 using namespace std;
 
 int main(int argc, char* argv[]){
-    App app;
-    return app.Execute();
-}
\ No newline at end of file
+    string outputPath = "output.bmp";
+    bool heatmaps = false;
+    string tracePath;
+    for (int i = 1; i < argc; ++i){
+        string argument = argv[i];
+        if ((argument == "--output" || argument == "-o") && i + 1 < argc){
+            outputPath = argv[++i];
+        } else if (argument == "--heatmap"){
+            heatmaps = true;
+        } else if (argument == "--trace" && i + 1 < argc){
+            tracePath = argv[++i];
+        } else{
+            cout << "Usage: " << argv[0] << " [--output PATH] [--heatmap] [--trace PATH]\n"
+                 << "  --output PATH  where the finished image is saved, .bmp, .qoi or .png (default output.bmp)\n"
+                 << "  --heatmap      also saves box tests, triangle tests and time per pixel as false-colour\n"
+                 << "                 images next to it (output.boxes.bmp, output.triangles.bmp, output.time.bmp)\n"
+                 << "  --trace PATH   writes a timeline of scene build, OBJ loads, tiles, encoding and display\n"
+                 << "                 uploads of every thread as a Chrome trace (chrome://tracing, ui.perfetto.dev)\n";
+            return argument == "--help" ? 0 : 1;
+        }
+    }
+    try {
+        RT::ImageFormatFromPath(outputPath);
+    } catch (const std::exception& e) {
+        cout << e.what() << "\n";
+        return 1;
+    }
+
+    if (!tracePath.empty()){
+        RT::Trace::SetThreadName("main");
+        RT::Trace::Start();
+    }
+    int result;
+    {
+        App app(outputPath, heatmaps);
+        result = app.Execute();
+    }
+    if (!tracePath.empty()){
+        try {
+            RT::Trace::Save(tracePath);
+        } catch (const std::exception& e) {
+            cout << e.what() << "\n";
+            return 1;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,57 @@
+#include "EmbeddedMeshes.h"
+#include "MeshFile.h"
+#include <map>
+#include <mutex>
+
+namespace {
+    struct Image{
+        const unsigned char* pData;
+        size_t size;
+        uint64_t sourceChecksum;
+        std::shared_ptr<const RT::TriangleMesh> pMesh;
+    };
+
+    struct Registry{
+        std::mutex mutex;
+        std::map<std::string, Image> images;
+    };
+
+    // Function-local, so it exists before the first static Registration of any translation unit
+    Registry& GetRegistry() {
+        static Registry registry;
+        return registry;
+    }
+}
+
+void EmbeddedMeshes::Register(const char *name, const unsigned char *pImage, size_t size, uint64_t sourceChecksum) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.images[name] = Image{pImage, size, sourceChecksum, nullptr};
+}
+
+std::shared_ptr<const RT::TriangleMesh> EmbeddedMeshes::Get(const std::string &name) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.images.find(name);
+    if (it == registry.images.end()) return nullptr;
+    Image& image = it->second;
+    if (!image.pMesh){
+        // The arrays live as long as the process, nothing has to own them
+        image.pMesh = MeshFile::View(reinterpret_cast<const char*>(image.pData), image.size, nullptr, false,
+                                     "embedded " + name);
+    }
+    return image.pMesh;
+}
+
+bool EmbeddedMeshes::Contains(const std::string &name) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.images.count(name) != 0;
+}
+
+uint64_t EmbeddedMeshes::GetSourceChecksum(const std::string &name) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.images.find(name);
+    return it == registry.images.end() ? 0 : it->second.sourceChecksum;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file EmbeddedMeshes.h
+ * @brief Defines the EmbeddedMeshes class, mesh images linked into the executable.
+ */
+#ifndef MAIN_CPP_EMBEDDEDMESHES_H
+#define MAIN_CPP_EMBEDDEDMESHES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../RayTrace/Objects.h"
+
+/**
+ * @class EmbeddedMeshes
+ * @brief Registry of MeshFile images compiled into the executable as constant arrays.
+ *
+ * The images are written by RealChess-EmbedPieces at build time into a generated source file, whose static
+ * Registration objects add them before main() runs. Meshes view the arrays in place, so getting one reads no file
+ * and parses nothing.
+ */
+class EmbeddedMeshes{
+public:
+    /// \brief Registers an image at static initialisation, the arrays have to be 64 byte aligned
+    struct Registration{
+        Registration(const char* name, const unsigned char* pImage, size_t size, uint64_t sourceChecksum) {
+            Register(name, pImage, size, sourceChecksum);
+        }
+    };
+
+    static void Register(const char* name, const unsigned char* pImage, size_t size, uint64_t sourceChecksum);
+    /// \brief Mesh viewing the image of name, created on the first request, null if the build has none
+    static std::shared_ptr<const RT::TriangleMesh> Get(const std::string& name);
+    static bool Contains(const std::string& name);
+    /// \brief Checksum of the OBJ file and load options the image was converted from (MeshFile::SourceChecksum())
+    static uint64_t GetSourceChecksum(const std::string& name);
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "MappedFile.h"
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Error opening file: " + path);
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)){
+        CloseHandle(file);
+        throw std::runtime_error("Error reading file: " + path);
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ > 0){
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) pData_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (mapping) CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) throw std::runtime_error("Error opening file: " + path);
+    struct stat status{};
+    if (fstat(file, &status) != 0){
+        close(file);
+        throw std::runtime_error("Error reading file: " + path);
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    if (size_ > 0){
+        void* pMapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+        if (pMapping != MAP_FAILED){
+            pData_ = static_cast<const char*>(pMapping);
+            madvise(pMapping, size_, MADV_SEQUENTIAL);
+        }
+    }
+    close(file);
+#endif
+    if (size_ > 0 && !pData_) throw std::runtime_error("Error mapping file: " + path);
+}
+
+MappedFile::~MappedFile() {
+    Unmap();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : pData_(std::exchange(other.pData_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other){
+        Unmap();
+        pData_ = std::exchange(other.pData_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+std::string MappedFile::TemporaryPath(const std::string &path) {
+    static std::atomic<uint64_t> counter{0};
+#ifdef _WIN32
+    unsigned long processId = GetCurrentProcessId();
+#else
+    unsigned long processId = static_cast<unsigned long>(getpid());
+#endif
+    return path + "." + std::to_string(processId) + "." + std::to_string(counter++) + ".tmp";
+}
+
+void MappedFile::Unmap() {
+    if (!pData_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(pData_);
+#else
+    munmap(const_cast<char*>(pData_), size_);
+#endif
+    pData_ = nullptr;
+}
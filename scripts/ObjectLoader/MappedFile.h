@@ -0,0 +1,47 @@
+/**
+ * @file MappedFile.h
+ * @brief Defines the MappedFile class, a read-only memory mapping of a whole file.
+ */
+#ifndef MAIN_CPP_MAPPEDFILE_H
+#define MAIN_CPP_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief Maps a file into memory for reading, so loaders parse it in place without copying it into streams.
+ *
+ * The mapping lives as long as the object, it can be moved but not copied. Empty files give an empty range.
+ */
+class MappedFile{
+public:
+    /// \brief Maps the whole file, throws std::runtime_error if it can't be opened or mapped
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* GetData() const { return pData_; }
+    size_t GetSize() const { return size_; }
+    const char* begin() const { return pData_; }
+    const char* end() const { return pData_ + size_; }
+
+    /**
+     * @brief Unique name next to path (process id and a counter) for writing a file which then replaces path.
+     *
+     * Threads and processes sharing a directory never write the same temporary file, and renaming it over path
+     * (std::filesystem::rename) replaces the old file at once, readers see either of them but never none.
+     */
+    static std::string TemporaryPath(const std::string& path);
+
+private:
+    void Unmap();
+
+    const char* pData_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "MeshCache.h"
+#include "MeshFile.h"
+#include "../Threading/ThreadPool.h"
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+MeshCache &MeshCache::Shared() {
+    static MeshCache cache;
+    return cache;
+}
+
+std::shared_ptr<const RT::TriangleMesh> MeshCache::Get(const std::string &path, const ObjLoadOptions &options,
+                                                       const std::string &variant, const Prepare &prepare) {
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(path, error);
+    if (error) throw std::runtime_error("Error opening file: " + path);
+    std::string key = path + '\n' + std::to_string(options.flipVertices) + std::to_string(options.normals) +
+                      std::to_string(options.texCoords) + std::to_string(options.optimizeLayout) + std::to_string(options.lods) + ' ' +
+                      std::to_string(options.weldTolerance) + '\n' + variant;
+
+    std::promise<std::shared_ptr<const RT::TriangleMesh>> promise;
+    std::shared_future<std::shared_ptr<const RT::TriangleMesh>> cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end() && it->second.modified == modified){
+            cached = it->second.mesh;
+        } else{
+            entries_[key] = Entry{modified, promise.get_future().share()};
+        }
+    }
+    if (cached.valid()){
+        // Waits outside the lock if another thread is still loading the file
+        ++hits_;
+        return cached.get();
+    }
+    ++loads_;
+    try {
+        std::shared_ptr<RT::TriangleMesh> pMesh;
+        if (path.size() >= std::strlen(MeshFile::EXTENSION) &&
+            path.compare(path.size() - std::strlen(MeshFile::EXTENSION), std::string::npos, MeshFile::EXTENSION) == 0){
+            // Converted meshes already carry their load options
+            pMesh = MeshFile::Load(path);
+        } else{
+            pMesh = ObjLoader::loadTriangleMeshObj(path, options);
+        }
+        if (prepare) prepare(*pMesh);
+        promise.set_value(pMesh);
+        return pMesh;
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end() && it->second.modified == modified) entries_.erase(it);
+        throw;
+    }
+}
+
+void MeshCache::Prewarm(const std::vector<std::string> &paths, const ObjLoadOptions &options) {
+    ThreadPool::Shared().ParallelFor(paths.size(), [&](size_t i) {
+        Get(paths[i], options);
+    });
+}
+
+void MeshCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+size_t MeshCache::GetSize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
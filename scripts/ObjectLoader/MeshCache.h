@@ -0,0 +1,69 @@
+/**
+ * @file MeshCache.h
+ * @brief Defines the MeshCache class, loaded meshes shared by all scenes of the process.
+ */
+#ifndef MAIN_CPP_MESHCACHE_H
+#define MAIN_CPP_MESHCACHE_H
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ObjLoader.h"
+
+/**
+ * @class MeshCache
+ * @brief Thread-safe cache of loaded and prepared meshes, keyed by path, load options and file modification time.
+ *
+ * Meshes are handed out as shared immutable objects with edges and normals already computed, every caller of the
+ * same key gets the same instance. A file is parsed once per process, concurrent requests for it wait for the
+ * first load instead of parsing it again. A changed modification time reloads the file on the next request,
+ * meshes handed out earlier stay valid. Failed loads are not cached. Paths ending in `.rtmesh` are mapped by
+ * MeshFile instead of parsed, the load options are ignored for them.
+ */
+class MeshCache{
+public:
+    /// \brief Runs once on a freshly loaded mesh before it's shared, e.g. fitting it to a board square
+    using Prepare = std::function<void(RT::TriangleMesh&)>;
+
+    /// \brief Process-wide cache used by Chessboard
+    static MeshCache& Shared();
+
+    /**
+     * @brief Returns the mesh loaded from path, loading it on the first request.
+     *
+     * Meshes prepared differently need different variant names, the variant is part of the key. Throws
+     * std::runtime_error if the file can't be read or parsed.
+     */
+    std::shared_ptr<const RT::TriangleMesh> Get(const std::string& path, const ObjLoadOptions& options = {},
+                                                const std::string& variant = "", const Prepare& prepare = nullptr);
+    /// \brief Loads the files on the ThreadPool so the first scene doesn't wait for them
+    void Prewarm(const std::vector<std::string>& paths, const ObjLoadOptions& options = {});
+    /// \brief Drops all meshes, the ones still in use stay alive until released
+    void Clear();
+
+    size_t GetSize();
+    /// \brief Requests answered without loading
+    size_t GetHits() const { return hits_; }
+    /// \brief Requests which loaded the file
+    size_t GetLoads() const { return loads_; }
+
+private:
+    struct Entry{
+        std::filesystem::file_time_type modified;
+        std::shared_future<std::shared_ptr<const RT::TriangleMesh>> mesh;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, Entry> entries_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> loads_{0};
+};
+
+#endif
@@ -0,0 +1,302 @@
+#include "MeshFile.h"
+#include "MappedFile.h"
+#include "../Image/Deflate.h"
+#include "../RayTrace/Trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+    constexpr char MAGIC[8] = {'R', 'T', 'M', 'E', 'S', 'H', '\0', '\0'};
+    constexpr uint64_t SECTION_ALIGNMENT = 64;
+    constexpr uint32_t AUTHORED_NORMALS = 1;
+
+    enum Section{
+        VERTICES,
+        TRIANGLES,
+        EDGES,
+        NORMALS,
+        VERTEX_NORMALS,
+        BVH,
+        TEX_COORDS,
+        LODS,
+        SECTION_COUNT
+    };
+
+    /// \brief Image of a level of detail inside the file, offset from the start of the image it belongs to
+    struct LodEntry{
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct SectionEntry{
+        uint64_t offset;
+        uint64_t count;
+        uint32_t elementSize;
+        uint32_t reserved;
+    };
+
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t flags;
+        uint32_t dataCrc;
+        uint64_t sourceChecksum;
+        double featureSize;
+        SectionEntry sections[SECTION_COUNT];
+    };
+
+    // Sections are viewed as arrays of these types, they must stay plain aggregates of doubles and ints
+    static_assert(sizeof(Vec3D) == 3 * sizeof(double) && std::is_standard_layout_v<Vec3D>);
+    static_assert(sizeof(Vector<int, 3>) == 3 * sizeof(int) && std::is_standard_layout_v<Vector<int, 3>>);
+    static_assert(sizeof(std::pair<Vec3D, Vec3D>) == 2 * sizeof(Vec3D));
+    static_assert(sizeof(Vector<double, 2>) == 2 * sizeof(double));
+    static_assert(std::is_trivially_copyable_v<RT::MeshBvhNode>);
+
+    constexpr uint32_t ELEMENT_SIZES[SECTION_COUNT] = {
+            sizeof(Vec3D), sizeof(Vector<int, 3>), sizeof(std::pair<Vec3D, Vec3D>), sizeof(Vec3D), sizeof(Vec3D),
+            sizeof(RT::MeshBvhNode), sizeof(Vector<double, 2>), sizeof(LodEntry)
+    };
+
+    uint64_t AlignUp(uint64_t value) {
+        return (value + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+
+    /// \brief Checks the header and that all sections lie inside the image of size bytes
+    const Header& ValidateHeader(const char* pImage, size_t size, const std::string& name) {
+        if (size < sizeof(Header)) throw std::runtime_error("Not a mesh file: " + name);
+        const auto& header = *reinterpret_cast<const Header*>(pImage);
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) throw std::runtime_error("Not a mesh file: " + name);
+        if (header.version != MeshFile::VERSION || header.headerSize != sizeof(Header)){
+            throw std::runtime_error("Unsupported mesh file version " + std::to_string(header.version) + ": " + name);
+        }
+        for (size_t i = 0; i < SECTION_COUNT; ++i){
+            const SectionEntry& section = header.sections[i];
+            if (section.elementSize != ELEMENT_SIZES[i]){
+                throw std::runtime_error("Mesh file was written with a different data layout: " + name);
+            }
+            if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > size ||
+                section.count > (size - section.offset) / section.elementSize){
+                throw std::runtime_error("Mesh file is truncated or corrupted: " + name);
+            }
+        }
+        return header;
+    }
+
+    /**
+     * Checks that every triangle indexes existing vertices and that the BVH is a depth first tree the traversal
+     * can walk: children after their parent, leaves inside the triangles and no deeper than MeshBvh::MAX_DEPTH.
+     * One linear pass, so files trusted without their CRC still can't make the renderer read out of bounds.
+     */
+    void ValidateIndices(const Header& header, const char* pImage, const std::string& name) {
+        const SectionEntry* pSections = header.sections;
+        const auto* pTriangles = reinterpret_cast<const Vector<int, 3>*>(pImage + pSections[TRIANGLES].offset);
+        uint64_t vertexCount = pSections[VERTICES].count;
+        for (size_t i = 0; i < pSections[TRIANGLES].count; ++i){
+            for (size_t k = 0; k < 3; ++k){
+                if (pTriangles[i][k] < 0 || static_cast<uint64_t>(pTriangles[i][k]) >= vertexCount){
+                    throw std::runtime_error("Mesh file triangle indices are out of range: " + name);
+                }
+            }
+        }
+
+        const auto* pNodes = reinterpret_cast<const RT::MeshBvhNode*>(pImage + pSections[BVH].offset);
+        uint64_t nodeCount = pSections[BVH].count;
+        uint64_t triangleCount = pSections[TRIANGLES].count;
+        std::vector<uint8_t> depths(nodeCount, 0);
+        for (size_t i = 0; i < nodeCount; ++i){
+            const RT::MeshBvhNode& node = pNodes[i];
+            if (node.IsLeaf()){
+                if (static_cast<uint64_t>(node.first) + node.count > triangleCount){
+                    throw std::runtime_error("Mesh file BVH leaf is out of range: " + name);
+                }
+                continue;
+            }
+            if (i + 1 >= nodeCount || node.first <= i + 1 || node.first >= nodeCount ||
+                depths[i] + 1u >= RT::MeshBvh::MAX_DEPTH){
+                throw std::runtime_error("Mesh file BVH is corrupted: " + name);
+            }
+            depths[i + 1] = std::max<uint8_t>(depths[i + 1], depths[i] + 1);
+            depths[node.first] = std::max<uint8_t>(depths[node.first], depths[i] + 1);
+        }
+    }
+
+    template<typename T>
+    RT::MeshArray<T> ViewSection(const Header& header, Section section, const char* pImage,
+                                 const std::shared_ptr<const void>& pOwner) {
+        const SectionEntry& entry = header.sections[section];
+        return RT::MeshArray<T>::View(reinterpret_cast<const T*>(pImage + entry.offset), entry.count, pOwner);
+    }
+}
+
+void MeshFile::Append(const RT::TriangleMesh &mesh, std::vector<uint8_t> &data, uint64_t sourceChecksum) {
+    if (data.size() % SECTION_ALIGNMENT != 0) throw std::invalid_argument("Mesh image must start 64 byte aligned");
+    if (mesh.GetCompact()) throw std::invalid_argument("Compacted meshes can't be written, save them before");
+    const std::pair<const void*, size_t> arrays[LODS] = {
+            {mesh.GetVertices().data(), mesh.GetVertices().size()},
+            {mesh.GetTriangles().data(), mesh.GetTriangles().size()},
+            {mesh.GetEdges().data(), mesh.GetEdges().size()},
+            {mesh.GetNormals().data(), mesh.GetNormals().size()},
+            {mesh.GetVertexNormals().data(), mesh.GetVertexNormals().size()},
+            {mesh.GetBvh().data(), mesh.GetBvh().size()},
+            {mesh.GetTexCoords().data(), mesh.GetTexCoords().size()},
+    };
+
+    Header header{};
+    std::copy(MAGIC, MAGIC + sizeof(MAGIC), header.magic);
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    header.flags = mesh.HasAuthoredNormals() ? AUTHORED_NORMALS : 0;
+    header.sourceChecksum = sourceChecksum;
+    header.featureSize = mesh.GetFeatureSize();
+    size_t imageStart = data.size();
+    data.resize(imageStart + sizeof(Header));
+    for (size_t i = 0; i < LODS; ++i){
+        uint64_t offset = AlignUp(data.size() - imageStart);
+        data.resize(imageStart + offset);
+        header.sections[i] = SectionEntry{offset, arrays[i].second, ELEMENT_SIZES[i], 0};
+        const auto* pBytes = static_cast<const uint8_t*>(arrays[i].first);
+        data.insert(data.end(), pBytes, pBytes + arrays[i].second * ELEMENT_SIZES[i]);
+    }
+    // Levels of detail are complete images of their own after the table pointing to them
+    const auto& lods = mesh.GetLods();
+    uint64_t tableOffset = AlignUp(data.size() - imageStart);
+    header.sections[LODS] = SectionEntry{tableOffset, lods.size(), ELEMENT_SIZES[LODS], 0};
+    std::vector<LodEntry> table;
+    data.resize(imageStart + tableOffset + lods.size() * sizeof(LodEntry));
+    for (const auto& pLod : lods){
+        data.resize(imageStart + AlignUp(data.size() - imageStart));
+        size_t lodStart = data.size();
+        Append(*pLod, data);
+        table.push_back(LodEntry{lodStart - imageStart, data.size() - lodStart});
+    }
+    if (!table.empty()) std::memcpy(data.data() + imageStart + tableOffset, table.data(), table.size() * sizeof(LodEntry));
+    const uint8_t* pPayload = data.data() + imageStart + sizeof(Header);
+    header.dataCrc = RT::Deflate::Crc32(pPayload, data.size() - imageStart - sizeof(Header));
+    std::memcpy(data.data() + imageStart, &header, sizeof(header));
+}
+
+void MeshFile::Save(const RT::TriangleMesh &mesh, const std::string &path, uint64_t sourceChecksum) {
+    TRACE_SCOPE_DETAIL("Mesh save", path);
+    std::vector<uint8_t> data;
+    Append(mesh, data, sourceChecksum);
+
+    std::string temporaryPath = MappedFile::TemporaryPath(path);
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) throw std::runtime_error("Error opening file: " + temporaryPath);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        file.flush();
+        if (!file){
+            std::remove(temporaryPath.c_str());
+            throw std::runtime_error("Writing mesh file failed: " + temporaryPath);
+        }
+    }
+    // Replaces an existing file in one step, also on Windows unlike std::rename
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error){
+        std::remove(temporaryPath.c_str());
+        throw std::runtime_error("Replacing mesh file failed: " + path);
+    }
+}
+
+std::shared_ptr<RT::TriangleMesh> MeshFile::Load(const std::string &path, bool verify) {
+    TRACE_SCOPE_DETAIL("Mesh load", path);
+    auto pFile = std::make_shared<MappedFile>(path);
+    return View(pFile->GetData(), pFile->GetSize(), pFile, verify, path);
+}
+
+std::shared_ptr<RT::TriangleMesh> MeshFile::View(const char *pImage, size_t size, std::shared_ptr<const void> pOwner,
+                                                 bool verify, const std::string &name) {
+    if (reinterpret_cast<uintptr_t>(pImage) % alignof(RT::MeshBvhNode) != 0){
+        throw std::invalid_argument("Mesh image is not aligned: " + name);
+    }
+    const Header& header = ValidateHeader(pImage, size, name);
+    if (verify){
+        const auto* pData = reinterpret_cast<const uint8_t*>(pImage) + sizeof(Header);
+        if (RT::Deflate::Crc32(pData, size - sizeof(Header)) != header.dataCrc){
+            throw std::runtime_error("Mesh file checksum mismatch: " + name);
+        }
+    }
+    const SectionEntry* pSections = header.sections;
+    if (pSections[EDGES].count != pSections[TRIANGLES].count || pSections[NORMALS].count != pSections[TRIANGLES].count ||
+        pSections[VERTEX_NORMALS].count != pSections[VERTICES].count ||
+        (pSections[TEX_COORDS].count != 0 && pSections[TEX_COORDS].count != pSections[VERTICES].count) ||
+        (pSections[BVH].count == 0) != (pSections[TRIANGLES].count == 0)){
+        throw std::runtime_error("Mesh file sections don't match: " + name);
+    }
+    ValidateIndices(header, pImage, name);
+
+    RT::MeshArrays arrays;
+    arrays.vertices = ViewSection<Vec3D>(header, VERTICES, pImage, pOwner);
+    arrays.triangles = ViewSection<Vector<int, 3>>(header, TRIANGLES, pImage, pOwner);
+    arrays.edges = ViewSection<std::pair<Vec3D, Vec3D>>(header, EDGES, pImage, pOwner);
+    arrays.normals = ViewSection<Vec3D>(header, NORMALS, pImage, pOwner);
+    arrays.vertexNormals = ViewSection<Vec3D>(header, VERTEX_NORMALS, pImage, pOwner);
+    arrays.bvh = ViewSection<RT::MeshBvhNode>(header, BVH, pImage, pOwner);
+    arrays.texCoords = ViewSection<Vector<double, 2>>(header, TEX_COORDS, pImage, pOwner);
+    arrays.authoredNormals = (header.flags & AUTHORED_NORMALS) != 0;
+    arrays.featureSize = header.featureSize;
+    auto pMesh = std::make_shared<RT::TriangleMesh>(std::move(arrays));
+
+    // The CRC of this image covers the levels as well. Levels lie after all sections of this image, so every
+    // nested image is smaller and viewing them always ends
+    const auto* pTable = reinterpret_cast<const LodEntry*>(pImage + pSections[LODS].offset);
+    uint64_t sectionsEnd = sizeof(Header);
+    for (size_t i = 0; i < SECTION_COUNT; ++i){
+        sectionsEnd = std::max(sectionsEnd, pSections[i].offset + pSections[i].count * pSections[i].elementSize);
+    }
+    std::vector<std::shared_ptr<RT::TriangleMesh>> lods;
+    for (size_t i = 0; i < pSections[LODS].count; ++i){
+        const LodEntry& entry = pTable[i];
+        if (entry.offset % SECTION_ALIGNMENT != 0 || entry.offset < sectionsEnd || entry.offset > size ||
+            entry.size > size - entry.offset){
+            throw std::runtime_error("Mesh file is truncated or corrupted: " + name);
+        }
+        lods.push_back(View(pImage + entry.offset, entry.size, pOwner, false,
+                            name + " (level of detail " + std::to_string(i + 1) + ")"));
+    }
+    pMesh->SetLods(std::move(lods));
+    return pMesh;
+}
+
+uint64_t MeshFile::ReadSourceChecksum(const std::string &path) {
+    MappedFile file(path);
+    return ValidateHeader(file.GetData(), file.GetSize(), path).sourceChecksum;
+}
+
+uint64_t MeshFile::SourceChecksum(const std::string &objPath, const ObjLoadOptions &options) {
+    MappedFile file(objPath);
+    uint32_t crc = RT::Deflate::Crc32(reinterpret_cast<const uint8_t*>(file.GetData()), file.GetSize());
+    uint64_t optionBits = static_cast<uint64_t>(options.flipVertices) | static_cast<uint64_t>(options.normals) << 1 |
+                          static_cast<uint64_t>(options.texCoords) << 2 |
+                          static_cast<uint64_t>(options.optimizeLayout) << 3 | static_cast<uint64_t>(options.lods) << 4;
+    uint64_t toleranceBits;
+    std::memcpy(&toleranceBits, &options.weldTolerance, sizeof(toleranceBits));
+    // FNV-1a style mixing of the options into the file checksum
+    uint64_t checksum = static_cast<uint64_t>(crc) << 32 ^ static_cast<uint64_t>(file.GetSize());
+    checksum = (checksum ^ optionBits) * 0x100000001b3ull;
+    return (checksum ^ toleranceBits) * 0x100000001b3ull;
+}
+
+bool MeshFile::IsUpToDate(const std::string &meshPath, const std::string &objPath, const ObjLoadOptions &options) {
+    try {
+        return ReadSourceChecksum(meshPath) == SourceChecksum(objPath, options);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+std::shared_ptr<RT::TriangleMesh> MeshFile::Convert(const std::string &objPath, const std::string &meshPath,
+                                                    const ObjLoadOptions &options) {
+    uint64_t checksum = SourceChecksum(objPath, options);
+    auto pMesh = ObjLoader::loadTriangleMeshObj(objPath, options);
+    Save(*pMesh, meshPath, checksum);
+    return pMesh;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file MeshFile.h
+ * @brief Defines the MeshFile class, a binary mesh format loaded by memory mapping without parsing.
+ */
+#ifndef MAIN_CPP_MESHFILE_H
+#define MAIN_CPP_MESHFILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ObjLoader.h"
+
+/**
+ * @class MeshFile
+ * @brief Saves and loads `.rtmesh` files, all arrays of a TriangleMesh laid out for direct use.
+ *
+ * Layout (little endian, native double and int layout):
+ * - header: magic `RTMESH\0\0`, version, header size, flags (bit 0: authored normals), CRC-32 of everything after
+ *   the header, checksum of the source file, feature size, and offset, count and element size of every section
+ * - sections, each starting on a 64 byte boundary: vertices, triangles, edges, face normals, vertex normals,
+ *   BVH nodes (MeshBvh.h) and texture coordinates, in the order of TriangleMesh, then the table of levels of detail
+ *   (offset and size of each)
+ * - levels of detail, each a complete image of this layout starting on a 64 byte boundary
+ *
+ * Loading maps the file and the mesh views the sections in place, nothing is parsed, copied or recomputed until the
+ * mesh is transformed. Triangle indices, BVH nodes and level of detail offsets are always range checked, so files
+ * loaded without verifying the CRC can't make the renderer read outside of them. Files of another version or with
+ * different element sizes (another build layout) are refused. The source checksum identifies the OBJ file and load
+ * options a mesh was converted from, so stale conversions can be detected (IsUpToDate()).
+ */
+class MeshFile{
+public:
+    static constexpr uint32_t VERSION = 2;
+    static constexpr const char* EXTENSION = ".rtmesh";
+
+    /// \brief Writes the mesh, replacing an existing file only once it's complete
+    static void Save(const RT::TriangleMesh& mesh, const std::string& path, uint64_t sourceChecksum = 0);
+    /**
+     * @brief Maps the file and returns a mesh viewing it.
+     *
+     * verify also checks the CRC of the data, which reads the whole file. Throws std::runtime_error on files
+     * which are not valid meshes of this version.
+     */
+    static std::shared_ptr<RT::TriangleMesh> Load(const std::string& path, bool verify = false);
+    /**
+     * @brief Appends the file image of the mesh to data, used to embed meshes in other files.
+     *
+     * data has to end on a 64 byte boundary, section offsets are relative to the start of the image. Compacted
+     * meshes (TriangleMesh::Compact()) throw std::invalid_argument, files always keep full precision.
+     */
+    static void Append(const RT::TriangleMesh& mesh, std::vector<uint8_t>& data, uint64_t sourceChecksum = 0);
+    /**
+     * @brief Returns a mesh viewing the image of size bytes at pImage, kept alive by pOwner.
+     *
+     * The image has to stay mapped as long as pOwner lives and start 8 byte aligned. name is used in errors.
+     */
+    static std::shared_ptr<RT::TriangleMesh> View(const char* pImage, size_t size, std::shared_ptr<const void> pOwner,
+                                                  bool verify, const std::string& name);
+    /// \brief Source checksum stored in the header, throws std::runtime_error like Load()
+    static uint64_t ReadSourceChecksum(const std::string& path);
+
+    /// \brief Checksum of the OBJ file contents and the options it's loaded with
+    static uint64_t SourceChecksum(const std::string& objPath, const ObjLoadOptions& options);
+    /// \brief True if meshPath is a valid mesh converted from the current objPath with the same options
+    static bool IsUpToDate(const std::string& meshPath, const std::string& objPath, const ObjLoadOptions& options);
+    /// \brief Loads the OBJ file, saves it as meshPath and returns the mesh
+    static std::shared_ptr<RT::TriangleMesh> Convert(const std::string& objPath, const std::string& meshPath,
+                                                     const ObjLoadOptions& options = {});
+};
+
+#endif
@@ -0,0 +1,411 @@
+#include "MeshPreprocess.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+    /// \brief Spreads the lowest 21 bits of value to every third bit
+    uint64_t SpreadBits(uint64_t value) {
+        value &= 0x1fffff;
+        value = (value | value << 32) & 0x1f00000000ffffull;
+        value = (value | value << 16) & 0x1f0000ff0000ffull;
+        value = (value | value << 8) & 0x100f00f00f00f00full;
+        value = (value | value << 4) & 0x10c30c30c30c30c3ull;
+        value = (value | value << 2) & 0x1249249249249249ull;
+        return value;
+    }
+
+    /// \brief Sum of squared distances to a set of planes, the symmetric 4x4 matrix of Garland and Heckbert
+    struct Quadric{
+        // xx, xy, xz, xd, yy, yz, yd, zz, zd, dd
+        double q[10] = {};
+
+        void AddPlane(const Vec3D& normal, double distance, double weight) {
+            double a = normal[0], b = normal[1], c = normal[2], d = distance;
+            double terms[10] = {a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d};
+            for (size_t i = 0; i < 10; ++i) q[i] += weight * terms[i];
+        }
+        Quadric& operator+=(const Quadric& other) {
+            for (size_t i = 0; i < 10; ++i) q[i] += other.q[i];
+            return *this;
+        }
+        double Evaluate(const Vec3D& p) const {
+            double x = p[0], y = p[1], z = p[2];
+            return q[0] * x * x + 2. * q[1] * x * y + 2. * q[2] * x * z + 2. * q[3] * x + q[4] * y * y +
+                   2. * q[5] * y * z + 2. * q[6] * y + q[7] * z * z + 2. * q[8] * z + q[9];
+        }
+        /// \brief Point of the smallest error, false if the planes don't determine one
+        bool Minimize(Vec3D& point) const {
+            double det = q[0] * (q[4] * q[7] - q[5] * q[5]) - q[1] * (q[1] * q[7] - q[5] * q[2]) +
+                         q[2] * (q[1] * q[5] - q[4] * q[2]);
+            double trace = q[0] + q[4] + q[7];
+            if (!(std::fabs(det) > 1e-10 * trace * trace * trace)) return false;
+            // Cramer's rule for A p = -b
+            double bx = -q[3], by = -q[6], bz = -q[8];
+            point[0] = (bx * (q[4] * q[7] - q[5] * q[5]) - q[1] * (by * q[7] - q[5] * bz) +
+                        q[2] * (by * q[5] - q[4] * bz)) / det;
+            point[1] = (q[0] * (by * q[7] - bz * q[5]) - bx * (q[1] * q[7] - q[5] * q[2]) +
+                        q[2] * (q[1] * bz - by * q[2])) / det;
+            point[2] = (q[0] * (q[4] * bz - q[5] * by) - q[1] * (q[1] * bz - by * q[2]) +
+                        bx * (q[1] * q[5] - q[4] * q[2])) / det;
+            return true;
+        }
+    };
+
+    /// \brief Borders weigh this much more than faces, so they move only where nothing else is left
+    constexpr double BORDER_WEIGHT = 1000.;
+    /// \brief Collapses turning a face by more than about 78 degrees are refused
+    constexpr double MIN_NORMAL_COSINE = 0.2;
+
+    /// \brief Edge collapse state of Simplify()
+    class Simplifier{
+    public:
+        Simplifier(const std::vector<Vec3D>& vertices, const std::vector<Vector<int, 3>>& triangles)
+            : positions_(vertices), triangles_(triangles), alive_(triangles.size(), true),
+              quadrics_(vertices.size()), vertexFaces_(vertices.size()), versions_(vertices.size(), 0),
+              liveTriangles_(triangles.size()) {}
+
+        std::vector<MeshPreprocess::SimplifiedMesh> Run(const std::vector<size_t>& targets) {
+            std::vector<std::pair<int, int>> edges;
+            edges.reserve(triangles_.size() * 3);
+            for (size_t face = 0; face < triangles_.size(); ++face){
+                const auto& triangle = triangles_[face];
+                Vec3D normal = cross(positions_[triangle[1]] - positions_[triangle[0]],
+                                     positions_[triangle[2]] - positions_[triangle[0]]);
+                double length = std::sqrt(normal.dot(normal));
+                for (size_t corner = 0; corner < 3; ++corner){
+                    int a = triangle[corner], b = triangle[(corner + 1) % 3];
+                    vertexFaces_[a].push_back(static_cast<int>(face));
+                    edges.emplace_back(std::min(a, b), std::max(a, b));
+                }
+                if (length == 0.) continue;
+                // Planes are weighted by the face area
+                normal = normal / length;
+                for (size_t corner = 0; corner < 3; ++corner){
+                    quadrics_[triangle[corner]].AddPlane(normal, -normal.dot(positions_[triangle[0]]), length / 2.);
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            for (size_t i = 0; i < edges.size();){
+                size_t end = i;
+                while (end < edges.size() && edges[end] == edges[i]) ++end;
+                if (end - i == 1) AddBorderPlanes(edges[i].first, edges[i].second);
+                i = end;
+            }
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+            for (const auto& [a, b] : edges){
+                Push(a, b);
+            }
+
+            std::vector<MeshPreprocess::SimplifiedMesh> meshes;
+            size_t next = 0;
+            while (next < targets.size()){
+                if (liveTriangles_ <= targets[next]){
+                    meshes.push_back(Snapshot());
+                    ++next;
+                    continue;
+                }
+                if (candidates_.empty()){
+                    // Stuck above the target, the mesh as far as it got is the last level
+                    if (meshes.empty() || meshes.back().triangles.size() > liveTriangles_) meshes.push_back(Snapshot());
+                    break;
+                }
+                Candidate candidate = candidates_.top();
+                candidates_.pop();
+                if (versions_[candidate.kept] != candidate.keptVersion ||
+                    versions_[candidate.removed] != candidate.removedVersion) continue;
+                if (CanCollapse(candidate)) Collapse(candidate);
+            }
+            return meshes;
+        }
+
+    private:
+        struct Candidate{
+            double cost;
+            int kept;
+            int removed;
+            uint32_t keptVersion;
+            uint32_t removedVersion;
+            Vec3D target;
+
+            bool operator>(const Candidate& other) const { return cost > other.cost; }
+        };
+
+        void AddBorderPlanes(int a, int b) {
+            for (int face : vertexFaces_[a]){
+                const auto& triangle = triangles_[face];
+                if (triangle[0] != b && triangle[1] != b && triangle[2] != b) continue;
+                Vec3D edge = positions_[b] - positions_[a];
+                Vec3D faceNormal = cross(positions_[triangle[1]] - positions_[triangle[0]],
+                                         positions_[triangle[2]] - positions_[triangle[0]]);
+                Vec3D normal = cross(edge, faceNormal);
+                double length = std::sqrt(normal.dot(normal));
+                if (length == 0.) return;
+                normal = normal / length;
+                double weight = BORDER_WEIGHT * edge.dot(edge);
+                quadrics_[a].AddPlane(normal, -normal.dot(positions_[a]), weight);
+                quadrics_[b].AddPlane(normal, -normal.dot(positions_[a]), weight);
+                return;
+            }
+        }
+
+        void Push(int a, int b) {
+            Quadric quadric = quadrics_[a];
+            quadric += quadrics_[b];
+            Vec3D target;
+            if (!quadric.Minimize(target)){
+                // Flat or straight neighbourhood, the best of the ends and the middle
+                Vec3D middle = (positions_[a] + positions_[b]) / 2.;
+                target = middle;
+                double best = quadric.Evaluate(middle);
+                for (int end : {a, b}){
+                    double cost = quadric.Evaluate(positions_[end]);
+                    if (cost < best){
+                        best = cost;
+                        target = positions_[end];
+                    }
+                }
+            }
+            double cost = std::max(0., quadric.Evaluate(target));
+            candidates_.push(Candidate{cost, a, b, versions_[a], versions_[b], target});
+        }
+
+        void CollectNeighbours(int vertex, std::vector<int>& neighbours) const {
+            neighbours.clear();
+            for (int face : vertexFaces_[vertex]){
+                if (!alive_[face]) continue;
+                for (size_t corner = 0; corner < 3; ++corner){
+                    if (triangles_[face][corner] != vertex) neighbours.push_back(triangles_[face][corner]);
+                }
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+            neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        }
+
+        bool CanCollapse(const Candidate& candidate) {
+            int kept = candidate.kept, removed = candidate.removed;
+            // Vertices next to both ends must be exactly the tips of the faces on the edge, otherwise two sheets
+            // of the surface would be joined
+            CollectNeighbours(kept, keptNeighbours_);
+            CollectNeighbours(removed, removedNeighbours_);
+            size_t shared = 0, sharedFaces = 0;
+            for (int neighbour : keptNeighbours_){
+                shared += std::binary_search(removedNeighbours_.begin(), removedNeighbours_.end(), neighbour);
+            }
+            for (int face : vertexFaces_[kept]){
+                const auto& triangle = triangles_[face];
+                sharedFaces += alive_[face] && (triangle[0] == removed || triangle[1] == removed ||
+                                                triangle[2] == removed);
+            }
+            if (sharedFaces == 0 || shared != sharedFaces) return false;
+
+            for (int end : {kept, removed}){
+                for (int face : vertexFaces_[end]){
+                    if (!alive_[face]) continue;
+                    Vector<int, 3> triangle = triangles_[face];
+                    bool hasKept = false, hasRemoved = false;
+                    for (size_t corner = 0; corner < 3; ++corner){
+                        hasKept |= triangle[corner] == kept;
+                        hasRemoved |= triangle[corner] == removed;
+                    }
+                    if (hasKept && hasRemoved) continue;
+                    Vec3D corners[3];
+                    for (size_t corner = 0; corner < 3; ++corner){
+                        corners[corner] = triangle[corner] == end ? candidate.target : positions_[triangle[corner]];
+                    }
+                    Vec3D before = cross(positions_[triangle[1]] - positions_[triangle[0]],
+                                         positions_[triangle[2]] - positions_[triangle[0]]);
+                    Vec3D after = cross(corners[1] - corners[0], corners[2] - corners[0]);
+                    double lengths = std::sqrt(before.dot(before) * after.dot(after));
+                    if (lengths == 0. || before.dot(after) < MIN_NORMAL_COSINE * lengths) return false;
+                }
+            }
+            return true;
+        }
+
+        void Collapse(const Candidate& candidate) {
+            int kept = candidate.kept, removed = candidate.removed;
+            positions_[kept] = candidate.target;
+            quadrics_[kept] += quadrics_[removed];
+            for (int face : vertexFaces_[removed]){
+                if (!alive_[face]) continue;
+                auto& triangle = triangles_[face];
+                if (triangle[0] == kept || triangle[1] == kept || triangle[2] == kept){
+                    alive_[face] = false;
+                    --liveTriangles_;
+                    continue;
+                }
+                for (size_t corner = 0; corner < 3; ++corner){
+                    if (triangle[corner] == removed) triangle[corner] = kept;
+                }
+                vertexFaces_[kept].push_back(face);
+            }
+            std::vector<int>().swap(vertexFaces_[removed]);
+            auto& keptFaces = vertexFaces_[kept];
+            keptFaces.erase(std::remove_if(keptFaces.begin(), keptFaces.end(), [this](int face) { return !alive_[face]; }),
+                            keptFaces.end());
+            ++versions_[kept];
+            ++versions_[removed];
+
+            CollectNeighbours(kept, keptNeighbours_);
+            for (int neighbour : keptNeighbours_){
+                Push(kept, neighbour);
+            }
+        }
+
+        MeshPreprocess::SimplifiedMesh Snapshot() const {
+            MeshPreprocess::SimplifiedMesh mesh;
+            std::vector<int> newIndex(positions_.size(), -1);
+            mesh.triangles.reserve(liveTriangles_);
+            for (size_t face = 0; face < triangles_.size(); ++face){
+                if (!alive_[face]) continue;
+                Vector<int, 3> triangle = triangles_[face];
+                for (size_t corner = 0; corner < 3; ++corner){
+                    int& vertex = newIndex[triangle[corner]];
+                    if (vertex < 0){
+                        vertex = static_cast<int>(mesh.vertices.size());
+                        mesh.vertices.push_back(positions_[triangle[corner]]);
+                    }
+                    triangle[corner] = vertex;
+                }
+                mesh.triangles.push_back(triangle);
+            }
+            return mesh;
+        }
+
+        std::vector<Vec3D> positions_;
+        std::vector<Vector<int, 3>> triangles_;
+        std::vector<bool> alive_;
+        std::vector<Quadric> quadrics_;
+        std::vector<std::vector<int>> vertexFaces_;
+        /// \brief Raised on every change of a vertex, candidates of older versions are stale
+        std::vector<uint32_t> versions_;
+        size_t liveTriangles_;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> candidates_;
+        std::vector<int> keptNeighbours_;
+        std::vector<int> removedNeighbours_;
+    };
+
+    struct CellHash{
+        size_t operator()(const Vector<int64_t, 3>& cell) const {
+            uint64_t hash = static_cast<uint64_t>(cell[0]) * 0x9e3779b97f4a7c15ull;
+            hash ^= static_cast<uint64_t>(cell[1]) * 0xc2b2ae3d27d4eb4full + (hash >> 29);
+            hash ^= static_cast<uint64_t>(cell[2]) * 0x165667b19e3779f9ull + (hash >> 32);
+            return static_cast<size_t>(hash);
+        }
+    };
+}
+
+uint64_t MeshPreprocess::MortonCode(uint32_t x, uint32_t y, uint32_t z) {
+    return SpreadBits(x) | SpreadBits(y) << 1 | SpreadBits(z) << 2;
+}
+
+size_t MeshPreprocess::Weld(const std::vector<Vec3D> &positions, double tolerance, std::vector<int> &remap) {
+    remap.resize(positions.size());
+    std::iota(remap.begin(), remap.end(), 0);
+    if (tolerance < 0.) return 0;
+
+    // Kept positions are bucketed into cells of the tolerance size, a match can only be in a neighbouring cell
+    double cellSize = tolerance > 0. ? tolerance : 1.;
+    std::unordered_map<Vector<int64_t, 3>, std::vector<int>, CellHash> cells;
+    cells.reserve(positions.size());
+    size_t merged = 0;
+    for (size_t i = 0; i < positions.size(); ++i){
+        const Vec3D& position = positions[i];
+        Vector<int64_t, 3> cell;
+        for (size_t axis = 0; axis < 3; ++axis){
+            cell[axis] = static_cast<int64_t>(std::floor(position[axis] / cellSize));
+        }
+        int match = -1;
+        int64_t reach = tolerance > 0. ? 1 : 0;
+        for (int64_t dx = -reach; dx <= reach && match < 0; ++dx){
+            for (int64_t dy = -reach; dy <= reach && match < 0; ++dy){
+                for (int64_t dz = -reach; dz <= reach && match < 0; ++dz){
+                    auto it = cells.find(Vector<int64_t, 3>{cell[0] + dx, cell[1] + dy, cell[2] + dz});
+                    if (it == cells.end()) continue;
+                    for (int candidate : it->second){
+                        Vec3D difference = positions[candidate] - position;
+                        if (difference.dot(difference) <= tolerance * tolerance){
+                            match = candidate;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        if (match >= 0){
+            remap[i] = match;
+            ++merged;
+        } else{
+            cells[cell].push_back(static_cast<int>(i));
+        }
+    }
+    return merged;
+}
+
+void MeshPreprocess::SortMorton(std::vector<Vec3D> &vertices, std::vector<Vector<int, 3>> &triangles,
+                                std::vector<Vec3D> *pVertexNormals, std::vector<Vector<double, 2>> *pTexCoords) {
+    if (triangles.empty()) return;
+    Vec3D low{DBL_MAX, DBL_MAX, DBL_MAX}, high{-DBL_MAX, -DBL_MAX, -DBL_MAX};
+    for (const auto& vertex : vertices){
+        for (size_t axis = 0; axis < 3; ++axis){
+            low[axis] = std::min(low[axis], vertex[axis]);
+            high[axis] = std::max(high[axis], vertex[axis]);
+        }
+    }
+    // Centroids are quantised to 21 bits per axis of the mesh box
+    constexpr double CELLS = (1 << 21) - 1;
+    std::vector<std::pair<uint64_t, uint32_t>> keys(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i){
+        const auto& triangle = triangles[i];
+        Vec3D centroid = (vertices[triangle[0]] + vertices[triangle[1]] + vertices[triangle[2]]) / 3.;
+        uint32_t cell[3];
+        for (size_t axis = 0; axis < 3; ++axis){
+            double extent = high[axis] - low[axis];
+            double relative = extent > 0. ? (centroid[axis] - low[axis]) / extent : 0.;
+            cell[axis] = static_cast<uint32_t>(std::clamp(relative, 0., 1.) * CELLS);
+        }
+        keys[i] = {MortonCode(cell[0], cell[1], cell[2]), static_cast<uint32_t>(i)};
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<int> newIndex(vertices.size(), -1);
+    std::vector<int> oldIndex;
+    oldIndex.reserve(vertices.size());
+    std::vector<Vector<int, 3>> sorted;
+    sorted.reserve(triangles.size());
+    for (const auto& [code, index] : keys){
+        Vector<int, 3> triangle = triangles[index];
+        for (size_t corner = 0; corner < 3; ++corner){
+            int& vertex = newIndex[triangle[corner]];
+            if (vertex < 0){
+                vertex = static_cast<int>(oldIndex.size());
+                oldIndex.push_back(triangle[corner]);
+            }
+            triangle[corner] = vertex;
+        }
+        sorted.push_back(triangle);
+    }
+    triangles = std::move(sorted);
+
+    auto permute = [&oldIndex](auto& values) {
+        std::remove_reference_t<decltype(values)> permuted;
+        permuted.reserve(oldIndex.size());
+        for (int index : oldIndex){
+            permuted.push_back(values[index]);
+        }
+        values = std::move(permuted);
+    };
+    permute(vertices);
+    if (pVertexNormals && !pVertexNormals->empty()) permute(*pVertexNormals);
+    if (pTexCoords && !pTexCoords->empty()) permute(*pTexCoords);
+}
+
+std::vector<MeshPreprocess::SimplifiedMesh> MeshPreprocess::Simplify(const std::vector<Vec3D> &vertices,
+                                                                     const std::vector<Vector<int, 3>> &triangles,
+                                                                     const std::vector<size_t> &targets) {
+    return Simplifier(vertices, triangles).Run(targets);
+}
@@ -0,0 +1,63 @@
+/**
+ * @file MeshPreprocess.h
+ * @brief Defines the MeshPreprocess class, import-time cleanup and memory layout of meshes.
+ */
+#ifndef MAIN_CPP_MESHPREPROCESS_H
+#define MAIN_CPP_MESHPREPROCESS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../LinearAlgebra/Vector.h"
+
+/**
+ * @class MeshPreprocess
+ * @brief Welding of duplicate positions, reordering along a Morton curve and simplification into levels of detail.
+ *
+ * Used by ObjLoader before the mesh is created. Ray traversal reads triangles leaf by leaf and the vertices they
+ * index, so triangles close in space should be close in memory and so should their vertices. Triangles are sorted
+ * by the Morton code of their centroid (MeshBvh keeps that order inside its leaves) and vertices are renumbered
+ * in the order the sorted triangles first use them.
+ */
+class MeshPreprocess{
+public:
+    /// \brief Vertices and triangles of one level of detail returned by Simplify()
+    struct SimplifiedMesh{
+        std::vector<Vec3D> vertices;
+        std::vector<Vector<int, 3>> triangles;
+    };
+
+    /**
+     * @brief Maps every position to the first one within tolerance of it.
+     *
+     * remap receives the index of the kept position for every position, positions themselves aren't changed.
+     * Tolerance 0 merges exact duplicates only, a negative tolerance maps every position to itself.
+     * @return The amount of merged positions.
+     */
+    static size_t Weld(const std::vector<Vec3D>& positions, double tolerance, std::vector<int>& remap);
+    /**
+     * @brief Sorts triangles by the Morton code of their centroids and renumbers vertices by first use.
+     *
+     * Per-vertex arrays (vertex normals, texture coordinates) are permuted with the vertices when not null,
+     * vertices no triangle uses are dropped.
+     */
+    static void SortMorton(std::vector<Vec3D>& vertices, std::vector<Vector<int, 3>>& triangles,
+                           std::vector<Vec3D>* pVertexNormals, std::vector<Vector<double, 2>>* pTexCoords);
+    /**
+     * @brief Simplifies the mesh by quadric error edge collapses (Garland and Heckbert).
+     *
+     * Every vertex accumulates the planes of its faces, an edge collapses into the point closest to the planes of
+     * both vertices, cheapest edge first. Edges on open borders also keep a plane perpendicular to their face, so
+     * borders don't shrink. Collapses which would flip a face or join two sheets of the surface are skipped.
+     * Simplification runs once and a copy is taken whenever the triangle count drops to the next of targets
+     * (ordered from the largest), unused vertices are dropped from the copies. Fewer meshes are returned when
+     * the mesh can't be simplified that far.
+     */
+    static std::vector<SimplifiedMesh> Simplify(const std::vector<Vec3D>& vertices,
+                                                const std::vector<Vector<int, 3>>& triangles,
+                                                const std::vector<size_t>& targets);
+    /// \brief Interleaves the lowest 21 bits of x, y and z (x in the lowest bit)
+    static uint64_t MortonCode(uint32_t x, uint32_t y, uint32_t z);
+};
+
+#endif
@@ -0,0 +1,308 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "MeshPreprocess.h"
+#include "../RayTrace/Trace.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    /// \brief Indices of one face corner into the position, texture coordinate and normal lists, -1 if missing
+    struct Corner{
+        int position;
+        int texCoord;
+        int normal;
+    };
+
+    class ObjParser{
+    public:
+        ObjParser(const std::string& path, const char* pBegin, const char* pEnd)
+            : path_(path), pCurrent_(pBegin), pEnd_(pEnd) {}
+
+        void Parse();
+        std::shared_ptr<RT::TriangleMesh> CreateMesh(const ObjLoadOptions& options);
+
+    private:
+        [[noreturn]] void Fail(const std::string& message) const {
+            throw std::runtime_error(path_ + ":" + std::to_string(line_) + ": " + message);
+        }
+        void SkipSpaces() {
+            while (pCurrent_ < pEnd_ && (*pCurrent_ == ' ' || *pCurrent_ == '\t' || *pCurrent_ == '\r')) ++pCurrent_;
+        }
+        void SkipLine() {
+            while (pCurrent_ < pEnd_ && *pCurrent_ != '\n') ++pCurrent_;
+        }
+        bool AtLineEnd() const { return pCurrent_ >= pEnd_ || *pCurrent_ == '\n' || *pCurrent_ == '#'; }
+        double ParseDouble();
+        /// \brief Parses a 1-based or negative index of a list with size elements into a 0-based one
+        int ParseIndex(size_t size, const char* name);
+        void ParseFace();
+        /// \brief Cuts polygon_ into triangles appended to corners_
+        void Triangulate();
+        void AddTriangle(size_t a, size_t b, size_t c);
+        /// \brief Levels of detail of the welded faces, call before positions_ are moved into the mesh
+        std::vector<std::shared_ptr<RT::TriangleMesh>> CreateLods(const ObjLoadOptions& options);
+
+        std::string path_;
+        const char* pCurrent_;
+        const char* pEnd_;
+        size_t line_ = 1;
+
+        std::vector<Vec3D> positions_;
+        std::vector<Vec3D> normals_;
+        std::vector<Vector<double, 2>> texCoords_;
+
+        std::vector<Corner> polygon_;
+        /// \brief Three corners per triangle, vertices are merged once it's known which attributes are kept
+        std::vector<Corner> corners_;
+        bool missingNormals_ = false;
+    };
+
+    double ObjParser::ParseDouble() {
+        SkipSpaces();
+        if (pCurrent_ < pEnd_ && *pCurrent_ == '+') ++pCurrent_;
+        double value;
+        auto [pNext, error] = std::from_chars(pCurrent_, pEnd_, value);
+        if (error != std::errc()) Fail("expected a number");
+        pCurrent_ = pNext;
+        return value;
+    }
+
+    int ObjParser::ParseIndex(size_t size, const char *name) {
+        long index;
+        auto [pNext, error] = std::from_chars(pCurrent_, pEnd_, index);
+        if (error != std::errc() || index == 0) Fail(std::string("expected a ") + name + " index");
+        pCurrent_ = pNext;
+        long resolved = index > 0 ? index - 1 : static_cast<long>(size) + index;
+        if (resolved < 0 || resolved >= static_cast<long>(size)){
+            Fail(std::string(name) + " index " + std::to_string(index) + " out of range");
+        }
+        return static_cast<int>(resolved);
+    }
+
+    void ObjParser::Parse() {
+        while (pCurrent_ < pEnd_){
+            SkipSpaces();
+            const char* pKeyword = pCurrent_;
+            while (pCurrent_ < pEnd_ && *pCurrent_ != ' ' && *pCurrent_ != '\t' && *pCurrent_ != '\n' &&
+                   *pCurrent_ != '\r') ++pCurrent_;
+            std::string_view keyword(pKeyword, pCurrent_ - pKeyword);
+            if (keyword == "v"){
+                double x = ParseDouble();
+                double y = ParseDouble();
+                double z = ParseDouble();
+                positions_.push_back(Vec3D{x, y, z});
+            } else if (keyword == "vn"){
+                double x = ParseDouble();
+                double y = ParseDouble();
+                double z = ParseDouble();
+                normals_.push_back(Vec3D{x, y, z}.normalized());
+            } else if (keyword == "vt"){
+                double u = ParseDouble();
+                SkipSpaces();
+                double v = AtLineEnd() ? 0. : ParseDouble();
+                texCoords_.push_back(Vector<double, 2>{u, v});
+            } else if (keyword == "f"){
+                ParseFace();
+            }
+            // Optional w components, unsupported records and comments
+            SkipLine();
+            if (pCurrent_ < pEnd_) ++pCurrent_;
+            ++line_;
+        }
+        if (corners_.empty()) Fail("no faces");
+    }
+
+    void ObjParser::ParseFace() {
+        polygon_.clear();
+        SkipSpaces();
+        while (!AtLineEnd()){
+            Corner corner{ParseIndex(positions_.size(), "vertex"), -1, -1};
+            if (pCurrent_ < pEnd_ && *pCurrent_ == '/'){
+                ++pCurrent_;
+                if (pCurrent_ < pEnd_ && *pCurrent_ != '/') corner.texCoord = ParseIndex(texCoords_.size(), "texture");
+                if (pCurrent_ < pEnd_ && *pCurrent_ == '/'){
+                    ++pCurrent_;
+                    corner.normal = ParseIndex(normals_.size(), "normal");
+                }
+            }
+            if (!AtLineEnd() && *pCurrent_ != ' ' && *pCurrent_ != '\t' && *pCurrent_ != '\r'){
+                Fail("unexpected character in face");
+            }
+            missingNormals_ |= corner.normal < 0;
+            polygon_.push_back(corner);
+            SkipSpaces();
+        }
+        if (polygon_.size() < 3) Fail("face with less than 3 vertices");
+        Triangulate();
+    }
+
+    void ObjParser::AddTriangle(size_t a, size_t b, size_t c) {
+        corners_.push_back(polygon_[a]);
+        corners_.push_back(polygon_[b]);
+        corners_.push_back(polygon_[c]);
+    }
+
+    void ObjParser::Triangulate() {
+        size_t n = polygon_.size();
+        if (n == 3){
+            AddTriangle(0, 1, 2);
+            return;
+        }
+
+        // Ear clipping in the polygon plane, projected along the dominant axis of its Newell normal
+        Vec3D normal{0., 0., 0.};
+        for (size_t i = 0; i < n; ++i){
+            const Vec3D& a = positions_[polygon_[i].position];
+            const Vec3D& b = positions_[polygon_[(i + 1) % n].position];
+            normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+            normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+            normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+        }
+        size_t axis = std::fabs(normal[0]) > std::fabs(normal[1]) ? 0 : 1;
+        if (std::fabs(normal[2]) > std::fabs(normal[axis])) axis = 2;
+        size_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+        double orientation = normal[axis] < 0. ? -1. : 1.;
+        auto point = [&](size_t i) {
+            const Vec3D& p = positions_[polygon_[i].position];
+            return std::make_pair(p[u], p[v]);
+        };
+        auto area = [&](size_t a, size_t b, size_t c) {
+            auto [ax, ay] = point(a);
+            auto [bx, by] = point(b);
+            auto [cx, cy] = point(c);
+            return orientation * ((bx - ax) * (cy - ay) - (by - ay) * (cx - ax));
+        };
+
+        std::vector<size_t> remaining(n);
+        for (size_t i = 0; i < n; ++i) remaining[i] = i;
+        while (remaining.size() > 3){
+            size_t count = remaining.size();
+            size_t ear = count;
+            for (size_t i = 0; i < count && ear == count; ++i){
+                size_t a = remaining[(i + count - 1) % count], b = remaining[i], c = remaining[(i + 1) % count];
+                if (area(a, b, c) <= 0.) continue;
+                bool empty = true;
+                for (size_t j = 0; j < count && empty; ++j){
+                    size_t p = remaining[j];
+                    if (p == a || p == b || p == c) continue;
+                    empty = area(a, b, p) < 0. || area(b, c, p) < 0. || area(c, a, p) < 0.;
+                }
+                if (empty) ear = i;
+            }
+            // Degenerate polygons have no ear, they are cut as a fan
+            if (ear == count) ear = 1;
+            size_t a = remaining[(ear + count - 1) % count], b = remaining[ear], c = remaining[(ear + 1) % count];
+            AddTriangle(a, b, c);
+            remaining.erase(remaining.begin() + static_cast<long>(ear));
+        }
+        AddTriangle(remaining[0], remaining[1], remaining[2]);
+    }
+
+    std::shared_ptr<RT::TriangleMesh> ObjParser::CreateMesh(const ObjLoadOptions &options) {
+        std::vector<int> remap;
+        if (MeshPreprocess::Weld(positions_, options.weldTolerance, remap) > 0){
+            // Triangles with two corners welded together have no area
+            size_t kept = 0;
+            for (size_t i = 0; i < corners_.size(); i += 3){
+                Corner triangle[3] = {corners_[i], corners_[i + 1], corners_[i + 2]};
+                for (auto& corner : triangle) corner.position = remap[corner.position];
+                if (triangle[0].position == triangle[1].position || triangle[1].position == triangle[2].position ||
+                    triangle[0].position == triangle[2].position) continue;
+                std::copy(triangle, triangle + 3, corners_.begin() + static_cast<long>(kept));
+                kept += 3;
+            }
+            corners_.resize(kept);
+            if (corners_.empty()) throw std::runtime_error(path_ + ": no faces left after welding");
+        }
+
+        bool keepNormals = options.normals && !normals_.empty() && !missingNormals_;
+        bool keepTexCoords = options.texCoords && !texCoords_.empty();
+        size_t triangleCount = corners_.size() / 3;
+        std::vector<std::shared_ptr<RT::TriangleMesh>> lods;
+        if (options.lods && triangleCount / Utils::LOD_REDUCTION >= Utils::LOD_MIN_TRIANGLES){
+            lods = CreateLods(options);
+        }
+        std::vector<Vec3D> vertices;
+        std::vector<Vec3D> vertexNormals;
+        std::vector<Vector<double, 2>> texCoords;
+        std::vector<Vector<int, 3>> triangles(corners_.size() / 3);
+
+        if (!keepNormals && !keepTexCoords){
+            vertices = std::move(positions_);
+            for (size_t i = 0; i < corners_.size(); ++i){
+                triangles[i / 3][i % 3] = corners_[i].position;
+            }
+        } else{
+            // Corners sharing a position but not the kept attributes become separate vertices
+            std::unordered_map<uint64_t, int> vertexIndices;
+            vertexIndices.reserve(positions_.size() * 2);
+            for (size_t i = 0; i < corners_.size(); ++i){
+                const Corner& corner = corners_[i];
+                int texCoord = keepTexCoords ? corner.texCoord : -1;
+                int normal = keepNormals ? corner.normal : -1;
+                uint64_t key = (static_cast<uint64_t>(corner.position) * (texCoords_.size() + 1) + texCoord + 1) *
+                               (normals_.size() + 1) + normal + 1;
+                auto [it, inserted] = vertexIndices.try_emplace(key, static_cast<int>(vertices.size()));
+                if (inserted){
+                    vertices.push_back(positions_[corner.position]);
+                    if (keepNormals) vertexNormals.push_back(normals_[normal]);
+                    if (keepTexCoords) texCoords.push_back(texCoord < 0 ? Vector<double, 2>() : texCoords_[texCoord]);
+                }
+                triangles[i / 3][i % 3] = it->second;
+            }
+        }
+        if (options.flipVertices){
+            for (auto& triangle : triangles){
+                std::swap(triangle[0], triangle[1]);
+            }
+        }
+
+        if (options.optimizeLayout){
+            MeshPreprocess::SortMorton(vertices, triangles, keepNormals ? &vertexNormals : nullptr,
+                                       keepTexCoords ? &texCoords : nullptr);
+        }
+
+        auto pMesh = std::make_shared<RT::TriangleMesh>(vertices, triangles);
+        if (keepNormals) pMesh->SetVertexNormals(std::move(vertexNormals));
+        if (keepTexCoords) pMesh->SetTexCoords(std::move(texCoords));
+        pMesh->SetLods(std::move(lods));
+        return pMesh;
+    }
+
+    std::vector<std::shared_ptr<RT::TriangleMesh>> ObjParser::CreateLods(const ObjLoadOptions &options) {
+        TRACE_SCOPE("Mesh simplify");
+        std::vector<Vector<int, 3>> triangles(corners_.size() / 3);
+        for (size_t i = 0; i < corners_.size(); ++i){
+            triangles[i / 3][i % 3] = corners_[i].position;
+        }
+        if (options.flipVertices){
+            for (auto& triangle : triangles){
+                std::swap(triangle[0], triangle[1]);
+            }
+        }
+        std::vector<size_t> targets;
+        for (size_t count = triangles.size() / Utils::LOD_REDUCTION; count >= Utils::LOD_MIN_TRIANGLES;
+             count /= Utils::LOD_REDUCTION){
+            targets.push_back(count);
+        }
+
+        std::vector<std::shared_ptr<RT::TriangleMesh>> lods;
+        for (auto& level : MeshPreprocess::Simplify(positions_, triangles, targets)){
+            if (options.optimizeLayout) MeshPreprocess::SortMorton(level.vertices, level.triangles, nullptr, nullptr);
+            lods.push_back(std::make_shared<RT::TriangleMesh>(level.vertices, level.triangles));
+        }
+        return lods;
+    }
+}
+
+std::shared_ptr<RT::TriangleMesh> ObjLoader::loadTriangleMeshObj(const std::string &path,
+                                                                 const ObjLoadOptions &options) {
+    TRACE_SCOPE_DETAIL("OBJ load", path);
+    MappedFile file(path);
+    ObjParser parser(path, file.begin(), file.end());
+    parser.Parse();
+    return parser.CreateMesh(options);
+}
@@ -1,75 +1,49 @@
 #ifndef MAIN_CPP_OBJECTLOADER_H
 #define MAIN_CPP_OBJECTLOADER_H
 
-#include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 #include <memory>
-#include <exception>
+#include <string>
 
 #include "../RayTrace/Objects.h"
-#include "../Log.h"
 
-constexpr const char BIG_DELIMITER = ' ';
-constexpr const char SMALL_DELIMITER = '/';
+/**
+ * @struct ObjLoadOptions
+ * @brief What ObjLoader keeps from the file besides positions and faces.
+ */
+struct ObjLoadOptions{
+    /// \brief Swaps the first two vertices of every triangle, reversing its winding
+    bool flipVertices = false;
+    /// \brief Keep `vn` normals as vertex normals, otherwise they are computed from the faces
+    bool normals = true;
+    /// \brief Keep `vt` coordinates
+    bool texCoords = true;
+    /// \brief Positions closer than this are merged before triangles are built, negative keeps them all
+    double weldTolerance = Utils::WELD_TOLERANCE;
+    /// \brief Orders triangles and vertices along a Morton curve, see MeshPreprocess.h
+    bool optimizeLayout = true;
+    /// \brief Simplified levels of detail for meshes above Utils::LOD_MIN_TRIANGLES, see TriangleMesh::GetLods()
+    bool lods = true;
+};
 
+/**
+ * @class ObjLoader
+ * @brief Loads Wavefront `.obj` files into triangle meshes.
+ *
+ * The file is memory mapped and parsed in place with std::from_chars. Supported records are `v`, `vn`, `vt` and
+ * `f` with any of the `v`, `v/vt`, `v//vn`, `v/vt/vn` forms and negative (relative) indices, everything else
+ * (groups, materials, comments) is skipped. Quads and larger polygons are triangulated by ear clipping in their
+ * plane. Corners with the same position but a different normal or texture coordinate become separate mesh
+ * vertices, normals are dropped when some corner doesn't have one. Duplicate positions are welded first,
+ * faces collapsed by welding are dropped, and the finished arrays are laid out along a Morton curve. Large meshes
+ * get levels of detail simplified from the welded positions, so seams of normals or texture coordinates don't
+ * tear them, each with a Utils::LOD_REDUCTION times fewer triangles down to Utils::LOD_MIN_TRIANGLES.
+ */
 class ObjLoader{
 public:
-    static std::shared_ptr<RT::TriangleMesh> loadTriangleMeshObj(const std::string& filename, bool flipVertices = false);
-
-private:
+    /// \brief Loads the mesh from path, throws std::runtime_error with the line number of malformed records
+    static std::shared_ptr<RT::TriangleMesh> loadTriangleMeshObj(const std::string& path,
+                                                                 const ObjLoadOptions& options = {});
 };
 
-
-inline std::shared_ptr<RT::TriangleMesh> ObjLoader::loadTriangleMeshObj(const std::string &filename, bool flipVertices) {
-    std::ifstream file("../objects/" + filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Error opening file: " + filename);
-    }
-
-    std::vector<Vec3D> vertices;
-    std::vector<Vector<int, 3>> triangles;
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream inputStream(line);
-        char bigDelimiter = ' ';
-        std::string bigToken;
-        std::getline(inputStream, bigToken, bigDelimiter);
-        if (bigToken == "v") {
-            Vec3D vertex;
-            inputStream >> vertex;
-            vertices.push_back(vertex);
-        } else if (bigToken == "f") {
-            std::string smallToken;
-            std::vector<int> polygonIndices;
-            int vertInd;
-            for (size_t i = 0; std::getline(inputStream, bigToken, BIG_DELIMITER); ++i) {
-                std::stringstream inputStream2(bigToken);
-                std::getline(inputStream2, smallToken, SMALL_DELIMITER);
-                vertInd = std::stoi(smallToken) - 1;
-                polygonIndices.emplace_back(vertInd);
-            }
-            if (polygonIndices.size() != 3) {
-                throw std::invalid_argument(".obj file should contain only triangular faces.");
-            } else{
-                Vector<int, 3> triangle{polygonIndices[0], polygonIndices[1], polygonIndices[2]};
-                triangles.emplace_back(triangle);
-            }
-        }
-    }
-    if (flipVertices) {
-        for (auto &triangle: triangles) {
-            int a = triangle[0];
-            int b = triangle[1];
-            triangle[0] = b;
-            triangle[1] = a;
-        }
-    }
-    std::shared_ptr<RT::TriangleMesh> triangleMesh = std::make_shared<RT::TriangleMesh>(RT::TriangleMesh(vertices, triangles));
-    triangleMesh->updateEdgesAndNormals();
-    return triangleMesh;
-}
-
 #endif
@@ -1,12 +1,37 @@
 #include "../Utilities/Utils.h"
 #include "Random.h"
 
-thread_local std::mt19937 Rand::randomGenerator_{std::random_device{}()};
-std::uniform_int_distribution<std::mt19937::result_type> Rand::distribution_{std::numeric_limits<std::mt19937::result_type>::min(), std::numeric_limits<std::mt19937::result_type>::max()};
-std::uniform_int_distribution<std::mt19937::result_type> Rand::cachedDistribution_{0, 10000 - 1};
+namespace {
+    uint64_t SplitMix64(uint64_t value) {
+        value += 0x9E3779B97F4A7C15ULL;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+}
+
+thread_local uint64_t Rand::state_ = 0x853C49E6748FEA9BULL;
+thread_local uint64_t Rand::increment_ = 0xDA3E39CB94B95BDBULL;
+
+void Rand::Seed(uint64_t seed, uint64_t stream) {
+    // Streams are mixed first, neighbouring pixels would otherwise get visibly correlated sequences
+    increment_ = (SplitMix64(stream) << 1) | 1;
+    state_ = 0;
+    Next();
+    state_ += SplitMix64(seed ^ SplitMix64(stream + 0x632BE59BD9B4E019ULL));
+    Next();
+}
+
+uint32_t Rand::Next() {
+    uint64_t old = state_;
+    state_ = old * 6364136223846793005ULL + increment_;
+    uint32_t shifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+    uint32_t rotation = static_cast<uint32_t>(old >> 59);
+    return (shifted >> rotation) | (shifted << ((-rotation) & 31));
+}
 
 double Rand::RandomDouble() {
-    return (double)distribution_(randomGenerator_) / (double)std::numeric_limits<std::mt19937::result_type>::max();
+    return (double)Next() / (double)UINT32_MAX;
 }
 
 Vec3D Rand::RandomUnitVector() {
@@ -15,4 +40,4 @@ Vec3D Rand::RandomUnitVector() {
     return randomVector;
 }
 
-void Rand::Initialize() {}
\ No newline at end of file
+void Rand::Initialize() {}
@@ -1,20 +1,32 @@
 #ifndef MAIN_CPP_RANDOM_H
 #define MAIN_CPP_RANDOM_H
 
+#include <cstdint>
 #include "../Utilities/Utils.h"
 
+/**
+ * @class Rand
+ * @brief Per-thread PCG32 random generator.
+ *
+ * The renderer restarts the sequence for every pixel sample with Seed(), so the random numbers a sample uses
+ * depend only on the render seed and the sample, not on which thread renders it or in which order. That makes
+ * renders reproducible, which checkpoint resuming relies on.
+ */
 class Rand {
 public:
     static void Initialize();
+    /// \brief Restarts the sequence of the calling thread, every (seed, stream) pair gives a different sequence
+    static void Seed(uint64_t seed, uint64_t stream);
     /// \brief Returns a random double in the interval [0,1]
     static double RandomDouble();
     /// \brief Returns a random normalized vector
     static Vec3D RandomUnitVector();
 
 private:
-    static thread_local std::mt19937 randomGenerator_;
-    static std::uniform_int_distribution<std::mt19937::result_type> distribution_;
-    static std::uniform_int_distribution<std::mt19937::result_type> cachedDistribution_;
+    static uint32_t Next();
+
+    static thread_local uint64_t state_;
+    static thread_local uint64_t increment_;
 };
 
 #endif
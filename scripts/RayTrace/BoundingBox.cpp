@@ -3,8 +3,12 @@
 
 RT::BoundingBox::BoundingBox(std::shared_ptr<RT::Object> pObject) {
     pInsideObjectList_.emplace_back(pObject);
-    if (pObject->GetType() == RT::ObjectType::TRIANGLE){
+    // Flat and spherical objects are tested as fast as a box, so they are their own box (planes have no other)
+    RT::ObjectType type = pObject->GetType();
+    if (type == RT::ObjectType::TRIANGLE || type == RT::ObjectType::QUAD || type == RT::ObjectType::SPHERE ||
+        type == RT::ObjectType::PLANE){
         pBoxObjectList_.emplace_back(pObject);
+        selfBounded_ = true;
     } else {
         auto [minPoint, maxPoint] = pObject->GetBoundingPoints();
 
@@ -35,10 +39,10 @@ RT::BoundingBox::BoundingBox(std::shared_ptr<RT::Object> pObject) {
     }
 }
 
-std::vector<std::shared_ptr<RT::Object>> RT::BoundingBox::GetBoundingBox() const {
+const std::vector<std::shared_ptr<RT::Object>>& RT::BoundingBox::GetBoundingBox() const {
     return pBoxObjectList_;
 }
 
-std::vector<std::shared_ptr<RT::Object>> RT::BoundingBox::GetObjectList() const {
+const std::vector<std::shared_ptr<RT::Object>>& RT::BoundingBox::GetObjectList() const {
     return pInsideObjectList_;
 }
@@ -28,12 +28,15 @@ namespace RT{
           */
         BoundingBox(std::shared_ptr<RT::Object> pObject);
 
-        std::vector<std::shared_ptr<RT::Object>> GetBoundingBox() const;
-        std::vector<std::shared_ptr<RT::Object>> GetObjectList() const;
+        const std::vector<std::shared_ptr<RT::Object>>& GetBoundingBox() const;
+        const std::vector<std::shared_ptr<RT::Object>>& GetObjectList() const;
+        /// \brief The object is its own box, the hit of the box test is already the hit of the object
+        bool IsSelfBounded() const { return selfBounded_; }
 
     private:
         std::vector<std::shared_ptr<RT::Object>> pInsideObjectList_;
         std::vector<std::shared_ptr<RT::Object>> pBoxObjectList_;
+        bool selfBounded_ = false;
     };
 }
 
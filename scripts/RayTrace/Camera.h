@@ -28,10 +28,15 @@ namespace RT{
         void SetAspectRatio(double aspectRatio);
         void SetHorizontalScale(double horizontalScale);
 
-        Vec3D GetPos() { return cameraPos_; }
-        Vec3D GetCenter() { return screenCenter_; }
-        Vec3D GetScreenU() { return screenU_; }
-        Vec3D GetScreenV() { return screenV_; }
+        Vec3D GetPos() const { return cameraPos_; }
+        Vec3D GetCenter() const { return screenCenter_; }
+        Vec3D GetScreenU() const { return screenU_; }
+        Vec3D GetScreenV() const { return screenV_; }
+        const Vec3D& GetLookAt() const { return cameraLookAt_; }
+        const Vec3D& GetUp() const { return cameraUp_; }
+        double GetLookLength() const { return lookLength_; }
+        double GetAspectRatio() const { return aspectRatio_; }
+        double GetHorizontalScale() const { return horizontalScale_; }
         /// \brief Calculates additional camera parameters from the provided ones
         void CalculateParams();
         /**
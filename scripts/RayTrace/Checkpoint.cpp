@@ -0,0 +1,98 @@
+#include "Checkpoint.h"
+#include "Trace.h"
+#include "../Image/Deflate.h"
+#include "../ObjectLoader/MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    constexpr char MAGIC[8] = {'R', 'T', 'C', 'H', 'E', 'C', 'K', 'P'};
+    constexpr uint32_t VERSION = 1;
+
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t pixelSize;
+        uint64_t fingerprint;
+        uint64_t width;
+        uint64_t height;
+        uint64_t passes;
+    };
+}
+
+void RT::Checkpoint::Save(const std::string &path, uint64_t fingerprint, size_t passes,
+                          const RT::Framebuffer &framebuffer) {
+    TRACE_SCOPE("Checkpoint save");
+    Header header{};
+    std::copy(MAGIC, MAGIC + 8, header.magic);
+    header.version = VERSION;
+    header.pixelSize = sizeof(AccumulatedPixel);
+    header.fingerprint = fingerprint;
+    header.width = framebuffer.GetWidth();
+    header.height = framebuffer.GetHeight();
+    header.passes = passes;
+
+    const auto* pHeader = reinterpret_cast<const uint8_t*>(&header);
+    const auto* pPixels = reinterpret_cast<const uint8_t*>(framebuffer.GetTileData(0));
+    size_t pixelBytes = framebuffer.GetTileCount() * Framebuffer::TILE_PIXELS * sizeof(AccumulatedPixel);
+    uint32_t crc = Deflate::Crc32(pHeader, sizeof(header));
+    crc = Deflate::Crc32(pPixels, pixelBytes, crc);
+
+    std::string temporaryPath = MappedFile::TemporaryPath(path);
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) throw std::runtime_error("Error opening file: " + temporaryPath);
+        file.write(reinterpret_cast<const char*>(pHeader), sizeof(header));
+        file.write(reinterpret_cast<const char*>(pPixels), static_cast<std::streamsize>(pixelBytes));
+        file.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+        file.flush();
+        if (!file){
+            file.close();
+            std::remove(temporaryPath.c_str());
+            throw std::runtime_error("Writing checkpoint failed: " + temporaryPath);
+        }
+    }
+    // Replaces the previous checkpoint in one step, also on Windows unlike std::rename, so there is always one
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error){
+        std::remove(temporaryPath.c_str());
+        throw std::runtime_error("Replacing checkpoint failed: " + path);
+    }
+}
+
+bool RT::Checkpoint::Load(const std::string &path, uint64_t fingerprint, RT::Framebuffer &framebuffer,
+                          size_t &passes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    Header header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || !std::equal(MAGIC, MAGIC + 8, header.magic) || header.version != VERSION ||
+        header.pixelSize != sizeof(AccumulatedPixel)){
+        throw std::runtime_error("Not a checkpoint of this renderer: " + path);
+    }
+    if (header.fingerprint != fingerprint || header.width != framebuffer.GetWidth() ||
+        header.height != framebuffer.GetHeight()){
+        throw std::runtime_error("Checkpoint " + path + " belongs to a different scene, camera, resolution, "
+                                 "settings or renderer version, delete it to start over");
+    }
+
+    auto* pPixels = reinterpret_cast<char*>(framebuffer.GetTileData(0));
+    size_t pixelBytes = framebuffer.GetTileCount() * Framebuffer::TILE_PIXELS * sizeof(AccumulatedPixel);
+    uint32_t storedCrc = 0;
+    file.read(pPixels, static_cast<std::streamsize>(pixelBytes));
+    file.read(reinterpret_cast<char*>(&storedCrc), sizeof(storedCrc));
+    uint32_t crc = Deflate::Crc32(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    crc = Deflate::Crc32(reinterpret_cast<const uint8_t*>(pPixels), pixelBytes, crc);
+    if (!file || crc != storedCrc){
+        framebuffer.Clear();
+        throw std::runtime_error("Checkpoint is damaged: " + path);
+    }
+    framebuffer.MarkAllDirty();
+    passes = header.passes;
+    return true;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file Checkpoint.h
+ * @brief Defines saving and loading of the render state, so long renders can be resumed.
+ */
+#ifndef MAIN_CPP_CHECKPOINT_H
+#define MAIN_CPP_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include "Framebuffer.h"
+#include "../Utilities/Utils.h"
+
+namespace RT{
+    /// \brief Where and how often a progressive render saves its state
+    struct CheckpointOptions{
+        /// \brief Checkpoint file, empty disables checkpoints
+        std::string path;
+        /// \brief Minimal time between two checkpoints, they are written only between passes
+        double intervalSeconds = Utils::CHECKPOINT_INTERVAL;
+    };
+
+    /**
+     * @class Checkpoint
+     * @brief Binary file with the accumulated samples of a progressive render.
+     *
+     * Holds the scene fingerprint (Scene::GetFingerprint()), the image size, the amount of finished passes and the
+     * framebuffer as is: float color sums and per-pixel sample counts. Random sequences are seeded per sample
+     * (see Rand), so the amount of finished passes is the whole RNG position and a resumed render continues
+     * exactly where the interrupted one was. A CRC-32 at the end detects truncated or damaged files.
+     */
+    class Checkpoint{
+    public:
+        /// \brief Writes the checkpoint into a temporary file and renames it, so a crash never leaves a broken file
+        static void Save(const std::string& path, uint64_t fingerprint, size_t passes, const RT::Framebuffer& framebuffer);
+        /**
+         * @brief Loads a checkpoint into framebuffer, which has to have the size of the image already.
+         *
+         * @return False if there is no checkpoint file.
+         * @throws std::runtime_error if the file is damaged or belongs to a different scene, camera, size or settings.
+         */
+        static bool Load(const std::string& path, uint64_t fingerprint, RT::Framebuffer& framebuffer, size_t& passes);
+    };
+}
+
+#endif
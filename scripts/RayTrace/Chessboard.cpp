@@ -1,33 +1,161 @@
 #include "Chessboard.h"
 #include "Material.h"
+#include "Trace.h"
+#include "Zobrist.h"
+#include "../ObjectLoader/EmbeddedMeshes.h"
+#include "../ObjectLoader/MeshCache.h"
+#include "../ObjectLoader/MeshFile.h"
+#include "../Threading/ThreadPool.h"
+#include <filesystem>
+#include <map>
+#include <mutex>
 
-RT::Chessboard::Chessboard(const Vec3D &bottomLeft) {
+namespace {
+    /// \brief Size of the figure footprint relative to its square
+    double PieceScale(const std::string& figureName) {
+        if (figureName == "pawn" || figureName == "rook") return 0.65;
+        if (figureName == "bishop" || figureName == "knight") return 0.75;
+        return 0.8;
+    }
+
+    std::string PiecePath(const std::string& figureName, const std::string& directory) {
+        if (directory.empty() || directory.back() == '/' || directory.back() == '\\') return directory + figureName + ".obj";
+        return directory + "/" + figureName + ".obj";
+    }
+
+    std::mutex pieceDirectoryMutex;
+    std::string pieceDirectory;
+
+    std::string GetPieceDirectory() {
+        std::lock_guard<std::mutex> lock(pieceDirectoryMutex);
+        return pieceDirectory;
+    }
+
+    /// \brief Fitted surfaces by figure name with the source key they were fitted for, null for other shapes
+    std::mutex pieceSurfacesMutex;
+    std::map<std::string, std::pair<uint64_t, std::shared_ptr<const RT::SurfaceOfRevolution>>> pieceSurfaces;
+
+    /// \brief Content checksums of piece files by path with the modification time they were computed for
+    std::mutex pieceChecksumsMutex;
+    std::map<std::string, std::pair<std::filesystem::file_time_type, uint64_t>> pieceChecksums;
+}
+
+std::shared_ptr<const RT::TriangleMesh> RT::Chessboard::LoadPiece(const std::string &figureName) {
+    std::string directory = GetPieceDirectory();
+    if (directory.empty()){
+        if (auto pMesh = EmbeddedMeshes::Get(figureName)) return pMesh;
+        directory = Utils::OBJECTS_DIRECTORY;
+    }
+    return LoadPieceFile(figureName, directory);
+}
+
+std::shared_ptr<const RT::TriangleMesh> RT::Chessboard::LoadPieceFile(const std::string &figureName,
+                                                                      const std::string &directory) {
+    double scale = PieceScale(figureName);
+    return MeshCache::Shared().Get(PiecePath(figureName, directory), GetPieceLoadOptions(), "board square",
+                                   [scale](RT::TriangleMesh& mesh) { mesh.Fit1x1(scale, scale); });
+}
+
+std::shared_ptr<const RT::SurfaceOfRevolution> RT::Chessboard::LoadPieceSurface(const std::string &figureName) {
+    uint64_t sourceKey = GetPieceSourceKey(figureName);
+    {
+        std::lock_guard<std::mutex> lock(pieceSurfacesMutex);
+        auto it = pieceSurfaces.find(figureName);
+        if (it != pieceSurfaces.end() && it->second.first == sourceKey) return it->second.second;
+    }
+    auto pMesh = LoadPiece(figureName);
+    Vec3D base;
+    auto profile = RT::SurfaceOfRevolution::FitProfile(*pMesh, Utils::REVOLUTION_FIT_TOLERANCE, base);
+    std::shared_ptr<const RT::SurfaceOfRevolution> pSurface;
+    if (!profile.empty()){
+        auto pFitted = std::make_shared<RT::SurfaceOfRevolution>(std::move(profile));
+        pFitted->SetSmoothness(pMesh->GetSmoothness());
+        pSurface = pFitted;
+    }
+    std::lock_guard<std::mutex> lock(pieceSurfacesMutex);
+    pieceSurfaces[figureName] = std::make_pair(sourceKey, pSurface);
+    return pSurface;
+}
+
+ObjLoadOptions RT::Chessboard::GetPieceLoadOptions() {
+    ObjLoadOptions options;
+    options.normals = false;
+    options.texCoords = false;
+    return options;
+}
+
+void RT::Chessboard::SetPieceDirectory(const std::string &directory) {
+    std::lock_guard<std::mutex> lock(pieceDirectoryMutex);
+    pieceDirectory = directory;
+}
+
+uint64_t RT::Chessboard::GetPieceSourceKey(const std::string &figureName) {
+    std::string directory = GetPieceDirectory();
+    if (directory.empty()){
+        if (EmbeddedMeshes::Contains(figureName)) return EmbeddedMeshes::GetSourceChecksum(figureName);
+        directory = Utils::OBJECTS_DIRECTORY;
+    }
+    // Missing pieces fail the build, their key doesn't matter
+    std::string path = PiecePath(figureName, directory);
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(path, error);
+    if (error) return 0;
+    {
+        std::lock_guard<std::mutex> lock(pieceChecksumsMutex);
+        auto it = pieceChecksums.find(path);
+        if (it != pieceChecksums.end() && it->second.first == modified) return it->second.second;
+    }
+    // Keyed by content, so copies of the same files on other hosts get the same key, the embedded ones included
+    uint64_t checksum;
+    try {
+        checksum = MeshFile::SourceChecksum(path, GetPieceLoadOptions());
+    } catch (const std::runtime_error&) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(pieceChecksumsMutex);
+    pieceChecksums[path] = std::make_pair(modified, checksum);
+    return checksum;
+}
+
+uint64_t RT::Chessboard::GetPieceSetKey() {
+    uint64_t key = 0;
+    for (const char* figureName : {"pawn", "rook", "knight", "bishop", "queen", "king"}){
+        key = RT::Zobrist::Combine(key, GetPieceSourceKey(figureName));
+    }
+    return key;
+}
+
+void RT::Chessboard::PrewarmPieces() {
+    const std::vector<std::string> figureNames{"pawn", "rook", "knight", "bishop", "queen", "king"};
+    ThreadPool::Shared().ParallelFor(figureNames.size(), [&](size_t i) { LoadPiece(figureNames[i]); });
+}
+
+RT::Chessboard::Chessboard(const Vec3D &bottomLeft) : Chessboard(bottomLeft, Config::FIGURE_CONFIGURATION) {}
+
+RT::Chessboard::Chessboard(const Vec3D &bottomLeft, const RT::FigureConfiguration &figures, bool analyticPieces)
+    : figures_(figures) {
+    TRACE_SCOPE("Chessboard");
+    if (figures_.size() != 8){
+        throw std::invalid_argument("Figure configuration must have 8 rows");
+    }
+    for (const auto& row : figures_){
+        if (row.size() != 8) throw std::invalid_argument("Figure configuration must have 8 columns");
+    }
     // Create chess board objects
     for (double i = 0; i < 8; ++i){
         std::vector<std::shared_ptr<RT::Object>> row;
         for (double j = 0; j < 8; ++j){
             row.push_back(nullptr);
 
-            Vec3D pointA1 = Vec3D{i + bottomLeft[0], 0., j + bottomLeft[1]};
-            Vec3D pointC1 = Vec3D{i + 1. + bottomLeft[0], 0., j + 1. + bottomLeft[1]};
-            Vec3D pointB1 = Vec3D{i + bottomLeft[0], 0., j + 1. + bottomLeft[1]};
-            auto pTriangle1 = std::make_shared<RT::Triangle>(pointA1, pointB1, pointC1);
-
-            Vec3D pointA2 = Vec3D{i + 1 + bottomLeft[0], 0., j + bottomLeft[1]};
-            Vec3D pointC2 = Vec3D{i + 1 + bottomLeft[0], 0., j + 1 + bottomLeft[1]};
-            Vec3D pointB2 = Vec3D{i + bottomLeft[0], 0., j + bottomLeft[1]};
-            auto pTriangle2 = std::make_shared<RT::Triangle>(pointA2, pointB2, pointC2);
-
+            // One quad per square, facing up like the two triangles it replaces
+            auto pSquare = std::make_shared<RT::Quad>(Vec3D{i + bottomLeft[0], 0., j + bottomLeft[1]},
+                                                      Vec3D{0., 0., 1.}, Vec3D{1., 0., 0.});
             if ((int)(i + j) % 2 == 0){
-                pTriangle1->SetMaterial(Config::WHITE_BOARD_MATERIAL);
-                pTriangle2->SetMaterial(Config::WHITE_BOARD_MATERIAL);
+                pSquare->SetMaterial(Config::WHITE_BOARD_MATERIAL);
             } else{
-                pTriangle1->SetMaterial(Config::BLACK_BOARD_MATERIAL);
-                pTriangle2->SetMaterial(Config::BLACK_BOARD_MATERIAL);
+                pSquare->SetMaterial(Config::BLACK_BOARD_MATERIAL);
             }
-
-            triangleGrid_.push_back(pTriangle1);
-            triangleGrid_.push_back(pTriangle2);
+            triangleGrid_.push_back(pSquare);
         }
     }
 
@@ -37,24 +165,24 @@ RT::Chessboard::Chessboard(const Vec3D &bottomLeft) {
         for (int j = 0; j < 8; ++j){
             std::string figureName = figures_[i][j];
             if (figureName != "empty") {
-                auto figure = ObjLoader::loadTriangleMeshObj(figureName + ".obj");
+                // Translating the copy keeps the edges and normals computed by the cache
+                std::shared_ptr<RT::Object> figure;
+                if (auto pSurface = analyticPieces ? LoadPieceSurface(figureName) : nullptr){
+                    figure = std::make_shared<RT::SurfaceOfRevolution>(*pSurface);
+                } else{
+                    figure = std::make_shared<RT::TriangleMesh>(*LoadPiece(figureName));
+                }
                 if (figureName == "pawn"){
-                    figure->Fit1x1(0.65, 0.65);
                     figure->SetMaterial(Config::PAWN_MATERIAL);
                 } else if (figureName == "rook"){
-                    figure->Fit1x1(0.65, 0.65);
                     figure->SetMaterial(Config::ROOK_MATERIAL);
                 } else if (figureName == "bishop") {
-                    figure->Fit1x1(0.75, 0.75);
                     figure->SetMaterial(Config::BISHOP_MATERIAL);
                 } else if (figureName == "knight"){
-                    figure->Fit1x1(0.75, 0.75);
                     figure->SetMaterial(Config::KNIGHT_MATERIAL);
                 } else if (figureName == "king"){
-                    figure->Fit1x1(0.8, 0.8);
                     figure->SetMaterial(Config::KING_MATERIAL);
                 } else{
-                    figure->Fit1x1(0.8, 0.8);
                     figure->SetMaterial(Config::QUEEN_MATERIAL);
                 }
                 figure->SetCenter(Vec3D{i + 0.5, 0., j + 0.5});
@@ -63,64 +191,54 @@ RT::Chessboard::Chessboard(const Vec3D &bottomLeft) {
         }
     }
 
-    // Create chess board rim objects
-    Vec3D pointA = Vec3D{8., -1., 8.};
-    Vec3D pointB = Vec3D{8., 0., 8.};
-    Vec3D pointC = Vec3D{0., 0., 8.};
-    auto pTriangle = std::make_shared<RT::Triangle>(pointA, pointB, pointC);
-    pTriangle->SetMaterial(Config::BLACK_BOARD_MATERIAL);
-    triangleGrid_.push_back(pTriangle);
-
-    pointA = Vec3D{0., 0., 8.};
-    pointB = Vec3D{0., -1., 8.};
-    pointC = Vec3D{8., -1., 8.};
-    pTriangle = std::make_shared<RT::Triangle>(pointA, pointB, pointC);
-    pTriangle->SetMaterial(Config::BLACK_BOARD_MATERIAL);
-    triangleGrid_.push_back(pTriangle);
-
-    pointA = Vec3D{8., 0., 8.};
-    pointB = Vec3D{8., -1., 0.};
-    pointC = Vec3D{8., 0., 0.};
-    pTriangle = std::make_shared<RT::Triangle>(pointA, pointB, pointC);
-    pTriangle->SetMaterial(Config::BLACK_BOARD_MATERIAL);
-    triangleGrid_.push_back(pTriangle);
-
-    pointA = Vec3D{0., 0., 8.};
-    pointB = Vec3D{0., -1., 8.};
-    pointC = Vec3D{0., 0., 0.};
-    pTriangle = std::make_shared<RT::Triangle>(pointA, pointB, pointC);
-    pTriangle->SetMaterial(Config::BLACK_BOARD_MATERIAL);
-    triangleGrid_.push_back(pTriangle);
-
-    pointA = Vec3D{0., -1., 8.};
-    pointB = Vec3D{0., -1., 0.};
-    pointC = Vec3D{0., 0., 0.};
-    pTriangle = std::make_shared<RT::Triangle>(pointA, pointB, pointC);
-    pTriangle->SetMaterial(Config::BLACK_BOARD_MATERIAL);
-    triangleGrid_.push_back(pTriangle);
-
-    pointA = Vec3D{0., -1., 0.};
-    pointB = Vec3D{8., -1., 0.};
-    pointC = Vec3D{8., 0., 0.};
-    pTriangle = std::make_shared<RT::Triangle>(pointA, pointB, pointC);
-    pTriangle->SetMaterial(Config::BLACK_BOARD_MATERIAL);
-    triangleGrid_.push_back(pTriangle);
-
-    pointA = Vec3D{8., 0., 0.};
-    pointB = Vec3D{0., 0., 0.};
-    pointC = Vec3D{0., -1., 0.};
-    pTriangle = std::make_shared<RT::Triangle>(pointA, pointB, pointC);
-    pTriangle->SetMaterial(Config::BLACK_BOARD_MATERIAL);
-    triangleGrid_.push_back(pTriangle);
-
-    pointA = Vec3D{8., 0., 8.};
-    pointB = Vec3D{8., -1., 8.};
-    pointC = Vec3D{8., -1., 0.};
-    pTriangle = std::make_shared<RT::Triangle>(pointA, pointB, pointC);
-    pTriangle->SetMaterial(Config::BLACK_BOARD_MATERIAL);
-    triangleGrid_.push_back(pTriangle);
-
+    // Create chess board rim objects as corner, edge u, edge v, normals along +x and +z like the triangles they
+    // were made of
+    const Vec3D rimFaces[4][3] = {
+            {Vec3D{0., -1., 8.}, Vec3D{8., 0., 0.}, Vec3D{0., 1., 0.}}, // z = 8
+            {Vec3D{8., -1., 0.}, Vec3D{0., 1., 0.}, Vec3D{0., 0., 8.}}, // x = 8
+            {Vec3D{0., -1., 0.}, Vec3D{0., 1., 0.}, Vec3D{0., 0., 8.}}, // x = 0
+            {Vec3D{0., -1., 0.}, Vec3D{8., 0., 0.}, Vec3D{0., 1., 0.}}  // z = 0
+    };
+    for (const auto& face : rimFaces){
+        auto pRim = std::make_shared<RT::Quad>(face[0], face[1], face[2]);
+        pRim->SetMaterial(Config::BLACK_BOARD_MATERIAL);
+        triangleGrid_.push_back(pRim);
+    }
+}
 
+RT::FigureConfiguration RT::Chessboard::FiguresFromFen(const std::string &fen) {
+    RT::FigureConfiguration figures(8, std::vector<std::string>(8, "empty"));
+    // Only the placement field is used, the rest of a full FEN record is ignored
+    std::string placement = fen.substr(0, fen.find(' '));
+    int rank = 7;
+    int file = 0;
+    for (char c : placement){
+        if (c == '/'){
+            if (file != 8) throw std::invalid_argument("FEN rank " + std::to_string(rank + 1) + " doesn't have 8 squares");
+            --rank;
+            file = 0;
+            if (rank < 0) throw std::invalid_argument("FEN has more than 8 ranks");
+        } else if (c >= '1' && c <= '8'){
+            file += c - '0';
+        } else{
+            std::string name;
+            switch (tolower(c)){
+                case 'p': name = "pawn"; break;
+                case 'n': name = "knight"; break;
+                case 'b': name = "bishop"; break;
+                case 'r': name = "rook"; break;
+                case 'q': name = "queen"; break;
+                case 'k': name = "king"; break;
+                default: throw std::invalid_argument(std::string("Unknown FEN piece: ") + c);
+            }
+            if (file >= 8) throw std::invalid_argument("FEN rank " + std::to_string(rank + 1) + " has too many squares");
+            figures[rank][file] = name;
+            ++file;
+        }
+        if (file > 8) throw std::invalid_argument("FEN rank " + std::to_string(rank + 1) + " has too many squares");
+    }
+    if (rank != 0 || file != 8) throw std::invalid_argument("FEN must describe all 8 ranks");
+    return figures;
 }
 
 std::vector<std::shared_ptr<RT::Object>> RT::Chessboard::GetObjectPointers() {
@@ -11,8 +11,12 @@
 #include "../Utilities/Config.h"
 #include "Objects.h"
 #include <vector>
+#include <string>
 
 namespace RT{
+    /// \brief Names of figures on each square, indexed [row][column] as in Config::FIGURE_CONFIGURATION
+    using FigureConfiguration = std::vector<std::vector<std::string>>;
+
     class Chessboard{
     public:
         /** \brief Creates the chessboard object and its pieces
@@ -20,6 +24,50 @@ namespace RT{
          * @param bottomLeft sets up the bottom left corner coordinates of the chessboard
          */
         Chessboard(const Vec3D& bottomLeft);
+        /** \brief Creates the chessboard object with custom placement of pieces
+         *
+         * @param bottomLeft sets up the bottom left corner coordinates of the chessboard
+         * @param figures figure names for each square, "empty" for no figure
+         * @param analyticPieces lathe-shaped figures are placed as surfaces of revolution (LoadPieceSurface())
+         */
+        Chessboard(const Vec3D& bottomLeft, const RT::FigureConfiguration& figures, bool analyticPieces = false);
+        /** \brief Converts piece placement part of FEN notation to figure configuration
+         *
+         * Colors are ignored, because materials are assigned per figure type (see Config.h).
+         * Throws std::invalid_argument on malformed input.
+         */
+        static RT::FigureConfiguration FiguresFromFen(const std::string& fen);
+        /** \brief Returns the mesh of a figure ("pawn", "king", ...) fitted to a board square, copy it to place it
+         *
+         * Pieces embedded in the executable at build time (EmbeddedMeshes.h) are viewed in memory. Pieces of the
+         * directory set by SetPieceDirectory(), or of Utils::OBJECTS_DIRECTORY in builds without embedded ones,
+         * are loaded by LoadPieceFile().
+         */
+        static std::shared_ptr<const RT::TriangleMesh> LoadPiece(const std::string& figureName);
+        /** \brief Loads the OBJ file of a figure in directory once per process through MeshCache::Shared()
+         *
+         * The bundled pieces are exported with flat normals, so their normals and texture coordinates are dropped
+         * and smooth vertex normals are computed from the faces instead.
+         */
+        static std::shared_ptr<const RT::TriangleMesh> LoadPieceFile(const std::string& figureName,
+                                                                     const std::string& directory);
+        /** \brief Returns a figure fitted to a board square as a surface of revolution, null if it isn't lathe-shaped
+         *
+         * The profile is fitted to the mesh of LoadPiece() within Utils::REVOLUTION_FIT_TOLERANCE
+         * (SurfaceOfRevolution::FitProfile()), once per figure and piece source. Pawn, rook, queen and king fit,
+         * the mitre of the bishop and the knight don't.
+         */
+        static std::shared_ptr<const RT::SurfaceOfRevolution> LoadPieceSurface(const std::string& figureName);
+        /// \brief Options the piece OBJ files are loaded with
+        static ObjLoadOptions GetPieceLoadOptions();
+        /// \brief Loads pieces from OBJ files in directory instead of the embedded ones, empty restores the default
+        static void SetPieceDirectory(const std::string& directory);
+        /// \brief Identifies the source of a figure, the checksum of the embedded image or of the file content
+        static uint64_t GetPieceSourceKey(const std::string& figureName);
+        /// \brief Source keys of all six figures combined, changes whenever any piece a scene may use changes
+        static uint64_t GetPieceSetKey();
+        /// \brief Loads all figures into the mesh cache in parallel, so the first scene doesn't wait for them
+        static void PrewarmPieces();
         /** \brief Returns pointers to stored objects(board, pieces)
          *
          *
@@ -30,7 +78,7 @@ namespace RT{
         std::vector<std::vector<std::shared_ptr<RT::Object>>> board_;
         std::vector<std::shared_ptr<RT::Object>> triangleGrid_;
 
-        std::vector<std::vector<std::string>> figures_ = Config::FIGURE_CONFIGURATION;
+        RT::FigureConfiguration figures_;
     };
 }
 
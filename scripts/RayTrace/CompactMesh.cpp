@@ -0,0 +1,120 @@
+#include "CompactMesh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    constexpr double NORMAL_SCALE = std::numeric_limits<int16_t>::max();
+    constexpr double LENGTH_SCALE = std::numeric_limits<uint16_t>::max();
+
+    double SignNotZero(double value) {
+        return value < 0. ? -1. : 1.;
+    }
+}
+
+RT::CompactMesh::CompactMesh(const RT::MeshArray<Vec3D> &vertices, const RT::MeshArray<Vector<int, 3>> &triangles,
+                             const RT::MeshArray<Vec3D> &vertexNormals,
+                             const RT::MeshArray<RT::MeshBvhNode> &bvh) {
+    if (vertexNormals.size() != vertices.size()){
+        throw std::invalid_argument("Mesh needs one vertex normal per vertex to be compacted");
+    }
+    Vec3D low{DBL_MAX, DBL_MAX, DBL_MAX}, high{-DBL_MAX, -DBL_MAX, -DBL_MAX};
+    for (const auto& vertex : vertices){
+        for (size_t axis = 0; axis < 3; ++axis){
+            low[axis] = std::min(low[axis], vertex[axis]);
+            high[axis] = std::max(high[axis], vertex[axis]);
+        }
+    }
+    // One step below the lowest vertex, so positions start at 1 and boxes can be padded to 0
+    for (size_t axis = 0; axis < 3; ++axis){
+        double extent = vertices.empty() ? 0. : high[axis] - low[axis];
+        step_[axis] = extent > 0. ? extent / POSITION_STEPS : 1.;
+        origin_[axis] = vertices.empty() ? 0. : low[axis] - step_[axis];
+    }
+
+    positions_.reserve(3 * vertices.size());
+    normals_.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i){
+        for (size_t axis = 0; axis < 3; ++axis){
+            double steps = std::round((vertices[i][axis] - origin_[axis]) / step_[axis]);
+            positions_.push_back(static_cast<uint16_t>(std::clamp(steps, 1., POSITION_STEPS + 1.)));
+        }
+        normals_.push_back(EncodeNormal(vertexNormals[i]));
+    }
+
+    bool wide = vertices.size() > std::numeric_limits<uint16_t>::max() + size_t(1);
+    if (wide) indices32_.reserve(3 * triangles.size());
+    else indices16_.reserve(3 * triangles.size());
+    for (const auto& triangle : triangles){
+        for (size_t corner = 0; corner < 3; ++corner){
+            if (wide) indices32_.push_back(static_cast<uint32_t>(triangle[corner]));
+            else indices16_.push_back(static_cast<uint16_t>(triangle[corner]));
+        }
+    }
+
+    // Boxes are bounded anew from the quantised corners, children follow their parent, so walking backwards
+    // finds both children done
+    bvh_.resize(bvh.size());
+    for (size_t i = bvh.size(); i-- > 0;){
+        const RT::MeshBvhNode& source = bvh[i];
+        RT::CompactBvhNode& node = bvh_[i];
+        node.first = source.first;
+        node.count = source.count;
+        uint32_t lowSteps[3] = {UINT32_MAX, UINT32_MAX, UINT32_MAX}, highSteps[3] = {0, 0, 0};
+        if (source.IsLeaf()){
+            for (size_t triangle = source.first; triangle < source.first + source.count; ++triangle){
+                uint32_t corners[3];
+                GetTriangle(triangle, corners);
+                for (uint32_t corner : corners){
+                    for (size_t axis = 0; axis < 3; ++axis){
+                        lowSteps[axis] = std::min<uint32_t>(lowSteps[axis], positions_[3 * corner + axis] - 1);
+                        highSteps[axis] = std::max<uint32_t>(highSteps[axis], positions_[3 * corner + axis] + 1);
+                    }
+                }
+            }
+        } else{
+            for (const RT::CompactBvhNode* pChild : {&bvh_[i + 1], &bvh_[source.first]}){
+                for (size_t axis = 0; axis < 3; ++axis){
+                    lowSteps[axis] = std::min<uint32_t>(lowSteps[axis], pChild->min[axis]);
+                    highSteps[axis] = std::max<uint32_t>(highSteps[axis], pChild->max[axis]);
+                }
+            }
+        }
+        for (size_t axis = 0; axis < 3; ++axis){
+            node.min[axis] = static_cast<uint16_t>(lowSteps[axis]);
+            node.max[axis] = static_cast<uint16_t>(highSteps[axis]);
+        }
+    }
+}
+
+RT::CompactNormal RT::CompactMesh::EncodeNormal(const Vec3D &normal) {
+    RT::CompactNormal encoded{0, 0, 0};
+    double length = std::sqrt(normal.dot(normal));
+    double sum = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    // Also false for NaN, which the normals of unused vertices are
+    if (!(sum > 0.)) return encoded;
+    double u = normal[0] / sum, v = normal[1] / sum;
+    // The lower half is folded over the diagonals of the square
+    if (normal[2] < 0.){
+        double foldedU = (1. - std::fabs(v)) * SignNotZero(u);
+        v = (1. - std::fabs(u)) * SignNotZero(v);
+        u = foldedU;
+    }
+    encoded.x = static_cast<int16_t>(std::round(std::clamp(u, -1., 1.) * NORMAL_SCALE));
+    encoded.y = static_cast<int16_t>(std::round(std::clamp(v, -1., 1.) * NORMAL_SCALE));
+    encoded.length = static_cast<uint16_t>(std::round(std::min(length, 1.) * LENGTH_SCALE));
+    return encoded;
+}
+
+Vec3D RT::CompactMesh::DecodeNormal(const RT::CompactNormal &normal) {
+    double u = normal.x / NORMAL_SCALE, v = normal.y / NORMAL_SCALE;
+    double z = 1. - std::fabs(u) - std::fabs(v);
+    if (z < 0.){
+        double unfoldedU = (1. - std::fabs(v)) * SignNotZero(u);
+        v = (1. - std::fabs(u)) * SignNotZero(v);
+        u = unfoldedU;
+    }
+    return Vec3D{u, v, z}.normalized() * (normal.length / LENGTH_SCALE);
+}
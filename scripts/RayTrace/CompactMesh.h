@@ -0,0 +1,125 @@
+/**
+ * @file CompactMesh.h
+ * @brief Defines the CompactMesh class, quantised mesh data decoded by the intersection kernel.
+ */
+#ifndef MAIN_CPP_COMPACTMESH_H
+#define MAIN_CPP_COMPACTMESH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../LinearAlgebra/Vector.h"
+#include "MeshArray.h"
+#include "MeshBvh.h"
+
+namespace RT{
+    /**
+     * @struct CompactBvhNode
+     * @brief MeshBvhNode with its box in quantised mesh coordinates, 20 bytes instead of 56.
+     */
+    struct CompactBvhNode{
+        uint16_t min[3];
+        uint16_t max[3];
+        uint32_t first;
+        uint32_t count;
+
+        bool IsLeaf() const { return count != 0; }
+    };
+
+    /**
+     * @struct CompactNormal
+     * @brief Octahedral encoded direction and length of a vertex normal, 6 bytes instead of 24.
+     */
+    struct CompactNormal{
+        int16_t x;
+        int16_t y;
+        uint16_t length;
+    };
+
+    /**
+     * @class CompactMesh
+     * @brief Positions, indices, vertex normals and BVH of a TriangleMesh in about a sixth of the memory.
+     *
+     * Positions are 16-bit steps within the bounds of the mesh, vertex normals are octahedral encoded into two
+     * 16-bit values with a 16-bit length (normals averaged from faces are shorter than 1 and shade that way),
+     * indices are 16-bit for meshes of at most 65536 vertices. Edges and face normals aren't stored,
+     * the kernel computes them from the decoded corners. Nodes are rounded outwards to whole steps and padded by
+     * one, so every box contains its decoded triangles.
+     */
+    class CompactMesh{
+    public:
+        /// \brief Steps across the coordinate range of every axis, the rest of 16 bits pads the boxes
+        static constexpr uint32_t POSITION_STEPS = 65533;
+
+        /// \brief Encodes the arrays of a mesh, triangles in the order of the BVH leaves
+        CompactMesh(const RT::MeshArray<Vec3D>& vertices, const RT::MeshArray<Vector<int, 3>>& triangles,
+                    const RT::MeshArray<Vec3D>& vertexNormals, const RT::MeshArray<RT::MeshBvhNode>& bvh);
+
+        size_t GetVertexNum() const { return positions_.size() / 3; }
+        size_t GetTriangleNum() const { return (indices16_.size() + indices32_.size()) / 3; }
+        const std::vector<RT::CompactBvhNode>& GetBvh() const { return bvh_; }
+
+        Vec3D GetVertex(uint32_t vertex) const {
+            const uint16_t* pPosition = &positions_[3 * vertex];
+            return Vec3D{origin_[0] + pPosition[0] * step_[0], origin_[1] + pPosition[1] * step_[1],
+                         origin_[2] + pPosition[2] * step_[2]};
+        }
+        void GetTriangle(size_t triangle, uint32_t corners[3]) const {
+            for (size_t corner = 0; corner < 3; ++corner){
+                corners[corner] = indices16_.empty() ? indices32_[3 * triangle + corner]
+                                                     : indices16_[3 * triangle + corner];
+            }
+        }
+        Vec3D GetVertexNormal(uint32_t vertex) const { return DecodeNormal(normals_[vertex]); }
+
+        /// \brief Converts a ray for Enter(), origin into steps from the mesh origin, directions scaled to match
+        void ToSteps(const double origin[3], const double inverseDirection[3], double stepOrigin[3],
+                     double stepInverseDirection[3]) const {
+            for (size_t axis = 0; axis < 3; ++axis){
+                stepOrigin[axis] = (origin[axis] - origin_[axis]) / step_[axis];
+                stepInverseDirection[axis] = inverseDirection[axis] * step_[axis];
+            }
+        }
+        /// \brief Same as MeshBvh::Enter() for a ray converted by ToSteps(), distances stay in mesh units
+        static double Enter(const RT::CompactBvhNode& node, const double stepOrigin[3],
+                            const double stepInverseDirection[3], double maxDistance) {
+            double near = 0., far = maxDistance;
+            for (size_t axis = 0; axis < 3; ++axis){
+                double t0 = (node.min[axis] - stepOrigin[axis]) * stepInverseDirection[axis];
+                double t1 = (node.max[axis] - stepOrigin[axis]) * stepInverseDirection[axis];
+                if (t0 > t1) std::swap(t0, t1);
+                near = t0 > near ? t0 : near;
+                far = t1 < far ? t1 : far;
+                if (near > far) return -1.;
+            }
+            return near;
+        }
+
+        /** @{ \name Bytes held, by the arrays they replace */
+        size_t GetPositionBytes() const { return positions_.capacity() * sizeof(uint16_t); }
+        size_t GetIndexBytes() const {
+            return indices16_.capacity() * sizeof(uint16_t) + indices32_.capacity() * sizeof(uint32_t);
+        }
+        size_t GetNormalBytes() const { return normals_.capacity() * sizeof(RT::CompactNormal); }
+        size_t GetBvhBytes() const { return bvh_.capacity() * sizeof(RT::CompactBvhNode); }
+        /** @} */
+
+        /// \brief Octahedral encoding, the direction folded onto the xy square, lengths above 1 are clamped
+        static RT::CompactNormal EncodeNormal(const Vec3D& normal);
+        static Vec3D DecodeNormal(const RT::CompactNormal& normal);
+
+    private:
+        Vec3D origin_;
+        Vec3D step_;
+        std::vector<uint16_t> positions_;
+        // Only one of them is filled
+        std::vector<uint16_t> indices16_;
+        std::vector<uint32_t> indices32_;
+        std::vector<RT::CompactNormal> normals_;
+        std::vector<RT::CompactBvhNode> bvh_;
+    };
+}
+
+#endif
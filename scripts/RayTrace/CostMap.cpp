@@ -0,0 +1,110 @@
+#include "CostMap.h"
+#include "ToneMapper.h"
+#include "../Image/ImageWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    /// \brief Stops of the false colour gradient (dark purple to light yellow, similar to inferno)
+    constexpr double GRADIENT[][3] = {
+        {0., 0., 4.},
+        {87., 16., 110.},
+        {188., 55., 84.},
+        {249., 142., 9.},
+        {252., 255., 164.}
+    };
+    constexpr size_t GRADIENT_STOPS = sizeof(GRADIENT) / sizeof(GRADIENT[0]);
+    /// \brief Values at this percentile and above get the brightest color
+    constexpr double SCALE_PERCENTILE = 0.99;
+
+    uint32_t FalseColor(double value) {
+        double position = std::clamp(value, 0., 1.) * (GRADIENT_STOPS - 1);
+        size_t stop = std::min(static_cast<size_t>(position), GRADIENT_STOPS - 2);
+        double t = position - stop;
+        uint32_t channels[3];
+        for (size_t i = 0; i < 3; ++i){
+            channels[i] = static_cast<uint32_t>(GRADIENT[stop][i] + (GRADIENT[stop + 1][i] - GRADIENT[stop][i]) * t);
+        }
+        return RT::ToneMapper::Pack(channels[0], channels[1], channels[2]);
+    }
+}
+
+void RT::CostMap::Resize(size_t width, size_t height) {
+    width_ = width;
+    height_ = height;
+    pixels_.assign(width * height, PixelCost{});
+}
+
+void RT::CostMap::Clear() {
+    std::fill(pixels_.begin(), pixels_.end(), PixelCost{});
+}
+
+double RT::CostMap::GetValue(size_t x, size_t y, RT::CostMap::Metric metric) const {
+    const PixelCost& pixel = GetPixel(x, y);
+    switch (metric) {
+        case Metric::BOX_TESTS:
+            return static_cast<double>(pixel.boxTests);
+        case Metric::TRIANGLE_TESTS:
+            return static_cast<double>(pixel.triangleTests);
+        default:
+            return pixel.nanoseconds;
+    }
+}
+
+std::vector<uint32_t> RT::CostMap::ToFalseColor(RT::CostMap::Metric metric) const {
+    std::vector<double> values(width_ * height_);
+    for (size_t y = 0; y < height_; ++y){
+        for (size_t x = 0; x < width_; ++x){
+            values[y * width_ + x] = GetValue(x, y, metric);
+        }
+    }
+    double scale = 0.;
+    if (!values.empty()){
+        std::vector<double> sorted = values;
+        auto percentile = sorted.begin() + static_cast<ptrdiff_t>((sorted.size() - 1) * SCALE_PERCENTILE);
+        std::nth_element(sorted.begin(), percentile, sorted.end());
+        scale = *percentile > 0. ? 1. / *percentile : 0.;
+    }
+
+    std::vector<uint32_t> image(width_ * height_);
+    for (size_t y = 0; y < height_; ++y){
+        for (size_t x = 0; x < width_; ++x){
+            image[(height_ - y - 1) * width_ + x] = FalseColor(values[y * width_ + x] * scale);
+        }
+    }
+    return image;
+}
+
+void RT::CostMap::SaveHeatmaps(const std::string &imagePath) const {
+    if (IsEmpty()) throw std::logic_error("Cost map is empty, enable it before rendering");
+    RT::ImageFormat format = RT::ImageFormatFromPath(imagePath);
+    for (size_t i = 0; i < static_cast<size_t>(Metric::COUNT); ++i){
+        std::string path = HeatmapPath(imagePath, static_cast<Metric>(i));
+        std::ofstream image(path, std::ios::binary | std::ios::out);
+        if (!image.is_open()) throw std::runtime_error("Error opening file: " + path);
+        std::vector<uint32_t> pixels = ToFalseColor(static_cast<Metric>(i));
+        auto pWriter = RT::ImageWriter::Create(format, image, width_, height_);
+        pWriter->WriteRows(pixels.data(), height_);
+        pWriter->Finish();
+    }
+}
+
+std::string RT::CostMap::HeatmapPath(const std::string &imagePath, RT::CostMap::Metric metric) {
+    size_t dot = imagePath.find_last_of('.');
+    return imagePath.substr(0, dot) + "." + MetricName(metric) + imagePath.substr(dot);
+}
+
+const char* RT::CostMap::MetricName(RT::CostMap::Metric metric) {
+    switch (metric) {
+        case Metric::BOX_TESTS:
+            return "boxes";
+        case Metric::TRIANGLE_TESTS:
+            return "triangles";
+        case Metric::TIME:
+            return "time";
+        default:
+            return "";
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * @file CostMap.h
+ * @brief Defines the CostMap class, per-pixel cost of rendering shown as false-colour heatmaps.
+ */
+#ifndef MAIN_CPP_COSTMAP_H
+#define MAIN_CPP_COSTMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RT{
+    /**
+     * @struct PixelCost
+     * @brief Work spent on all samples of one pixel.
+     */
+    struct PixelCost{
+        uint64_t boxTests = 0;
+        uint64_t triangleTests = 0;
+        double nanoseconds = 0.;
+    };
+
+    /**
+     * @class CostMap
+     * @brief Box tests, triangle tests and wall time of every pixel of a render.
+     *
+     * Filled by Scene when enabled with Scene::EnableCostMap(), rows go from the bottom like in the framebuffer.
+     * Test counts come from RenderStats, so they stay 0 when __STATS__ is off. Heatmaps are scaled to the 99th
+     * percentile of the metric, so a few extreme pixels don't turn the rest of the image black.
+     */
+    class CostMap{
+    public:
+        enum class Metric{
+            BOX_TESTS,
+            TRIANGLE_TESTS,
+            TIME,
+            COUNT
+        };
+
+        /// \brief Changes size and zeroes all pixels
+        void Resize(size_t width, size_t height);
+        void Clear();
+
+        size_t GetWidth() const { return width_; }
+        size_t GetHeight() const { return height_; }
+        bool IsEmpty() const { return pixels_.empty(); }
+        size_t GetMemoryUsage() const { return pixels_.capacity() * sizeof(PixelCost); }
+
+        void Add(size_t x, size_t y, uint64_t boxTests, uint64_t triangleTests, double nanoseconds) {
+            PixelCost& pixel = pixels_[y * width_ + x];
+            pixel.boxTests += boxTests;
+            pixel.triangleTests += triangleTests;
+            pixel.nanoseconds += nanoseconds;
+        }
+        const PixelCost& GetPixel(size_t x, size_t y) const { return pixels_[y * width_ + x]; }
+        double GetValue(size_t x, size_t y, Metric metric) const;
+
+        /// \brief Heatmap of a metric as 0xAARRGGBB pixels with rows from the top, ready for ImageWriter
+        std::vector<uint32_t> ToFalseColor(Metric metric) const;
+        /**
+         * @brief Saves a heatmap of every metric next to the image.
+         *
+         * For `output.bmp` these are `output.boxes.bmp`, `output.triangles.bmp` and `output.time.bmp`.
+         */
+        void SaveHeatmaps(const std::string& imagePath) const;
+
+        /// \brief Path of the metric heatmap belonging to imagePath
+        static std::string HeatmapPath(const std::string& imagePath, Metric metric);
+        /// \brief Lowercase name of the metric, used in heatmap file names
+        static const char* MetricName(Metric metric);
+
+    private:
+        size_t width_ = 0;
+        size_t height_ = 0;
+        std::vector<PixelCost> pixels_;
+    };
+}
+
+#endif
@@ -0,0 +1,52 @@
+#include "Framebuffer.h"
+#include "../Utilities/Utils.h"
+#include <algorithm>
+
+RT::Framebuffer::Framebuffer(size_t width, size_t height) {
+    Resize(width, height);
+}
+
+size_t RT::Framebuffer::GetRequiredMemory(size_t width, size_t height) {
+    size_t tiles = std::max<size_t>((width + TILE_SIZE - 1) / TILE_SIZE * ((height + TILE_SIZE - 1) / TILE_SIZE), 1);
+    return tiles * (TILE_PIXELS * sizeof(AccumulatedPixel) + sizeof(std::atomic<bool>));
+}
+
+void RT::Framebuffer::Resize(size_t width, size_t height) {
+    size_t tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    size_t tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    if (tilesX * tilesY != tilesX_ * tilesY_ || !pPixels_){
+        size_t bytes = std::max<size_t>(tilesX * tilesY, 1) * TILE_PIXELS * sizeof(AccumulatedPixel);
+        pPixels_.reset(static_cast<AccumulatedPixel*>(::operator new[](bytes, std::align_val_t(CACHE_LINE))));
+        pDirtyTiles_.reset(new std::atomic<bool>[std::max<size_t>(tilesX * tilesY, 1)]);
+    }
+    width_ = width;
+    height_ = height;
+    tilesX_ = tilesX;
+    tilesY_ = tilesY;
+    Clear();
+}
+
+void RT::Framebuffer::Clear() {
+    std::fill(pPixels_.get(), pPixels_.get() + std::max<size_t>(GetTileCount(), 1) * TILE_PIXELS, AccumulatedPixel{});
+    MarkAllDirty();
+}
+
+void RT::Framebuffer::MarkAllDirty() const {
+    for (size_t tile = 0; tile < GetTileCount(); ++tile){
+        MarkTileDirty(tile);
+    }
+}
+
+void RT::Framebuffer::GetTileBounds(size_t tile, size_t &x0, size_t &y0, size_t &x1, size_t &y1) const {
+    x0 = (tile % tilesX_) * TILE_SIZE;
+    y0 = (tile / tilesX_) * TILE_SIZE;
+    x1 = std::min(x0 + TILE_SIZE, width_);
+    y1 = std::min(y0 + TILE_SIZE, height_);
+}
+
+Vec3D RT::Framebuffer::GetColor(size_t x, size_t y) const {
+    const AccumulatedPixel& pixel = GetPixel(x, y);
+    if (pixel.samples <= 0.f) return Utils::BACKGROUND_COLOR;
+    double inverse = 1. / pixel.samples;
+    return Vec3D{pixel.r * inverse, pixel.g * inverse, pixel.b * inverse};
+}
@@ -0,0 +1,109 @@
+/**
+ * @file Framebuffer.h
+ * @brief Defines the Framebuffer class, accumulation buffer of rendered samples.
+ */
+#ifndef MAIN_CPP_FRAMEBUFFER_H
+#define MAIN_CPP_FRAMEBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include "../LinearAlgebra/Vector.h"
+
+namespace RT{
+    /**
+     * @struct AccumulatedPixel
+     * @brief Sum of all sample colors of one pixel and the amount of samples, the average is sum / samples.
+     */
+    struct alignas(16) AccumulatedPixel{
+        float r = 0.f;
+        float g = 0.f;
+        float b = 0.f;
+        float samples = 0.f;
+    };
+
+    /**
+     * @class Framebuffer
+     * @brief Single contiguous RGBA float buffer, where A holds the sample count.
+     *
+     * Pixels are stored tile by tile (TILE_SIZE x TILE_SIZE pixels, row major inside a tile), one tile is 4 KiB
+     * and starts on a cache line boundary. Threads rendering different tiles therefore never write to the same
+     * cache line, and a tile stays in cache while it's being rendered. y = 0 is the bottom row of the image.
+     * Every tile has a dirty flag, set by the renderer once the tile is finished and taken by the display.
+     */
+    class Framebuffer{
+    public:
+        static constexpr size_t TILE_SIZE = 16;
+        static constexpr size_t TILE_PIXELS = TILE_SIZE * TILE_SIZE;
+        static constexpr size_t CACHE_LINE = 64;
+
+        Framebuffer() = default;
+        Framebuffer(size_t width, size_t height);
+
+        /// \brief Changes size and clears all pixels
+        void Resize(size_t width, size_t height);
+        /// \brief Sets all sums and sample counts to 0, marks all tiles dirty
+        void Clear();
+
+        size_t GetWidth() const { return width_; }
+        size_t GetHeight() const { return height_; }
+        size_t GetTilesX() const { return tilesX_; }
+        size_t GetTilesY() const { return tilesY_; }
+        size_t GetTileCount() const { return tilesX_ * tilesY_; }
+        /// \brief Bytes allocated for pixels and dirty flags, 0 for a default constructed framebuffer
+        size_t GetMemoryUsage() const { return pPixels_ ? GetRequiredMemory(width_, height_) : 0; }
+        /// \brief Bytes Resize(width, height) allocates
+        static size_t GetRequiredMemory(size_t width, size_t height);
+        /// \brief Pixel range [x0, x1) x [y0, y1) covered by a tile, clipped to image size
+        void GetTileBounds(size_t tile, size_t& x0, size_t& y0, size_t& x1, size_t& y1) const;
+
+        /// \brief Adds sum of colors of samples to the pixel
+        void AddSamples(size_t x, size_t y, const Vec3D& colorSum, float samples) {
+            AccumulatedPixel& pixel = pPixels_[Index(x, y)];
+            pixel.r += static_cast<float>(colorSum[0]);
+            pixel.g += static_cast<float>(colorSum[1]);
+            pixel.b += static_cast<float>(colorSum[2]);
+            pixel.samples += samples;
+        }
+        /// \brief Replaces accumulated samples of the pixel with a single color
+        void SetColor(size_t x, size_t y, const Vec3D& color) {
+            pPixels_[Index(x, y)] = AccumulatedPixel{static_cast<float>(color[0]), static_cast<float>(color[1]),
+                                                     static_cast<float>(color[2]), 1.f};
+        }
+        const AccumulatedPixel& GetPixel(size_t x, size_t y) const { return pPixels_[Index(x, y)]; }
+        /// \brief Average color of the pixel in range [0, 1] (not clamped), background color if it has no samples
+        Vec3D GetColor(size_t x, size_t y) const;
+
+        /// \brief Publishes a finished tile, pixels written before the call are visible to whoever takes the flag
+        void MarkTileDirty(size_t tile) const { pDirtyTiles_[tile].store(true, std::memory_order_release); }
+        void MarkAllDirty() const;
+        /// \brief Returns whether the tile changed since the last call and clears its flag
+        bool TakeDirtyTile(size_t tile) const { return pDirtyTiles_[tile].exchange(false, std::memory_order_acq_rel); }
+
+        /// \brief Pointer to the first pixel of a tile, followed by TILE_PIXELS pixels
+        AccumulatedPixel* GetTileData(size_t tile) { return pPixels_.get() + tile * TILE_PIXELS; }
+        const AccumulatedPixel* GetTileData(size_t tile) const { return pPixels_.get() + tile * TILE_PIXELS; }
+
+    private:
+        size_t Index(size_t x, size_t y) const {
+            size_t tile = (y / TILE_SIZE) * tilesX_ + x / TILE_SIZE;
+            return tile * TILE_PIXELS + (y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE;
+        }
+
+        struct AlignedDelete{
+            void operator()(AccumulatedPixel* pPixels) const {
+                ::operator delete[](pPixels, std::align_val_t(CACHE_LINE));
+            }
+        };
+
+        size_t width_ = 0;
+        size_t height_ = 0;
+        size_t tilesX_ = 0;
+        size_t tilesY_ = 0;
+        std::unique_ptr<AccumulatedPixel[], AlignedDelete> pPixels_;
+        std::unique_ptr<std::atomic<bool>[]> pDirtyTiles_;
+    };
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "Material.h"
 #include "../Random/Random.h"
+#include <stdexcept>
+#include <string>
 
 bool RT::Lambertian:: Scatter(const RT::Ray &ray, const RT::HitPayload &hitPayload, RT::ScatterPayload &scatterPayload, int depth) const {
     scatterPayload.damping = albedo_;
@@ -13,6 +15,18 @@ double RT::Lambertian::ScatteringPDF(const RT::Ray& ray, const RT::HitPayload& h
     return std::max(0., cosineTheta / M_PI);
 }
 
+std::shared_ptr<RT::Material> RT::Material::Create(const RT::MaterialParams &params) {
+    switch (params.type) {
+        case RT::MaterialType::LAMBERTIAN:
+            return std::make_shared<RT::Lambertian>(params.albedo);
+        case RT::MaterialType::METAL:
+            return std::make_shared<RT::Metal>(params.albedo, params.fuzz);
+        case RT::MaterialType::DIELECTRIC:
+            return std::make_shared<RT::Dielectric>(params.refractionIndex, params.albedo, params.transparency);
+    }
+    throw std::invalid_argument("Unknown material type " + std::to_string(static_cast<int>(params.type)));
+}
+
 RT::Lambertian::Lambertian(const Vec3D albedo) {
     albedo_ = albedo;
 }
@@ -21,6 +35,13 @@ std::shared_ptr<RT::Material> RT::Lambertian::Clone() const {
     return std::make_unique<RT::Lambertian>(*this);
 }
 
+RT::MaterialParams RT::Lambertian::GetParams() const {
+    RT::MaterialParams params;
+    params.type = RT::MaterialType::LAMBERTIAN;
+    params.albedo = albedo_;
+    return params;
+}
+
 bool RT::Metal::Scatter(const RT::Ray& ray, const RT::HitPayload& hitPayload, RT::ScatterPayload &scatterPayload, int depth) const {
     Vec3D reflected = ray.GetReflected(hitPayload.hitNormal);
     reflected = reflected.normalized() + (fuzz_ * Rand::RandomUnitVector());
@@ -42,6 +63,14 @@ std::shared_ptr<RT::Material> RT::Metal::Clone() const {
     return std::make_unique<RT::Metal>(*this);
 }
 
+RT::MaterialParams RT::Metal::GetParams() const {
+    RT::MaterialParams params;
+    params.type = RT::MaterialType::METAL;
+    params.albedo = albedo_;
+    params.fuzz = fuzz_;
+    return params;
+}
+
 RT::Dielectric::Dielectric(double refractionIndex, Vec3D albedo, Vec3D transparency) {
     refractionIndex_ = refractionIndex;
     albedo_ = albedo;
@@ -50,7 +79,7 @@ RT::Dielectric::Dielectric(double refractionIndex, Vec3D albedo, Vec3D transpare
 
 bool RT::Dielectric::Scatter(const RT::Ray &ray, const RT::HitPayload &hitPayload,
                              RT::ScatterPayload &scatterPayload, int depth) const {
-    scatterPayload.damping = (depth == Utils::BOUNCES) ? albedo_ : transparency_;
+    scatterPayload.damping = (depth == 0) ? albedo_ : transparency_;
     scatterPayload.pPDF = nullptr;
     scatterPayload.skipPDF = true;
 
@@ -81,3 +110,12 @@ double RT::Dielectric::Reflectance(double cosine, double refractionIndex) {
 std::shared_ptr<RT::Material> RT::Dielectric::Clone() const {
     return std::make_unique<RT::Dielectric>(*this);
 }
+
+RT::MaterialParams RT::Dielectric::GetParams() const {
+    RT::MaterialParams params;
+    params.type = RT::MaterialType::DIELECTRIC;
+    params.albedo = albedo_;
+    params.refractionIndex = refractionIndex_;
+    params.transparency = transparency_;
+    return params;
+}
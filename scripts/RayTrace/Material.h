@@ -20,6 +20,25 @@ namespace RT{
         RT::Ray skipPDFRay; /**< The ray to use if skipping the PDF calculation. */
         std::shared_ptr<PDF> pPDF; /**< Pointer to the probability density function for scattering. */
     };
+    /// \brief Concrete material classes, see MaterialParams
+    enum class MaterialType{
+        LAMBERTIAN,
+        METAL,
+        DIELECTRIC
+    };
+    /**
+     * @struct MaterialParams
+     * @brief All parameters of a material, so it can be stored and created again (see SceneSnapshot.h).
+     *
+     * Parameters the type doesn't have are left at their defaults.
+     */
+    struct MaterialParams{
+        RT::MaterialType type = RT::MaterialType::LAMBERTIAN;
+        Vec3D albedo = Utils::BASE_ALBEDO;
+        double fuzz = 0.;
+        double refractionIndex = Utils::BASE_REFRACTION_INDEX;
+        Vec3D transparency = Utils::BASE_TRANSPARENCY;
+    };
     /**
      * @class Material
      * @brief Abstract base class for all materials in the ray tracing environment.
@@ -34,7 +53,7 @@ namespace RT{
          * @param ray Ray to scatter
          * @param hitPayload Hit payload for info about the hit
          * @param scatterPayload Scatter payload for info about the scattering
-         * @param depth Remaining bounces of the ray
+         * @param depth Bounce index of the ray, 0 for rays shot from the camera
          * @return Returns whether the ray should scatter or reflect and sets up scatter payload params such as PDF, scattered ray...
          */
         virtual bool Scatter(const RT::Ray& ray, const RT::HitPayload& hitPayload, RT::ScatterPayload& scatterPayload, int depth) const { return false; }
@@ -47,6 +66,11 @@ namespace RT{
          */
         virtual double ScatteringPDF(const RT::Ray& ray, const RT::HitPayload& hitPayload, const RT::Ray& scattered) const { return false; };
         virtual std::shared_ptr<RT::Material> Clone() const = 0;
+        /// \brief Bytes of the material instance, for Scene::GetMemoryReport()
+        virtual size_t GetMemoryUsage() const = 0;
+        virtual RT::MaterialParams GetParams() const = 0;
+        /// \brief Creates the material of params.type, throws std::invalid_argument for an unknown type
+        static std::shared_ptr<RT::Material> Create(const RT::MaterialParams& params);
 
         virtual void SetAlbedo(Vec3D albedo) const {};
         virtual void SetFuzz(double fuzz) const {};
@@ -66,6 +90,8 @@ namespace RT{
         void SetAlbedo(Vec3D albedo) { albedo_ = albedo; }
 
         std::shared_ptr<RT::Material> Clone() const override;
+        size_t GetMemoryUsage() const override { return sizeof(*this); }
+        RT::MaterialParams GetParams() const override;
 
     private:
         Vec3D albedo_; /**< The albedo (reflectivity) of the material. */
@@ -86,6 +112,8 @@ namespace RT{
         void SetFuzz(double fuzz) { fuzz_ = fuzz; }
 
         std::shared_ptr<RT::Material> Clone() const override;
+        size_t GetMemoryUsage() const override { return sizeof(*this); }
+        RT::MaterialParams GetParams() const override;
 
     private:
         Vec3D albedo_; /**< The albedo (reflectivity) of the material. */
@@ -106,6 +134,8 @@ namespace RT{
         Vec3D GetAlbedo() const { return albedo_; }
 
         std::shared_ptr<RT::Material> Clone() const override;
+        size_t GetMemoryUsage() const override { return sizeof(*this); }
+        RT::MaterialParams GetParams() const override;
 
     private:
         Vec3D albedo_; /**< The albedo (reflectivity) of the material. */
@@ -0,0 +1,61 @@
+#include "MemoryReport.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    std::string FormatMiB(size_t bytes) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.1f MiB", bytes / 1048576.);
+        return text;
+    }
+
+    void CheckLimit(const char* name, size_t bytes, size_t limit) {
+        if (limit == 0 || bytes <= limit) return;
+        throw std::runtime_error(std::string("Memory budget exceeded: ") + name + " would take " + FormatMiB(bytes) +
+                                 ", the budget is " + FormatMiB(limit));
+    }
+}
+
+void RT::MemoryReport::WriteSummary(std::ostream &stream) const {
+    const std::pair<const char*, size_t> rows[] = {
+            {"mesh vertices", meshVertices},
+            {"mesh indices", meshIndices},
+            {"mesh edges", meshEdges},
+            {"mesh normals", meshNormals},
+            {"mesh vertex normals", meshVertexNormals},
+            {"mesh texture coordinates", meshTexCoords},
+            {"mesh BVH", meshBvh},
+            {"mapped mesh files", mappedMeshes},
+            {"objects", objects},
+            {"acceleration structures", accelerationStructures},
+            {"materials", materials},
+            {"framebuffer", framebuffer},
+            {"cost map", costMap},
+            {"thread scratch", threadScratch},
+            {"total", GetTotal()},
+    };
+    char line[64];
+    for (const auto& [name, bytes] : rows){
+        std::snprintf(line, sizeof(line), "  %-24s %12.1f KiB\n", name, bytes / 1024.);
+        stream << line;
+    }
+}
+
+void RT::MemoryReport::WriteJson(std::ostream &stream) const {
+    stream << "{\"mesh_vertices\": " << meshVertices << ", \"mesh_indices\": " << meshIndices
+           << ", \"mesh_edges\": " << meshEdges << ", \"mesh_normals\": " << meshNormals
+           << ", \"mesh_vertex_normals\": " << meshVertexNormals << ", \"mesh_tex_coords\": " << meshTexCoords
+           << ", \"mesh_bvh\": " << meshBvh << ", \"mapped_meshes\": " << mappedMeshes
+           << ", \"objects\": " << objects
+           << ", \"acceleration_structures\": " << accelerationStructures << ", \"materials\": " << materials
+           << ", \"framebuffer\": " << framebuffer << ", \"cost_map\": " << costMap
+           << ", \"thread_scratch\": " << threadScratch << ", \"total\": " << GetTotal() << "}\n";
+}
+
+void RT::MemoryBudget::Check(const RT::MemoryReport &report) const {
+    CheckLimit("meshes", report.GetMeshTotal(), meshes);
+    CheckLimit("acceleration structures", report.accelerationStructures, accelerationStructures);
+    CheckLimit("framebuffer and cost map", report.framebuffer + report.costMap, framebuffer);
+    CheckLimit("the scene", report.GetTotal(), total);
+}
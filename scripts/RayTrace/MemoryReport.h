@@ -0,0 +1,73 @@
+/**
+ * @file MemoryReport.h
+ * @brief Defines the MemoryReport of bytes used by a scene per subsystem and the MemoryBudget limiting them.
+ */
+#ifndef MAIN_CPP_MEMORYREPORT_H
+#define MAIN_CPP_MEMORYREPORT_H
+
+#include <cstddef>
+#include <ostream>
+
+namespace RT{
+    /**
+     * @struct MemoryReport
+     * @brief Bytes held by a scene, see Scene::GetMemoryReport().
+     *
+     * Containers are counted by their capacity, not their size, since that's what they allocate. Allocator
+     * overhead and shared_ptr control blocks are not included, so the process uses somewhat more.
+     */
+    struct MemoryReport{
+        /** @{ \name TriangleMesh arrays */
+        size_t meshVertices = 0;
+        size_t meshIndices = 0;
+        size_t meshEdges = 0;
+        size_t meshNormals = 0;
+        size_t meshVertexNormals = 0;
+        size_t meshTexCoords = 0;
+        size_t meshBvh = 0;
+        /** @} */
+        /// \brief Mesh arrays viewed in mapped mesh files (page cache, counted per mesh), not in the total
+        size_t mappedMeshes = 0;
+        /// \brief Object instances (triangles, meshes without their arrays) and the scene object list
+        size_t objects = 0;
+        /// \brief Bounding boxes with their face triangles and object lists
+        size_t accelerationStructures = 0;
+        /// \brief Distinct materials of scene objects and bounding boxes
+        size_t materials = 0;
+        size_t framebuffer = 0;
+        size_t costMap = 0;
+        /// \brief Per-thread counters and closest hit search lists of all render threads, an upper estimate
+        size_t threadScratch = 0;
+
+        size_t GetMeshTotal() const {
+            return meshVertices + meshIndices + meshEdges + meshNormals + meshVertexNormals + meshTexCoords + meshBvh;
+        }
+        size_t GetTotal() const {
+            return GetMeshTotal() + objects + accelerationStructures + materials + framebuffer + costMap + threadScratch;
+        }
+
+        /// \brief Writes the report as an aligned table in KiB
+        void WriteSummary(std::ostream& stream) const;
+        /// \brief Writes all values in bytes as a JSON object
+        void WriteJson(std::ostream& stream) const;
+    };
+
+    /**
+     * @struct MemoryBudget
+     * @brief Hard limits in bytes, 0 means unlimited.
+     *
+     * Checked by Scene while it's built (meshes, acceleration structures, total) and before the framebuffer is
+     * allocated, a scene over budget throws std::runtime_error instead of pushing the host into swap.
+     */
+    struct MemoryBudget{
+        size_t meshes = 0;
+        size_t accelerationStructures = 0;
+        size_t framebuffer = 0;
+        size_t total = 0;
+
+        /// \brief Throws std::runtime_error naming the first exceeded limit
+        void Check(const RT::MemoryReport& report) const;
+    };
+}
+
+#endif
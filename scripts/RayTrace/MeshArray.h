@@ -0,0 +1,94 @@
+/**
+ * @file MeshArray.h
+ * @brief Defines the MeshArray class, mesh data either owned or viewed in a memory mapped file.
+ */
+#ifndef MAIN_CPP_MESHARRAY_H
+#define MAIN_CPP_MESHARRAY_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace RT{
+    /**
+     * @class MeshArray
+     * @brief Read-only array of mesh data, backed by a vector shared between copies or by memory it doesn't own.
+     *
+     * Meshes loaded from binary mesh files (MeshFile.h) view the mapped file directly, a shared owner keeps the
+     * mapping alive for as long as any copy of the array uses it. Copies of an array use the same vector or view
+     * the same memory, Mutable() gives the array a vector of its own first (copy on write), so placing copies of
+     * a mesh only duplicates the arrays the transformation changes.
+     */
+    template<typename T>
+    class MeshArray{
+    public:
+        MeshArray() = default;
+        MeshArray(std::vector<T> values) : pOwned_(std::make_shared<std::vector<T>>(std::move(values))) {}
+        MeshArray(const MeshArray& other) = default;
+        MeshArray(MeshArray&& other) noexcept { *this = std::move(other); }
+
+        MeshArray& operator=(const MeshArray& other) = default;
+        MeshArray& operator=(MeshArray&& other) noexcept {
+            pOwned_ = std::move(other.pOwned_);
+            pView_ = other.pView_;
+            viewSize_ = other.viewSize_;
+            pOwner_ = std::move(other.pOwner_);
+            other.pView_ = nullptr;
+            other.viewSize_ = 0;
+            return *this;
+        }
+        MeshArray& operator=(std::vector<T> values) {
+            pOwned_ = std::make_shared<std::vector<T>>(std::move(values));
+            pView_ = nullptr;
+            viewSize_ = 0;
+            pOwner_.reset();
+            return *this;
+        }
+
+        /// \brief Array viewing size elements at pData, pOwner keeps the memory alive
+        static MeshArray View(const T* pData, size_t size, std::shared_ptr<const void> pOwner) {
+            MeshArray array;
+            array.pView_ = pData;
+            array.viewSize_ = size;
+            array.pOwner_ = std::move(pOwner);
+            return array;
+        }
+
+        const T* data() const { return pOwned_ ? pOwned_->data() : pView_; }
+        size_t size() const { return pOwned_ ? pOwned_->size() : viewSize_; }
+        bool empty() const { return size() == 0; }
+        const T* begin() const { return data(); }
+        const T* end() const { return data() + size(); }
+        const T& operator[](size_t index) const { return data()[index]; }
+
+        /// \brief True if the data lives in memory the array doesn't own (a mapped file)
+        bool IsView() const { return pView_ != nullptr; }
+        /// \brief Heap bytes of the vector, counted by every copy sharing it; viewed memory isn't counted
+        size_t GetMemoryUsage() const { return pOwned_ ? pOwned_->capacity() * sizeof(T) : 0; }
+        /// \brief Bytes of viewed memory, 0 for owned data
+        size_t GetViewedBytes() const { return pView_ ? viewSize_ * sizeof(T) : 0; }
+
+        /// \brief Vector of this array only, viewed data or a vector shared with other copies is copied into it first
+        std::vector<T>& Mutable() {
+            if (!pOwned_ || pOwned_.use_count() > 1){
+                pOwned_ = std::make_shared<std::vector<T>>(begin(), end());
+                pView_ = nullptr;
+                viewSize_ = 0;
+                pOwner_.reset();
+            } else{
+                // Pairs with the release of the last other copy, its reads finish before this array writes
+                std::atomic_thread_fence(std::memory_order_acquire);
+            }
+            return *pOwned_;
+        }
+
+    private:
+        std::shared_ptr<std::vector<T>> pOwned_;
+        const T* pView_ = nullptr;
+        size_t viewSize_ = 0;
+        std::shared_ptr<const void> pOwner_;
+    };
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "MeshBvh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace {
+    /// \brief Absolute padding of boxes, far below the size of any mesh feature
+    constexpr double BOX_MARGIN = 1e-9;
+
+    struct Builder{
+        const Vec3D* pVertices;
+        std::vector<Vector<int, 3>>& triangles;
+        std::vector<uint32_t>& order;
+        std::vector<Vec3D> centroids;
+        std::vector<RT::MeshBvhNode> nodes;
+        std::vector<uint32_t> median;
+
+        void Bound(RT::MeshBvhNode& node, size_t first, size_t count) {
+            for (size_t axis = 0; axis < 3; ++axis){
+                node.min[axis] = DBL_MAX;
+                node.max[axis] = -DBL_MAX;
+            }
+            for (size_t i = first; i < first + count; ++i){
+                for (size_t corner = 0; corner < 3; ++corner){
+                    const Vec3D& vertex = pVertices[triangles[order[i]][corner]];
+                    for (size_t axis = 0; axis < 3; ++axis){
+                        node.min[axis] = std::min(node.min[axis], vertex[axis]);
+                        node.max[axis] = std::max(node.max[axis], vertex[axis]);
+                    }
+                }
+            }
+            for (size_t axis = 0; axis < 3; ++axis){
+                node.min[axis] -= BOX_MARGIN * (1. + std::fabs(node.min[axis]));
+                node.max[axis] += BOX_MARGIN * (1. + std::fabs(node.max[axis]));
+            }
+        }
+
+        uint32_t Split(size_t first, size_t count) {
+            uint32_t index = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+            Bound(nodes[index], first, count);
+            if (count <= RT::MeshBvh::LEAF_TRIANGLES){
+                nodes[index].first = static_cast<uint32_t>(first);
+                nodes[index].count = static_cast<uint32_t>(count);
+                return index;
+            }
+
+            double low[3] = {DBL_MAX, DBL_MAX, DBL_MAX}, high[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+            for (size_t i = first; i < first + count; ++i){
+                for (size_t axis = 0; axis < 3; ++axis){
+                    low[axis] = std::min(low[axis], centroids[order[i]][axis]);
+                    high[axis] = std::max(high[axis], centroids[order[i]][axis]);
+                }
+            }
+            size_t axis = 0;
+            for (size_t candidate = 1; candidate < 3; ++candidate){
+                if (high[candidate] - low[candidate] > high[axis] - low[axis]) axis = candidate;
+            }
+            size_t half = count / 2;
+            auto less = [&](uint32_t a, uint32_t b) {
+                // Ties are broken by index, so builds are deterministic
+                if (centroids[a][axis] != centroids[b][axis]) return centroids[a][axis] < centroids[b][axis];
+                return a < b;
+            };
+            // The median is found on a copy, then both halves keep the order the triangles came in (e.g. the
+            // Morton order of ObjLoader), which nth_element would scramble
+            auto begin = order.begin() + static_cast<long>(first);
+            median.assign(begin, begin + static_cast<long>(count));
+            std::nth_element(median.begin(), median.begin() + static_cast<long>(half), median.end(), less);
+            uint32_t pivot = median[half];
+            std::stable_partition(begin, begin + static_cast<long>(count),
+                                  [&](uint32_t triangle) { return less(triangle, pivot); });
+            nodes[index].count = 0;
+            Split(first, half);
+            uint32_t right = Split(first + half, count - half);
+            nodes[index].first = right;
+            return index;
+        }
+    };
+}
+
+std::vector<RT::MeshBvhNode> RT::MeshBvh::Build(const Vec3D *pVertices, std::vector<Vector<int, 3>> &triangles,
+                                                std::vector<uint32_t> &order) {
+    order.resize(triangles.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (triangles.empty()) return {};
+
+    Builder builder{pVertices, triangles, order, {}, {}, {}};
+    builder.centroids.reserve(triangles.size());
+    for (const auto& triangle : triangles){
+        builder.centroids.push_back((pVertices[triangle[0]] + pVertices[triangle[1]] + pVertices[triangle[2]]) / 3.);
+    }
+    builder.nodes.reserve(2 * triangles.size() / LEAF_TRIANGLES + 1);
+    builder.Split(0, triangles.size());
+
+    std::vector<Vector<int, 3>> sorted;
+    sorted.reserve(triangles.size());
+    for (uint32_t index : order){
+        sorted.push_back(triangles[index]);
+    }
+    triangles = std::move(sorted);
+    return std::move(builder.nodes);
+}
+
+void RT::MeshBvh::Translate(std::vector<MeshBvhNode> &nodes, const Vec3D &offset) {
+    for (auto& node : nodes){
+        for (size_t axis = 0; axis < 3; ++axis){
+            node.min[axis] += offset[axis];
+            node.max[axis] += offset[axis];
+        }
+    }
+}
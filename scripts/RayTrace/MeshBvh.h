@@ -0,0 +1,73 @@
+/**
+ * @file MeshBvh.h
+ * @brief Defines the bounding volume hierarchy over the triangles of a single mesh.
+ */
+#ifndef MAIN_CPP_MESHBVH_H
+#define MAIN_CPP_MESHBVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../LinearAlgebra/Vector.h"
+
+namespace RT{
+    /**
+     * @struct MeshBvhNode
+     * @brief Axis aligned box of a BVH node, 56 bytes, stored as is in binary mesh files.
+     *
+     * Nodes are laid out depth first, the left child of an inner node directly follows it.
+     */
+    struct MeshBvhNode{
+        double min[3];
+        double max[3];
+        /// \brief First triangle of a leaf, index of the right child of an inner node
+        uint32_t first;
+        /// \brief Triangles of a leaf, 0 for inner nodes
+        uint32_t count;
+
+        bool IsLeaf() const { return count != 0; }
+    };
+
+    namespace MeshBvh{
+        /// \brief Leaves hold at most this many triangles
+        constexpr const size_t LEAF_TRIANGLES = 4;
+        /// \brief Deepest inner node a traversal can descend from, size of its stack of postponed children
+        constexpr const size_t MAX_DEPTH = 64;
+
+        /**
+         * @brief Builds the hierarchy by median splits along the longest axis of the triangle centroids.
+         *
+         * Triangles are reordered so every leaf covers a contiguous range, order receives the original index of every
+         * triangle (to reorder per-triangle data). Both halves of a split keep the relative order of their triangles,
+         * so a mesh already in a spatial order keeps it within the leaves. Boxes are padded by a tiny margin, so rays
+         * grazing an edge still reach its triangles.
+         */
+        std::vector<MeshBvhNode> Build(const Vec3D* pVertices, std::vector<Vector<int, 3>>& triangles,
+                                       std::vector<uint32_t>& order);
+        /// \brief Moves all boxes by offset, the same as rebuilding after translating the vertices
+        void Translate(std::vector<MeshBvhNode>& nodes, const Vec3D& offset);
+
+        /**
+         * @brief Distance at which the ray enters the box, or a negative value if it misses it.
+         *
+         * inverseDirection holds 1 / direction per axis, maxDistance cuts off boxes behind the closest hit so far.
+         */
+        inline double Enter(const MeshBvhNode& node, const double origin[3], const double inverseDirection[3],
+                            double maxDistance) {
+            double near = 0., far = maxDistance;
+            for (size_t axis = 0; axis < 3; ++axis){
+                double t0 = (node.min[axis] - origin[axis]) * inverseDirection[axis];
+                double t1 = (node.max[axis] - origin[axis]) * inverseDirection[axis];
+                if (t0 > t1) std::swap(t0, t1);
+                near = t0 > near ? t0 : near;
+                far = t1 < far ? t1 : far;
+                if (near > far) return -1.;
+            }
+            return near;
+        }
+    }
+}
+
+#endif
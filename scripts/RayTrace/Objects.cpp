@@ -1,5 +1,20 @@
 #include "Objects.h"
 #include <float.h>
+#include <cmath>
+
+namespace {
+    /// \brief Adjacent profile segments meeting at a larger angle keep their own normals, the edge stays sharp
+    constexpr double CREASE_COSINE = 0.5;
+
+    double DistanceToSegment(const Vector<double, 2>& point, const Vector<double, 2>& start,
+                             const Vector<double, 2>& end) {
+        Vector<double, 2> segment = end - start;
+        double lengthSquared = segment.dot(segment);
+        double t = lengthSquared > 0. ? std::clamp((point - start).dot(segment) / lengthSquared, 0., 1.) : 0.;
+        Vector<double, 2> offset = point - start - segment * t;
+        return std::sqrt(offset.dot(offset));
+    }
+}
 
 // Base
 RT::Object::Object() {
@@ -87,6 +102,96 @@ std::pair<Vec3D, Vec3D> RT::Triangle::GetBoundingPoints() const {
 }
 
 
+// Sphere
+RT::Sphere::Sphere(const Vec3D &center, double radius) : center_(center), radius_(radius) {
+    if (!(radius_ > 0.)) throw std::invalid_argument("Sphere radius must be positive");
+}
+
+const RT::ObjectType RT::Sphere::GetType() const {
+    return RT::ObjectType::SPHERE;
+}
+
+void RT::Sphere::SetCenter(const Vec3D point) {
+    center_ = point;
+}
+
+void RT::Sphere::SetPos(const Vec3D point) {
+    center_ = point + Vec3D{radius_, radius_, radius_};
+}
+
+std::pair<Vec3D, Vec3D> RT::Sphere::GetBoundingPoints() const {
+    Vec3D extent{radius_, radius_, radius_};
+    return std::make_pair(center_ - extent, center_ + extent);
+}
+
+
+// Quad
+RT::Quad::Quad(const Vec3D &corner, const Vec3D &edgeU, const Vec3D &edgeV)
+        : corner_(corner), edgeU_(edgeU), edgeV_(edgeV) {
+    Vec3D normal = cross(edgeU_, edgeV_);
+    double lengthSquared = normal.dot(normal);
+    if (lengthSquared == 0.) throw std::invalid_argument("Quad edges must not be parallel");
+    // u = dot(cross(offset, edgeV), normal) / |normal|^2 = dot(offset, cross(edgeV, normal)) / |normal|^2
+    axisU_ = cross(edgeV_, normal) / lengthSquared;
+    axisV_ = cross(normal, edgeU_) / lengthSquared;
+    normal_ = normal / std::sqrt(lengthSquared);
+}
+
+const RT::ObjectType RT::Quad::GetType() const {
+    return RT::ObjectType::QUAD;
+}
+
+void RT::Quad::SetCenter(const Vec3D point) {
+    corner_ = point - (edgeU_ + edgeV_) / 2.;
+}
+
+void RT::Quad::SetPos(const Vec3D point) {
+    corner_ = corner_ - GetBoundingPoints().first + point;
+}
+
+std::pair<Vec3D, Vec3D> RT::Quad::GetBoundingPoints() const {
+    Vec3D minPoint = corner_, maxPoint = corner_;
+    for (const Vec3D& point : {corner_ + edgeU_, corner_ + edgeV_, corner_ + edgeU_ + edgeV_}){
+        for (size_t axis = 0; axis < 3; ++axis){
+            minPoint[axis] = std::min(minPoint[axis], point[axis]);
+            maxPoint[axis] = std::max(maxPoint[axis], point[axis]);
+        }
+    }
+    return std::make_pair(minPoint, maxPoint);
+}
+
+
+// Plane
+RT::Plane::Plane(const Vec3D &point, const Vec3D &normal) : point_(point) {
+    if (normal.dot(normal) == 0.) throw std::invalid_argument("Plane normal must not be zero");
+    normal_ = normal.normalized();
+}
+
+const RT::ObjectType RT::Plane::GetType() const {
+    return RT::ObjectType::PLANE;
+}
+
+void RT::Plane::SetCenter(const Vec3D point) {
+    point_ = point;
+}
+
+void RT::Plane::SetPos(const Vec3D point) {
+    point_ = point;
+}
+
+std::pair<Vec3D, Vec3D> RT::Plane::GetBoundingPoints() const {
+    double infinity = std::numeric_limits<double>::infinity();
+    Vec3D minPoint{-infinity, -infinity, -infinity}, maxPoint{infinity, infinity, infinity};
+    for (size_t axis = 0; axis < 3; ++axis){
+        if (std::fabs(normal_[axis]) == 1.){
+            minPoint[axis] = point_[axis];
+            maxPoint[axis] = point_[axis];
+        }
+    }
+    return std::make_pair(minPoint, maxPoint);
+}
+
+
 // Light
 RT::DistantLightSource::DistantLightSource() {
     color_ = Utils::LIGHT_COLOR;
@@ -127,23 +232,57 @@ RT::TriangleMesh::TriangleMesh(std::vector<Vec3D> &vertices, std::vector<Vector<
     updateEdgesAndNormals();
 }
 
+RT::TriangleMesh::TriangleMesh(RT::MeshArrays arrays)
+    : vertices_(std::move(arrays.vertices)), triangles_(std::move(arrays.triangles)),
+      normals_(std::move(arrays.normals)), vertexNormals_(std::move(arrays.vertexNormals)),
+      edges_(std::move(arrays.edges)), bvh_(std::move(arrays.bvh)), authoredNormals_(arrays.authoredNormals),
+      texCoords_(std::move(arrays.texCoords)), featureSize_(arrays.featureSize) {}
+
+RT::TriangleMesh::TriangleMesh(const RT::TriangleMesh &other) : Object(other) {
+    *this = other;
+}
+
+RT::TriangleMesh &RT::TriangleMesh::operator=(const RT::TriangleMesh &other) {
+    if (this == &other) return *this;
+    Object::operator=(other);
+    smoothness_ = other.smoothness_;
+    boundingVolume_ = other.boundingVolume_;
+    vertices_ = other.vertices_;
+    triangles_ = other.triangles_;
+    normals_ = other.normals_;
+    vertexNormals_ = other.vertexNormals_;
+    edges_ = other.edges_;
+    bvh_ = other.bvh_;
+    authoredNormals_ = other.authoredNormals_;
+    texCoords_ = other.texCoords_;
+    featureSize_ = other.featureSize_;
+    pCompact_ = other.pCompact_;
+    // Levels are transformed with the mesh, so they can't be shared with the original
+    lods_.clear();
+    for (const auto& pLod : other.lods_){
+        lods_.push_back(std::make_shared<RT::TriangleMesh>(*pLod));
+    }
+    return *this;
+}
+
 size_t RT::TriangleMesh::GetTriangleNum() const {
+    if (pCompact_) return pCompact_->GetTriangleNum();
     return triangles_.size();
 }
 
-const std::vector<Vec3D>& RT::TriangleMesh::GetVertices() const {
+const RT::MeshArray<Vec3D>& RT::TriangleMesh::GetVertices() const {
     return vertices_;
 }
 
-const std::vector<Vector<int, 3>>& RT::TriangleMesh::GetTriangles() const {
+const RT::MeshArray<Vector<int, 3>>& RT::TriangleMesh::GetTriangles() const {
     return triangles_;
 }
 
-const std::vector<std::pair<Vec3D, Vec3D>>& RT::TriangleMesh::GetEdges() const {
+const RT::MeshArray<std::pair<Vec3D, Vec3D>>& RT::TriangleMesh::GetEdges() const {
     return edges_;
 }
 
-const std::vector<Vec3D>& RT::TriangleMesh::GetNormals() const {
+const RT::MeshArray<Vec3D>& RT::TriangleMesh::GetNormals() const {
     return normals_;
 }
 
@@ -151,7 +290,58 @@ const RT::ObjectType RT::TriangleMesh::GetType() const {
     return RT::ObjectType::TRIANGLE_MESH;
 }
 
+void RT::TriangleMesh::SetVertexNormals(std::vector<Vec3D> vertexNormals) {
+    CheckNotCompact();
+    if (vertexNormals.size() != vertices_.size()){
+        throw std::invalid_argument("Mesh needs one vertex normal per vertex");
+    }
+    for (auto& normal : vertexNormals){
+        normal.normalize();
+    }
+    vertexNormals_ = std::move(vertexNormals);
+    authoredNormals_ = true;
+}
+
+void RT::TriangleMesh::SetTexCoords(std::vector<Vector<double, 2>> texCoords) {
+    CheckNotCompact();
+    if (texCoords.size() != vertices_.size()){
+        throw std::invalid_argument("Mesh needs one texture coordinate per vertex");
+    }
+    texCoords_ = std::move(texCoords);
+}
+
+void RT::TriangleMesh::SetLods(std::vector<std::shared_ptr<RT::TriangleMesh>> lods) {
+    lods_ = std::move(lods);
+}
+
+const RT::TriangleMesh &RT::TriangleMesh::SelectLod(double footprint) const {
+    for (auto it = lods_.rbegin(); it != lods_.rend(); ++it){
+        if ((*it)->GetFeatureSize() <= footprint) return **it;
+    }
+    return *this;
+}
+
+void RT::TriangleMesh::Compact() {
+    for (auto& pLod : lods_){
+        pLod->Compact();
+    }
+    if (pCompact_) return;
+    pCompact_ = std::make_shared<const RT::CompactMesh>(vertices_, triangles_, vertexNormals_, bvh_);
+    // Texture coordinates aren't read by the kernel, so they stay as they are
+    vertices_ = std::vector<Vec3D>();
+    triangles_ = std::vector<Vector<int, 3>>();
+    normals_ = std::vector<Vec3D>();
+    vertexNormals_ = std::vector<Vec3D>();
+    edges_ = std::vector<std::pair<Vec3D, Vec3D>>();
+    bvh_ = std::vector<RT::MeshBvhNode>();
+}
+
+void RT::TriangleMesh::CheckNotCompact() const {
+    if (pCompact_) throw std::logic_error("Compacted meshes can't be changed");
+}
+
 void RT::TriangleMesh::SetCenter(const Vec3D point) {
+    CheckNotCompact();
     Vec3D center{0., 0., 0.};
     double minY = DBL_MAX;
     for (auto& vertex : vertices_){
@@ -165,13 +355,11 @@ void RT::TriangleMesh::SetCenter(const Vec3D point) {
         }
     }
     center = center / amount;
-    Vec3D diff = center - point;
-    for (auto& vertex : vertices_){
-        vertex = vertex - diff;
-    }
+    Translate(point - center);
 }
 
 void RT::TriangleMesh::Fit1x1(double xOffset, double zOffset) {
+    CheckNotCompact();
     Vec3D bottomLeftCorner{
             std::numeric_limits<double>::max(),
             std::numeric_limits<double>::max(),
@@ -193,24 +381,52 @@ void RT::TriangleMesh::Fit1x1(double xOffset, double zOffset) {
     }
     double xScale = topRightCorner[0] - bottomLeftCorner[0];
     double zScale = topRightCorner[2] - bottomLeftCorner[2];
-    for (auto& vertex : vertices_){
-        vertex[0] = (vertex[0] - bottomLeftCorner[0]) / xScale * xOffset;
-        vertex[1] = (vertex[1] - bottomLeftCorner[1]) / xScale * xOffset;
-        vertex[2] = (vertex[2] - bottomLeftCorner[2]) / zScale * zOffset;
+    Rescale(bottomLeftCorner, Vec3D{xScale, xScale, zScale}, Vec3D{xOffset, xOffset, zOffset});
+}
 
+void RT::TriangleMesh::Rescale(const Vec3D &corner, const Vec3D &extent, const Vec3D &size) {
+    for (auto& vertex : vertices_.Mutable()){
+        for (size_t axis = 0; axis < 3; ++axis){
+            vertex[axis] = (vertex[axis] - corner[axis]) / extent[axis] * size[axis];
+        }
+    }
+    // Normals scale inversely to the vertices to stay perpendicular to the surface
+    if (authoredNormals_){
+        for (auto& normal : vertexNormals_.Mutable()){
+            for (size_t axis = 0; axis < 3; ++axis){
+                normal[axis] *= extent[axis] / size[axis];
+            }
+            normal.normalize();
+        }
     }
     updateEdgesAndNormals();
+    for (auto& pLod : lods_){
+        pLod->Rescale(corner, extent, size);
+    }
+}
+
+void RT::TriangleMesh::Translate(const Vec3D &offset) {
+    for (auto& vertex : vertices_.Mutable()){
+        vertex = vertex + offset;
+    }
+    RT::MeshBvh::Translate(bvh_.Mutable(), offset);
+    for (auto& pLod : lods_){
+        pLod->Translate(offset);
+    }
 }
 
 void RT::TriangleMesh::updateEdgesAndNormals() {
-    edges_.clear();
-    normals_.clear();
-    std::vector<int> facesCounter;
+    CheckNotCompact();
+    std::vector<uint32_t> order;
+    bvh_ = RT::MeshBvh::Build(vertices_.data(), triangles_.Mutable(), order);
+
+    std::vector<std::pair<Vec3D, Vec3D>> edges;
+    std::vector<Vec3D> normals;
+    double edgeLengths = 0.;
+    edges.reserve(triangles_.size());
+    normals.reserve(triangles_.size());
+    std::vector<int> facesCounter(vertices_.size(), 0);
     std::vector<Vec3D> vertexNormals(vertices_.size());
-    for (int i = 0; i < vertices_.size(); ++i){
-        facesCounter.emplace_back(0);
-        vertexNormals.emplace_back(Vec3D{0., 0., 0.});
-    }
 
     for (auto& triangle : triangles_){
         Vec3D pointA = vertices_[triangle[0]];
@@ -223,9 +439,10 @@ void RT::TriangleMesh::updateEdgesAndNormals() {
 
         Vec3D normal = cross(edgeAB, edgeAC);
         normal.normalize();
+        edgeLengths += std::sqrt(edgeAB.dot(edgeAB)) + std::sqrt(edgeAC.dot(edgeAC));
 
-        edges_.emplace_back(edge);
-        normals_.emplace_back(normal);
+        edges.emplace_back(edge);
+        normals.emplace_back(normal);
 
         vertexNormals[triangle[0]] = vertexNormals[triangle[0]] + normal;
         vertexNormals[triangle[1]] = vertexNormals[triangle[1]] + normal;
@@ -234,21 +451,37 @@ void RT::TriangleMesh::updateEdgesAndNormals() {
         facesCounter[triangle[1]]++;
         facesCounter[triangle[2]]++;
     }
-    for (int i = 0; i < vertices_.size(); ++i) {
+    edges_ = std::move(edges);
+    normals_ = std::move(normals);
+    featureSize_ = triangles_.empty() ? 0. : edgeLengths / (2. * triangles_.size());
+    if (authoredNormals_) return;
+
+    for (size_t i = 0; i < vertices_.size(); ++i) {
         if (facesCounter[i] > 0){
             vertexNormals[i] = (vertexNormals[i] / facesCounter[i]);
         } else{
             vertexNormals[i].normalize();
         }
     }
-    vertexNormals_ = vertexNormals;
+    vertexNormals_ = std::move(vertexNormals);
 }
 
-const std::vector<Vec3D > &RT::TriangleMesh::GetVertexNormals() const {
+const RT::MeshArray<Vec3D> &RT::TriangleMesh::GetVertexNormals() const {
     return vertexNormals_;
 }
 
 std::pair<Vec3D, Vec3D > RT::TriangleMesh::GetBoundingPoints() const {
+    if (pCompact_){
+        Vec3D minPoint{DBL_MAX, DBL_MAX, DBL_MAX}, maxPoint{-DBL_MAX, -DBL_MAX, -DBL_MAX};
+        for (uint32_t i = 0; i < pCompact_->GetVertexNum(); ++i){
+            Vec3D vertex = pCompact_->GetVertex(i);
+            for (size_t axis = 0; axis < 3; ++axis){
+                minPoint[axis] = std::min(minPoint[axis], vertex[axis]);
+                maxPoint[axis] = std::max(maxPoint[axis], vertex[axis]);
+            }
+        }
+        return std::make_pair(minPoint, maxPoint);
+    }
     Vec3D pointA = vertices_[triangles_[0][0]];
     Vec3D pointB = vertices_[triangles_[0][1]];
     Vec3D pointC = vertices_[triangles_[0][2]];
@@ -278,19 +511,18 @@ std::pair<Vec3D, Vec3D > RT::TriangleMesh::GetBoundingPoints() const {
 }
 
 void RT::TriangleMesh::SetPos(const Vec3D point) {
+    CheckNotCompact();
     Vec3D leftCorner = vertices_[0];
     for (auto& vertex : vertices_){
         leftCorner[0] = std::min(leftCorner[0], vertex[0]);
         leftCorner[1] = std::min(leftCorner[1], vertex[1]);
         leftCorner[2] = std::min(leftCorner[2], vertex[2]);
     }
-    Vec3D diff = leftCorner - point;
-    for (auto& vertex : vertices_){
-        vertex = vertex - diff;
-    }
+    Translate(point - leftCorner);
 }
 
 void RT::TriangleMesh::Rotate(double angle) {
+    CheckNotCompact();
     Vec3D center{0., 0., 0.};
     double minY = DBL_MAX;
     for (auto& vertex : vertices_){
@@ -304,11 +536,22 @@ void RT::TriangleMesh::Rotate(double angle) {
         }
     }
     center = center / amount;
-    double angleRad = angle * (M_PI / 180.);
-    for (auto& vertex : vertices_){
-        RotatePointAroundCenter(vertex, center, angleRad);
+    RotateAround(center, angle * (M_PI / 180.));
+}
+
+void RT::TriangleMesh::RotateAround(const Vec3D &center, double angleInRadians) {
+    for (auto& vertex : vertices_.Mutable()){
+        RotatePointAroundCenter(vertex, center, angleInRadians);
+    }
+    if (authoredNormals_){
+        for (auto& normal : vertexNormals_.Mutable()){
+            RotatePointAroundCenter(normal, Vec3D{0., 0., 0.}, angleInRadians);
+        }
     }
     updateEdgesAndNormals();
+    for (auto& pLod : lods_){
+        pLod->RotateAround(center, angleInRadians);
+    }
 }
 
 void RT::TriangleMesh::RotatePointAroundCenter(Vec3D& point, Vec3D center, double angle) {
@@ -323,3 +566,176 @@ void RT::TriangleMesh::RotatePointAroundCenter(Vec3D& point, Vec3D center, doubl
 }
 
 
+// Surface of revolution
+RT::SurfaceOfRevolution::SurfaceOfRevolution(std::vector<Vector<double, 2>> profile) : profile_(std::move(profile)) {
+    if (profile_.size() < 2) throw std::invalid_argument("Surface of revolution needs at least two profile points");
+    double area = 0.;
+    for (size_t i = 0; i < profile_.size(); ++i){
+        if (profile_[i][0] < 0.) throw std::invalid_argument("Surface of revolution profile has a negative radius");
+        const auto& next = profile_[(i + 1) % profile_.size()];
+        area += profile_[i][0] * next[1] - next[0] * profile_[i][1];
+    }
+    // Counterclockwise in the (radius, height) plane puts the outside on the right of every segment
+    if (area < 0.) std::reverse(profile_.begin(), profile_.end());
+
+    bottom_ = DBL_MAX;
+    top_ = -DBL_MAX;
+    for (size_t i = 0; i + 1 < profile_.size(); ++i){
+        const auto& start = profile_[i];
+        const auto& end = profile_[i + 1];
+        Vector<double, 2> tangent = end - start;
+        double length = std::sqrt(tangent.dot(tangent));
+        if (length == 0.) continue;
+        RT::RevolutionSegment segment;
+        segment.start = start;
+        segment.end = end;
+        segment.minY = std::min(start[1], end[1]);
+        segment.maxY = std::max(start[1], end[1]);
+        segment.maxRadius = std::max(start[0], end[0]);
+        segment.horizontal = start[1] == end[1];
+        segment.slope = segment.horizontal ? 0. : tangent[0] / tangent[1];
+        segment.normal = Vector<double, 2>{tangent[1] / length, -tangent[0] / length};
+        segment.startNormal = segment.normal;
+        segment.endNormal = segment.normal;
+        segments_.push_back(segment);
+        radius_ = std::max(radius_, segment.maxRadius);
+        bottom_ = std::min(bottom_, segment.minY);
+        top_ = std::max(top_, segment.maxY);
+    }
+    if (segments_.empty()) throw std::invalid_argument("Surface of revolution profile has no length");
+    for (size_t i = 0; i + 1 < segments_.size(); ++i){
+        auto& current = segments_[i];
+        auto& next = segments_[i + 1];
+        if (current.normal.dot(next.normal) < CREASE_COSINE) continue;
+        Vector<double, 2> shared = (current.normal + next.normal).normalized();
+        current.endNormal = shared;
+        next.startNormal = shared;
+    }
+}
+
+const RT::ObjectType RT::SurfaceOfRevolution::GetType() const {
+    return RT::ObjectType::SURFACE_OF_REVOLUTION;
+}
+
+std::pair<Vec3D, Vec3D> RT::SurfaceOfRevolution::GetBoundingPoints() const {
+    return std::make_pair(base_ + Vec3D{-radius_, bottom_, -radius_}, base_ + Vec3D{radius_, top_, radius_});
+}
+
+void RT::SurfaceOfRevolution::SetCenter(const Vec3D point) {
+    base_ = point;
+}
+
+void RT::SurfaceOfRevolution::SetPos(const Vec3D point) {
+    base_ = point + Vec3D{radius_, -bottom_, radius_};
+}
+
+std::vector<Vector<double, 2>> RT::SurfaceOfRevolution::FitProfile(const RT::TriangleMesh &mesh, double tolerance,
+                                                                   Vec3D &base) {
+    const auto& vertices = mesh.GetVertices();
+    if (vertices.size() == 0) return {};
+    Vec3D minPoint{DBL_MAX, DBL_MAX, DBL_MAX}, maxPoint{-DBL_MAX, -DBL_MAX, -DBL_MAX};
+    for (const auto& vertex : vertices){
+        for (size_t axis = 0; axis < 3; ++axis){
+            minPoint[axis] = std::min(minPoint[axis], vertex[axis]);
+            maxPoint[axis] = std::max(maxPoint[axis], vertex[axis]);
+        }
+    }
+    base = Vec3D{(minPoint[0] + maxPoint[0]) / 2., minPoint[1], (minPoint[2] + maxPoint[2]) / 2.};
+    double maxDistance = tolerance * (maxPoint[1] - minPoint[1]);
+    if (maxDistance <= 0.) return {};
+
+    // Vertices within a quarter of the tolerance of the first vertex of a ring join it, which absorbs small
+    // decorations moving single vertices of a ring
+    double ringTolerance = maxDistance / 4.;
+    std::vector<Vector<double, 2>> points;
+    std::vector<Vector<double, 2>> ringSums;
+    std::vector<Vector<double, 2>> ringFirsts;
+    std::vector<size_t> ringSizes;
+    std::vector<size_t> vertexRings;
+    for (const auto& vertex : vertices){
+        Vector<double, 2> point{std::hypot(vertex[0] - base[0], vertex[2] - base[2]), vertex[1] - base[1]};
+        size_t ring = 0;
+        while (ring < ringFirsts.size() && (std::fabs(ringFirsts[ring][0] - point[0]) > ringTolerance ||
+                                            std::fabs(ringFirsts[ring][1] - point[1]) > ringTolerance)) ++ring;
+        if (ring == ringFirsts.size()){
+            ringFirsts.push_back(point);
+            ringSums.push_back(Vector<double, 2>{0., 0.});
+            ringSizes.push_back(0);
+        }
+        ringSums[ring] = ringSums[ring] + point;
+        ++ringSizes[ring];
+        vertexRings.push_back(ring);
+        points.push_back(point);
+    }
+
+    // Full rings carry the profile, the others are details of the mesh checked against it at the end
+    size_t fullSize = *std::max_element(ringSizes.begin(), ringSizes.end());
+    if (fullSize < 3) return {};
+    std::vector<size_t> fullRings;
+    for (size_t ring = 0; ring < ringSizes.size(); ++ring){
+        if (ringSizes[ring] == fullSize) fullRings.push_back(ring);
+    }
+    if (fullRings.size() < 2) return {};
+    auto ringPoint = [&](size_t ring) { return ringSums[ring] / static_cast<double>(fullSize); };
+
+    std::vector<std::vector<size_t>> neighbours(ringSizes.size());
+    std::vector<bool> capped(ringSizes.size(), false);
+    for (const auto& triangle : mesh.GetTriangles()){
+        size_t rings[3] = {vertexRings[triangle[0]], vertexRings[triangle[1]], vertexRings[triangle[2]]};
+        if (rings[0] == rings[1] && rings[1] == rings[2]) capped[rings[0]] = true;
+        for (size_t corner = 0; corner < 3; ++corner){
+            size_t ring = rings[corner], other = rings[(corner + 1) % 3];
+            if (ring != other) neighbours[ring].push_back(other);
+        }
+    }
+
+    // Chained from the widest of the lowest rings through the nearest unused full ring connected by an edge,
+    // or the nearest of all when no edge leads further
+    size_t current = fullRings[0];
+    for (size_t ring : fullRings){
+        Vector<double, 2> point = ringPoint(ring), best = ringPoint(current);
+        if (point[1] < best[1] - ringTolerance || (point[1] <= best[1] + ringTolerance && point[0] > best[0])) current = ring;
+    }
+    std::vector<bool> used(ringSizes.size(), false);
+    std::vector<size_t> chain{current};
+    used[current] = true;
+    while (chain.size() < fullRings.size()){
+        auto nearest = [&](const std::vector<size_t>& candidates) {
+            size_t found = SIZE_MAX;
+            double foundDistance = DBL_MAX;
+            for (size_t ring : candidates){
+                if (used[ring] || ringSizes[ring] != fullSize) continue;
+                Vector<double, 2> offset = ringPoint(ring) - ringPoint(current);
+                double distance = offset.dot(offset);
+                if (distance < foundDistance){
+                    found = ring;
+                    foundDistance = distance;
+                }
+            }
+            return found;
+        };
+        size_t next = nearest(neighbours[current]);
+        if (next == SIZE_MAX) next = nearest(fullRings);
+        current = next;
+        used[current] = true;
+        chain.push_back(current);
+    }
+
+    std::vector<Vector<double, 2>> profile;
+    for (size_t ring : chain) profile.push_back(ringPoint(ring));
+    if (capped[chain.front()] && profile.front()[0] > ringTolerance){
+        profile.insert(profile.begin(), Vector<double, 2>{0., profile.front()[1]});
+    }
+    if (capped[chain.back()] && profile.back()[0] > ringTolerance){
+        profile.push_back(Vector<double, 2>{0., profile.back()[1]});
+    }
+
+    for (const auto& point : points){
+        double distance = DBL_MAX;
+        for (size_t i = 0; i + 1 < profile.size(); ++i){
+            distance = std::min(distance, DistanceToSegment(point, profile[i], profile[i + 1]));
+        }
+        if (distance > maxDistance) return {};
+    }
+    return profile;
+}
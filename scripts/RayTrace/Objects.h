@@ -7,6 +7,9 @@
 #define MAIN_CPP_OBJECT_H
 
 #include "../Utilities/Utils.h"
+#include "MeshArray.h"
+#include "MeshBvh.h"
+#include "CompactMesh.h"
 #include <vector>
 #include <memory>
 #include <initializer_list>
@@ -24,7 +27,10 @@ namespace RT{
         BASE,
         TRIANGLE,
         TRIANGLE_MESH,
-        SPHERE // not implemented yet
+        SURFACE_OF_REVOLUTION,
+        SPHERE,
+        QUAD,
+        PLANE
     };
     /**
      * @class Object
@@ -80,23 +86,167 @@ namespace RT{
         Vec3D edgeAC_;
         Vec3D edgeBC_;
     };
+    /**
+     * @class Sphere
+     * @brief Sphere intersected analytically, its normals point outwards.
+     */
+    class Sphere : public Object{
+    public:
+        /// \brief Throws std::invalid_argument for a radius which isn't positive
+        Sphere(const Vec3D &center, double radius);
+
+        const Vec3D& GetCenter() const { return center_; }
+        double GetRadius() const { return radius_; }
+
+        virtual const RT::ObjectType GetType() const override;
+        /// \brief Set center coordinates of the object
+        void SetCenter(const Vec3D point) override;
+        /// \brief Set bottom left coordinates of the object(min x, min y, min z)
+        void SetPos(const Vec3D point) override;
+        virtual std::pair<Vec3D, Vec3D> GetBoundingPoints() const override;
+
+    private:
+        Vec3D center_;
+        double radius_;
+    };
+    /**
+     * @class Quad
+     * @brief Parallelogram corner + u * edgeU + v * edgeV for u and v in [0, 1], one test instead of two triangles.
+     *
+     * The normal is cross(edgeU, edgeV), like a Triangle of corner, corner + edgeU and corner + edgeV.
+     */
+    class Quad : public Object{
+    public:
+        /// \brief Throws std::invalid_argument for parallel edges
+        Quad(const Vec3D &corner, const Vec3D &edgeU, const Vec3D &edgeV);
+
+        const Vec3D& GetCorner() const { return corner_; }
+        const Vec3D& GetEdgeU() const { return edgeU_; }
+        const Vec3D& GetEdgeV() const { return edgeV_; }
+        const Vec3D& GetNormal() const { return normal_; }
+        /** @{ \name Dot products with an offset from the corner in the plane are its u and v */
+        const Vec3D& GetAxisU() const { return axisU_; }
+        const Vec3D& GetAxisV() const { return axisV_; }
+        /** @} */
+
+        virtual const RT::ObjectType GetType() const override;
+        /// \brief Set center coordinates of the object
+        void SetCenter(const Vec3D point) override;
+        /// \brief Set bottom left coordinates of the object(min x, min y, min z)
+        void SetPos(const Vec3D point) override;
+        virtual std::pair<Vec3D, Vec3D> GetBoundingPoints() const override;
+
+    private:
+        Vec3D corner_;
+        Vec3D edgeU_;
+        Vec3D edgeV_;
+        Vec3D normal_;
+        Vec3D axisU_;
+        Vec3D axisV_;
+    };
+    /**
+     * @class Plane
+     * @brief Infinite plane through a point, tested by every ray that reaches its bounding box (itself).
+     */
+    class Plane : public Object{
+    public:
+        /// \brief The normal is normalized, throws std::invalid_argument for a zero normal
+        Plane(const Vec3D &point, const Vec3D &normal);
+
+        const Vec3D& GetPoint() const { return point_; }
+        const Vec3D& GetNormal() const { return normal_; }
+
+        virtual const RT::ObjectType GetType() const override;
+        /// \brief Moves the plane through point
+        void SetCenter(const Vec3D point) override;
+        /// \brief Moves the plane through point
+        void SetPos(const Vec3D point) override;
+        /// \brief Unbounded along every axis, except the one an axis-aligned plane is perpendicular to
+        virtual std::pair<Vec3D, Vec3D> GetBoundingPoints() const override;
+
+    private:
+        Vec3D point_;
+        Vec3D normal_;
+    };
     /**
      * @class TriangleMesh
      * @brief Represents a mesh of triangles for effective representation in the ray tracing environment.
      */
+    /**
+     * @struct MeshArrays
+     * @brief All arrays of a TriangleMesh, used to create a mesh from precomputed data (see MeshFile.h).
+     */
+    struct MeshArrays{
+        RT::MeshArray<Vec3D> vertices;
+        RT::MeshArray<Vector<int, 3>> triangles;
+        RT::MeshArray<std::pair<Vec3D, Vec3D>> edges;
+        RT::MeshArray<Vec3D> normals;
+        RT::MeshArray<Vec3D> vertexNormals;
+        RT::MeshArray<RT::MeshBvhNode> bvh;
+        RT::MeshArray<Vector<double, 2>> texCoords;
+        bool authoredNormals = false;
+        /// \brief Mean edge length, see TriangleMesh::GetFeatureSize()
+        double featureSize = 0.;
+    };
     class TriangleMesh : public Object{
     public:
         TriangleMesh(std::vector<Vec3D> &vertices, std::vector<Vector<int, 3>> &triangles);
+        /// \brief Mesh of precomputed arrays, which have to be consistent, nothing is recalculated
+        explicit TriangleMesh(RT::MeshArrays arrays);
+        /**
+         * \brief Copies share the arrays until a transformation changes them (MeshArray::Mutable()), levels of detail
+         * are copied the same way, so a placed piece owns only its moved vertices and BVH boxes
+         */
+        TriangleMesh(const TriangleMesh& other);
+        TriangleMesh& operator=(const TriangleMesh& other);
 
         size_t GetTriangleNum() const;
 
-        const std::vector<Vec3D>& GetVertices() const;
-        const std::vector<Vector<int, 3>>& GetTriangles() const;
-        const std::vector<std::pair<Vec3D, Vec3D>>& GetEdges() const;
-        const std::vector<Vec3D>& GetNormals() const;
-        const std::vector<Vec3D>& GetVertexNormals() const;
+        const RT::MeshArray<Vec3D>& GetVertices() const;
+        /// \brief Triangles in the order of the BVH leaves, per-triangle arrays follow the same order
+        const RT::MeshArray<Vector<int, 3>>& GetTriangles() const;
+        const RT::MeshArray<std::pair<Vec3D, Vec3D>>& GetEdges() const;
+        const RT::MeshArray<Vec3D>& GetNormals() const;
+        const RT::MeshArray<Vec3D>& GetVertexNormals() const;
+        /// \brief Texture coordinates of every vertex, empty if the mesh has none
+        const RT::MeshArray<Vector<double, 2>>& GetTexCoords() const { return texCoords_; }
+        /// \brief Hierarchy over the triangles, root first, empty for a mesh without triangles
+        const RT::MeshArray<RT::MeshBvhNode>& GetBvh() const { return bvh_; }
+        /// \brief True if vertex normals come from the file rather than from the faces
+        bool HasAuthoredNormals() const { return authoredNormals_; }
+        /// \brief Mean edge length, the size of the smallest details the mesh can show
+        double GetFeatureSize() const { return featureSize_; }
+        /// \brief Simplified versions of the mesh, from the most detailed one, see MeshPreprocess::Simplify()
+        const std::vector<std::shared_ptr<RT::TriangleMesh>>& GetLods() const { return lods_; }
+        /**
+         * @brief Sets the simplified versions of the mesh, they are transformed together with it.
+         *
+         * Transformations are measured on this mesh (its box, its lowest vertices) and applied to the levels
+         * unchanged, so all levels stay in place however their own vertices differ.
+         */
+        void SetLods(std::vector<std::shared_ptr<RT::TriangleMesh>> lods);
+        /// \brief Coarsest level whose feature size is within footprint, the mesh itself if there is none
+        const RT::TriangleMesh& SelectLod(double footprint) const;
+        /**
+         * @brief Replaces the arrays used by intersection tests with a CompactMesh, the levels of detail too.
+         *
+         * Vertices, triangles, edges, normals and the BVH are released, the getters return empty arrays and the
+         * mesh can't be transformed any more (std::logic_error). Meant for placed meshes of a built scene.
+         */
+        void Compact();
+        /// \brief Quantised arrays after Compact(), null before
+        const RT::CompactMesh* GetCompact() const { return pCompact_.get(); }
+        /**
+         * @brief Replaces the vertex normals computed from the faces with authored ones.
+         *
+         * Authored normals are kept by updateEdgesAndNormals() and transformed together with the vertices.
+         * Throws std::invalid_argument if there isn't one normal per vertex.
+         */
+        void SetVertexNormals(std::vector<Vec3D> vertexNormals);
+        /// \brief Sets texture coordinates, one per vertex, throws std::invalid_argument otherwise
+        void SetTexCoords(std::vector<Vector<double, 2>> texCoords);
         void SetSmoothness(double smoothness) { smoothness_ = smoothness; };
-        double GetSmoothness() { return smoothness_; };
+        double GetSmoothness() const { return smoothness_; };
 
         virtual const RT::ObjectType GetType() const override;
         virtual std::pair<Vec3D, Vec3D> GetBoundingPoints() const override;
@@ -106,7 +256,7 @@ namespace RT{
         void SetPos(const Vec3D point) override;
         /// \brief Rescale the object to fit 1x1 square(x and z coordinates) with x and y multiplier to 1x1 square
         void Fit1x1(double xOffset, double zOffset);
-        /// \brief Recalculate edges and normals after changing object
+        /// \brief Recalculate edges, normals and the BVH after changing object
         void updateEdgesAndNormals();
         /**
          * @brief Rotates the mesh around its center.
@@ -116,6 +266,14 @@ namespace RT{
 
     private:
         void RotatePointAroundCenter(Vec3D& point, Vec3D center, double angleInRadians);
+        /// \brief Moves the mesh and its levels of detail by offset
+        void Translate(const Vec3D& offset);
+        /// \brief Maps every coordinate to (coordinate - corner) / extent * size, on the levels of detail too
+        void Rescale(const Vec3D& corner, const Vec3D& extent, const Vec3D& size);
+        /// \brief Rotates the mesh and its levels of detail around the vertical axis through center
+        void RotateAround(const Vec3D& center, double angleInRadians);
+        /// \brief Throws std::logic_error for a compacted mesh
+        void CheckNotCompact() const;
 
         double smoothness_ = Utils::BASE_SMOOTHNESS;
 
@@ -123,13 +281,100 @@ namespace RT{
         std::vector<RT::Triangle*> boundingVolume_;
 
         // Triangle mesh base params
-        std::vector<Vec3D> vertices_;
-        std::vector<Vector<int, 3>> triangles_;
+        RT::MeshArray<Vec3D> vertices_;
+        RT::MeshArray<Vector<int, 3>> triangles_;
 
         // Precalculated params needed for intersection testing
-        std::vector<Vec3D> normals_;
-        std::vector<Vec3D> vertexNormals_;
-        std::vector<std::pair<Vec3D, Vec3D>> edges_; // only two edges needed for our intersection testing
+        RT::MeshArray<Vec3D> normals_;
+        RT::MeshArray<Vec3D> vertexNormals_;
+        RT::MeshArray<std::pair<Vec3D, Vec3D>> edges_; // only two edges needed for our intersection testing
+        RT::MeshArray<RT::MeshBvhNode> bvh_;
+
+        // Loaded from the file, not derived from the vertices
+        bool authoredNormals_ = false;
+        RT::MeshArray<Vector<double, 2>> texCoords_;
+
+        double featureSize_ = 0.;
+        std::vector<std::shared_ptr<RT::TriangleMesh>> lods_;
+        // Never changed once created, so copies share it
+        std::shared_ptr<const RT::CompactMesh> pCompact_;
+    };
+    /**
+     * @struct RevolutionSegment
+     * @brief Segment of the profile of a SurfaceOfRevolution, points as (radius, height above the base).
+     */
+    struct RevolutionSegment{
+        Vector<double, 2> start;
+        Vector<double, 2> end;
+        double minY;
+        double maxY;
+        double maxRadius;
+        /// \brief Change of the radius per unit of height, the segment sweeps a cone frustum
+        double slope;
+        /// \brief Both ends at the same height, the segment sweeps an annulus in a horizontal plane
+        bool horizontal;
+        /// \brief Outward normal of the segment and the normals of the profile at its ends, for smooth shading
+        Vector<double, 2> normal;
+        Vector<double, 2> startNormal;
+        Vector<double, 2> endNormal;
+    };
+    /**
+     * @class SurfaceOfRevolution
+     * @brief A profile curve revolved around the vertical axis through a base point, for lathe-shaped pieces.
+     *
+     * Rays are intersected exactly with the cone frustum or annulus of every profile segment (Ray.cpp), the
+     * normal around the axis is exact and the normal along the profile is blended by smoothness from the
+     * segment normal to the normals interpolated between the profile points, like the vertex normals of a mesh.
+     */
+    class SurfaceOfRevolution : public Object{
+    public:
+        /**
+         * @brief Surface of a closed or open profile of (radius, height above the base) points.
+         *
+         * The profile may run either way, it's oriented so that the solid lies on its left going up the outside.
+         * Points on the axis close the surface there, a profile ending off the axis leaves a hole.
+         * Throws std::invalid_argument for less than two points or negative radii.
+         */
+        explicit SurfaceOfRevolution(std::vector<Vector<double, 2>> profile);
+
+        const std::vector<Vector<double, 2>>& GetProfile() const { return profile_; }
+        const std::vector<RT::RevolutionSegment>& GetSegments() const { return segments_; }
+        /// \brief Point of the axis at height 0 of the profile
+        const Vec3D& GetBase() const { return base_; }
+        double GetRadius() const { return radius_; }
+        /** @{ \name Lowest and highest profile point, above the base */
+        double GetBottom() const { return bottom_; }
+        double GetTop() const { return top_; }
+        /** @} */
+        void SetSmoothness(double smoothness) { smoothness_ = smoothness; };
+        double GetSmoothness() const { return smoothness_; };
+
+        virtual const RT::ObjectType GetType() const override;
+        virtual std::pair<Vec3D, Vec3D> GetBoundingPoints() const override;
+        /// \brief Moves the base to point, the center of the bottom like TriangleMesh::SetCenter()
+        void SetCenter(const Vec3D point) override;
+        /// \brief Set bottom left coordinates of the object(min x, min y, min z)
+        void SetPos(const Vec3D point) override;
+
+        /**
+         * @brief Fits the profile of a lathe-shaped mesh, empty if the mesh isn't one.
+         *
+         * Vertices are grouped into rings of equal radius and height around the vertical axis through the center
+         * of the mesh box, the rings with the most vertices are chained along the edges of the mesh from the
+         * lowest one and the ends are closed on the axis where faces cap them. The fit is rejected if a vertex lies
+         * farther than tolerance times the height of the mesh from the profile. base receives the point of the
+         * axis at the lowest vertex.
+         */
+        static std::vector<Vector<double, 2>> FitProfile(const RT::TriangleMesh& mesh, double tolerance, Vec3D& base);
+
+    private:
+        std::vector<Vector<double, 2>> profile_;
+        std::vector<RT::RevolutionSegment> segments_;
+        Vec3D base_{0., 0., 0.};
+        double radius_ = 0.;
+        double bottom_ = 0.;
+        double top_ = 0.;
+        double smoothness_ = Utils::BASE_SMOOTHNESS;
     };
     /**
      * @class DistantLightSource
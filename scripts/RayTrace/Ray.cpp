@@ -1,4 +1,54 @@
 #include "Ray.h"
+#include "RenderStats.h"
+
+namespace {
+    /**
+     * Ordered traversal of a mesh BVH of either node type. enter(node) returns the distance at which the ray
+     * enters a node or a negative value beyond closest, testLeaf(node) lowers closest to the distance of its hits.
+     * The nearer child goes first, so farther boxes are mostly cut off by the closest hit.
+     */
+    template<typename Node, typename EnterNode, typename TestLeaf>
+    void Traverse(const Node* pNodes, const double& closest, EnterNode& enter, TestLeaf& testLeaf) {
+        uint32_t stack[RT::MeshBvh::MAX_DEPTH];
+        double stackDistances[RT::MeshBvh::MAX_DEPTH];
+        size_t stackSize = 0;
+        uint32_t nodeIndex = 0;
+        if (enter(pNodes[0]) < 0.) return;
+        while (true){
+            const Node& node = pNodes[nodeIndex];
+            STAT_ADD(bvhNodeVisits, 1);
+            if (node.IsLeaf()){
+                testLeaf(node);
+            } else{
+                uint32_t left = nodeIndex + 1, right = node.first;
+                double leftDistance = enter(pNodes[left]);
+                double rightDistance = enter(pNodes[right]);
+                if (leftDistance >= 0. && rightDistance >= 0.){
+                    if (rightDistance < leftDistance){
+                        std::swap(left, right);
+                        std::swap(leftDistance, rightDistance);
+                    }
+                    stack[stackSize] = right;
+                    stackDistances[stackSize++] = rightDistance;
+                    nodeIndex = left;
+                    continue;
+                }
+                if (leftDistance >= 0.){
+                    nodeIndex = left;
+                    continue;
+                }
+                if (rightDistance >= 0.){
+                    nodeIndex = right;
+                    continue;
+                }
+            }
+            // Boxes entered behind a hit found since they were pushed are skipped
+            while (stackSize > 0 && stackDistances[stackSize - 1] > closest) --stackSize;
+            if (stackSize == 0) break;
+            nodeIndex = stack[--stackSize];
+        }
+    }
+}
 
 RT::Ray::Ray() {}
 
@@ -41,10 +91,24 @@ void RT::Ray::SetDirection(Vec3D &direction) {
     direction_ = direction.normalized();
 }
 
+void RT::Ray::SetCone(double width, double spread) {
+    coneWidth_ = width;
+    coneSpread_ = spread;
+}
+
 void RT::Ray::RayIntersect(std::shared_ptr<RT::Object> pObject, RT::HitPayload& payload) {
+    Intersect(pObject, payload, true);
+}
+
+void RT::Ray::RayIntersectUncounted(std::shared_ptr<RT::Object> pObject, RT::HitPayload &payload) {
+    Intersect(pObject, payload, false);
+}
+
+void RT::Ray::Intersect(const std::shared_ptr<RT::Object>& pObject, RT::HitPayload& payload, bool counted) {
     RT::HitPayload newPayload;
     RT::ObjectType objType = pObject->GetType();
     if (objType == RT::ObjectType::TRIANGLE){
+        if (counted) STAT_ADD(triangleTests, 1);
         RT::Triangle* pTriangle = static_cast<RT::Triangle*>(pObject.get());
         Vec3D triangleNormal = pTriangle->GetNormal();
         newPayload = RayTriangleIntersect(pTriangle->GetPointA(), pTriangle->GetPointB(), pTriangle->GetPointC(),
@@ -54,6 +118,17 @@ void RT::Ray::RayIntersect(std::shared_ptr<RT::Object> pObject, RT::HitPayload&
     } else if (objType == RT::ObjectType::TRIANGLE_MESH){
         RT::TriangleMesh* pTriangleMesh = static_cast<RT::TriangleMesh*>(pObject.get());
         newPayload = RayTriangleMeshIntersect(pTriangleMesh);
+    } else if (objType == RT::ObjectType::QUAD){
+        if (counted) STAT_ADD(analyticTests, 1);
+        newPayload = RayQuadIntersect(static_cast<RT::Quad*>(pObject.get()));
+    } else if (objType == RT::ObjectType::SPHERE){
+        if (counted) STAT_ADD(analyticTests, 1);
+        newPayload = RaySphereIntersect(static_cast<RT::Sphere*>(pObject.get()));
+    } else if (objType == RT::ObjectType::PLANE){
+        if (counted) STAT_ADD(analyticTests, 1);
+        newPayload = RayPlaneIntersect(static_cast<RT::Plane*>(pObject.get()));
+    } else if (objType == RT::ObjectType::SURFACE_OF_REVOLUTION){
+        newPayload = RaySurfaceOfRevolutionIntersect(static_cast<RT::SurfaceOfRevolution*>(pObject.get()));
     } else{
         throw std::invalid_argument("Base type object cannot be intersected");
     }
@@ -65,61 +140,303 @@ void RT::Ray::RayIntersect(std::shared_ptr<RT::Object> pObject, RT::HitPayload&
 
 RT::HitPayload RT::Ray::RayTriangleMeshIntersect(RT::TriangleMesh *pTriangleMesh) {
     RT::HitPayload payload;
+    if (pTriangleMesh->GetTriangleNum() == 0) return payload;
 
-    const auto& pVertices = pTriangleMesh->GetVertices();
-    const auto& pEdges = pTriangleMesh->GetEdges();
-    const auto& pTriangles = pTriangleMesh->GetTriangles();
-    const auto& pVertexNormals = pTriangleMesh->GetVertexNormals();
-    const auto& pNormals = pTriangleMesh->GetNormals();
+    double origin[3], inverseDirection[3];
+    for (size_t axis = 0; axis < 3; ++axis){
+        origin[axis] = startPoint_[axis];
+        // Avoids 0 * infinity for rays parallel to a slab starting on its plane
+        double direction = std::fabs(direction_[axis]) > 1e-300 ? direction_[axis] : 1e-300;
+        inverseDirection[axis] = 1. / direction;
+    }
 
-    size_t i = 0;
-    for (const auto& triangle : pTriangles){
+    // Rays starting inside the mesh box (bounces off the mesh itself) keep full detail, a coarser surface could
+    // shadow the point they start from
+    const RT::TriangleMesh* pMesh = pTriangleMesh;
+    if (!pTriangleMesh->GetLods().empty() && (coneWidth_ > 0. || coneSpread_ > 0.)){
+        double entry;
+        if (const RT::CompactMesh* pCompact = pTriangleMesh->GetCompact()){
+            double stepOrigin[3], stepInverseDirection[3];
+            pCompact->ToSteps(origin, inverseDirection, stepOrigin, stepInverseDirection);
+            entry = RT::CompactMesh::Enter(pCompact->GetBvh()[0], stepOrigin, stepInverseDirection, payload.hitDist);
+        } else{
+            entry = RT::MeshBvh::Enter(pTriangleMesh->GetBvh()[0], origin, inverseDirection, payload.hitDist);
+        }
+        if (entry < 0.) return payload;
+        if (entry > 0.) pMesh = &pTriangleMesh->SelectLod(GetFootprint(entry));
+        if (pMesh != pTriangleMesh) STAT_ADD(lodTraversals, 1);
+    }
+    double smoothness = pTriangleMesh->GetSmoothness();
+
+    // Compact meshes decode their corners here, edges and the face normal are computed from them and vertex
+    // normals are only decoded for a closer hit
+    if (const RT::CompactMesh* pCompact = pMesh->GetCompact()){
+        double stepOrigin[3], stepInverseDirection[3];
+        pCompact->ToSteps(origin, inverseDirection, stepOrigin, stepInverseDirection);
+        auto enter = [&](const RT::CompactBvhNode& node) {
+            return RT::CompactMesh::Enter(node, stepOrigin, stepInverseDirection, payload.hitDist);
+        };
+        auto testLeaf = [&](const RT::CompactBvhNode& node) {
+            STAT_ADD(triangleTests, node.count);
+            for (size_t i = node.first; i < node.first + node.count; ++i){
+                uint32_t corners[3];
+                pCompact->GetTriangle(i, corners);
+                Vec3D pointA = pCompact->GetVertex(corners[0]);
+                Vec3D edgeAB = pCompact->GetVertex(corners[1]) - pointA;
+                Vec3D edgeAC = pCompact->GetVertex(corners[2]) - pointA;
+                RT::HitPayload newPayload;
+                if (!RayTriangleHit(pointA, edgeAB, edgeAC, newPayload) || newPayload.hitDist >= payload.hitDist) continue;
+                Vec3D normal = cross(edgeAB, edgeAC).normalized();
 #ifdef __SMOOTHING__
-        RT::HitPayload newPayload = RayTriangleIntersect(pVertices[triangle[0]], pVertices[triangle[1]],pVertices[triangle[2]],
-                                                   pEdges[i].first, pEdges[i].second, pNormals[i], pTriangleMesh->GetSmoothness(),
-                                                   pVertexNormals[triangle[0]], pVertexNormals[triangle[1]], pVertexNormals[triangle[2]]);
+                InterpolateNormal(newPayload, normal, smoothness, pCompact->GetVertexNormal(corners[0]),
+                                  pCompact->GetVertexNormal(corners[1]), pCompact->GetVertexNormal(corners[2]));
 #else
-        auto normal = pNormals[i];
-        RT::HitPayload newPayload = RayTriangleIntersect(pVertices[triangle[0]], pVertices[triangle[1]],pVertices[triangle[2]],
-                                                   pEdges[i].first, pEdges[i].second, normal, 0.,
-                                                   normal, normal, normal);
+                InterpolateNormal(newPayload, normal, 0., normal, normal, normal);
 #endif
-        if (newPayload.hitDist < payload.hitDist){
-            payload = newPayload;
-        }
-        ++i;
+                payload = newPayload;
+            }
+        };
+        Traverse(pCompact->GetBvh().data(), payload.hitDist, enter, testLeaf);
+        return payload;
     }
+
+    const auto& pVertices = pMesh->GetVertices();
+    const auto& pEdges = pMesh->GetEdges();
+    const auto& pTriangles = pMesh->GetTriangles();
+    const auto& pVertexNormals = pMesh->GetVertexNormals();
+    const auto& pNormals = pMesh->GetNormals();
+    auto enter = [&](const RT::MeshBvhNode& node) {
+        return RT::MeshBvh::Enter(node, origin, inverseDirection, payload.hitDist);
+    };
+    auto testLeaf = [&](const RT::MeshBvhNode& node) {
+        STAT_ADD(triangleTests, node.count);
+        for (size_t i = node.first; i < node.first + node.count; ++i){
+            const auto& triangle = pTriangles[i];
+#ifdef __SMOOTHING__
+            RT::HitPayload newPayload = RayTriangleIntersect(pVertices[triangle[0]], pVertices[triangle[1]],pVertices[triangle[2]],
+                                                       pEdges[i].first, pEdges[i].second, pNormals[i], smoothness,
+                                                       pVertexNormals[triangle[0]], pVertexNormals[triangle[1]], pVertexNormals[triangle[2]]);
+#else
+            auto normal = pNormals[i];
+            RT::HitPayload newPayload = RayTriangleIntersect(pVertices[triangle[0]], pVertices[triangle[1]],pVertices[triangle[2]],
+                                                       pEdges[i].first, pEdges[i].second, normal, 0.,
+                                                       normal, normal, normal);
+#endif
+            if (newPayload.hitDist < payload.hitDist){
+                payload = newPayload;
+            }
+        }
+    };
+    Traverse(pMesh->GetBvh().data(), payload.hitDist, enter, testLeaf);
     return payload;
 }
 
-RT::HitPayload RT::Ray::RayTriangleIntersect(const Vec3D &pointA, const Vec3D &pointB, const Vec3D &pointC,
-                                             const Vec3D &edgeAB, const Vec3D &edgeAC, const Vec3D &faceNormal, double smoothness,
-                                             const Vec3D &hitNormal1, const Vec3D &hitNormal2, const Vec3D &hitNormal3) {
+RT::HitPayload RT::Ray::RaySphereIntersect(const RT::Sphere *pSphere) const {
+    RT::HitPayload payload;
+    Vec3D offset = startPoint_ - pSphere->GetCenter();
+    double radius = pSphere->GetRadius();
+    double halfB = offset.dot(direction_);
+    double c = offset.dot(offset) - radius * radius;
+    double discriminant = halfB * halfB - c;
+    if (discriminant < 0.) return payload;
+    double root = std::sqrt(discriminant);
+    // The far root is the exit of rays starting inside
+    double hitDist = -halfB - root;
+    if (hitDist < 0.01) hitDist = -halfB + root;
+    if (hitDist < 0.01) return payload;
+    payload.hitDist = hitDist;
+    payload.hitPoint = startPoint_ + direction_ * hitDist;
+    payload.hitNormal = (payload.hitPoint - pSphere->GetCenter()) / radius;
+    payload.frontFace = direction_.dot(payload.hitNormal) < 0.;
+    return payload;
+}
+
+RT::HitPayload RT::Ray::RayQuadIntersect(const RT::Quad *pQuad) const {
+    RT::HitPayload payload;
+    const Vec3D& normal = pQuad->GetNormal();
+    double facing = normal.dot(direction_);
+    if (std::fabs(facing) < 1e-12) return payload;
+    Vec3D toCorner = pQuad->GetCorner() - startPoint_;
+    double hitDist = normal.dot(toCorner) / facing;
+    if (hitDist < 0.01) return payload;
+    // Offset of the hit from the corner, rejected before anything is written into the payload
+    Vec3D offset = direction_ * hitDist - toCorner;
+    double u = offset.dot(pQuad->GetAxisU());
+    if (u < 0. || u > 1.) return payload;
+    double v = offset.dot(pQuad->GetAxisV());
+    if (v < 0. || v > 1.) return payload;
+    payload.u = u;
+    payload.v = v;
+    payload.hitDist = hitDist;
+    payload.hitPoint = startPoint_ + direction_ * hitDist;
+    payload.hitNormal = normal;
+    payload.frontFace = facing < 0.;
+    return payload;
+}
+
+RT::HitPayload RT::Ray::RayPlaneIntersect(const RT::Plane *pPlane) const {
     RT::HitPayload payload;
+    const Vec3D& normal = pPlane->GetNormal();
+    double facing = normal.dot(direction_);
+    if (std::fabs(facing) < 1e-12) return payload;
+    double hitDist = normal.dot(pPlane->GetPoint() - startPoint_) / facing;
+    if (hitDist < 0.01) return payload;
+    payload.hitDist = hitDist;
+    payload.hitPoint = startPoint_ + direction_ * hitDist;
+    payload.hitNormal = normal;
+    payload.frontFace = facing < 0.;
+    return payload;
+}
+
+RT::HitPayload RT::Ray::RaySurfaceOfRevolutionIntersect(const RT::SurfaceOfRevolution *pSurface) const {
+    RT::HitPayload payload;
+    const Vec3D& base = pSurface->GetBase();
+    double originX = startPoint_[0] - base[0], originY = startPoint_[1] - base[1], originZ = startPoint_[2] - base[2];
+    double directionY = direction_[1];
+    // Squared distance from the axis along the ray is a * t^2 + 2 * b * t + c
+    double a = direction_[0] * direction_[0] + direction_[2] * direction_[2];
+    double b = originX * direction_[0] + originZ * direction_[2];
+    double c = originX * originX + originZ * originZ;
+
+    // Bounding cylinder, closest approach to the axis and the heights the ray passes through
+    double radius = pSurface->GetRadius();
+    double near = 0., far = DBL_MAX, closestSquared = c;
+    if (a > 1e-12){
+        double discriminant = b * b - a * (c - radius * radius);
+        if (discriminant < 0.) return payload;
+        double root = std::sqrt(discriminant);
+        near = (-b - root) / a;
+        far = (-b + root) / a;
+        closestSquared = c - b * b / a;
+    } else if (c > radius * radius){
+        return payload;
+    }
+    if (std::fabs(directionY) > 1e-12){
+        double t0 = (pSurface->GetBottom() - originY) / directionY;
+        double t1 = (pSurface->GetTop() - originY) / directionY;
+        if (t0 > t1) std::swap(t0, t1);
+        near = std::max(near, t0);
+        far = std::min(far, t1);
+    } else if (originY < pSurface->GetBottom() || originY > pSurface->GetTop()){
+        return payload;
+    }
+    if (far < 0.01 || near > far) return payload;
+
+    const RT::RevolutionSegment* pHitSegment = nullptr;
+    double closest = DBL_MAX;
+    auto accept = [&](double t, const RT::RevolutionSegment& segment) {
+        if (t < 0.01 || t >= closest) return;
+        double y = originY + directionY * t;
+        if (y < segment.minY || y > segment.maxY) return;
+        closest = t;
+        pHitSegment = &segment;
+    };
+    for (const auto& segment : pSurface->GetSegments()){
+        if (segment.maxRadius * segment.maxRadius < closestSquared) continue;
+        if (std::fabs(directionY) > 1e-12){
+            double t0 = (segment.minY - originY) / directionY;
+            double t1 = (segment.maxY - originY) / directionY;
+            if (std::max(t0, t1) < 0.01 || std::min(t0, t1) >= closest) continue;
+        } else if (originY < segment.minY || originY > segment.maxY){
+            continue;
+        }
+        STAT_ADD(analyticTests, 1);
+
+        if (segment.horizontal){
+            if (std::fabs(directionY) <= 1e-12) continue;
+            double t = (segment.start[1] - originY) / directionY;
+            double distanceSquared = (a * t + 2. * b) * t + c;
+            double minRadius = std::min(segment.start[0], segment.end[0]);
+            if (distanceSquared < minRadius * minRadius || distanceSquared > segment.maxRadius * segment.maxRadius) continue;
+            if (t >= 0.01 && t < closest){
+                closest = t;
+                pHitSegment = &segment;
+            }
+            continue;
+        }
+        // Radius of the cone at the height of the ray is e + f * t, only its nappe with e + f * t >= 0 is real
+        double e = segment.start[0] + segment.slope * (originY - segment.start[1]);
+        double f = segment.slope * directionY;
+        double quadratic = a - f * f, linear = b - e * f, constant = c - e * e;
+        if (std::fabs(quadratic) < 1e-12){
+            if (std::fabs(linear) < 1e-12) continue;
+            double t = -constant / (2. * linear);
+            if (e + f * t >= 0.) accept(t, segment);
+            continue;
+        }
+        double discriminant = linear * linear - quadratic * constant;
+        if (discriminant < 0.) continue;
+        double root = std::sqrt(discriminant);
+        double t0 = (-linear - root) / quadratic, t1 = (-linear + root) / quadratic;
+        if (t0 > t1) std::swap(t0, t1);
+        if (e + f * t0 >= 0.) accept(t0, segment);
+        if (e + f * t1 >= 0.) accept(t1, segment);
+    }
+    if (!pHitSegment) return payload;
+
+    const RT::RevolutionSegment& segment = *pHitSegment;
+    payload.hitDist = closest;
+    payload.hitPoint = startPoint_ + direction_ * closest;
+    double x = originX + direction_[0] * closest, y = originY + directionY * closest, z = originZ + direction_[2] * closest;
+    double distance = std::sqrt(x * x + z * z);
+    double radialX = distance > 1e-12 ? x / distance : 0., radialZ = distance > 1e-12 ? z / distance : 0.;
+    // Position along the segment, by radius on horizontal segments and by height on the others
+    double along = segment.horizontal ? (distance - segment.start[0]) / (segment.end[0] - segment.start[0])
+                                      : (y - segment.start[1]) / (segment.end[1] - segment.start[1]);
+    along = std::clamp(along, 0., 1.);
+
+#ifdef __SMOOTHING__
+    double smoothness = pSurface->GetSmoothness();
+#else
+    double smoothness = 0.;
+#endif
+    Vector<double, 2> normal = segment.normal * (1. - smoothness) +
+            (segment.startNormal * (1. - along) + segment.endNormal * along) * smoothness;
+    payload.hitNormal = Vec3D{normal[0] * radialX, normal[1], normal[0] * radialZ}.normalized();
+    Vec3D faceNormal{segment.normal[0] * radialX, segment.normal[1], segment.normal[0] * radialZ};
+    payload.frontFace = direction_.dot(faceNormal) < 0.;
+    return payload;
+}
+
+bool RT::Ray::RayTriangleHit(const Vec3D &pointA, const Vec3D &edgeAB, const Vec3D &edgeAC,
+                             RT::HitPayload &payload) const {
     Vec3D pVec = cross(direction_, edgeAC);
     double det = edgeAB.dot(pVec);
-    if (abs(det) < Utils::PARALLEL_PRECISION) return payload;
+    if (abs(det) < Utils::PARALLEL_PRECISION) return false;
 
     double invDet = 1 / det;
     Vec3D tVec = startPoint_ - pointA;
 
     payload.u = tVec.dot(pVec) * invDet;
-    if (payload.u < 0 || payload.u > 1) return payload;
+    if (payload.u < 0 || payload.u > 1) return false;
 
     Vec3D qVec = cross(tVec, edgeAB);
     payload.v = direction_.dot(qVec) * invDet;
-    if (payload.v < 0 || payload.u + payload.v > 1) return payload;
+    if (payload.v < 0 || payload.u + payload.v > 1) return false;
 
     double hitDist = edgeAC.dot(qVec) * invDet;
-    if (hitDist < 0.01) return payload;
+    if (hitDist < 0.01) return false;
     payload.hitDist = hitDist;
+    payload.hitPoint = startPoint_ + direction_ * hitDist;
+    payload.frontFace = det > 0;
+    return true;
+}
+
+void RT::Ray::InterpolateNormal(RT::HitPayload &payload, const Vec3D &faceNormal, double smoothness,
+                                const Vec3D &hitNormal1, const Vec3D &hitNormal2, const Vec3D &hitNormal3) {
     payload.hitNormal = (
             1 - payload.u - payload.v) * (hitNormal1 * smoothness + faceNormal * (1. - smoothness)) +
             payload.u * (hitNormal2 * smoothness + faceNormal * (1. - smoothness)) +
             payload.v * (hitNormal3 * smoothness + faceNormal * (1. - smoothness));
-    payload.hitPoint = startPoint_ + direction_ * hitDist;
-    payload.frontFace = det > 0;
+}
 
+RT::HitPayload RT::Ray::RayTriangleIntersect(const Vec3D &pointA, const Vec3D &pointB, const Vec3D &pointC,
+                                             const Vec3D &edgeAB, const Vec3D &edgeAC, const Vec3D &faceNormal, double smoothness,
+                                             const Vec3D &hitNormal1, const Vec3D &hitNormal2, const Vec3D &hitNormal3) {
+    RT::HitPayload payload;
+    if (RayTriangleHit(pointA, edgeAB, edgeAC, payload)){
+        InterpolateNormal(payload, faceNormal, smoothness, hitNormal1, hitNormal2, hitNormal3);
+    }
     return payload;
 }
 
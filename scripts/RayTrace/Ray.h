@@ -37,6 +37,17 @@ namespace RT{
         void SetStartPoint(Vec3D &startPoint);
         void SetScreenPoint(Vec3D &screenPoint);
         void SetDirection(Vec3D &direction);
+        /**
+         * @brief Sets the ray cone, its width at the start point and its spread angle in radians.
+         *
+         * The footprint of the cone where it enters a mesh picks the coarsest level of detail whose feature size
+         * fits into it (TriangleMesh::SelectLod()). Rays start with an empty cone, which keeps full detail.
+         */
+        void SetCone(double width, double spread);
+        double GetConeWidth() const { return coneWidth_; }
+        double GetConeSpread() const { return coneSpread_; }
+        /// \brief Width of the cone at distance from the start point
+        double GetFootprint(double distance) const { return coneWidth_ + coneSpread_ * distance; }
 
         const Vec3D GetStartPoint() const;
         const Vec3D GetScreenPoint() const;
@@ -45,19 +56,34 @@ namespace RT{
         const Vec3D GetReflected(const Vec3D& reflectNormal) const;
         /// \brief Get retracted ray direction along a hit surface normal of dielectric material
         const Vec3D GetRefracted(const Vec3D& refractNormal, double ri) const;
-        /// \brief Check if ray intersects with object
+        /// \brief Check if ray intersects with object, counted as a triangle or analytic test in RenderStats
         void RayIntersect(std::shared_ptr<RT::Object> pObject, RT::HitPayload& payload);
+        /// \brief RayIntersect() without counting the test, for faces of bounding boxes which count as one box test
+        void RayIntersectUncounted(std::shared_ptr<RT::Object> pObject, RT::HitPayload& payload);
 
         /// \brief Reflect this ray along a hit surface normal
         void Reflect(const Vec3D &reflectNormal, const Vec3D &rayStart);
     private:
+        void Intersect(const std::shared_ptr<RT::Object>& pObject, RT::HitPayload& payload, bool counted);
+        /// \brief Möller–Trumbore test, fills everything but the normal of payload on a hit in front of the ray
+        bool RayTriangleHit(const Vec3D &pointA, const Vec3D &edgeAB, const Vec3D &edgeAC, RT::HitPayload& payload) const;
+        /// \brief Normal at the barycentric hit of payload, blended from face to vertex normals by smoothness
+        static void InterpolateNormal(RT::HitPayload& payload, const Vec3D &faceNormal, double smoothness,
+                                      const Vec3D &hitNormal1, const Vec3D &hitNormal2, const Vec3D &hitNormal3);
         RT::HitPayload RayTriangleIntersect(const Vec3D &pointA, const Vec3D &pointB, const Vec3D &pointC,
                                             const Vec3D &edgeAB, const Vec3D &edgeAC, const Vec3D &faceNormal, double smoothness,
                                             const Vec3D &hitNormal1, const Vec3D &hitNormal2, const Vec3D &hitNormal3);
         RT::HitPayload RayTriangleMeshIntersect(RT::TriangleMesh* pTriangleMesh);
+        RT::HitPayload RaySphereIntersect(const RT::Sphere* pSphere) const;
+        RT::HitPayload RayQuadIntersect(const RT::Quad* pQuad) const;
+        RT::HitPayload RayPlaneIntersect(const RT::Plane* pPlane) const;
+        /// \brief Exact test against the frustum or annulus of every profile segment the ray can reach
+        RT::HitPayload RaySurfaceOfRevolutionIntersect(const RT::SurfaceOfRevolution* pSurface) const;
         Vec3D startPoint_;
         Vec3D screenPoint_;
         Vec3D direction_;
+        double coneWidth_ = 0.;
+        double coneSpread_ = 0.;
     };
 }
 
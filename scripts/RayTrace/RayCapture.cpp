@@ -0,0 +1,106 @@
+#include "RayCapture.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    constexpr char MAGIC[8] = {'R', 'T', 'R', 'A', 'Y', 'C', 'A', 'P'};
+    constexpr uint32_t VERSION = 1;
+
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t count;
+        uint64_t descriptionSize;
+    };
+}
+
+const char* RT::RayKindName(RT::RayKind kind) {
+    switch (kind) {
+        case RayKind::PRIMARY:
+            return "primary";
+        case RayKind::SECONDARY:
+            return "secondary";
+        case RayKind::SHADOW:
+            return "shadow";
+        default:
+            return "";
+    }
+}
+
+RT::Ray RT::CapturedRay::ToRay() const {
+    Vec3D start{origin[0], origin[1], origin[2]};
+    Vec3D rayDirection{direction[0], direction[1], direction[2]};
+    RT::Ray ray;
+    ray.SetStartPoint(start);
+    ray.SetDirection(rayDirection);
+    return ray;
+}
+
+bool RT::CapturedRay::IsHit() const {
+    return hitDistance != DBL_MAX;
+}
+
+RT::RayCapture::RayCapture(size_t every, size_t limit) : every_(std::max<size_t>(every, 1)), limit_(limit) {}
+
+void RT::RayCapture::Record(const RT::Ray &ray, RT::RayKind kind, int depth, const RT::HitPayload &payload) {
+    if (counter_.fetch_add(1, std::memory_order_relaxed) % every_ != 0) return;
+    CapturedRay captured{};
+    Vec3D start = ray.GetStartPoint();
+    Vec3D direction = ray.GetDirection();
+    for (size_t i = 0; i < 3; ++i){
+        captured.origin[i] = start[i];
+        captured.direction[i] = direction[i];
+    }
+    captured.hitDistance = payload.hitDist;
+    captured.kind = kind;
+    captured.depth = static_cast<uint8_t>(std::min(depth, 255));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (rays_.size() < limit_) rays_.push_back(captured);
+}
+
+void RT::RayCapture::Save(const std::string &path, const std::string &sceneDescription) const {
+    Header header{};
+    std::copy(MAGIC, MAGIC + 8, header.magic);
+    header.version = VERSION;
+    header.recordSize = sizeof(CapturedRay);
+    header.count = rays_.size();
+    header.descriptionSize = sceneDescription.size();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) throw std::runtime_error("Error opening file: " + path);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(sceneDescription.data(), static_cast<std::streamsize>(sceneDescription.size()));
+    file.write(reinterpret_cast<const char*>(rays_.data()), static_cast<std::streamsize>(rays_.size() * sizeof(CapturedRay)));
+    file.flush();
+    if (!file) throw std::runtime_error("Writing rays failed: " + path);
+}
+
+std::vector<RT::CapturedRay> RT::RayCapture::Load(const std::string &path, std::string &sceneDescription) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) throw std::runtime_error("Error opening file: " + path);
+
+    Header header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || !std::equal(MAGIC, MAGIC + 8, header.magic) || header.version != VERSION ||
+        header.recordSize != sizeof(CapturedRay)){
+        throw std::runtime_error("Not a ray capture of this renderer: " + path);
+    }
+    // Sizes are checked against the file, so a damaged header can't allocate absurd amounts of memory
+    file.seekg(0, std::ios::end);
+    uint64_t available = static_cast<uint64_t>(file.tellg()) - sizeof(header);
+    if (header.descriptionSize > available ||
+        header.count != (available - header.descriptionSize) / sizeof(CapturedRay)){
+        throw std::runtime_error("Ray capture is truncated or damaged: " + path);
+    }
+    file.seekg(sizeof(header));
+
+    sceneDescription.resize(header.descriptionSize);
+    file.read(sceneDescription.data(), static_cast<std::streamsize>(header.descriptionSize));
+    std::vector<CapturedRay> rays(header.count);
+    file.read(reinterpret_cast<char*>(rays.data()), static_cast<std::streamsize>(rays.size() * sizeof(CapturedRay)));
+    if (!file) throw std::runtime_error("Ray capture is truncated or damaged: " + path);
+    return rays;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file RayCapture.h
+ * @brief Defines recording of rays traced during a render, so traversal can be benchmarked on real workloads.
+ */
+#ifndef MAIN_CPP_RAYCAPTURE_H
+#define MAIN_CPP_RAYCAPTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Ray.h"
+
+namespace RT{
+    enum class RayKind : uint8_t{
+        PRIMARY, /**< Shot from the camera. */
+        SECONDARY, /**< Scattered or reflected by a material. */
+        SHADOW, /**< Towards the light source. */
+        COUNT
+    };
+
+    /// \brief Lowercase name of the ray kind
+    const char* RayKindName(RayKind kind);
+
+    /**
+     * @struct CapturedRay
+     * @brief One traced ray with the closest hit found during the render.
+     *
+     * Origin and direction are stored as doubles, so the replayed ray is the traced one up to the rounding of its
+     * normalization and a different hit comes from the traversal.
+     */
+    struct CapturedRay{
+        double origin[3];
+        double direction[3];
+        /// \brief Distance of the closest hit, DBL_MAX for rays which didn't hit anything
+        double hitDistance;
+        RT::RayKind kind;
+        /// \brief Bounce index, 0 for primary rays
+        uint8_t depth;
+        uint8_t padding[6];
+
+        /// \brief Ray with the stored origin and direction
+        RT::Ray ToRay() const;
+        bool IsHit() const;
+    };
+
+    /**
+     * @class RayCapture
+     * @brief Records every n-th ray traced by Scene into a compact binary file.
+     *
+     * File layout: magic "RTRAYCAP", version, record size, ray count, length of the scene description and the
+     * description itself (a RenderJob line, so the replay can rebuild the same scene), followed by the
+     * CapturedRay records.
+     */
+    class RayCapture{
+    public:
+        /// \brief Records rays 0, every, 2 * every... (counted over all threads) until limit rays are recorded
+        explicit RayCapture(size_t every = 1, size_t limit = Utils::RAY_CAPTURE_LIMIT);
+
+        /// \brief Called by Scene for every traced ray with its closest hit, thread safe
+        void Record(const RT::Ray& ray, RT::RayKind kind, int depth, const RT::HitPayload& payload);
+
+        /// \brief Recorded rays, call only while nothing records
+        const std::vector<RT::CapturedRay>& GetRays() const { return rays_; }
+        /// \brief Writes the recorded rays, throws std::runtime_error on failure
+        void Save(const std::string& path, const std::string& sceneDescription) const;
+        /// \brief Reads rays written by Save(), throws std::runtime_error if the file is missing or damaged
+        static std::vector<RT::CapturedRay> Load(const std::string& path, std::string& sceneDescription);
+
+    private:
+        size_t every_;
+        size_t limit_;
+        std::atomic<uint64_t> counter_{0};
+        std::mutex mutex_;
+        std::vector<RT::CapturedRay> rays_;
+    };
+}
+
+#endif
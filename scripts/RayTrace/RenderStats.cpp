@@ -0,0 +1,167 @@
+#include "RenderStats.h"
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+namespace {
+    struct Registry{
+        std::mutex mutex;
+        std::vector<RT::RenderStats*> threads;
+        /// \brief Counters of threads which already exited
+        RT::RenderStats retired;
+    };
+
+    Registry& GetRegistry() {
+        // Never destroyed, threads of static objects (e.g. the shared thread pool) may exit after main() returns
+        static Registry* pRegistry = new Registry();
+        return *pRegistry;
+    }
+
+    struct ThreadStats{
+        RT::RenderStats stats;
+
+        ThreadStats() {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.threads.push_back(&stats);
+        }
+        ~ThreadStats() {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.retired += stats;
+            registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), &stats));
+        }
+    };
+
+    template <size_t N>
+    void WriteJsonArray(std::ostream& stream, const uint64_t (&values)[N]) {
+        stream << "[";
+        for (size_t i = 0; i < N; ++i){
+            stream << (i == 0 ? "" : ", ") << values[i];
+        }
+        stream << "]";
+    }
+}
+
+const char* RT::PathEndName(RT::PathEnd end) {
+    switch (end) {
+        case PathEnd::ESCAPED:
+            return "escaped";
+        case PathEnd::ABSORBED:
+            return "absorbed";
+        case PathEnd::MAX_DEPTH:
+            return "max_depth";
+        default:
+            return "";
+    }
+}
+
+RT::RenderStats &RT::RenderStats::operator+=(const RT::RenderStats &other) {
+    for (size_t i = 0; i <= MAX_TRACKED_DEPTH; ++i){
+        raysPerBounce[i] += other.raysPerBounce[i];
+        pathLengths[i] += other.pathLengths[i];
+    }
+    shadowRays += other.shadowRays;
+    boxTests += other.boxTests;
+    bvhNodeVisits += other.bvhNodeVisits;
+    triangleTests += other.triangleTests;
+    analyticTests += other.analyticTests;
+    lodTraversals += other.lodTraversals;
+    scatterCalls += other.scatterCalls;
+    for (size_t i = 0; i < static_cast<size_t>(PathEnd::COUNT); ++i){
+        pathEnds[i] += other.pathEnds[i];
+    }
+    seconds += other.seconds;
+    return *this;
+}
+
+uint64_t RT::RenderStats::GetSecondaryRays() const {
+    uint64_t rays = 0;
+    for (size_t i = 1; i <= MAX_TRACKED_DEPTH; ++i){
+        rays += raysPerBounce[i];
+    }
+    return rays;
+}
+
+double RT::RenderStats::GetAveragePathLength() const {
+    uint64_t paths = 0, bounces = 0;
+    for (size_t i = 0; i <= MAX_TRACKED_DEPTH; ++i){
+        paths += pathLengths[i];
+        bounces += pathLengths[i] * i;
+    }
+    return paths > 0 ? static_cast<double>(bounces) / paths : 0.;
+}
+
+void RT::RenderStats::WriteJson(std::ostream &stream) const {
+    stream << "{\n"
+           << "  \"seconds\": " << seconds << ",\n"
+           << "  \"mrays_per_second\": " << GetMraysPerSecond() << ",\n"
+           << "  \"rays\": {\"primary\": " << GetPrimaryRays() << ", \"secondary\": " << GetSecondaryRays()
+           << ", \"shadow\": " << shadowRays << ", \"total\": " << GetTotalRays() << "},\n"
+           << "  \"rays_per_bounce\": ";
+    WriteJsonArray(stream, raysPerBounce);
+    stream << ",\n"
+           << "  \"box_tests\": " << boxTests << ",\n"
+           << "  \"bvh_node_visits\": " << bvhNodeVisits << ",\n"
+           << "  \"triangle_tests\": " << triangleTests << ",\n"
+           << "  \"analytic_tests\": " << analyticTests << ",\n"
+           << "  \"lod_traversals\": " << lodTraversals << ",\n"
+           << "  \"scatter_calls\": " << scatterCalls << ",\n"
+           << "  \"path_lengths\": ";
+    WriteJsonArray(stream, pathLengths);
+    stream << ",\n  \"average_path_length\": " << GetAveragePathLength() << ",\n  \"path_ends\": {";
+    for (size_t i = 0; i < static_cast<size_t>(PathEnd::COUNT); ++i){
+        stream << (i == 0 ? "" : ", ") << "\"" << PathEndName(static_cast<PathEnd>(i)) << "\": " << pathEnds[i];
+    }
+    stream << "}\n}\n";
+}
+
+void RT::RenderStats::WriteSummary(std::ostream &stream) const {
+    uint64_t rays = std::max<uint64_t>(GetTotalRays(), 1);
+    auto flags = stream.flags();
+    auto precision = stream.precision();
+    stream << std::fixed << std::setprecision(2)
+           << "Rendered in " << seconds << " s, " << GetMraysPerSecond() << " Mrays/s\n"
+           << "  rays: " << GetPrimaryRays() << " primary, " << GetSecondaryRays() << " secondary, "
+           << shadowRays << " shadow\n"
+           << "  per ray: " << static_cast<double>(boxTests) / rays << " box tests, "
+           << static_cast<double>(bvhNodeVisits) / rays << " node visits, "
+           << static_cast<double>(triangleTests) / rays << " triangle tests";
+    if (analyticTests > 0) stream << ", " << static_cast<double>(analyticTests) / rays << " analytic tests";
+    stream << "\n";
+    if (lodTraversals > 0){
+        stream << "  levels of detail: " << lodTraversals << " mesh traversals\n";
+    }
+    stream << "  paths: " << GetAveragePathLength() << " bounces on average, ended by";
+    for (size_t i = 0; i < static_cast<size_t>(PathEnd::COUNT); ++i){
+        stream << (i == 0 ? " " : ", ") << PathEndName(static_cast<PathEnd>(i)) << " " << pathEnds[i];
+    }
+    stream << std::endl;
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+RT::RenderStats &RT::RenderStats::Local() {
+    thread_local ThreadStats threadStats;
+    return threadStats.stats;
+}
+
+void RT::RenderStats::Reset() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (RenderStats* pStats : registry.threads){
+        *pStats = RenderStats();
+    }
+    registry.retired = RenderStats();
+}
+
+RT::RenderStats RT::RenderStats::Collect() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    RenderStats total = registry.retired;
+    for (const RenderStats* pStats : registry.threads){
+        total += *pStats;
+    }
+    return total;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file RenderStats.h
+ * @brief Defines the RenderStats counters of rays, intersection tests and paths of a render.
+ */
+#ifndef MAIN_CPP_RENDERSTATS_H
+#define MAIN_CPP_RENDERSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include "../Utilities/Utils.h"
+
+/// \brief Adds amount to a counter of the calling thread, compiled out without __STATS__
+#ifdef __STATS__
+#define STAT_ADD(counter, amount) (RT::RenderStats::Local().counter += (amount))
+#else
+#define STAT_ADD(counter, amount) ((void)0)
+#endif
+
+namespace RT{
+    enum class PathEnd{
+        ESCAPED, /**< The ray left the scene, it's colored by the background. */
+        ABSORBED, /**< The material didn't scatter the ray. */
+        MAX_DEPTH, /**< The path reached RenderSettings::bounces. */
+        COUNT
+    };
+
+    /**
+     * @struct RenderStats
+     * @brief Counters of one render, where the time of the render goes.
+     *
+     * Every thread counts into its own instance (Local()), so counting is a plain increment without atomics or
+     * shared cache lines. Scene resets the counters when a render starts and merges all threads with Collect()
+     * when it ends. Counting can be compiled out by removing __STATS__ from Utils.h.
+     */
+    struct RenderStats{
+        /// \brief Paths and bounces longer than this are counted in the last bucket
+        static constexpr size_t MAX_TRACKED_DEPTH = 32;
+
+        /// \brief Rays traced at each bounce, [0] are primary rays shot from the camera
+        uint64_t raysPerBounce[MAX_TRACKED_DEPTH + 1] = {};
+        /// \brief Rays towards the light source
+        uint64_t shadowRays = 0;
+        /// \brief Ray - bounding box tests
+        uint64_t boxTests = 0;
+        /// \brief Bounding boxes hit by a ray, whose objects were tested, and visited nodes of mesh BVHs
+        uint64_t bvhNodeVisits = 0;
+        /// \brief Ray - triangle tests of scene objects, without the faces of bounding boxes
+        uint64_t triangleTests = 0;
+        /// \brief Ray tests of spheres, quads, planes and profile segments of surfaces of revolution
+        uint64_t analyticTests = 0;
+        /// \brief Mesh traversals which used a simplified level of detail instead of the full mesh
+        uint64_t lodTraversals = 0;
+        /// \brief Calls of Material::Scatter
+        uint64_t scatterCalls = 0;
+        /// \brief Amount of bounces of finished paths
+        uint64_t pathLengths[MAX_TRACKED_DEPTH + 1] = {};
+        /// \brief Finished paths by the reason they ended, indexed by PathEnd
+        uint64_t pathEnds[static_cast<size_t>(PathEnd::COUNT)] = {};
+        /// \brief Wall time of the render, set by Scene
+        double seconds = 0.;
+
+        RenderStats& operator+=(const RenderStats& other);
+
+        uint64_t GetPrimaryRays() const { return raysPerBounce[0]; }
+        uint64_t GetSecondaryRays() const;
+        /// \brief Primary, secondary and shadow rays
+        uint64_t GetTotalRays() const { return GetPrimaryRays() + GetSecondaryRays() + shadowRays; }
+        double GetMraysPerSecond() const { return seconds > 0. ? GetTotalRays() / seconds * 1e-6 : 0.; }
+        /// \brief Average amount of bounces of a path
+        double GetAveragePathLength() const;
+
+        /// \brief Writes all counters as a JSON object
+        void WriteJson(std::ostream& stream) const;
+        /// \brief Writes a short human readable summary
+        void WriteSummary(std::ostream& stream) const;
+
+        /// \brief Counters of the calling thread
+        static RenderStats& Local();
+        /// \brief Zeroes counters of all threads, call only while no render is running
+        static void Reset();
+        /// \brief Sum of counters of all threads (including finished ones) since the last Reset()
+        static RenderStats Collect();
+    };
+
+    /// \brief Lowercase name of the path end, used in JSON
+    const char* PathEndName(PathEnd end);
+}
+
+#endif
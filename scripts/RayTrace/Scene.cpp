@@ -1,79 +1,125 @@
 #include "Scene.h"
 #include "Chessboard.h"
+#include "ToneMapper.h"
+#include "Zobrist.h"
+#include "Trace.h"
+#include "RenderStats.h"
+#include "SceneSnapshot.h"
+#include "../Random/Random.h"
+#include "../Threading/ThreadPool.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+namespace {
+    void CountPathEnd(RT::PathEnd end, int depth) {
+        STAT_ADD(pathLengths[std::min<size_t>(depth, RT::RenderStats::MAX_TRACKED_DEPTH)], 1);
+        STAT_ADD(pathEnds[static_cast<size_t>(end)], 1);
+    }
+}
+
+RT::Scene::Scene() : Scene(Config::FIGURE_CONFIGURATION) {}
+
+RT::Scene::Scene(const RT::FigureConfiguration &figures, const RT::SceneOptions &options)
+    : figures_(figures), options_(options) {
+    TRACE_SCOPE("Scene build");
+    if (options_.snapshotDirectory.empty()){
+        BuildObjects();
+    } else{
+        LoadOrBuildObjects();
+    }
+    if (options_.compactMeshes) CompactMeshes();
+    CalculateBoundingBoxes();
 
-RT::Scene::Scene() {
+    rasterization_ = false;
+    CheckMemoryBudget(0, 0, 0);
+}
+
+void RT::Scene::BuildObjects() {
     auto blue_material_metal = std::make_shared<RT::Metal>(Vec3D{1., 1., 0.}, 0.0);
     auto pink_material_metal = std::make_shared<RT::Metal>(Vec3D{1., 0.35, 1.}, 0.01);
 
     // Create base plane
-    Chessboard chessboard(Vec3D{0., 0., 0.});
+    Chessboard chessboard(Vec3D{0., 0., 0.}, figures_, options_.analyticPieces);
     auto pObjListChessboard = chessboard.GetObjectPointers();
     for (auto pObj : pObjListChessboard){
+        if (options_.glassPieces && (pObj->GetType() == RT::ObjectType::TRIANGLE_MESH ||
+                                     pObj->GetType() == RT::ObjectType::SURFACE_OF_REVOLUTION)){
+            pObj->SetMaterial(Config::GLASS_PIECE_MATERIAL);
+        }
         pObjectList_.push_back(pObj);
     }
 
 //     Create metal mirrors for prettier scene
-    auto plane = std::make_shared<RT::Triangle>(Vec3D{-1., -1., -1.}, Vec3D{9., -1., -1.}, Vec3D{9., 9., -1.});
-    plane->SetMaterial(blue_material_metal);
-    pObjectList_.push_back(plane);
-    auto plane2 = std::make_shared<RT::Triangle>(Vec3D{-1., 9., -1.}, Vec3D{-1., -1., -1.}, Vec3D{9., 9., -1.});
-    plane2->SetMaterial(blue_material_metal);
-    pObjectList_.push_back(plane2);
-    auto plane3 = std::make_shared<RT::Triangle>(Vec3D{-1., -1., -2.}, Vec3D{-1., -1., 9.}, Vec3D{-1., 9., 9.});
-    plane3->SetMaterial(pink_material_metal);
-    pObjectList_.push_back(plane3);
-    auto plane4 = std::make_shared<RT::Triangle>(Vec3D{-1., 9., -2.}, Vec3D{-1., -1., -2.}, Vec3D{-1., 9., 9.});
-    plane4->SetMaterial(pink_material_metal);
-    pObjectList_.push_back(plane4);
+    if (options_.mirrors){
+        auto mirror = std::make_shared<RT::Quad>(Vec3D{-1., -1., -1.}, Vec3D{10., 0., 0.}, Vec3D{0., 10., 0.});
+        mirror->SetMaterial(blue_material_metal);
+        pObjectList_.push_back(mirror);
+        auto mirror2 = std::make_shared<RT::Quad>(Vec3D{-1., -1., -2.}, Vec3D{0., 0., 11.}, Vec3D{0., 10., 0.});
+        mirror2->SetMaterial(pink_material_metal);
+        pObjectList_.push_back(mirror2);
+    }
+}
 
-    CalculateBoundingBoxes();
+void RT::Scene::LoadOrBuildObjects() {
+    uint64_t key = GetSnapshotKey(figures_, options_);
+    std::string path = RT::SceneSnapshot::GetPath(options_.snapshotDirectory, key);
+    try {
+        if (RT::SceneSnapshot::Load(path, key, pObjectList_)) return;
+    } catch (const std::runtime_error& e) {
+        Log("Rebuilding the scene: %s", e.what());
+    }
+    BuildObjects();
+    // A snapshot which can't be written only costs the next start-up the build
+    try {
+        std::filesystem::create_directories(options_.snapshotDirectory);
+        RT::SceneSnapshot::Save(path, key, pObjectList_);
+    } catch (const std::exception& e) {
+        Log("Saving the scene snapshot failed: %s", e.what());
+    }
+}
 
-    rasterization_ = false;
+void RT::Scene::CompactMeshes() {
+    for (const auto& pObject : pObjectList_){
+        if (pObject->GetType() == RT::ObjectType::TRIANGLE_MESH){
+            static_cast<RT::TriangleMesh&>(*pObject).Compact();
+        }
+    }
 }
 
-void RT::Scene::Initialize(size_t width, size_t height, SDL_Renderer *pRend){
+void RT::Scene::Initialize(size_t width, size_t height){
     sceneWidth_ = width;
     sceneHeight_ = height;
-    pRenderer_ = pRend;
-
-    rColor_.resize(sceneWidth_, std::vector<double>(sceneHeight_, Utils::RGB_MAX));
-    gColor_.resize(sceneWidth_, std::vector<double>(sceneHeight_, Utils::RGB_MAX));
-    bColor_.resize(sceneWidth_, std::vector<double>(sceneHeight_, Utils::RGB_MAX));
-
-    uint32_t rMask, gMask, bMask, aMask;
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-    rMask = 0xff000000;
-    gMask = 0x00ff0000;
-    bMask = 0x0000ff00;
-    aMask = 0x000000ff;
-#else
-    rMask = 0x000000ff;
-    gMask = 0x0000ff00;
-    bMask = 0x00ff0000;
-    aMask = 0xff000000;
-#endif
-
-    SDL_Surface *temp = SDL_CreateRGBSurface(0, sceneWidth_, sceneHeight_, 32, rMask, gMask, bMask, aMask);
-    pTexture_ = SDL_CreateTextureFromSurface(pRenderer_, temp);
-    SDL_FreeSurface(temp);
 
+    CheckMemoryBudget(RT::Framebuffer::GetRequiredMemory(sceneWidth_, sceneHeight_), sceneWidth_, sceneHeight_);
+    framebuffer_.Resize(sceneWidth_, sceneHeight_);
+    if (costMapEnabled_) costMap_.Resize(sceneWidth_, sceneHeight_);
 }
 
-uint32_t RT::Scene::ConvertToInt32(double red, double green, double blue) {
-    unsigned char r = static_cast<unsigned char>(red);
-    unsigned char g = static_cast<unsigned char>(green);
-    unsigned char b = static_cast<unsigned char>(blue);
+void RT::Scene::SetResolution(size_t width, size_t height) {
+    sceneWidth_ = width;
+    sceneHeight_ = height;
 
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-    Uint32 color = (r << 24) + (g << 16) + (b << 8) + 255;
-#else
-    Uint32 color = (255 << 24) + (r << 16) + (g << 8) + b;
-#endif
+    framebuffer_ = RT::Framebuffer();
+    CheckMemoryBudget(0, sceneWidth_, sceneHeight_);
+    if (costMapEnabled_) costMap_.Resize(sceneWidth_, sceneHeight_);
+}
 
-    return color;
+void RT::Scene::EnableCostMap(bool enable) {
+    costMapEnabled_ = enable;
+    if (enable) costMap_.Resize(sceneWidth_, sceneHeight_);
+    else costMap_ = RT::CostMap();
 }
 
 bool RT::Scene::Render() {
+    TRACE_SCOPE("Scene::Render");
+    auto start = StartStats();
     if (rasterization_) {
         std::vector<double> depthBuffer;
         for (int i = 0; i < sceneWidth_ * sceneHeight_; ++i) { depthBuffer.emplace_back(DBL_MAX); }
@@ -90,142 +136,351 @@ bool RT::Scene::Render() {
                 ++i;
             }
         }
+        framebuffer_.MarkAllDirty();
     } else{
-        double xFact = 1. / (sceneWidth_);
-        double yFact = 1. / (sceneHeight_);
-#ifdef __MT__
-    std::vector<std::thread> threads;
-    threads.reserve(sceneHeight_);
-    for (size_t y = 0; y < sceneHeight_; ++y) {
-        // Launch a thread for each row
-        threads.emplace_back([this, xFact, yFact, y]() {
-            for (size_t x = 0; x < sceneWidth_; ++x) {
-                // Create and cast ray
-                Vec3D pixelColor = Utils::EMPTY_COLOR;
-                for (double i = 0; i < Utils::SQRT_SAMPLES; ++i){
-                    for (double j = 0; j < Utils::SQRT_SAMPLES; ++j){
-                        // Normalize the pixels according to screen size and center
-                        double xNorm = (x + i / Utils::SQRT_SAMPLES) * xFact - 0.5;
-                        double yNorm = (y + j / Utils::SQRT_SAMPLES) * yFact - 0.5;
-                        RT::Ray ray = camera_.GetRay(xNorm, yNorm);
-                        pixelColor = pixelColor + CalculateHitColor(ray, Utils::BOUNCES);
-                    }
-                }
-                pixelColor = pixelColor / (Utils::SQRT_SAMPLES * Utils::SQRT_SAMPLES);
-                // Convert and set pixel on screen
-                Vec3D pixelColorRGB = ConvertToRGB(pixelColor);
-                SetPixelColor(x, y, pixelColorRGB);
-            }
-        });
-    }
-    for (auto& thread : threads) {
-        thread.join();
+        RenderTiles(framebuffer_, 0, 0, settings_.sqrtSamples * settings_.sqrtSamples);
     }
-#else
-    for (size_t y = 0; y < sceneHeight_; ++y){
-        for (size_t x = 0; x < sceneWidth_; ++x){
-            Vec3D pixelColor = Utils::EMPTY_COLOR;
-            std::cout << "x, y: " << x << ", " << y << std::endl;
-            for (double i = 0; i < Utils::SQRT_SAMPLES; ++i){
-                for (double j = 0; j < Utils::SQRT_SAMPLES; ++j){
-                    // Normalize the pixels according to screen size and center
-                    double xNorm = (x + i / Utils::SQRT_SAMPLES) * xFact - 0.5;
-                    double yNorm = (y + j / Utils::SQRT_SAMPLES) * yFact - 0.5;
-                    RT::Ray ray = camera_.GetRay(xNorm, yNorm);
-                    pixelColor = pixelColor + CalculateHitColor(ray, Utils::BOUNCES);
-                }
+    FinishStats(start);
+    return !stopRequested_.exchange(false);
+}
+
+void RT::Scene::RenderTiles(RT::Framebuffer &framebuffer, size_t firstRow, size_t firstSample, size_t endSample) {
+    double xFact = 1. / (sceneWidth_);
+    double yFact = 1. / (sceneHeight_);
+    auto renderTile = [this, &framebuffer, firstRow, xFact, yFact, firstSample, endSample](size_t tile) {
+        if (stopRequested_) return;
+        TRACE_SCOPE_DETAIL("Tile", std::to_string(tile));
+        size_t x0, y0, x1, y1;
+        framebuffer.GetTileBounds(tile, x0, y0, x1, y1);
+        for (size_t y = y0; y < y1; ++y){
+            for (size_t x = x0; x < x1; ++x){
+                RenderPixel(framebuffer, x, y, firstRow, xFact, yFact, firstSample, endSample);
             }
-            pixelColor = pixelColor / (Utils::SQRT_SAMPLES * Utils::SQRT_SAMPLES);
-            Vec3D pixelRGBColor = ConvertToRGB(pixelColor);
-            SetPixelColor(x, y, pixelRGBColor);
         }
+        framebuffer.MarkTileDirty(tile);
+    };
+#ifdef __MT__
+    // Tiles are handed out to the shared pool one at a time, each tile is a separate block of memory
+    ThreadPool::Shared().ParallelFor(framebuffer.GetTileCount(), renderTile);
+#else
+    for (size_t tile = 0; tile < framebuffer.GetTileCount(); ++tile){
+        renderTile(tile);
     }
 #endif
+}
+
+bool RT::Scene::RenderToImage(RT::ImageWriter &writer, size_t bandRows, size_t bandsInFlight) {
+    if (writer.GetWidth() != sceneWidth_ || writer.GetHeight() != sceneHeight_){
+        throw std::invalid_argument("Image writer size doesn't match the scene");
+    }
+    if (bandRows == 0){
+        bandRows = std::max<size_t>(1, Utils::STREAMED_BAND_PIXELS / sceneWidth_);
     }
-    const int paddingAmount = ((4 - (sceneWidth_ * 3) % 4) % 4);
-    unsigned char bmpPad[3] = { 0, 0, 0 };
-    std::ofstream image = CreateBmpFile();
-    for (int i = 0; i < sceneHeight_; ++i) {
-        for (int j = 0; j < sceneWidth_; ++j) {
-            Vec3D color{bColor_[j][i], gColor_[j][i], rColor_[j][i]};
-            WriteColor(color, image);
+    bandRows = (bandRows + Framebuffer::TILE_SIZE - 1) / Framebuffer::TILE_SIZE * Framebuffer::TILE_SIZE;
+    bandsInFlight = std::max<size_t>(bandsInFlight, 1);
+    size_t maxRows = std::min(bandRows, sceneHeight_);
+    size_t bandBytes = RT::Framebuffer::GetRequiredMemory(sceneWidth_, maxRows) + sceneWidth_ * maxRows * sizeof(uint32_t);
+    CheckMemoryBudget(bandsInFlight * bandBytes, sceneWidth_, sceneHeight_);
+    TRACE_SCOPE("Scene::RenderToImage");
+    auto start = StartStats();
+
+    struct Band{
+        RT::Framebuffer framebuffer;
+        std::vector<uint32_t> pixels;
+    };
+    std::vector<std::unique_ptr<Band>> bands;
+    std::deque<Band*> freeBands, finishedBands;
+    for (size_t i = 0; i < bandsInFlight; ++i){
+        bands.push_back(std::make_unique<Band>());
+        freeBands.push_back(bands.back().get());
+    }
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool renderingDone = false;
+    std::exception_ptr pWriterError;
+
+    // Bands are rendered from the top of the image, while the writer thread encodes the previous ones
+    std::thread writerThread([&]() {
+        RT::Trace::SetThreadName("image writer");
+        RT::ToneMapper toneMapper;
+        while (true){
+            Band* pBand;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]() { return renderingDone || !finishedBands.empty(); });
+                if (finishedBands.empty()) return;
+                pBand = finishedBands.front();
+                finishedBands.pop_front();
+            }
+            try {
+                TRACE_SCOPE("Image encode");
+                const RT::Framebuffer& framebuffer = pBand->framebuffer;
+                pBand->pixels.resize(framebuffer.GetWidth() * framebuffer.GetHeight());
+                toneMapper.Resolve(framebuffer, pBand->pixels.data(), framebuffer.GetWidth());
+                writer.WriteRows(pBand->pixels.data(), framebuffer.GetHeight());
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                pWriterError = std::current_exception();
+                stopRequested_ = true;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                freeBands.push_back(pBand);
+            }
+            condition.notify_all();
+        }
+    });
+
+    for (size_t topRow = 0; topRow < sceneHeight_ && !stopRequested_; topRow += bandRows){
+        Band* pBand;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&]() { return !freeBands.empty(); });
+            pBand = freeBands.front();
+            freeBands.pop_front();
         }
-        image.write(reinterpret_cast<char*>(bmpPad), paddingAmount);
+        size_t rows = std::min(bandRows, sceneHeight_ - topRow);
+        TRACE_SCOPE_DETAIL("Band", "rows " + std::to_string(topRow) + "-" + std::to_string(topRow + rows));
+        pBand->framebuffer.Resize(sceneWidth_, rows);
+        // Framebuffer rows go from the bottom of the image
+        RenderTiles(pBand->framebuffer, sceneHeight_ - topRow - rows, 0,
+                    settings_.sqrtSamples * settings_.sqrtSamples);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopRequested_) freeBands.push_back(pBand);
+            else finishedBands.push_back(pBand);
+        }
+        condition.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        renderingDone = true;
     }
-    image.close();
+    condition.notify_all();
+    writerThread.join();
+    FinishStats(start);
 
-    SDL_RenderClear(pRenderer_);
-    Display();
-    SDL_RenderPresent(pRenderer_);
+    if (pWriterError) {
+        stopRequested_ = false;
+        std::rethrow_exception(pWriterError);
+    }
+    if (stopRequested_.exchange(false)) return false;
+    writer.Finish();
     return true;
 }
 
-void RT::Scene::Display() {
-    uint32_t *pixelColors = new uint32_t[sceneWidth_ * sceneHeight_];
-    for (size_t x = 0; x < sceneWidth_; ++x){
-        for (size_t y = 0; y < sceneHeight_; ++y){
-            pixelColors[((sceneHeight_ - y - 1) * sceneWidth_) + x] = ConvertToInt32(rColor_[x][y], gColor_[x][y], bColor_[x][y]);
+bool RT::Scene::RenderProgressive(const RT::CheckpointOptions &options) {
+    const size_t passes = settings_.sqrtSamples * settings_.sqrtSamples;
+    const uint64_t fingerprint = GetFingerprint();
+    TRACE_SCOPE("Scene::RenderProgressive");
+    auto start = StartStats();
+    size_t pass = 0;
+    if (!options.path.empty() && RT::Checkpoint::Load(options.path, fingerprint, framebuffer_, pass)){
+        Log("Resuming %s after pass %zu of %zu", options.path.c_str(), pass, passes);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto lastCheckpoint = Clock::now();
+    bool saved = true;
+    while (pass < passes && !stopRequested_){
+        {
+            TRACE_SCOPE_DETAIL("Pass", std::to_string(pass));
+            RenderTiles(framebuffer_, 0, pass, pass + 1);
+        }
+        saved = false;
+        if (stopRequested_) break;
+        ++pass;
+        std::chrono::duration<double> sinceCheckpoint = Clock::now() - lastCheckpoint;
+        if (!options.path.empty() && (pass == passes || sinceCheckpoint.count() >= options.intervalSeconds)){
+            RT::Checkpoint::Save(options.path, fingerprint, pass, framebuffer_);
+            lastCheckpoint = Clock::now();
+            saved = true;
         }
     }
+    FinishStats(start);
+    if (!stopRequested_.exchange(false)) return true;
+    // Pixels of a stopped pass keep their own sample counts, the pass is finished after resuming
+    if (!options.path.empty() && !saved){
+        RT::Checkpoint::Save(options.path, fingerprint, pass, framebuffer_);
+    }
+    return false;
+}
+
+bool RT::Scene::RenderBand(RT::Framebuffer &band, size_t firstRow, size_t firstSample, size_t endSample) {
+    if (band.GetWidth() != sceneWidth_ || firstRow + band.GetHeight() > sceneHeight_){
+        throw std::invalid_argument("Band doesn't fit into the image");
+    }
+    endSample = std::min<size_t>(endSample, settings_.sqrtSamples * settings_.sqrtSamples);
+    TRACE_SCOPE("Scene::RenderBand");
+    auto start = StartStats();
+    RenderTiles(band, firstRow, firstSample, endSample);
+    FinishStats(start);
+    return !stopRequested_.exchange(false);
+}
+
+void RT::Scene::RenderPixel(RT::Framebuffer &framebuffer, size_t x, size_t y, size_t firstRow, double xFact,
+                            double yFact, size_t firstSample, size_t endSample) {
+    firstSample = std::max(firstSample, static_cast<size_t>(framebuffer.GetPixel(x, y).samples));
+    if (costMapEnabled_ && firstSample < endSample){
+        // Counters of the calling thread only grow during the pixel, so their difference is the pixel cost
+        const RT::RenderStats& stats = RT::RenderStats::Local();
+        uint64_t boxTests = stats.boxTests;
+        uint64_t triangleTests = stats.triangleTests;
+        auto start = std::chrono::steady_clock::now();
+        RenderSamples(framebuffer, x, y, firstRow, xFact, yFact, firstSample, endSample);
+        std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+        costMap_.Add(x, y + firstRow, stats.boxTests - boxTests, stats.triangleTests - triangleTests, time.count());
+    } else{
+        RenderSamples(framebuffer, x, y, firstRow, xFact, yFact, firstSample, endSample);
+    }
+}
+
+void RT::Scene::RenderSamples(RT::Framebuffer &framebuffer, size_t x, size_t y, size_t firstRow, double xFact,
+                              double yFact, size_t firstSample, size_t endSample) {
+    const size_t sqrtSamples = settings_.sqrtSamples;
+    const size_t pixelIndex = (y + firstRow) * sceneWidth_ + x;
+    for (size_t sample = firstSample; sample < endSample; ++sample){
+        // Every sample has its own random sequence, so it doesn't matter which pass or thread renders it
+        Rand::Seed(settings_.seed, pixelIndex * sqrtSamples * sqrtSamples + sample);
+        double i = static_cast<double>(sample / sqrtSamples);
+        double j = static_cast<double>(sample % sqrtSamples);
+        // Normalize the pixels according to screen size and center
+        double xNorm = (x + i / sqrtSamples) * xFact - 0.5;
+        double yNorm = (y + firstRow + j / sqrtSamples) * yFact - 0.5;
+        RT::Ray ray = camera_.GetRay(xNorm, yNorm);
+        // Added one by one, so the float sums don't depend on how the samples were split into passes
+        framebuffer.AddSamples(x, y, CalculateHitColor(ray, 0), 1.f);
+    }
+}
+
+uint64_t RT::Scene::GetFingerprint() const {
+    uint64_t fingerprint = GetContentKey(figures_, options_);
+    fingerprint = RT::Zobrist::Combine(fingerprint, camera_);
+    fingerprint = RT::Zobrist::Combine(fingerprint, static_cast<uint64_t>(sceneWidth_));
+    fingerprint = RT::Zobrist::Combine(fingerprint, static_cast<uint64_t>(sceneHeight_));
+    fingerprint = RT::Zobrist::Combine(fingerprint, static_cast<uint64_t>(settings_.sqrtSamples));
+    fingerprint = RT::Zobrist::Combine(fingerprint, static_cast<uint64_t>(settings_.bounces));
+    fingerprint = RT::Zobrist::Combine(fingerprint, settings_.seed);
+    return RT::Zobrist::Combine(fingerprint, static_cast<uint64_t>(settings_.meshLod));
+}
+
+uint64_t RT::Scene::GetContentKey(const RT::FigureConfiguration &figures, const RT::SceneOptions &options) {
+    uint64_t key = RT::Zobrist::Hash(figures);
+    key = RT::Zobrist::Combine(key, static_cast<uint64_t>(options.mirrors) |
+                                    static_cast<uint64_t>(options.glassPieces) << 1 |
+                                    static_cast<uint64_t>(options.compactMeshes) << 2 |
+                                    static_cast<uint64_t>(options.analyticPieces) << 3);
+    key = RT::Zobrist::Combine(key, RT::Chessboard::GetPieceSetKey());
+    return RT::Zobrist::Combine(key, RT::Zobrist::RendererHash());
+}
 
-    SDL_UpdateTexture(pTexture_, nullptr, pixelColors, sizeof(uint32_t) * sceneWidth_);
-    delete [] pixelColors;
+uint64_t RT::Scene::GetSnapshotKey(const RT::FigureConfiguration &figures, const RT::SceneOptions &options) {
+    uint64_t key = RT::Zobrist::Hash(figures);
+    key = RT::Zobrist::Combine(key, static_cast<uint64_t>(options.mirrors) |
+                                    static_cast<uint64_t>(options.glassPieces) << 1 |
+                                    static_cast<uint64_t>(options.analyticPieces) << 2);
+    key = RT::Zobrist::Combine(key, static_cast<uint64_t>(RT::SceneSnapshot::VERSION));
+    key = RT::Zobrist::Combine(key, RT::Chessboard::GetPieceSetKey());
+    return RT::Zobrist::Combine(key, RT::Zobrist::RendererHash());
+}
 
-    SDL_RenderCopy(pRenderer_, pTexture_, nullptr, nullptr);
+void RT::Scene::WriteImage(std::ostream &image, RT::ImageFormat format) {
+    TRACE_SCOPE("Image encode");
+    std::vector<uint32_t> pixels(sceneWidth_ * sceneHeight_);
+    RT::ToneMapper().Resolve(framebuffer_, pixels.data(), sceneWidth_);
+    std::unique_ptr<RT::ImageWriter> pWriter = RT::ImageWriter::Create(format, image, sceneWidth_, sceneHeight_);
+    pWriter->WriteRows(pixels.data(), sceneHeight_);
+    pWriter->Finish();
+}
+
+void RT::Scene::SaveImage(const std::string &path) {
+    RT::ImageFormat format = RT::ImageFormatFromPath(path);
+    std::ofstream image(path, std::ios::binary | std::ios::out);
+    if (!image.is_open()) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+    WriteImage(image, format);
+}
+
+std::chrono::steady_clock::time_point RT::Scene::StartStats() {
+    RT::RenderStats::Reset();
+    return std::chrono::steady_clock::now();
+}
+
+void RT::Scene::FinishStats(std::chrono::steady_clock::time_point start) {
+    stats_ = RT::RenderStats::Collect();
+    stats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
 Vec3D RT::Scene::CalculateHitColor(RT::Ray &ray, int depth) {
-    if (depth <= 0) return Utils::EMPTY_COLOR;
+    if (depth >= settings_.bounces){
+        CountPathEnd(RT::PathEnd::MAX_DEPTH, depth);
+        return Utils::EMPTY_COLOR;
+    }
+    STAT_ADD(raysPerBounce[std::min<size_t>(depth, RT::RenderStats::MAX_TRACKED_DEPTH)], 1);
 
     RT::HitPayload hitPayload;
-    if (!RayTrace(ray, hitPayload)){
+    bool hit = RayTrace(ray, hitPayload);
+    if (pRayCapture_){
+        pRayCapture_->Record(ray, depth == 0 ? RT::RayKind::PRIMARY : RT::RayKind::SECONDARY, depth, hitPayload);
+    }
+    if (!hit){
+        CountPathEnd(RT::PathEnd::ESCAPED, depth);
         return Utils::BACKGROUND_COLOR;
     }
 
     RT::ScatterPayload scatterPayload;
+    STAT_ADD(scatterCalls, 1);
     if (!hitPayload.pObject->GetMaterial()->Scatter(ray, hitPayload, scatterPayload, depth)){
+        CountPathEnd(RT::PathEnd::ABSORBED, depth);
         return Utils::EMPTY_COLOR;
     }
 
+    // Ray cone at the hit, specular bounces keep its spread and diffuse ones widen it
+    double footprint = ray.GetFootprint(hitPayload.hitDist);
     if (scatterPayload.skipPDF){
-        return CalculateHitColor(scatterPayload.skipPDFRay, depth - 1) * scatterPayload.damping;
+        scatterPayload.skipPDFRay.SetCone(footprint, ray.GetConeSpread());
+        return CalculateHitColor(scatterPayload.skipPDFRay, depth + 1) * scatterPayload.damping;
     }
+    double diffuseSpread = settings_.meshLod ? Utils::DIFFUSE_CONE_SPREAD : 0.;
     Vec3D scatteredRayDir = scatterPayload.pPDF->Generate();
     RT::Ray scatteredRay = RT::Ray(hitPayload.hitPoint + scatteredRayDir * 0.001, hitPayload.hitPoint + scatteredRayDir);
+    scatteredRay.SetCone(footprint, diffuseSpread);
     auto valPDF = scatterPayload.pPDF->Value(scatteredRay.GetDirection());
 
     HitPayload lightHitPayload;
+    STAT_ADD(shadowRays, 1);
     RT::Ray lightRay = RT::Ray(hitPayload.hitPoint - light_.GetDirection() * 0.05 * scatteredRayDir,
                                hitPayload.hitPoint - light_.GetDirection() + 0.05 * scatteredRayDir);
-    if (RayTrace(lightRay, lightHitPayload)) valPDF *= 2.;
+    lightRay.SetCone(footprint, diffuseSpread);
+    bool lightHit = RayTrace(lightRay, lightHitPayload);
+    if (pRayCapture_) pRayCapture_->Record(lightRay, RT::RayKind::SHADOW, depth, lightHitPayload);
+    if (lightHit) valPDF *= 2.;
 
     double scatteringPDF = hitPayload.pObject->GetMaterial()->ScatteringPDF(ray, hitPayload, scatteredRay);
-    Vec3D sampleColor = CalculateHitColor(scatteredRay, depth - 1);
+    Vec3D sampleColor = CalculateHitColor(scatteredRay, depth + 1);
 
     Vec3D scatterColor = (scatterPayload.damping * scatteringPDF * sampleColor) / valPDF
             / M_PI * std::max(0., dot(hitPayload.hitNormal, -light_.GetDirection())) * 3.;
     return scatterColor;
 }
 
-Vec3D RT::Scene::ConvertToRGB(const Vec3D &color) {
-    Vec3D colorRGB = Vec3D{color[0] * Utils::RGB_MAX, color[1] * Utils::RGB_MAX, color[2] * Utils::RGB_MAX};
-    return colorRGB;
-}
-
-void RT::Scene::SetPixelColor(size_t x, size_t y, Vec3D &pixelColor) {
-    rColor_[x][y] = pixelColor[0];
-    gColor_[x][y] = pixelColor[1];
-    bColor_[x][y] = pixelColor[2];
-}
-
 bool RT::Scene::RayTrace(RT::Ray &ray, RT::HitPayload& payload) {
     // Find all bounding boxes which ray intersects
     std::vector<std::pair<int, RT::BoundingBox*>> orderedBoxes;
     for (auto& pBox : boundingBoxes_){
+        // An object which is its own box is tested once, as the object
+        if (pBox.IsSelfBounded()){
+            ray.RayIntersect(pBox.GetObjectList().front(), payload);
+            continue;
+        }
         RT::HitPayload boundingPayload;
-        for (const auto boxObject : pBox.GetBoundingBox()){
-            ray.RayIntersect(boxObject, boundingPayload);
+        const auto& boxObjects = pBox.GetBoundingBox();
+        // The faces together are a single box test, they don't count as triangle or analytic tests
+        for (const auto boxObject : boxObjects){
+            ray.RayIntersectUncounted(boxObject, boundingPayload);
         }
+        STAT_ADD(boxTests, 1);
         if (boundingPayload.hitDist != DBL_MAX){
             std::pair<int, RT::BoundingBox*> pair = std::make_pair(boundingPayload.hitDist, &pBox);
             orderedBoxes.emplace_back(pair);
@@ -234,6 +489,7 @@ bool RT::Scene::RayTrace(RT::Ray &ray, RT::HitPayload& payload) {
     // Find the closest hit of any object inside the bounding boxes
     sort(orderedBoxes.begin(), orderedBoxes.end());
     for (const auto& [hitDist, pBox] : orderedBoxes){
+        STAT_ADD(bvhNodeVisits, 1);
         for (const auto pObject : pBox->GetObjectList()){
             ray.RayIntersect(pObject, payload);
 
@@ -243,62 +499,101 @@ bool RT::Scene::RayTrace(RT::Ray &ray, RT::HitPayload& payload) {
     return payload.hitDist != DBL_MAX;
 }
 
-void RT::Scene::CalculateBoundingBoxes() {
-    for (auto pObject : pObjectList_){
-        auto boundingBox = RT::BoundingBox(pObject);
-        boundingBoxes_.emplace_back(boundingBox);
+RT::MemoryReport RT::Scene::GetMemoryReport() const {
+    RT::MemoryReport report;
+    std::unordered_set<const RT::Material*> materials;
+    auto addMaterial = [&](const std::shared_ptr<RT::Object>& pObject) {
+        const RT::Material* pMaterial = pObject->GetMaterial().get();
+        if (pMaterial && materials.insert(pMaterial).second) report.materials += pMaterial->GetMemoryUsage();
+    };
+
+    // Copies of a piece share the arrays their placement didn't change, those are counted once
+    std::unordered_set<const void*> arrays;
+    auto addArray = [&](const auto& array, size_t& bytes) {
+        if (!arrays.insert(array.data()).second) return;
+        bytes += array.GetMemoryUsage();
+        report.mappedMeshes += array.GetViewedBytes();
+    };
+    // Levels of detail count into the same arrays as the meshes they belong to
+    std::function<void(const RT::TriangleMesh&)> addMesh = [&](const RT::TriangleMesh& mesh) {
+        addArray(mesh.GetVertices(), report.meshVertices);
+        addArray(mesh.GetTriangles(), report.meshIndices);
+        addArray(mesh.GetEdges(), report.meshEdges);
+        addArray(mesh.GetNormals(), report.meshNormals);
+        addArray(mesh.GetVertexNormals(), report.meshVertexNormals);
+        addArray(mesh.GetTexCoords(), report.meshTexCoords);
+        addArray(mesh.GetBvh(), report.meshBvh);
+        // Quantised arrays count into the arrays they replace
+        if (const RT::CompactMesh* pCompact = mesh.GetCompact()){
+            report.meshVertices += pCompact->GetPositionBytes();
+            report.meshIndices += pCompact->GetIndexBytes();
+            report.meshVertexNormals += pCompact->GetNormalBytes();
+            report.meshBvh += pCompact->GetBvhBytes();
+            report.objects += sizeof(RT::CompactMesh);
+        }
+        for (const auto& pLod : mesh.GetLods()){
+            report.objects += sizeof(RT::TriangleMesh);
+            addMesh(*pLod);
+        }
+    };
+
+    report.objects = pObjectList_.capacity() * sizeof(std::shared_ptr<RT::Object>);
+    for (const auto& pObject : pObjectList_){
+        addMaterial(pObject);
+        if (pObject->GetType() == RT::ObjectType::SURFACE_OF_REVOLUTION){
+            const auto& surface = static_cast<const RT::SurfaceOfRevolution&>(*pObject);
+            report.objects += sizeof(RT::SurfaceOfRevolution) +
+                              surface.GetProfile().capacity() * sizeof(Vector<double, 2>) +
+                              surface.GetSegments().capacity() * sizeof(RT::RevolutionSegment);
+            continue;
+        }
+        if (pObject->GetType() == RT::ObjectType::QUAD || pObject->GetType() == RT::ObjectType::SPHERE ||
+            pObject->GetType() == RT::ObjectType::PLANE){
+            report.objects += pObject->GetType() == RT::ObjectType::QUAD ? sizeof(RT::Quad) :
+                              pObject->GetType() == RT::ObjectType::SPHERE ? sizeof(RT::Sphere) : sizeof(RT::Plane);
+            continue;
+        }
+        if (pObject->GetType() != RT::ObjectType::TRIANGLE_MESH){
+            report.objects += sizeof(RT::Triangle);
+            continue;
+        }
+        report.objects += sizeof(RT::TriangleMesh);
+        addMesh(static_cast<const RT::TriangleMesh&>(*pObject));
+    }
+
+    // RayTrace() collects the hit boxes per ray, faces of self-bounded boxes are the scene objects themselves
+    report.accelerationStructures = boundingBoxes_.capacity() * sizeof(RT::BoundingBox);
+    for (const auto& box : boundingBoxes_){
+        const auto& faces = box.GetBoundingBox();
+        const auto& objects = box.GetObjectList();
+        report.accelerationStructures += (faces.capacity() + objects.capacity()) * sizeof(std::shared_ptr<RT::Object>);
+        if (box.IsSelfBounded()) continue;
+        for (const auto& pFace : faces){
+            report.accelerationStructures += sizeof(RT::Triangle);
+            addMaterial(pFace);
+        }
     }
-}
 
-std::ofstream RT::Scene::CreateBmpFile() const {
-    std::ofstream image;
-    image.open("output.bmp", std::ios::binary | std::ios::out);
-    const int paddingAmount = ((4 - (sceneWidth_ * 3) % 4) % 4);
-    const int fileHeaderSize = 14;
-    const int informationHeaderSize = 40;
-    const int fileSize = fileHeaderSize + informationHeaderSize + sceneWidth_ * sceneHeight_ * 3 + paddingAmount * sceneHeight_;
-
-    unsigned char fileHeader[fileHeaderSize];
-    for (int i = 0; i <= 13; i++) {
-        fileHeader[i] = 0;
-    }
-    fileHeader[0] = 'B';
-    fileHeader[1] = 'M';
-    fileHeader[2] = fileSize;
-    fileHeader[3] = fileSize >> 8;
-    fileHeader[4] = fileSize >> 16;
-    fileHeader[5] = fileSize >> 24;
-    fileHeader[10] = fileHeaderSize + informationHeaderSize;
-
-    unsigned char informationHeader[informationHeaderSize];
-    for (int i = 0; i <= 39; i++) {
-        informationHeader[i] = 0;
-    }
-    informationHeader[0] = informationHeaderSize;
-    informationHeader[4] = sceneWidth_;
-    informationHeader[5] = sceneWidth_ >> 8;
-    informationHeader[6] = sceneWidth_ >> 16;
-    informationHeader[7] = sceneWidth_ >> 24;
-    informationHeader[8] = sceneHeight_;
-    informationHeader[9] = sceneHeight_ >> 8;
-    informationHeader[10] = sceneHeight_ >> 16;
-    informationHeader[11] = sceneHeight_ >> 24;
-    informationHeader[12] = 1;
-    informationHeader[14] = 24;
-
-    image.write(reinterpret_cast<char*>(fileHeader), fileHeaderSize);
-    image.write(reinterpret_cast<char*>(informationHeader), informationHeaderSize);
-
-    return image;
+    report.framebuffer = framebuffer_.GetMemoryUsage();
+    report.costMap = costMap_.GetMemoryUsage();
+    size_t threads = ThreadPool::Shared().GetThreadCount() + 1;
+    report.threadScratch = threads * (sizeof(RT::RenderStats) +
+                                      boundingBoxes_.size() * sizeof(std::pair<int, RT::BoundingBox*>));
+    return report;
+}
 
+void RT::Scene::CheckMemoryBudget(size_t framebufferBytes, size_t width, size_t height) const {
+    RT::MemoryReport report = GetMemoryReport();
+    report.framebuffer = framebufferBytes;
+    report.costMap = costMapEnabled_ ? width * height * sizeof(RT::PixelCost) : 0;
+    options_.memoryBudget.Check(report);
 }
 
-void RT::Scene::WriteColor(Vec3D color, std::ofstream &image) {
-    unsigned char r = static_cast<unsigned char>((int)color[0]);
-    unsigned char g = static_cast<unsigned char>((int)color[1]);
-    unsigned char b = static_cast<unsigned char>((int)color[2]);
-    unsigned char whole[] = { r, g, b };
-    image.write(reinterpret_cast<char*>(whole), 3);
+void RT::Scene::CalculateBoundingBoxes() {
+    for (auto pObject : pObjectList_){
+        auto boundingBox = RT::BoundingBox(pObject);
+        boundingBoxes_.emplace_back(boundingBox);
+    }
 }
 
 void RT::Scene::ForTriangleRasterization(Vec3D A, Vec3D B, Vec3D C, Vec3D normal, std::vector<double> &depthBuffer) {
@@ -340,12 +635,10 @@ void RT::Scene::ForTriangleRasterization(Vec3D A, Vec3D B, Vec3D C, Vec3D normal
             minJ = std::min((int) ceil((maxY - lowerLeft[2]) / (upperRight[2] - lowerLeft[2]) * sceneHeight_),
                                 (int) (sceneHeight_ - 1));
         }
-        std::cout << minI << " " << maxI << " " << minJ << " " << maxJ << std::endl;
         for (int i = std::min(minI, maxJ); i < std::max(minI, maxI); ++i){
             for (int j = std::min(minJ, maxJ); j < std::max(minJ, maxJ); ++j){
                 Vec3D hitColor = Utils::BASE_ALBEDO / M_PI * std::max(0., dot(normal, -light_.GetDirection())) * 3.;
-                Vec3D pixelColor = ConvertToRGB(hitColor);
-                SetPixelColor(i, j, pixelColor);
+                framebuffer_.SetColor(i, j, hitColor);
 
             }
         }
@@ -6,12 +6,15 @@
 #ifndef MAIN_CPP_SCENE_H
 #define MAIN_CPP_SCENE_H
 
-#include <SDL.h>
 #include <limits.h>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <chrono>
 #include <algorithm>
 #include <thread>
+#include <ostream>
+#include <string>
 
 #include "../LinearAlgebra/Vector.h"
 #include "../ObjectLoader/ObjLoader.h"
@@ -22,70 +25,132 @@
 #include "Objects.h"
 #include "Material.h"
 #include "BoundingBox.h"
+#include "Chessboard.h"
+#include "Framebuffer.h"
+#include "Checkpoint.h"
+#include "RenderStats.h"
+#include "CostMap.h"
+#include "RayCapture.h"
+#include "MemoryReport.h"
+#include "../Image/ImageWriter.h"
 
 
 
 namespace RT{
+    /**
+     * @struct RenderSettings
+     * @brief Quality parameters of a single render, defaults are taken from Utils.h.
+     */
+    struct RenderSettings{
+        int sqrtSamples = Utils::SQRT_SAMPLES; /**< Squared amount of rays shot for each pixel. */
+        int bounces = Utils::BOUNCES; /**< Maximal amount of ray bounces. */
+        uint64_t seed = 0; /**< Seed of the random sequences, the same seed gives the same image. */
+        /**
+         * Diffuse bounces and their shadow rays trace simplified levels of detail of meshes which have them, picked
+         * by the footprint of a Utils::DIFFUSE_CONE_SPREAD wide ray cone. Camera rays and specular bounces
+         * don't widen the cone, so they see full detail until a path turns diffuse.
+         */
+        bool meshLod = true;
+    };
+    /**
+     * @struct SceneOptions
+     * @brief Variations of the scene content besides the placement of pieces.
+     */
+    struct SceneOptions{
+        bool mirrors = true; /**< Metal mirrors behind the board. */
+        bool glassPieces = false; /**< All pieces get Config::GLASS_PIECE_MATERIAL instead of their own material. */
+        RT::MemoryBudget memoryBudget; /**< Limits checked while building the scene and allocating the framebuffer. */
+        /**
+         * Directory of scene snapshots (SceneSnapshot.h), empty disables them. A scene is mapped from its snapshot
+         * there if one exists, otherwise it's built and saved for the next run.
+         */
+        std::string snapshotDirectory;
+        /**
+         * Placed meshes are quantised once the scene is built (TriangleMesh::Compact()), they take about a sixth of
+         * the memory for a small loss of precision. Snapshots are saved before, so they keep the full meshes.
+         */
+        bool compactMeshes = false;
+        /**
+         * Lathe-shaped pieces are placed as surfaces of revolution fitted to their meshes (Chessboard::LoadPieceSurface()),
+         * intersected exactly with perfect silhouettes, the others stay meshes.
+         */
+        bool analyticPieces = false;
+    };
     /**
      * @class Scene
      * @brief Represents a scene in the ray tracing environment.
      *
      * This class connects the entire ray tracing process. It is responsible for shooting rays,
-     * calculating corresponding pixel colors, rendering the app window, and saving the final image.
+     * calculating corresponding pixel colors and saving the final image. Showing the image is left to the caller,
+     * so the scene can be used without a window (e.g. by the render server).
      */
     class Scene{
     private:
 
-        SDL_Texture *pTexture_;
-        SDL_Renderer *pRenderer_;
-
         RT::Camera camera_;
+        RT::RenderSettings settings_;
+        RT::FigureConfiguration figures_;
+        RT::SceneOptions options_;
         std::vector<std::shared_ptr<RT::Object>> pObjectList_;
         RT::DistantLightSource light_;
 
-        std::vector<std::vector<double>> rColor_;
-        std::vector<std::vector<double>> gColor_;
-        std::vector<std::vector<double>> bColor_;
+        RT::Framebuffer framebuffer_;
 
-        size_t sceneWidth_;
-        size_t sceneHeight_;
+        size_t sceneWidth_ = 0;
+        size_t sceneHeight_ = 0;
 
         std::vector<RT::BoundingBox> boundingBoxes_;
 
         bool rasterization_;
         std::vector<std::shared_ptr<RT::Object>> rasterScreen_;
 
+        std::atomic<bool> stopRequested_{false};
+        RT::RenderStats stats_;
+        bool costMapEnabled_ = false;
+        RT::CostMap costMap_;
+        std::shared_ptr<RT::RayCapture> pRayCapture_;
+
     private:
-        uint32_t ConvertToInt32(double red, double green, double blue);
-        void SetPixelColor(size_t x, size_t y, Vec3D &pixelColor);
-        Vec3D ConvertToRGB(const Vec3D &color);
         /**
          * @brief Calculates the color at a hit point.
          *
          * @param ray The ray that hit the point.
-         * @param depth The remaining depth for recursive ray tracing.
+         * @param depth Bounce index of the ray, 0 for rays shot from the camera.
          * @return The color at the hit point.
          */
         Vec3D CalculateHitColor(RT::Ray &ray, int depth);
-        /**
-         * @brief Traces a ray to check for intersections.
-         *
-         * @param ray The ray to trace.
-         * @param payload The payload to store hit information.
-         * @return True if the ray intersects an object, false otherwise.
-         */
-        bool RayTrace(RT::Ray &ray, RT::HitPayload& payload);
+        /// \brief Creates the board, pieces and mirrors from figures_ and options_
+        void BuildObjects();
+        /// \brief Maps the objects from the snapshot in options_.snapshotDirectory, builds and saves them if missing
+        void LoadOrBuildObjects();
+        /// \brief Compacts every mesh of the object list
+        void CompactMeshes();
         /**
          * @brief Calculates the bounding boxes for objects in the scene.
          */
         void CalculateBoundingBoxes();
         /**
-         * @brief Creates a BMP file for the rendered image.
+         * @brief Renders samples [firstSample, endSample) of every pixel in framebuffer.
          *
-         * @return An output file stream for the BMP file.
+         * The framebuffer holds image rows starting at firstRow (from the bottom). Samples are indexed
+         * i * sqrtSamples + j over the sub-pixel grid, so the whole range renders the full quality at once.
+         * Samples a pixel already has (its sample count) are skipped, they would come out the same, so a partially
+         * rendered framebuffer is completed rather than rendered twice.
          */
-        std::ofstream CreateBmpFile() const;
-        void WriteColor(Vec3D color, std::ofstream& image);
+        void RenderTiles(RT::Framebuffer& framebuffer, size_t firstRow, size_t firstSample, size_t endSample);
+        /// \brief Shoots samples [firstSample, endSample) of one pixel and accumulates them in the framebuffer
+        void RenderPixel(RT::Framebuffer& framebuffer, size_t x, size_t y, size_t firstRow, double xFact,
+                         double yFact, size_t firstSample, size_t endSample);
+        /// \brief Sample loop of RenderPixel(), without skipping existing samples and recording the cost
+        void RenderSamples(RT::Framebuffer& framebuffer, size_t x, size_t y, size_t firstRow, double xFact,
+                           double yFact, size_t firstSample, size_t endSample);
+
+        /// \brief Zeroes the statistics counters when a render starts, returns the start time
+        std::chrono::steady_clock::time_point StartStats();
+        /// \brief Merges the counters of all threads into stats_
+        void FinishStats(std::chrono::steady_clock::time_point start);
+        /// \brief Checks options_.memoryBudget with framebufferBytes of pixel buffers and the cost map of given size
+        void CheckMemoryBudget(size_t framebufferBytes, size_t width, size_t height) const;
 
         // Unfinished
         void ForTriangleRasterization(Vec3D A, Vec3D B, Vec3D C, Vec3D normal, std::vector<double> &depthBuffer);
@@ -93,13 +158,119 @@ namespace RT{
     public:
         /// \brief Scene constructor, creates objects that belong to scene
         Scene();
+        /**
+         * @brief Creates the scene with pieces placed according to figures instead of Config.h
+         *
+         * @throws std::runtime_error if the built scene exceeds options.memoryBudget.
+         */
+        explicit Scene(const RT::FigureConfiguration& figures, const RT::SceneOptions& options = {});
 
-        /// \brief Sets up screen height and width, initializes SDL texture and renderer
-        void Initialize(size_t width, size_t height, SDL_Renderer *pRenderer);
-        /// \brief Displays stored color channels as pixels using SDL
-        void Display();
-        /// \brief Renders the screen pixel colors using raytracing for each pixel
+        /**
+         * @brief Traces a ray to check for intersections.
+         *
+         * Public so the closest hit search can be benchmarked on its own.
+         *
+         * @param ray The ray to trace.
+         * @param payload The payload to store hit information.
+         * @return True if the ray intersects an object, false otherwise.
+         */
+        bool RayTrace(RT::Ray &ray, RT::HitPayload& payload);
+        /// \brief Sets up screen height and width, clears the framebuffer, throws if it's over the memory budget
+        void Initialize(size_t width, size_t height);
+        /// \brief Sets up screen height and width and frees the framebuffer, for RenderToImage()
+        void SetResolution(size_t width, size_t height);
+        /**
+         * @brief Renders the screen pixel colors using raytracing for each pixel.
+         *
+         * Every finished tile is marked dirty in the framebuffer, so it can be displayed while the rest is rendered.
+         * @return False if the render was stopped by RequestStop() before it finished.
+         */
         bool Render();
+        /**
+         * @brief Renders the image band by band straight into writer, without the scene framebuffer.
+         *
+         * Meant for poster sized images, which wouldn't fit into memory. Bands of bandRows rows (rounded up to
+         * whole tiles, 0 picks about Utils::STREAMED_BAND_PIXELS pixels) are rendered from the top, finished bands
+         * are tone mapped and encoded on a separate thread while the next ones render. Peak memory is bounded by
+         * bandsInFlight * bandRows * width * 20 bytes, regardless of the image height. Set the size with
+         * SetResolution(), Initialize() would allocate the whole framebuffer. The bands count as the framebuffer in
+         * the memory budget.
+         * @return False if stopped by RequestStop(), the image is then left unfinished.
+         */
+        bool RenderToImage(RT::ImageWriter& writer, size_t bandRows = 0, size_t bandsInFlight = 2);
+        /**
+         * @brief Renders the image in passes of one sample per pixel, saving checkpoints in between.
+         *
+         * An existing checkpoint at options.path is resumed, the result is the same image as an uninterrupted
+         * render. A checkpoint is written after a pass once options.intervalSeconds passed since the last one,
+         * and always when stopped by RequestStop(). The finished render leaves its checkpoint in place, delete it
+         * once the image is saved.
+         * @return False if stopped by RequestStop().
+         * @throws std::runtime_error if the checkpoint belongs to a different render (see GetFingerprint()).
+         */
+        bool RenderProgressive(const RT::CheckpointOptions& options);
+        /**
+         * @brief Renders samples [firstSample, endSample) of a horizontal band of the image into band.
+         *
+         * The band holds image rows [firstRow, firstRow + band height) counted from the bottom, its width has to be
+         * the scene width. Used by distributed workers, the image size is set with SetResolution(). Sample sums are
+         * the same as in a render of the whole image, so bands starting on tile rows can be merged into
+         * the full framebuffer by adding their tiles.
+         * @return False if stopped by RequestStop().
+         */
+        bool RenderBand(RT::Framebuffer& band, size_t firstRow, size_t firstSample, size_t endSample);
+        /// \brief Makes the running (or the next) Render() return early, can be called from any thread
+        void RequestStop() { stopRequested_ = true; }
+        /// \brief Tone maps the rendered image and writes it into the stream in given format
+        void WriteImage(std::ostream& image, RT::ImageFormat format);
+        /// \brief Saves the rendered image, format is chosen by the extension (.bmp, .qoi or .png)
+        void SaveImage(const std::string& path);
+
+        /// \brief Accumulated colors of the rendered image
+        const RT::Framebuffer& GetFramebuffer() const { return framebuffer_; }
+        /// \brief Counters of the last render (rays, intersection tests, paths), see RenderStats.h
+        const RT::RenderStats& GetRenderStats() const { return stats_; }
+        /**
+         * @brief Starts or stops recording the cost of every pixel into the cost map.
+         *
+         * The map has the size of the image and is cleared together with the framebuffer by Initialize() and
+         * SetResolution(). Recording adds two clock reads per pixel, so it's off by default.
+         */
+        void EnableCostMap(bool enable);
+        /// \brief Box tests, triangle tests and time of every pixel rendered since the last Initialize()
+        const RT::CostMap& GetCostMap() const { return costMap_; }
+        /**
+         * @brief Bytes held by meshes, objects, bounding boxes, materials, the framebuffer and render threads.
+         *
+         * Computed on every call from the current containers, see MemoryReport.h.
+         */
+        RT::MemoryReport GetMemoryReport() const;
+        /// \brief Following renders record their rays into pCapture, nullptr stops recording
+        void SetRayCapture(std::shared_ptr<RT::RayCapture> pCapture) { pRayCapture_ = std::move(pCapture); }
+        size_t GetWidth() const { return sceneWidth_; }
+        size_t GetHeight() const { return sceneHeight_; }
+
+        /// \brief Camera used by following renders, call CalculateParams() after changing it
+        RT::Camera& GetCamera() { return camera_; }
+        const RT::RenderSettings& GetRenderSettings() const { return settings_; }
+        /**
+         * @brief Hash of the content key (GetContentKey()), camera, resolution and render settings, equal fingerprints
+         * give equal images.
+         */
+        uint64_t GetFingerprint() const;
+        /**
+         * @brief Key of everything a scene is built from: the placement, all scene options, the piece sources
+         * (Chessboard::GetPieceSetKey(), e.g. a different `--pieces` directory) and the renderer version.
+         */
+        static uint64_t GetContentKey(const RT::FigureConfiguration& figures, const RT::SceneOptions& options);
+        /**
+         * @brief Key of the scene snapshot built from figures and options.
+         *
+         * Mixes the placement, the scene options, the renderer version (materials are compiled in) and content checksums
+         * of the piece OBJ files, so a snapshot is rebuilt after any of them changes.
+         */
+        static uint64_t GetSnapshotKey(const RT::FigureConfiguration& figures, const RT::SceneOptions& options);
+        void SetRenderSettings(const RT::RenderSettings& settings) { settings_ = settings; }
     };
 }
 
@@ -0,0 +1,298 @@
+#include "SceneSnapshot.h"
+#include "Material.h"
+#include "Trace.h"
+#include "../Image/Deflate.h"
+#include "../ObjectLoader/MappedFile.h"
+#include "../ObjectLoader/MeshFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace {
+    constexpr char MAGIC[8] = {'R', 'T', 'S', 'C', 'E', 'N', 'E', '\0'};
+    constexpr size_t MESH_ALIGNMENT = 64;
+
+    enum ObjectKind : uint32_t{
+        TRIANGLE,
+        TRIANGLE_MESH,
+        SURFACE_OF_REVOLUTION,
+        SPHERE,
+        QUAD,
+        PLANE
+    };
+
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t key;
+        uint64_t materialCount;
+        uint64_t objectCount;
+        uint64_t fileSize;
+        uint32_t tableCrc;
+        uint32_t reserved;
+    };
+
+    struct MaterialRecord{
+        uint32_t type;
+        uint32_t reserved;
+        double albedo[3];
+        double fuzz;
+        double refractionIndex;
+        double transparency[3];
+    };
+
+    /**
+     * \brief Triangles use the corners, meshes the offset and size of their image, surfaces of revolution the base as
+     * first corner and the offset and size of their profile points. Spheres store center and radius, quads
+     * corner, edge u and edge v, planes point and normal in the corners.
+     */
+    struct ObjectRecord{
+        uint32_t kind;
+        uint32_t material;
+        double smoothness;
+        double corners[3][3];
+        uint64_t meshOffset;
+        uint64_t meshSize;
+    };
+
+    /// \brief Objects without a material get this index
+    constexpr uint32_t NO_MATERIAL = UINT32_MAX;
+
+    MaterialRecord ToRecord(const RT::MaterialParams& params) {
+        MaterialRecord record{};
+        record.type = static_cast<uint32_t>(params.type);
+        for (size_t i = 0; i < DIMS_3D; ++i){
+            record.albedo[i] = params.albedo[i];
+            record.transparency[i] = params.transparency[i];
+        }
+        record.fuzz = params.fuzz;
+        record.refractionIndex = params.refractionIndex;
+        return record;
+    }
+
+    RT::MaterialParams FromRecord(const MaterialRecord& record) {
+        RT::MaterialParams params;
+        params.type = static_cast<RT::MaterialType>(record.type);
+        params.albedo = Vec3D{record.albedo[0], record.albedo[1], record.albedo[2]};
+        params.transparency = Vec3D{record.transparency[0], record.transparency[1], record.transparency[2]};
+        params.fuzz = record.fuzz;
+        params.refractionIndex = record.refractionIndex;
+        return params;
+    }
+}
+
+std::string RT::SceneSnapshot::GetPath(const std::string &directory, uint64_t key) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(directory) / (std::string(name) + EXTENSION)).string();
+}
+
+void RT::SceneSnapshot::Save(const std::string &path, uint64_t key,
+                             const std::vector<std::shared_ptr<RT::Object>> &objects) {
+    TRACE_SCOPE("Scene snapshot save");
+    std::vector<MaterialRecord> materials;
+    std::map<const RT::Material*, uint32_t> materialIndices;
+    std::vector<ObjectRecord> records;
+    std::vector<const RT::TriangleMesh*> meshes;
+    std::vector<const RT::SurfaceOfRevolution*> surfaces;
+    for (const auto& pObject : objects){
+        ObjectRecord record{};
+        record.material = NO_MATERIAL;
+        if (const RT::Material* pMaterial = pObject->GetMaterial().get()){
+            auto [it, inserted] = materialIndices.emplace(pMaterial, static_cast<uint32_t>(materials.size()));
+            if (inserted) materials.push_back(ToRecord(pMaterial->GetParams()));
+            record.material = it->second;
+        }
+        if (pObject->GetType() == RT::ObjectType::TRIANGLE){
+            const auto& triangle = static_cast<const RT::Triangle&>(*pObject);
+            const Vec3D* corners[3] = {&triangle.GetPointA(), &triangle.GetPointB(), &triangle.GetPointC()};
+            record.kind = TRIANGLE;
+            for (size_t i = 0; i < 3; ++i){
+                for (size_t j = 0; j < DIMS_3D; ++j) record.corners[i][j] = (*corners[i])[j];
+            }
+        } else if (pObject->GetType() == RT::ObjectType::SPHERE){
+            const auto& sphere = static_cast<const RT::Sphere&>(*pObject);
+            record.kind = SPHERE;
+            for (size_t j = 0; j < DIMS_3D; ++j) record.corners[0][j] = sphere.GetCenter()[j];
+            record.corners[1][0] = sphere.GetRadius();
+        } else if (pObject->GetType() == RT::ObjectType::QUAD){
+            const auto& quad = static_cast<const RT::Quad&>(*pObject);
+            const Vec3D* corners[3] = {&quad.GetCorner(), &quad.GetEdgeU(), &quad.GetEdgeV()};
+            record.kind = QUAD;
+            for (size_t i = 0; i < 3; ++i){
+                for (size_t j = 0; j < DIMS_3D; ++j) record.corners[i][j] = (*corners[i])[j];
+            }
+        } else if (pObject->GetType() == RT::ObjectType::PLANE){
+            const auto& plane = static_cast<const RT::Plane&>(*pObject);
+            record.kind = PLANE;
+            for (size_t j = 0; j < DIMS_3D; ++j){
+                record.corners[0][j] = plane.GetPoint()[j];
+                record.corners[1][j] = plane.GetNormal()[j];
+            }
+        } else if (pObject->GetType() == RT::ObjectType::TRIANGLE_MESH){
+            auto& mesh = static_cast<RT::TriangleMesh&>(*pObject);
+            record.kind = TRIANGLE_MESH;
+            record.smoothness = mesh.GetSmoothness();
+            meshes.push_back(&mesh);
+        } else if (pObject->GetType() == RT::ObjectType::SURFACE_OF_REVOLUTION){
+            const auto& surface = static_cast<const RT::SurfaceOfRevolution&>(*pObject);
+            record.kind = SURFACE_OF_REVOLUTION;
+            record.smoothness = surface.GetSmoothness();
+            for (size_t j = 0; j < DIMS_3D; ++j) record.corners[0][j] = surface.GetBase()[j];
+            surfaces.push_back(&surface);
+        } else{
+            throw std::invalid_argument("Scene snapshot can't store objects of type " +
+                                        std::to_string(static_cast<int>(pObject->GetType())));
+        }
+        records.push_back(record);
+    }
+
+    Header header{};
+    std::copy(MAGIC, MAGIC + sizeof(MAGIC), header.magic);
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    header.key = key;
+    header.materialCount = materials.size();
+    header.objectCount = records.size();
+
+    // Meshes follow the tables, each image starting on a 64 byte boundary of the file
+    size_t tablesSize = materials.size() * sizeof(MaterialRecord) + records.size() * sizeof(ObjectRecord);
+    size_t meshesStart = (sizeof(Header) + tablesSize + MESH_ALIGNMENT - 1) / MESH_ALIGNMENT * MESH_ALIGNMENT;
+    std::vector<uint8_t> meshData;
+    size_t meshIndex = 0, surfaceIndex = 0;
+    for (auto& record : records){
+        if (record.kind != TRIANGLE_MESH && record.kind != SURFACE_OF_REVOLUTION) continue;
+        meshData.resize((meshData.size() + MESH_ALIGNMENT - 1) / MESH_ALIGNMENT * MESH_ALIGNMENT);
+        record.meshOffset = meshesStart + meshData.size();
+        if (record.kind == TRIANGLE_MESH){
+            MeshFile::Append(*meshes[meshIndex++], meshData);
+        } else{
+            for (const auto& point : surfaces[surfaceIndex]->GetProfile()){
+                double values[2] = {point[0], point[1]};
+                const auto* pBytes = reinterpret_cast<const uint8_t*>(values);
+                meshData.insert(meshData.end(), pBytes, pBytes + sizeof(values));
+            }
+            ++surfaceIndex;
+        }
+        record.meshSize = meshesStart + meshData.size() - record.meshOffset;
+    }
+    header.fileSize = meshesStart + meshData.size();
+
+    std::vector<uint8_t> tables(tablesSize);
+    std::memcpy(tables.data(), materials.data(), materials.size() * sizeof(MaterialRecord));
+    std::memcpy(tables.data() + materials.size() * sizeof(MaterialRecord), records.data(),
+                records.size() * sizeof(ObjectRecord));
+    header.tableCrc = Deflate::Crc32(tables.data(), tables.size());
+
+    std::string temporaryPath = MappedFile::TemporaryPath(path);
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) throw std::runtime_error("Error opening file: " + temporaryPath);
+        std::vector<char> padding(meshesStart - sizeof(Header) - tablesSize, 0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(tables.data()), static_cast<std::streamsize>(tables.size()));
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        file.write(reinterpret_cast<const char*>(meshData.data()), static_cast<std::streamsize>(meshData.size()));
+        file.flush();
+        if (!file){
+            std::remove(temporaryPath.c_str());
+            throw std::runtime_error("Writing scene snapshot failed: " + temporaryPath);
+        }
+    }
+    // Replaces an existing snapshot in one step, also on Windows unlike std::rename, so workers sharing the
+    // directory always map a complete file
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error){
+        std::remove(temporaryPath.c_str());
+        throw std::runtime_error("Replacing scene snapshot failed: " + path);
+    }
+}
+
+bool RT::SceneSnapshot::Load(const std::string &path, uint64_t key,
+                             std::vector<std::shared_ptr<RT::Object>> &objects) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) return false;
+    TRACE_SCOPE_DETAIL("Scene snapshot load", path);
+    auto pFile = std::make_shared<MappedFile>(path);
+    const char* pData = pFile->GetData();
+    if (pFile->GetSize() < sizeof(Header)) throw std::runtime_error("Scene snapshot is damaged: " + path);
+    const auto& header = *reinterpret_cast<const Header*>(pData);
+    if (!std::equal(MAGIC, MAGIC + sizeof(MAGIC), header.magic) || header.version != VERSION ||
+        header.headerSize != sizeof(Header)){
+        throw std::runtime_error("Not a scene snapshot of this renderer: " + path);
+    }
+    if (header.key != key) return false;
+    size_t tablesSize = header.materialCount * sizeof(MaterialRecord) + header.objectCount * sizeof(ObjectRecord);
+    if (header.fileSize != pFile->GetSize() || header.materialCount > pFile->GetSize() ||
+        header.objectCount > pFile->GetSize() || sizeof(Header) + tablesSize > pFile->GetSize() ||
+        Deflate::Crc32(reinterpret_cast<const uint8_t*>(pData) + sizeof(Header), tablesSize) != header.tableCrc){
+        throw std::runtime_error("Scene snapshot is damaged: " + path);
+    }
+
+    const auto* pMaterialRecords = reinterpret_cast<const MaterialRecord*>(pData + sizeof(Header));
+    std::vector<std::shared_ptr<RT::Material>> materials;
+    for (size_t i = 0; i < header.materialCount; ++i){
+        materials.push_back(RT::Material::Create(FromRecord(pMaterialRecords[i])));
+    }
+    const auto* pRecords = reinterpret_cast<const ObjectRecord*>(pMaterialRecords + header.materialCount);
+    std::vector<std::shared_ptr<RT::Object>> loaded;
+    for (size_t i = 0; i < header.objectCount; ++i){
+        const ObjectRecord& record = pRecords[i];
+        std::shared_ptr<RT::Object> pObject;
+        auto corner = [&record](size_t i) {
+            return Vec3D{record.corners[i][0], record.corners[i][1], record.corners[i][2]};
+        };
+        if (record.kind == TRIANGLE){
+            pObject = std::make_shared<RT::Triangle>(corner(0), corner(1), corner(2));
+        } else if (record.kind == SPHERE || record.kind == QUAD || record.kind == PLANE){
+            try {
+                if (record.kind == SPHERE) pObject = std::make_shared<RT::Sphere>(corner(0), record.corners[1][0]);
+                else if (record.kind == QUAD) pObject = std::make_shared<RT::Quad>(corner(0), corner(1), corner(2));
+                else pObject = std::make_shared<RT::Plane>(corner(0), corner(1));
+            } catch (const std::invalid_argument&) {
+                throw std::runtime_error("Scene snapshot is damaged: " + path);
+            }
+        } else if (record.kind == TRIANGLE_MESH && record.meshOffset % MESH_ALIGNMENT == 0 &&
+                   record.meshOffset >= sizeof(Header) + tablesSize &&
+                   record.meshOffset <= pFile->GetSize() && record.meshSize <= pFile->GetSize() - record.meshOffset){
+            // The image isn't covered by the CRC, View() range checks its indices and BVH before the mesh uses them
+            auto pMesh = MeshFile::View(pData + record.meshOffset, record.meshSize, pFile, false,
+                                        path + " mesh " + std::to_string(i));
+            pMesh->SetSmoothness(record.smoothness);
+            pObject = pMesh;
+        } else if (record.kind == SURFACE_OF_REVOLUTION && record.meshOffset % MESH_ALIGNMENT == 0 &&
+                   record.meshOffset >= sizeof(Header) + tablesSize &&
+                   record.meshOffset <= pFile->GetSize() && record.meshSize <= pFile->GetSize() - record.meshOffset &&
+                   record.meshSize % (2 * sizeof(double)) == 0){
+            const auto* pValues = reinterpret_cast<const double*>(pData + record.meshOffset);
+            std::vector<Vector<double, 2>> profile;
+            for (size_t j = 0; j < record.meshSize / sizeof(double); j += 2){
+                profile.push_back(Vector<double, 2>{pValues[j], pValues[j + 1]});
+            }
+            std::shared_ptr<RT::SurfaceOfRevolution> pSurface;
+            try {
+                pSurface = std::make_shared<RT::SurfaceOfRevolution>(std::move(profile));
+            } catch (const std::invalid_argument&) {
+                throw std::runtime_error("Scene snapshot is damaged: " + path);
+            }
+            pSurface->SetSmoothness(record.smoothness);
+            pSurface->SetCenter(corner(0));
+            pObject = pSurface;
+        } else{
+            throw std::runtime_error("Scene snapshot is damaged: " + path);
+        }
+        if (record.material != NO_MATERIAL){
+            if (record.material >= materials.size()) throw std::runtime_error("Scene snapshot is damaged: " + path);
+            pObject->SetMaterial(materials[record.material]);
+        }
+        loaded.push_back(std::move(pObject));
+    }
+    objects = std::move(loaded);
+    return true;
+}
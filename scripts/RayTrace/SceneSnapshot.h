@@ -0,0 +1,53 @@
+/**
+ * @file SceneSnapshot.h
+ * @brief Defines the SceneSnapshot class, built scenes stored on disk and mapped back in at start-up.
+ */
+#ifndef MAIN_CPP_SCENESNAPSHOT_H
+#define MAIN_CPP_SCENESNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Objects.h"
+
+namespace RT{
+    /**
+     * @class SceneSnapshot
+     * @brief Binary file with all objects of a built scene, their materials and the mesh BVHs.
+     *
+     * Layout: header (magic, version, key of the scene, counts, CRC-32 of the tables), material table
+     * (MaterialParams), object table in scene order (corners of triangles and quads, spheres, planes, or the offset
+     * of a mesh or a profile) and the placed meshes as 64 byte aligned MeshFile images, profiles of surfaces of
+     * revolution as pairs of doubles. Loading maps the file, meshes view their images in place, so only the other
+     * objects and materials are created; bounding boxes of the scene are rebuilt from the objects. The CRC
+     * covers the tables only, mesh images aren't read whole at load but their indices and BVHs are range checked
+     * (MeshFile::View()), so a damaged snapshot is refused instead of crashing the renderer.
+     *
+     * The key identifies everything the scene was built from (see Scene::GetSnapshotKey()), a snapshot with
+     * another key is never loaded.
+     */
+    class SceneSnapshot{
+    public:
+        static constexpr uint32_t VERSION = 2;
+        static constexpr const char* EXTENSION = ".rtscene";
+
+        /**
+         * \brief Writes the objects into a uniquely named temporary file and renames it over path, so neither a crash
+         * nor workers saving the same snapshot at once ever leave a broken or missing file
+         */
+        static void Save(const std::string& path, uint64_t key, const std::vector<std::shared_ptr<RT::Object>>& objects);
+        /**
+         * @brief Maps the snapshot and creates its objects.
+         *
+         * @return False if there is no file or it belongs to another key.
+         * @throws std::runtime_error if the file is damaged or written by another version.
+         */
+        static bool Load(const std::string& path, uint64_t key, std::vector<std::shared_ptr<RT::Object>>& objects);
+        /// \brief File of given key in directory
+        static std::string GetPath(const std::string& directory, uint64_t key);
+    };
+}
+
+#endif
@@ -0,0 +1,99 @@
+#include "ToneMapper.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RT_TONEMAPPER_SSE2
+#endif
+
+RT::ToneMapper::ToneMapper(double exposure, double gamma) {
+    if (gamma <= 0.) throw std::invalid_argument("Gamma has to be positive");
+    exposure_ = static_cast<float>(exposure);
+    linear_ = gamma == 1.;
+    for (size_t i = 0; i < GAMMA_LUT_SIZE; ++i){
+        double value = std::pow(static_cast<double>(i) / (GAMMA_LUT_SIZE - 1), 1. / gamma);
+        gammaLut_[i] = static_cast<uint8_t>(std::min(value * Utils::RGB_MAX, Utils::RGB_MAX));
+    }
+}
+
+void RT::ToneMapper::ResolveTile(const RT::Framebuffer &framebuffer, size_t tile, uint32_t *pImage, size_t pitch) const {
+    size_t x0, y0, x1, y1;
+    framebuffer.GetTileBounds(tile, x0, y0, x1, y1);
+    const AccumulatedPixel* pTile = framebuffer.GetTileData(tile);
+    size_t height = framebuffer.GetHeight();
+    for (size_t y = y0; y < y1; ++y){
+        ResolveRow(pTile + (y - y0) * Framebuffer::TILE_SIZE, x1 - x0, pImage + (height - y - 1) * pitch + x0);
+    }
+}
+
+void RT::ToneMapper::Resolve(const RT::Framebuffer &framebuffer, uint32_t *pImage, size_t pitch) const {
+    for (size_t tile = 0; tile < framebuffer.GetTileCount(); ++tile){
+        ResolveTile(framebuffer, tile, pImage, pitch);
+    }
+}
+
+#ifdef RT_TONEMAPPER_SSE2
+void RT::ToneMapper::ResolveRow(const RT::AccumulatedPixel *pPixels, size_t count, uint32_t *pRow) const {
+    // Linear output is quantized straight to [0, 255], otherwise to an index of the gamma table
+    const float maxValue = linear_ ? static_cast<float>(Utils::RGB_MAX) : static_cast<float>(GAMMA_LUT_SIZE - 1);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 scale = _mm_set1_ps(exposure_ * maxValue);
+    const __m128 upper = _mm_set1_ps(maxValue);
+    const __m128 background = _mm_setr_ps(static_cast<float>(Utils::BACKGROUND_COLOR[0]),
+                                          static_cast<float>(Utils::BACKGROUND_COLOR[1]),
+                                          static_cast<float>(Utils::BACKGROUND_COLOR[2]), 1.f);
+    const __m128 colorMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const __m128 alpha = _mm_setr_ps(0.f, 0.f, 0.f, static_cast<float>(Utils::RGB_MAX));
+
+    // Returns clamped BGRA lanes of one pixel, which matches the byte order of a little endian 0xAARRGGBB
+    auto convert = [&](const AccumulatedPixel& pixel) {
+        __m128 color = _mm_load_ps(&pixel.r);
+        __m128 empty = _mm_cmple_ps(_mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3)), zero);
+        color = _mm_or_ps(_mm_and_ps(empty, background), _mm_andnot_ps(empty, color));
+        __m128 samples = _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3));
+        color = _mm_mul_ps(color, _mm_div_ps(scale, samples));
+        color = _mm_min_ps(_mm_max_ps(color, zero), upper);
+        color = _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 0, 1, 2));
+        return _mm_cvttps_epi32(_mm_or_ps(_mm_and_ps(color, colorMask), alpha));
+    };
+
+    if (linear_){
+        size_t x = 0;
+        for (; x + 4 <= count; x += 4){
+            __m128i low = _mm_packs_epi32(convert(pPixels[x]), convert(pPixels[x + 1]));
+            __m128i high = _mm_packs_epi32(convert(pPixels[x + 2]), convert(pPixels[x + 3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pRow + x), _mm_packus_epi16(low, high));
+        }
+        for (; x < count; ++x){
+            __m128i packed = convert(pPixels[x]);
+            packed = _mm_packus_epi16(_mm_packs_epi32(packed, packed), packed);
+            pRow[x] = static_cast<uint32_t>(_mm_cvtsi128_si32(packed));
+        }
+    } else{
+        alignas(16) int32_t index[4];
+        for (size_t x = 0; x < count; ++x){
+            _mm_store_si128(reinterpret_cast<__m128i*>(index), convert(pPixels[x]));
+            pRow[x] = Pack(gammaLut_[index[2]], gammaLut_[index[1]], gammaLut_[index[0]]);
+        }
+    }
+}
+#else
+void RT::ToneMapper::ResolveRow(const RT::AccumulatedPixel *pPixels, size_t count, uint32_t *pRow) const {
+    const float maxValue = linear_ ? static_cast<float>(Utils::RGB_MAX) : static_cast<float>(GAMMA_LUT_SIZE - 1);
+    for (size_t x = 0; x < count; ++x){
+        AccumulatedPixel pixel = pPixels[x];
+        if (pixel.samples <= 0.f){
+            pixel = AccumulatedPixel{static_cast<float>(Utils::BACKGROUND_COLOR[0]),
+                                     static_cast<float>(Utils::BACKGROUND_COLOR[1]),
+                                     static_cast<float>(Utils::BACKGROUND_COLOR[2]), 1.f};
+        }
+        float scale = exposure_ * maxValue / pixel.samples;
+        uint32_t r = static_cast<uint32_t>(std::clamp(pixel.r * scale, 0.f, maxValue));
+        uint32_t g = static_cast<uint32_t>(std::clamp(pixel.g * scale, 0.f, maxValue));
+        uint32_t b = static_cast<uint32_t>(std::clamp(pixel.b * scale, 0.f, maxValue));
+        pRow[x] = linear_ ? Pack(r, g, b) : Pack(gammaLut_[r], gammaLut_[g], gammaLut_[b]);
+    }
+}
+#endif
@@ -0,0 +1,47 @@
+/**
+ * @file ToneMapper.h
+ * @brief Defines the ToneMapper class, conversion of accumulated float samples to displayable 8-bit pixels.
+ */
+#ifndef MAIN_CPP_TONEMAPPER_H
+#define MAIN_CPP_TONEMAPPER_H
+
+#include <array>
+#include <cstdint>
+#include "Framebuffer.h"
+#include "../Utilities/Utils.h"
+
+namespace RT{
+    /**
+     * @class ToneMapper
+     * @brief Averages samples, applies exposure, clamps, applies gamma and packs pixels as 0xAARRGGBB.
+     *
+     * Works on whole framebuffer tiles, with SSE2 four pixels are converted and packed at once. The output image
+     * is stored top row first, so the bottom row of the framebuffer (y = 0) ends up as the last image row.
+     */
+    class ToneMapper{
+    public:
+        explicit ToneMapper(double exposure = Utils::DISPLAY_EXPOSURE, double gamma = Utils::DISPLAY_GAMMA);
+
+        /// \brief Converts one tile, pImage points to the first pixel of the image, pitch is row length in pixels
+        void ResolveTile(const Framebuffer& framebuffer, size_t tile, uint32_t* pImage, size_t pitch) const;
+        /// \brief Converts all tiles of the framebuffer
+        void Resolve(const Framebuffer& framebuffer, uint32_t* pImage, size_t pitch) const;
+
+        /// \brief Packs RGB color in range [0, 255] as an opaque 0xAARRGGBB pixel
+        static uint32_t Pack(uint32_t red, uint32_t green, uint32_t blue) {
+            return (0xFFu << 24) | (red << 16) | (green << 8) | blue;
+        }
+
+    private:
+        /// \brief Resolution of the gamma lookup table
+        static constexpr size_t GAMMA_LUT_SIZE = 4096;
+
+        void ResolveRow(const AccumulatedPixel* pPixels, size_t count, uint32_t* pRow) const;
+
+        float exposure_;
+        bool linear_;
+        std::array<uint8_t, GAMMA_LUT_SIZE> gammaLut_{};
+    };
+}
+
+#endif
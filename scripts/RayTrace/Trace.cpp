@@ -0,0 +1,149 @@
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+std::atomic<bool> RT::Trace::enabled_{false};
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Event{
+        const char* name;
+        std::string detail;
+        int64_t start;
+        int64_t duration;
+    };
+
+    struct ThreadTrace{
+        int id;
+        std::string name;
+        /// \brief Guards events, only contended while the trace is written
+        std::mutex mutex;
+        std::vector<Event> events;
+    };
+
+    struct Registry{
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadTrace>> threads;
+        int nextId = 0;
+        Clock::time_point epoch = Clock::now();
+    };
+
+    Registry& GetRegistry() {
+        // Never destroyed, threads of static objects (e.g. the shared thread pool) may exit after main() returns
+        static Registry* pRegistry = new Registry();
+        return *pRegistry;
+    }
+
+    /// \brief Buffer of the calling thread, kept by the registry after the thread exits
+    ThreadTrace& Local() {
+        thread_local std::shared_ptr<ThreadTrace> pThread = []() {
+            auto pNew = std::make_shared<ThreadTrace>();
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            pNew->id = registry.nextId++;
+            registry.threads.push_back(pNew);
+            return pNew;
+        }();
+        return *pThread;
+    }
+
+    int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - GetRegistry().epoch).count();
+    }
+
+    void WriteString(std::ostream& stream, const std::string& text) {
+        stream << '"';
+        for (char c : text){
+            if (c == '"' || c == '\\') stream << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) stream << ' ';
+            else stream << c;
+        }
+        stream << '"';
+    }
+}
+
+void RT::Trace::Start() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& pThread : registry.threads){
+        std::lock_guard<std::mutex> threadLock(pThread->mutex);
+        pThread->events.clear();
+    }
+    registry.epoch = Clock::now();
+    enabled_ = true;
+}
+
+void RT::Trace::Stop() {
+    enabled_ = false;
+}
+
+void RT::Trace::SetThreadName(const std::string &name) {
+    ThreadTrace& thread = Local();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    thread.name = name;
+}
+
+void RT::Trace::Write(std::ostream &stream) {
+    Stop();
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    auto separator = [&]() -> std::ostream& {
+        stream << (first ? "\n" : ",\n");
+        first = false;
+        return stream;
+    };
+    stream << std::fixed << std::setprecision(3);
+    for (auto& pThread : registry.threads){
+        std::lock_guard<std::mutex> threadLock(pThread->mutex);
+        if (pThread->events.empty()) continue;
+        std::string name = pThread->name.empty() ? "thread " + std::to_string(pThread->id) : pThread->name;
+        separator() << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << pThread->id
+                    << ", \"args\": {\"name\": ";
+        WriteString(stream, name);
+        stream << "}}";
+        // Timestamps and durations are in microseconds
+        for (const Event& event : pThread->events){
+            separator() << "{\"name\": ";
+            WriteString(stream, event.name);
+            stream << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << pThread->id << ", \"ts\": " << event.start * 1e-3
+                   << ", \"dur\": " << event.duration * 1e-3;
+            if (!event.detail.empty()){
+                stream << ", \"args\": {\"detail\": ";
+                WriteString(stream, event.detail);
+                stream << "}";
+            }
+            stream << "}";
+        }
+    }
+    stream << "\n]}\n";
+}
+
+void RT::Trace::Save(const std::string &path) {
+    std::ofstream file(path);
+    if (!file.is_open()) throw std::runtime_error("Error opening file: " + path);
+    Write(file);
+    if (!file) throw std::runtime_error("Writing failed: " + path);
+}
+
+void RT::Trace::Scope::Begin(std::string detail) {
+    detail_ = std::move(detail);
+    start_ = Now();
+}
+
+void RT::Trace::Scope::End() {
+    // Spans still open when the trace is written are dropped
+    if (!IsEnabled()) return;
+    int64_t end = Now();
+    ThreadTrace& thread = Local();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    thread.events.push_back(Event{name_, std::move(detail_), start_, end - start_});
+}
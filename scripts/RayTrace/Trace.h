@@ -0,0 +1,79 @@
+/**
+ * @file Trace.h
+ * @brief Defines the Trace timeline recorder, spans of all threads saved as a Chrome/Perfetto trace.
+ */
+#ifndef MAIN_CPP_TRACE_H
+#define MAIN_CPP_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "../Utilities/Utils.h"
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+/// \brief Records a span from here to the end of the scope, name has to be a string literal
+#ifdef __TRACE__
+#define TRACE_SCOPE(name) RT::Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+/// \brief Span with a detail shown in the trace viewer, the detail is only evaluated while tracing
+#define TRACE_SCOPE_DETAIL(name, detail) \
+    RT::Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name, RT::Trace::IsEnabled() ? std::string(detail) : std::string())
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_DETAIL(name, detail) ((void)0)
+#endif
+
+namespace RT{
+    /**
+     * @class Trace
+     * @brief Records timed spans of every thread between Start() and Save().
+     *
+     * Spans go into a buffer of the recording thread, so threads don't contend while tracing. When tracing isn't
+     * started a span costs one relaxed atomic load, without __TRACE__ in Utils.h the macros compile to nothing.
+     * The output is the Chrome trace event format, it opens in chrome://tracing and ui.perfetto.dev.
+     */
+    class Trace{
+    public:
+        /// \brief Drops previously recorded spans and starts recording, time 0 of the trace is now
+        static void Start();
+        /// \brief Stops recording, recorded spans are kept until the next Start()
+        static void Stop();
+        static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+        /// \brief Name of the calling thread in the trace viewer, threads are otherwise numbered in order of use
+        static void SetThreadName(const std::string& name);
+
+        /// \brief Stops recording and writes all spans as Chrome trace JSON
+        static void Write(std::ostream& stream);
+        /// \brief Write() into a file, throws std::runtime_error on failure
+        static void Save(const std::string& path);
+
+        /// \brief Span recorded from construction to destruction, use the TRACE_SCOPE macros
+        class Scope{
+        public:
+            explicit Scope(const char* name, std::string detail = std::string()) : name_(name) {
+                if (IsEnabled()) Begin(std::move(detail));
+            }
+            ~Scope() {
+                if (start_ >= 0) End();
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            void Begin(std::string detail);
+            void End();
+
+            const char* name_;
+            std::string detail_;
+            /// \brief Start in nanoseconds since Start(), negative if tracing was off
+            int64_t start_ = -1;
+        };
+
+    private:
+        static std::atomic<bool> enabled_;
+    };
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "Zobrist.h"
+#include <array>
+#include <stdexcept>
+
+namespace {
+    const std::array<std::string, 6> FIGURE_NAMES = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+
+    uint64_t SplitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // [figure][square]
+    const auto ZOBRIST_KEYS = []() {
+        std::array<std::array<uint64_t, 64>, FIGURE_NAMES.size()> keys{};
+        uint64_t state = 0x5A0B8157C4E55ULL;
+        for (auto& figureKeys : keys){
+            for (auto& key : figureKeys){
+                key = SplitMix64(state);
+            }
+        }
+        return keys;
+    }();
+}
+
+uint64_t RT::Zobrist::SquareKey(size_t row, size_t column, const std::string &figureName) {
+    for (size_t figure = 0; figure < FIGURE_NAMES.size(); ++figure){
+        if (FIGURE_NAMES[figure] == figureName) return ZOBRIST_KEYS[figure][row * 8 + column];
+    }
+    throw std::invalid_argument("Unknown figure: " + figureName);
+}
+
+uint64_t RT::Zobrist::Hash(const RT::FigureConfiguration &figures) {
+    uint64_t hash = 0;
+    for (size_t row = 0; row < figures.size(); ++row){
+        for (size_t column = 0; column < figures[row].size(); ++column){
+            if (figures[row][column] != "empty"){
+                hash ^= SquareKey(row, column, figures[row][column]);
+            }
+        }
+    }
+    return hash;
+}
+
+uint64_t RT::Zobrist::Combine(uint64_t seed, uint64_t value) {
+    uint64_t state = seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+    return SplitMix64(state);
+}
+
+uint64_t RT::Zobrist::Combine(uint64_t seed, const std::string &text) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : text){
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return Combine(seed, hash);
+}
+
+uint64_t RT::Zobrist::Combine(uint64_t seed, const RT::Camera &camera) {
+    seed = Combine(seed, camera.GetPos());
+    seed = Combine(seed, camera.GetLookAt());
+    seed = Combine(seed, camera.GetUp());
+    seed = Combine(seed, camera.GetAspectRatio());
+    seed = Combine(seed, camera.GetLookLength());
+    return Combine(seed, camera.GetHorizontalScale());
+}
+
+uint64_t RT::Zobrist::RendererHash() {
+    return Combine(0, Utils::RENDERER_VERSION);
+}
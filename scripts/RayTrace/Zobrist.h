@@ -0,0 +1,53 @@
+/**
+ * @file Zobrist.h
+ * @brief Defines Zobrist hashing of chessboard positions and helpers for building content keys.
+ */
+#ifndef MAIN_CPP_ZOBRIST_H
+#define MAIN_CPP_ZOBRIST_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "Chessboard.h"
+#include "Camera.h"
+
+namespace RT{
+    /**
+     * @class Zobrist
+     * @brief Hashes piece placements by XOR-ing a fixed random key for every occupied (square, figure) pair.
+     *
+     * Keys are generated from a constant seed, so hashes are stable between runs and can be stored on disk.
+     */
+    class Zobrist{
+    public:
+        /// \brief Hash of the whole figure configuration, empty board hashes to 0
+        static uint64_t Hash(const RT::FigureConfiguration& figures);
+        /// \brief Key of a single figure on a square, throws std::invalid_argument for unknown figure names
+        static uint64_t SquareKey(size_t row, size_t column, const std::string& figureName);
+
+        /// \brief Mixes value into seed (splitmix64 finalizer), used to extend position hashes with other parameters
+        static uint64_t Combine(uint64_t seed, uint64_t value);
+        static uint64_t Combine(uint64_t seed, double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return Combine(seed, bits);
+        }
+        static uint64_t Combine(uint64_t seed, const Vec3D& vector) {
+            for (size_t i = 0; i < DIMS_3D; ++i) seed = Combine(seed, vector[i]);
+            return seed;
+        }
+        static uint64_t Combine(uint64_t seed, const std::string& text);
+        /// \brief Mixes in everything that determines the rays shot by the camera
+        static uint64_t Combine(uint64_t seed, const RT::Camera& camera);
+
+        /**
+         * @brief Hash of Utils::RENDERER_VERSION, the same for every build of the same renderer version.
+         *
+         * Materials and light are compiled in (Config.h, Utils.h), so anything stored on disk by a renderer of another
+         * version must not be reused.
+         */
+        static uint64_t RendererHash();
+    };
+}
+
+#endif
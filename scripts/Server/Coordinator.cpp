@@ -0,0 +1,239 @@
+#include "Coordinator.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+RT::Coordinator::Coordinator(const RT::CoordinatorOptions &options) : options_(options) {
+    if (options_.unixPath.empty()){
+        listener_ = Socket::ListenTcp(options_.host, options_.port);
+        Log("Coordinator listening on %s:%d", options_.host.c_str(), options_.port);
+    } else{
+        listener_ = Socket::ListenUnix(options_.unixPath);
+        Log("Coordinator listening on %s", options_.unixPath.c_str());
+    }
+    acceptThread_ = std::thread([this]() { AcceptLoop(); });
+}
+
+RT::Coordinator::~Coordinator() {
+    running_ = false;
+    listener_.Shutdown();
+    if (acceptThread_.joinable()) acceptThread_.join();
+    {
+        // Idle workers get DONE, busy ones (only after a failed render) are interrupted
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& pWorker : workers_){
+            if (pWorker->busy) pWorker->socket.Shutdown();
+        }
+    }
+    condition_.notify_all();
+    for (auto& thread : workerThreads_){
+        thread.join();
+    }
+}
+
+void RT::Coordinator::AcceptLoop() {
+    while (running_){
+        int error = 0;
+        Socket client = listener_.Accept(&error);
+        if (!client.IsValid()){
+            // Same as in RenderServer::Run, errors like running out of file descriptors last a while
+            if (running_){
+                Log("Accepting worker failed with error %d, retrying", error);
+                std::this_thread::sleep_for(std::chrono::milliseconds(Utils::ACCEPT_RETRY_MILLISECONDS));
+            }
+            continue;
+        }
+
+        auto pWorker = std::make_shared<Worker>();
+        pWorker->socket = std::move(client);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        workers_.push_back(pWorker);
+        workerThreads_.emplace_back([this, pWorker]() { ServeWorker(pWorker); });
+        Log("Worker connected, %zu connected", workers_.size());
+    }
+}
+
+void RT::Coordinator::ServeWorker(std::shared_ptr<Worker> pWorker) {
+    pWorker->socket.SetReceiveTimeout(options_.unitTimeoutSeconds * 1000);
+    while (true){
+        WorkUnit unit;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return !running_ || !units_.empty(); });
+            if (units_.empty()){
+                pWorker->socket.WriteString("DONE\n");
+                break;
+            }
+            unit = units_.front();
+            units_.pop_front();
+            pWorker->busy = true;
+        }
+        std::string error;
+        bool usable = ExecuteUnit(pWorker->socket, unit, error);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pWorker->busy = false;
+        }
+        if (!error.empty()) RetryUnit(unit, error);
+        if (!usable) break;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    workers_.erase(std::find(workers_.begin(), workers_.end(), pWorker));
+    if (running_){
+        Log("Worker disconnected, %zu connected", workers_.size());
+    }
+}
+
+bool RT::Coordinator::ExecuteUnit(RT::Socket &socket, const WorkUnit &unit, std::string &error) {
+    std::string request;
+    size_t tilesX;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = frames_.find(unit.frame);
+        if (unit.id < firstUnitId_ || it == frames_.end()) return true;
+        request = "JOB " + std::to_string(unit.id) + " " + std::to_string(unit.firstRow) + " " +
+                  std::to_string(unit.rows) + " " + std::to_string(unit.firstSample) + " " +
+                  std::to_string(unit.endSample) + " " + it->second->jobLine + "\n";
+        tilesX = it->second->framebuffer.GetTilesX();
+    }
+    if (!socket.WriteString(request)){
+        error = "worker disconnected";
+        return false;
+    }
+
+    std::string line;
+    if (!socket.ReadLine(line)){
+        error = "worker disconnected or timed out";
+        return false;
+    }
+    std::istringstream answer(line);
+    std::string kind;
+    size_t id = 0;
+    answer >> kind >> id;
+    if (kind == "ERROR" && id == unit.id){
+        std::getline(answer >> std::ws, error);
+        if (error.empty()) error = "worker error";
+        return true;
+    }
+    size_t tileRows = (unit.rows + Framebuffer::TILE_SIZE - 1) / Framebuffer::TILE_SIZE;
+    size_t pixelCount = tileRows * tilesX * Framebuffer::TILE_PIXELS;
+    size_t size = 0;
+    uint64_t fingerprint = 0;
+    if (kind != "TILES" || id != unit.id || !(answer >> size >> fingerprint) ||
+        size != pixelCount * sizeof(AccumulatedPixel)){
+        error = "unexpected answer: " + line.substr(0, 100);
+        return false;
+    }
+    std::vector<AccumulatedPixel> pixels(pixelCount);
+    if (!socket.ReadExact(pixels.data(), size)){
+        error = "worker disconnected or timed out";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = frames_.find(unit.frame);
+    if (unit.id < firstUnitId_ || it == frames_.end()) return true;
+    Frame& frame = *it->second;
+    // Workers with other pieces, scene options or renderer version would render a different image
+    if (frame.mergedUnits == 0){
+        frame.fingerprint = fingerprint;
+    } else if (fingerprint != frame.fingerprint){
+        error = "worker renders a different scene (pieces, scene options or renderer version)";
+        return false;
+    }
+    ++frame.mergedUnits;
+    AccumulatedPixel* pTarget = frame.framebuffer.GetTileData(unit.firstRow / Framebuffer::TILE_SIZE * tilesX);
+    for (size_t i = 0; i < pixelCount; ++i){
+        pTarget[i].r += pixels[i].r;
+        pTarget[i].g += pixels[i].g;
+        pTarget[i].b += pixels[i].b;
+        pTarget[i].samples += pixels[i].samples;
+    }
+    if (--frame.remainingUnits == 0) condition_.notify_all();
+    return true;
+}
+
+void RT::Coordinator::RetryUnit(WorkUnit unit, const std::string &error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (unit.id < firstUnitId_ || !failure_.empty()) return;
+    ++unit.attempts;
+    Log("Unit %zu of frame %zu (rows %zu-%zu) failed: %s", unit.id, unit.frame, unit.firstRow,
+        unit.firstRow + unit.rows, error.c_str());
+    if (unit.attempts >= options_.maxAttempts){
+        failure_ = "Frame " + std::to_string(unit.frame) + " failed " + std::to_string(unit.attempts) +
+                   " times, last error: " + error;
+    } else{
+        units_.push_front(unit);
+    }
+    condition_.notify_all();
+}
+
+void RT::Coordinator::EnqueueFrame(size_t frame, const RT::RenderJob &job) {
+    auto pFrame = std::make_unique<Frame>();
+    pFrame->jobLine = job.ToString();
+    pFrame->framebuffer.Resize(job.width, job.height);
+
+    size_t bandRows = options_.bandRows;
+    if (bandRows == 0) bandRows = std::max<size_t>(1, Utils::DISTRIBUTED_BAND_PIXELS / job.width);
+    bandRows = (bandRows + Framebuffer::TILE_SIZE - 1) / Framebuffer::TILE_SIZE * Framebuffer::TILE_SIZE;
+    size_t samples = job.settings.sqrtSamples * job.settings.sqrtSamples;
+    size_t splits = std::clamp<size_t>(options_.sampleSplits, 1, samples);
+    for (size_t firstRow = 0; firstRow < job.height; firstRow += bandRows){
+        for (size_t split = 0; split < splits; ++split){
+            WorkUnit unit{};
+            unit.id = nextUnitId_++;
+            unit.frame = frame;
+            unit.firstRow = firstRow;
+            unit.rows = std::min(bandRows, job.height - firstRow);
+            unit.firstSample = samples * split / splits;
+            unit.endSample = samples * (split + 1) / splits;
+            units_.push_back(unit);
+            ++pFrame->remainingUnits;
+        }
+    }
+    frames_[frame] = std::move(pFrame);
+}
+
+void RT::Coordinator::Render(const std::vector<RT::RenderJob> &frames,
+                             const std::function<void(size_t, const RT::Framebuffer &)> &onFrame) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    firstUnitId_ = nextUnitId_;
+    failure_.clear();
+    if (workers_.empty()){
+        Log("Waiting for workers");
+    }
+
+    auto abandon = [this]() {
+        units_.clear();
+        frames_.clear();
+        firstUnitId_ = nextUnitId_;
+    };
+    size_t nextFrame = 0;
+    for (size_t finished = 0; finished < frames.size(); ++finished){
+        while (nextFrame < frames.size() && nextFrame < finished + std::max<size_t>(options_.framesInFlight, 1)){
+            EnqueueFrame(nextFrame, frames[nextFrame]);
+            ++nextFrame;
+        }
+        condition_.notify_all();
+        condition_.wait(lock, [&]() { return !failure_.empty() || frames_[finished]->remainingUnits == 0; });
+        if (!failure_.empty()){
+            abandon();
+            throw std::runtime_error(failure_);
+        }
+
+        std::unique_ptr<Frame> pFrame = std::move(frames_[finished]);
+        frames_.erase(finished);
+        lock.unlock();
+        try {
+            onFrame(finished, pFrame->framebuffer);
+        } catch (...) {
+            lock.lock();
+            abandon();
+            throw;
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * @file Coordinator.h
+ * @brief Defines the Coordinator class, which splits frames into bands rendered by worker processes.
+ */
+#ifndef MAIN_CPP_COORDINATOR_H
+#define MAIN_CPP_COORDINATOR_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+#include "Socket.h"
+#include "RenderJob.h"
+
+namespace RT{
+    /**
+     * @struct CoordinatorOptions
+     * @brief Listening address of the coordinator and the way frames are split.
+     */
+    struct CoordinatorOptions{
+        std::string host = "127.0.0.1";
+        int port = 5556;
+        /// \brief Listen on this Unix domain socket instead of TCP when not empty
+        std::string unixPath;
+        /// \brief Rows of one work unit (rounded up to whole tiles), 0 picks about Utils::DISTRIBUTED_BAND_PIXELS
+        size_t bandRows = 0;
+        /// \brief Every band is further split into this many sample ranges
+        size_t sampleSplits = 1;
+        /// \brief A worker not answering within this time is dropped and its unit is given to another one
+        int unitTimeoutSeconds = 600;
+        /// \brief A unit failing this many times (worker errors, disconnects, timeouts) fails the whole render
+        size_t maxAttempts = 3;
+        /// \brief Frames whose units are handed out at once, so workers don't wait for the end of a frame
+        size_t framesInFlight = 2;
+    };
+
+    /**
+     * @class Coordinator
+     * @brief Hands out bands of frames to worker processes and merges the returned float tiles.
+     *
+     * Workers (see RenderWorker) connect to the coordinator and get one unit at a time. Protocol:
+     * - coordinator: `JOB <id> <firstRow> <rows> <firstSample> <endSample> <job line>\n`, the job line is
+     *   a RenderJob (RenderJob.h), rows are counted from the bottom of the image and start on a tile row
+     * - worker: `TILES <id> <size> <fingerprint>\n` followed by size bytes of the band framebuffer tiles
+     *   (AccumulatedPixel floats, tile by tile), or `ERROR <id> <message>\n`. The fingerprint of the worker scene
+     *   (Scene::GetFingerprint()) must be the same for all units of a frame, a worker with other pieces or
+     *   scene options is dropped
+     * - coordinator: `DONE\n` once all frames are finished, the worker then exits
+     *
+     * A band covers whole tile rows of the full width, so its tiles are a contiguous range of the frame
+     * framebuffer and merging is a plain addition of sums and sample counts. With a single sample range the frame
+     * is bitwise equal to a render in one process. Units of workers that disconnect, time out or report an error
+     * are queued again.
+     */
+    class Coordinator{
+    public:
+        /// \brief Starts listening for workers right away, throws std::runtime_error on failure
+        explicit Coordinator(const RT::CoordinatorOptions& options);
+        ~Coordinator();
+
+        /**
+         * @brief Renders all frames with the connected workers, blocks until they are finished.
+         *
+         * onFrame is called for every finished frame in order, with the merged framebuffer (y = 0 is the bottom
+         * row). Throws std::runtime_error when a unit fails CoordinatorOptions::maxAttempts times.
+         */
+        void Render(const std::vector<RT::RenderJob>& frames,
+                    const std::function<void(size_t, const RT::Framebuffer&)>& onFrame);
+
+    private:
+        struct WorkUnit{
+            size_t id;
+            size_t frame;
+            size_t firstRow;
+            size_t rows;
+            size_t firstSample;
+            size_t endSample;
+            size_t attempts = 0;
+        };
+        struct Frame{
+            std::string jobLine;
+            RT::Framebuffer framebuffer;
+            size_t remainingUnits = 0;
+            /// \brief Scene fingerprint (Scene::GetFingerprint()) of the first merged unit, all others must match
+            uint64_t fingerprint = 0;
+            size_t mergedUnits = 0;
+        };
+        struct Worker{
+            RT::Socket socket;
+            bool busy = false;
+        };
+
+        void AcceptLoop();
+        void ServeWorker(std::shared_ptr<Worker> pWorker);
+        /// \brief Renders the unit on the worker and merges the result, false if the worker can't be used anymore
+        bool ExecuteUnit(RT::Socket& socket, const WorkUnit& unit, std::string& error);
+        /// \brief Queues the unit again after a failure, fails the render after too many attempts
+        void RetryUnit(WorkUnit unit, const std::string& error);
+        /// \brief Splits the frame into units and queues them, mutex_ has to be locked
+        void EnqueueFrame(size_t frame, const RT::RenderJob& job);
+
+        RT::CoordinatorOptions options_;
+        RT::Socket listener_;
+        std::atomic<bool> running_{true};
+        std::thread acceptThread_;
+
+        // Guards everything below
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::deque<WorkUnit> units_;
+        std::map<size_t, std::unique_ptr<Frame>> frames_;
+        size_t nextUnitId_ = 0;
+        /// \brief Units with lower ids belong to a previous (failed) Render() call and are ignored
+        size_t firstUnitId_ = 0;
+        std::string failure_;
+        std::vector<std::shared_ptr<Worker>> workers_;
+        std::vector<std::thread> workerThreads_;
+    };
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "Coordinator.h"
+#include "../RayTrace/ToneMapper.h"
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    void PrintUsage(const char* program) {
+        std::cout << "Usage: " << program << " [--host HOST] [--port PORT] [--unix PATH] [--output PATH]"
+                  << " [--frames FILE] [--band-rows N] [--sample-splits N] [--timeout SECONDS] [--attempts N]"
+                  << " [key=value ...]\n"
+                  << "  Splits frames into bands rendered by RealChess-Worker processes and merges them.\n"
+                  << "  Keys describe a single frame like server jobs, --frames reads one RENDER job line per frame.\n"
+                  << "  With more frames the output path needs a printf pattern, e.g. frame%04d.png" << std::endl;
+    }
+
+    /// \brief Whether pattern is safe to pass to snprintf with one int, exactly one %d or %i conversion with optional
+    /// flags and width, any other % has to be escaped as %%
+    bool IsFramePattern(const std::string& pattern) {
+        size_t conversions = 0;
+        for (size_t i = 0; i < pattern.size(); ++i){
+            if (pattern[i] != '%') continue;
+            if (++i < pattern.size() && pattern[i] == '%') continue;
+            while (i < pattern.size() && std::string("-+ #0").find(pattern[i]) != std::string::npos) ++i;
+            while (i < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[i]))) ++i;
+            if (i == pattern.size() || (pattern[i] != 'd' && pattern[i] != 'i')) return false;
+            ++conversions;
+        }
+        return conversions == 1;
+    }
+
+    std::string FramePath(const std::string& pattern, size_t frame, size_t frameCount) {
+        if (frameCount == 1) return pattern;
+        char path[4096];
+        std::snprintf(path, sizeof(path), pattern.c_str(), static_cast<int>(frame));
+        return path;
+    }
+}
+
+int main(int argc, char* argv[]){
+    RT::CoordinatorOptions options;
+    std::string outputPath = "output.png";
+    std::string framesPath;
+    std::string jobLine = "RENDER";
+    for (int i = 1; i < argc; ++i){
+        std::string argument = argv[i];
+        if (argument == "--help"){
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        if (argument.rfind("--", 0) != 0){
+            jobLine += " " + argument;
+            continue;
+        }
+        if (i + 1 >= argc){
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        // std::stoi and std::stoul throw std::invalid_argument or std::out_of_range on bad numbers
+        try {
+            if (argument == "--host") options.host = value;
+            else if (argument == "--port") options.port = std::stoi(value);
+            else if (argument == "--unix") options.unixPath = value;
+            else if (argument == "--output") outputPath = value;
+            else if (argument == "--frames") framesPath = value;
+            else if (argument == "--band-rows") options.bandRows = std::stoul(value);
+            else if (argument == "--sample-splits") options.sampleSplits = std::stoul(value);
+            else if (argument == "--timeout") options.unitTimeoutSeconds = std::stoi(value);
+            else if (argument == "--attempts") options.maxAttempts = std::stoul(value);
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::logic_error&) {
+            std::cerr << "Invalid value of " << argument << ": " << value << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        std::vector<RT::RenderJob> frames;
+        if (framesPath.empty()){
+            frames.push_back(RT::RenderJob::Parse(jobLine));
+        } else{
+            std::ifstream file(framesPath);
+            if (!file.is_open()) throw std::runtime_error("Error opening file: " + framesPath);
+            std::string line;
+            while (std::getline(file, line)){
+                if (!line.empty() && line[0] != '#') frames.push_back(RT::RenderJob::Parse(line));
+            }
+        }
+        if (frames.size() > 1 && !IsFramePattern(outputPath)){
+            throw std::invalid_argument("Output path of more frames needs one frame number pattern, e.g. frame%04d.png, "
+                                        "other % written as %%: " + outputPath);
+        }
+        RT::ImageFormat format = RT::ImageFormatFromPath(outputPath);
+
+        RT::Coordinator coordinator(options);
+        auto start = std::chrono::steady_clock::now();
+        RT::ToneMapper toneMapper;
+        coordinator.Render(frames, [&](size_t frame, const RT::Framebuffer& framebuffer) {
+            std::string path = FramePath(outputPath, frame, frames.size());
+            std::ofstream image(path, std::ios::binary | std::ios::out);
+            if (!image.is_open()) throw std::runtime_error("Error opening file: " + path);
+            std::vector<uint32_t> pixels(framebuffer.GetWidth() * framebuffer.GetHeight());
+            toneMapper.Resolve(framebuffer, pixels.data(), framebuffer.GetWidth());
+            auto pWriter = RT::ImageWriter::Create(format, image, framebuffer.GetWidth(), framebuffer.GetHeight());
+            pWriter->WriteRows(pixels.data(), framebuffer.GetHeight());
+            pWriter->Finish();
+            std::cout << "Frame " << frame << " saved into " << path << std::endl;
+        });
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Rendered " << frames.size() << " frame(s) in " << seconds << " s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
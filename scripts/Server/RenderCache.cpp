@@ -0,0 +1,146 @@
+#include "RenderCache.h"
+#include "../RayTrace/Zobrist.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    constexpr const char* DISK_EXTENSION = ".img";
+}
+
+RT::RenderCache::RenderCache(const RT::RenderCacheOptions &options) : options_(options) {
+    if (options_.diskDirectory.empty()) return;
+
+    namespace fs = std::filesystem;
+    fs::create_directories(options_.diskDirectory);
+    // Rebuild the disk LRU from file modification times
+    std::vector<std::tuple<fs::file_time_type, uint64_t, size_t>> files;
+    for (const auto& file : fs::directory_iterator(options_.diskDirectory)){
+        if (!file.is_regular_file() || file.path().extension() != DISK_EXTENSION) continue;
+        try {
+            uint64_t key = std::stoull(file.path().stem().string(), nullptr, 16);
+            files.emplace_back(file.last_write_time(), key, file.file_size());
+        } catch (const std::logic_error&) {
+            // not ours
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return std::get<0>(a) > std::get<0>(b); });
+    for (const auto& [time, key, size] : files){
+        diskLru_.emplace_back(key, size);
+        diskIndex_[key] = std::prev(diskLru_.end());
+        diskBytes_ += size;
+    }
+    EvictDisk();
+}
+
+uint64_t RT::RenderCache::MakeKey(const RT::FigureConfiguration &figures, const RT::SceneOptions &options,
+                                  const RT::Camera &camera, size_t width, size_t height,
+                                  const RT::RenderSettings &settings, RT::ImageFormat format) {
+    // Stale disk entries of a differently configured renderer or other pieces are never returned
+    uint64_t key = RT::Scene::GetContentKey(figures, options);
+    key = RT::Zobrist::Combine(key, camera);
+    key = RT::Zobrist::Combine(key, static_cast<uint64_t>(width));
+    key = RT::Zobrist::Combine(key, static_cast<uint64_t>(height));
+    key = RT::Zobrist::Combine(key, static_cast<uint64_t>(settings.sqrtSamples));
+    key = RT::Zobrist::Combine(key, static_cast<uint64_t>(settings.bounces));
+    key = RT::Zobrist::Combine(key, settings.seed);
+    key = RT::Zobrist::Combine(key, static_cast<uint64_t>(settings.meshLod));
+    return RT::Zobrist::Combine(key, static_cast<uint64_t>(format));
+}
+
+RT::RenderCache::Image RT::RenderCache::Get(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = memoryIndex_.find(key);
+    if (it != memoryIndex_.end()){
+        memoryLru_.splice(memoryLru_.begin(), memoryLru_, it->second);
+        return it->second->image;
+    }
+
+    Image image = LoadFromDisk(key);
+    if (image){
+        memoryLru_.push_front(Entry{key, image});
+        memoryIndex_[key] = memoryLru_.begin();
+        memoryBytes_ += image->size();
+        EvictMemory();
+    }
+    return image;
+}
+
+void RT::RenderCache::Put(uint64_t key, RT::RenderCache::Image image) {
+    if (!image) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (memoryIndex_.find(key) == memoryIndex_.end() && image->size() <= options_.memoryLimitBytes){
+        memoryLru_.push_front(Entry{key, image});
+        memoryIndex_[key] = memoryLru_.begin();
+        memoryBytes_ += image->size();
+        EvictMemory();
+    }
+    if (!options_.diskDirectory.empty() && diskIndex_.find(key) == diskIndex_.end() &&
+        image->size() <= options_.diskLimitBytes){
+        StoreToDisk(key, *image);
+    }
+}
+
+void RT::RenderCache::EvictMemory() {
+    while (memoryBytes_ > options_.memoryLimitBytes && !memoryLru_.empty()){
+        memoryBytes_ -= memoryLru_.back().image->size();
+        memoryIndex_.erase(memoryLru_.back().key);
+        memoryLru_.pop_back();
+    }
+}
+
+RT::RenderCache::Image RT::RenderCache::LoadFromDisk(uint64_t key) {
+    auto it = diskIndex_.find(key);
+    if (it == diskIndex_.end()) return nullptr;
+
+    std::ifstream file(GetDiskPath(key), std::ios::binary);
+    auto image = std::make_shared<std::vector<char>>(it->second->second);
+    if (!file.read(image->data(), image->size())){
+        // Deleted or truncated behind our back
+        diskBytes_ -= it->second->second;
+        diskLru_.erase(it->second);
+        diskIndex_.erase(it);
+        return nullptr;
+    }
+    diskLru_.splice(diskLru_.begin(), diskLru_, it->second);
+    std::error_code error;
+    std::filesystem::last_write_time(GetDiskPath(key), std::filesystem::file_time_type::clock::now(), error);
+    return image;
+}
+
+void RT::RenderCache::StoreToDisk(uint64_t key, const std::vector<char> &image) {
+    // Written under a temporary name first, so readers never see a partial file
+    std::string path = GetDiskPath(key);
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        if (!file.write(image.data(), image.size())) return;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error){
+        std::remove(temporaryPath.c_str());
+        return;
+    }
+    diskLru_.emplace_front(key, image.size());
+    diskIndex_[key] = diskLru_.begin();
+    diskBytes_ += image.size();
+    EvictDisk();
+}
+
+void RT::RenderCache::EvictDisk() {
+    while (diskBytes_ > options_.diskLimitBytes && !diskLru_.empty()){
+        auto [key, size] = diskLru_.back();
+        std::remove(GetDiskPath(key).c_str());
+        diskBytes_ -= size;
+        diskIndex_.erase(key);
+        diskLru_.pop_back();
+    }
+}
+
+std::string RT::RenderCache::GetDiskPath(uint64_t key) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(options_.diskDirectory) / (std::string(name) + DISK_EXTENSION)).string();
+}
@@ -0,0 +1,83 @@
+/**
+ * @file RenderCache.h
+ * @brief Defines the RenderCache class, a content addressed cache of finished images.
+ */
+#ifndef MAIN_CPP_RENDERCACHE_H
+#define MAIN_CPP_RENDERCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "../RayTrace/Scene.h"
+
+namespace RT{
+    /**
+     * @struct RenderCacheOptions
+     * @brief Size limits of the cache tiers.
+     */
+    struct RenderCacheOptions{
+        size_t memoryLimitBytes = 256u << 20;
+        /// \brief Directory of the on-disk tier, empty disables it
+        std::string diskDirectory;
+        size_t diskLimitBytes = 2048u << 20;
+    };
+
+    /**
+     * @class RenderCache
+     * @brief Two tier (memory LRU, then disk) cache of encoded images keyed by MakeKey().
+     *
+     * Disk entries are files named by the hexadecimal key, least recently used ones are deleted when the disk
+     * limit is exceeded. Entries found on disk are promoted to the memory tier. All methods are thread safe.
+     */
+    class RenderCache{
+    public:
+        using Image = std::shared_ptr<const std::vector<char>>;
+
+        explicit RenderCache(const RT::RenderCacheOptions& options);
+
+        /**
+         * @brief Builds the content key of a render.
+         *
+         * Content key of the scene (Scene::GetContentKey(), position, scene options, piece sources and renderer
+         * version) extended with the camera (position, look at, up, aspect ratio, look length and horizontal scale),
+         * resolution, quality settings (with the random seed) and image format.
+         */
+        static uint64_t MakeKey(const RT::FigureConfiguration& figures, const RT::SceneOptions& options,
+                                const RT::Camera& camera, size_t width, size_t height,
+                                const RT::RenderSettings& settings, RT::ImageFormat format);
+
+        /// \brief Returns cached image or nullptr
+        Image Get(uint64_t key);
+        void Put(uint64_t key, Image image);
+
+    private:
+        struct Entry{
+            uint64_t key;
+            Image image;
+        };
+        void EvictMemory();
+        Image LoadFromDisk(uint64_t key);
+        void StoreToDisk(uint64_t key, const std::vector<char>& image);
+        void EvictDisk();
+        std::string GetDiskPath(uint64_t key) const;
+
+        RT::RenderCacheOptions options_;
+        std::mutex mutex_;
+
+        std::list<Entry> memoryLru_;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> memoryIndex_;
+        size_t memoryBytes_ = 0;
+
+        // key and file size, front is the most recently used
+        std::list<std::pair<uint64_t, size_t>> diskLru_;
+        std::unordered_map<uint64_t, std::list<std::pair<uint64_t, size_t>>::iterator> diskIndex_;
+        size_t diskBytes_ = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,130 @@
+#include "RenderJob.h"
+#include "RenderCache.h"
+#include <sstream>
+#include <iomanip>
+
+namespace {
+    constexpr int MAX_SQRT_SAMPLES = 64;
+    constexpr int MAX_BOUNCES = 256;
+
+    Vec3D ParseVector(const std::string& key, const std::string& value) {
+        Vec3D result;
+        std::stringstream stream(value);
+        std::string component;
+        for (size_t i = 0; i < DIMS_3D; ++i){
+            if (!std::getline(stream, component, ',')){
+                throw std::invalid_argument("Expected 3 comma separated numbers for " + key);
+            }
+            result[i] = std::stod(component);
+        }
+        return result;
+    }
+
+    long ParseInteger(const std::string& key, const std::string& value, long min, long max) {
+        size_t used = 0;
+        long result = std::stol(value, &used);
+        if (used != value.size() || result < min || result > max){
+            throw std::invalid_argument(key + " must be an integer in range [" + std::to_string(min) + ", " +
+                                        std::to_string(max) + "]");
+        }
+        return result;
+    }
+
+    std::string FormatVector(const Vec3D& vector) {
+        std::stringstream stream;
+        stream << std::setprecision(17) << vector[0] << "," << vector[1] << "," << vector[2];
+        return stream.str();
+    }
+}
+
+RT::RenderJob RT::RenderJob::Parse(const std::string &line, size_t maxResolution) {
+    std::stringstream stream(line);
+    std::string token;
+    if (!(stream >> token) || token != "RENDER"){
+        throw std::invalid_argument("Job must start with RENDER");
+    }
+
+    RenderJob job;
+    while (stream >> token){
+        size_t separator = token.find('=');
+        if (separator == std::string::npos) throw std::invalid_argument("Expected key=value, got " + token);
+        std::string key = token.substr(0, separator);
+        std::string value = token.substr(separator + 1);
+        try {
+            if (key == "fen") {
+                Chessboard::FiguresFromFen(value);
+                job.fen = value;
+            } else if (key == "pos") {
+                job.cameraPos = ParseVector(key, value);
+            } else if (key == "lookat") {
+                job.cameraLookAt = ParseVector(key, value);
+            } else if (key == "up") {
+                job.cameraUp = ParseVector(key, value);
+            } else if (key == "aspect") {
+                job.aspect = std::stod(value);
+                if (!(job.aspect > 0.)) throw std::invalid_argument("aspect must be positive");
+            } else if (key == "width") {
+                job.width = ParseInteger(key, value, 1, maxResolution);
+            } else if (key == "height") {
+                job.height = ParseInteger(key, value, 1, maxResolution);
+            } else if (key == "samples") {
+                job.settings.sqrtSamples = ParseInteger(key, value, 1, MAX_SQRT_SAMPLES);
+            } else if (key == "bounces") {
+                job.settings.bounces = ParseInteger(key, value, 1, MAX_BOUNCES);
+            } else if (key == "seed") {
+                size_t used = 0;
+                job.settings.seed = std::stoull(value, &used);
+                if (used != value.size() || value[0] == '-') throw std::invalid_argument("seed must be unsigned");
+            } else if (key == "lod") {
+                job.settings.meshLod = ParseInteger(key, value, 0, 1) != 0;
+            } else if (key == "format") {
+                job.format = RT::ImageFormatFromName(value);
+            } else {
+                throw std::invalid_argument("Unknown key " + key);
+            }
+        } catch (const std::logic_error& e) {
+            // std::stod and friends throw their own invalid_argument/out_of_range without the key name
+            throw std::invalid_argument("Invalid value of " + key + ": " + e.what());
+        }
+    }
+    return job;
+}
+
+std::string RT::RenderJob::ToString() const {
+    std::stringstream stream;
+    stream << "RENDER";
+    if (!fen.empty()) stream << " fen=" << fen;
+    stream << " pos=" << FormatVector(cameraPos)
+           << " lookat=" << FormatVector(cameraLookAt)
+           << " up=" << FormatVector(cameraUp);
+    if (aspect > 0.) stream << " aspect=" << std::setprecision(17) << aspect;
+    stream << " width=" << width << " height=" << height
+           << " samples=" << settings.sqrtSamples << " bounces=" << settings.bounces << " seed=" << settings.seed
+           << " lod=" << settings.meshLod
+           << " format=" << RT::ImageFormatName(format);
+    return stream.str();
+}
+
+RT::FigureConfiguration RT::RenderJob::GetFigures() const {
+    return fen.empty() ? Config::FIGURE_CONFIGURATION : Chessboard::FiguresFromFen(fen);
+}
+
+void RT::RenderJob::ConfigureCamera(RT::Camera &camera) const {
+    camera.SetPos(cameraPos);
+    camera.SetLookAt(cameraLookAt);
+    camera.SetUp(cameraUp);
+    camera.SetAspectRatio(aspect > 0. ? aspect : static_cast<double>(width) / height);
+    camera.CalculateParams();
+}
+
+void RT::RenderJob::Configure(RT::Scene &scene) const {
+    ConfigureCamera(scene.GetCamera());
+    scene.SetRenderSettings(settings);
+    scene.Initialize(width, height);
+}
+
+uint64_t RT::RenderJob::GetCacheKey(const RT::SceneOptions &options) const {
+    RT::Camera camera;
+    ConfigureCamera(camera);
+    return RT::RenderCache::MakeKey(GetFigures(), options, camera, width, height, settings, format);
+}
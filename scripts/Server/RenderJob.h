@@ -0,0 +1,52 @@
+/**
+ * @file RenderJob.h
+ * @brief Defines the RenderJob structure, description of one render requested over the network.
+ */
+#ifndef MAIN_CPP_RENDERJOB_H
+#define MAIN_CPP_RENDERJOB_H
+
+#include <string>
+#include "../RayTrace/Scene.h"
+
+namespace RT{
+    /**
+     * @struct RenderJob
+     * @brief Everything needed to render one image: position, camera, resolution and quality.
+     *
+     * Jobs travel as a single text line of key=value pairs, for example:
+     * `RENDER fen=8/8/8/8/4k3/8/8/8 pos=8,8,16 lookat=4,0,4 up=0,1,0 width=640 height=360 samples=2 bounces=20
+     * seed=7 lod=1 format=png`.
+     * Missing keys keep their defaults from Utils.h and Config.h.
+     */
+    struct RenderJob{
+        /// \brief Largest width and height accepted from the network
+        static constexpr size_t MAX_RESOLUTION = 16384;
+
+        /// \brief Piece placement in FEN notation, empty means Config::FIGURE_CONFIGURATION
+        std::string fen;
+        Vec3D cameraPos = Utils::DEFAULT_CAMERA_POS;
+        Vec3D cameraLookAt = Utils::DEFAULT_CAMERA_LOOKAT;
+        Vec3D cameraUp = Utils::DEFAULT_CAMERA_UP;
+        /// \brief Screen aspect ratio, 0 means width / height
+        double aspect = 0.;
+        size_t width = 640;
+        size_t height = 360;
+        RT::RenderSettings settings;
+        RT::ImageFormat format = RT::ImageFormat::BMP;
+
+        /// \brief Parses job line, throws std::invalid_argument on malformed or out of range values
+        static RenderJob Parse(const std::string& line, size_t maxResolution = MAX_RESOLUTION);
+        /// \brief Serializes the job to the line format accepted by Parse()
+        std::string ToString() const;
+        /// \brief Figure configuration described by the job
+        RT::FigureConfiguration GetFigures() const;
+        /// \brief Sets camera position, orientation and aspect ratio, recalculates camera params
+        void ConfigureCamera(RT::Camera& camera) const;
+        /// \brief Sets camera, quality and resolution of the scene
+        void Configure(RT::Scene& scene) const;
+        /// \brief Content key of the resulting image rendered in a scene built with options, see RenderCache::MakeKey()
+        uint64_t GetCacheKey(const RT::SceneOptions& options = {}) const;
+    };
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include "RenderServer.h"
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+
+RT::RenderServer::RenderServer(const RT::ServerOptions &options) : options_(options), cache_(options.cacheOptions) {
+    if (options_.unixPath.empty()){
+        listener_ = Socket::ListenTcp(options_.host, options_.port);
+        Log("Render server listening on %s:%d", options_.host.c_str(), options_.port);
+    } else{
+        listener_ = Socket::ListenUnix(options_.unixPath);
+        Log("Render server listening on %s", options_.unixPath.c_str());
+    }
+    running_ = true;
+    // Load the meshes and build the default position right away, so the first job doesn't wait for them
+    RT::Chessboard::PrewarmPieces();
+    GetScene("");
+    renderThread_ = std::thread([this]() { RenderLoop(); });
+}
+
+RT::RenderServer::~RenderServer() {
+    Stop();
+    {
+        // Wake up clients blocked in reads and wait for their handlers
+        std::unique_lock<std::mutex> lock(connectionsMutex_);
+        for (auto& pSocket : connections_){
+            pSocket->Shutdown();
+        }
+        connectionsCondition_.wait(lock, [this]() { return connections_.empty(); });
+    }
+    if (renderThread_.joinable()) renderThread_.join();
+}
+
+void RT::RenderServer::Stop() {
+    if (!running_.exchange(false)) return;
+    listener_.Shutdown();
+    queueCondition_.notify_all();
+}
+
+void RT::RenderServer::Run() {
+    while (running_){
+        int error = 0;
+        Socket client = listener_.Accept(&error);
+        if (!client.IsValid()){
+            // Errors like running out of file descriptors last until some connection closes, so don't spin on them
+            if (running_){
+                Log("Accepting connection failed with error %d, retrying", error);
+                std::this_thread::sleep_for(std::chrono::milliseconds(Utils::ACCEPT_RETRY_MILLISECONDS));
+            }
+            continue;
+        }
+
+        auto pSocket = std::make_shared<Socket>(std::move(client));
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex_);
+            if (connections_.size() >= options_.maxConnections){
+                pSocket->WriteString("BUSY\n");
+                continue;
+            }
+            connections_.push_back(pSocket);
+        }
+        std::thread([this, pSocket]() {
+            HandleConnection(pSocket);
+            std::lock_guard<std::mutex> lock(connectionsMutex_);
+            connections_.erase(std::find(connections_.begin(), connections_.end(), pSocket));
+            connectionsCondition_.notify_all();
+        }).detach();
+    }
+}
+
+void RT::RenderServer::HandleConnection(std::shared_ptr<RT::Socket> pSocket) {
+    std::string line;
+    while (running_ && pSocket->ReadLine(line)){
+        if (line.empty()) continue;
+
+        auto pJob = std::make_shared<PendingJob>();
+        try {
+            pJob->job = RT::RenderJob::Parse(line);
+        } catch (const std::exception& e) {
+            if (!pSocket->WriteString(std::string("ERROR ") + e.what() + "\n")) return;
+            continue;
+        }
+
+        RT::RenderCache::Image image = cache_.Get(pJob->job.GetCacheKey());
+        if (!image){
+            auto future = pJob->result.get_future();
+            if (!TryEnqueue(pJob)){
+                if (!pSocket->WriteString("BUSY\n")) return;
+                continue;
+            }
+            try {
+                image = future.get();
+            } catch (const std::exception& e) {
+                if (!pSocket->WriteString(std::string("ERROR ") + e.what() + "\n")) return;
+                continue;
+            }
+        }
+        std::string header = "OK " + std::to_string(image->size()) + " " +
+                             RT::ImageFormatName(pJob->job.format) + "\n";
+        if (!pSocket->WriteString(header) || !pSocket->WriteAll(image->data(), image->size())) return;
+    }
+}
+
+bool RT::RenderServer::TryEnqueue(const std::shared_ptr<PendingJob> &pJob) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!running_ || queue_.size() >= options_.queueCapacity) return false;
+        queue_.push_back(pJob);
+    }
+    queueCondition_.notify_one();
+    return true;
+}
+
+void RT::RenderServer::RenderLoop() {
+    while (true){
+        std::shared_ptr<PendingJob> pJob;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCondition_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            pJob = queue_.front();
+            queue_.pop_front();
+        }
+        try {
+            pJob->result.set_value(Execute(pJob->job));
+        } catch (...) {
+            pJob->result.set_exception(std::current_exception());
+        }
+    }
+}
+
+RT::RenderCache::Image RT::RenderServer::Execute(const RT::RenderJob &job) {
+    // An identical job may have been rendered while this one waited in the queue
+    uint64_t key = job.GetCacheKey();
+    if (auto image = cache_.Get(key)) return image;
+
+    auto pScene = GetScene(job.fen);
+    job.Configure(*pScene);
+    pScene->Render();
+
+    std::ostringstream stream(std::ios::binary);
+    pScene->WriteImage(stream, job.format);
+    std::string bytes = stream.str();
+    auto image = std::make_shared<const std::vector<char>>(bytes.begin(), bytes.end());
+    cache_.Put(key, image);
+    return image;
+}
+
+std::shared_ptr<RT::Scene> RT::RenderServer::GetScene(const std::string &fen) {
+    auto it = std::find_if(sceneCache_.begin(), sceneCache_.end(),
+                           [&fen](const auto& entry) { return entry.first == fen; });
+    if (it != sceneCache_.end()){
+        sceneCache_.splice(sceneCache_.begin(), sceneCache_, it);
+        return sceneCache_.front().second;
+    }
+
+    RT::RenderJob positionJob;
+    positionJob.fen = fen;
+    auto pScene = std::make_shared<RT::Scene>(positionJob.GetFigures());
+    sceneCache_.emplace_front(fen, pScene);
+    while (sceneCache_.size() > std::max<size_t>(options_.sceneCacheSize, 1)){
+        sceneCache_.pop_back();
+    }
+    return pScene;
+}
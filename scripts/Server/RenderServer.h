@@ -0,0 +1,97 @@
+/**
+ * @file RenderServer.h
+ * @brief Defines the RenderServer class, a long running process accepting render jobs over a local socket.
+ */
+#ifndef MAIN_CPP_RENDERSERVER_H
+#define MAIN_CPP_RENDERSERVER_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <atomic>
+
+#include "Socket.h"
+#include "RenderJob.h"
+#include "RenderCache.h"
+
+namespace RT{
+    /**
+     * @struct ServerOptions
+     * @brief Listening address and limits of the render server.
+     */
+    struct ServerOptions{
+        std::string host = "127.0.0.1";
+        int port = 5555;
+        /// \brief Listen on this Unix domain socket instead of TCP when not empty
+        std::string unixPath;
+        /// \brief Jobs waiting for the renderer, further jobs are rejected with BUSY
+        size_t queueCapacity = 8;
+        /// \brief Simultaneously open client connections, further connections are rejected with BUSY
+        size_t maxConnections = 64;
+        /// \brief Amount of built scenes (positions) kept in memory between jobs
+        size_t sceneCacheSize = 4;
+        /// \brief Limits of the finished image cache
+        RT::RenderCacheOptions cacheOptions;
+    };
+
+    /**
+     * @class RenderServer
+     * @brief Accepts render jobs, renders them one after another on the shared thread pool and sends back the image.
+     *
+     * Protocol (one job per line, any number of jobs per connection):
+     * - request: a RenderJob line, see RenderJob.h
+     * - response: `OK <size> <format>\n` followed by size bytes of the encoded image (bmp, qoi or png),
+     *   `BUSY\n` when the queue is full, or `ERROR <message>\n` for invalid jobs.
+     *
+     * Built scenes (loaded and fitted piece meshes with their bounding boxes) are kept in a small LRU cache,
+     * so repeated jobs on the same position only pay for the ray tracing. Finished images are kept in a RenderCache,
+     * repeated jobs are answered from it directly by the connection thread, without touching the queue.
+     */
+    class RenderServer{
+    public:
+        explicit RenderServer(const RT::ServerOptions& options);
+        ~RenderServer();
+
+        /// \brief Accepts connections until Stop() is called
+        void Run();
+        /// \brief Stops accepting connections and finishes queued jobs, safe to call from another thread
+        void Stop();
+
+    private:
+        struct PendingJob{
+            RT::RenderJob job;
+            std::promise<RT::RenderCache::Image> result;
+        };
+
+        void HandleConnection(std::shared_ptr<RT::Socket> pSocket);
+        bool TryEnqueue(const std::shared_ptr<PendingJob>& pJob);
+        void RenderLoop();
+        RT::RenderCache::Image Execute(const RT::RenderJob& job);
+        std::shared_ptr<RT::Scene> GetScene(const std::string& fen);
+
+        RT::ServerOptions options_;
+        RT::Socket listener_;
+        std::atomic<bool> running_{false};
+        RT::RenderCache cache_;
+
+        std::mutex queueMutex_;
+        std::condition_variable queueCondition_;
+        std::deque<std::shared_ptr<PendingJob>> queue_;
+        std::thread renderThread_;
+
+        std::mutex connectionsMutex_;
+        std::condition_variable connectionsCondition_;
+        std::vector<std::shared_ptr<RT::Socket>> connections_;
+
+        // Used only by the render thread
+        std::list<std::pair<std::string, std::shared_ptr<RT::Scene>>> sceneCache_;
+    };
+}
+
+#endif
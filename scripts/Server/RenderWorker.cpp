@@ -0,0 +1,51 @@
+#include "RenderWorker.h"
+#include <sstream>
+#include <stdexcept>
+
+size_t RT::RenderWorker::Run(RT::Socket &coordinator) {
+    size_t rendered = 0;
+    std::string line;
+    while (coordinator.ReadLine(line)){
+        if (line == "DONE") break;
+
+        std::istringstream request(line);
+        std::string kind, jobLine;
+        size_t id = 0, firstRow = 0, rows = 0, firstSample = 0, endSample = 0;
+        uint64_t fingerprint = 0;
+        request >> kind >> id >> firstRow >> rows >> firstSample >> endSample;
+        std::getline(request >> std::ws, jobLine);
+        try {
+            if (kind != "JOB" || !request) throw std::invalid_argument("Malformed unit: " + line);
+            if (firstRow % Framebuffer::TILE_SIZE != 0) throw std::invalid_argument("Band must start on a tile row");
+            RT::RenderJob job = RT::RenderJob::Parse(jobLine);
+            RT::Scene& scene = GetScene(job.fen);
+            job.ConfigureCamera(scene.GetCamera());
+            scene.SetRenderSettings(job.settings);
+            scene.SetResolution(job.width, job.height);
+            band_.Resize(job.width, rows);
+            scene.RenderBand(band_, firstRow, firstSample, endSample);
+            fingerprint = scene.GetFingerprint();
+        } catch (const std::exception& e) {
+            if (!coordinator.WriteString("ERROR " + std::to_string(id) + " " + e.what() + "\n")) break;
+            continue;
+        }
+
+        size_t size = band_.GetTileCount() * Framebuffer::TILE_PIXELS * sizeof(AccumulatedPixel);
+        std::string header = "TILES " + std::to_string(id) + " " + std::to_string(size) + " " +
+                             std::to_string(fingerprint) + "\n";
+        if (!coordinator.WriteString(header) || !coordinator.WriteAll(band_.GetTileData(0), size)) break;
+        ++rendered;
+    }
+    return rendered;
+}
+
+RT::Scene &RT::RenderWorker::GetScene(const std::string &fen) {
+    if (!pScene_ || sceneFen_ != fen){
+        pScene_.reset();
+        RT::RenderJob positionJob;
+        positionJob.fen = fen;
+        pScene_ = std::make_unique<RT::Scene>(positionJob.GetFigures(), sceneOptions_);
+        sceneFen_ = fen;
+    }
+    return *pScene_;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file RenderWorker.h
+ * @brief Defines the RenderWorker class, the process side of distributed rendering.
+ */
+#ifndef MAIN_CPP_RENDERWORKER_H
+#define MAIN_CPP_RENDERWORKER_H
+
+#include <memory>
+#include <string>
+
+#include "Socket.h"
+#include "RenderJob.h"
+
+namespace RT{
+    /**
+     * @class RenderWorker
+     * @brief Renders bands requested by a Coordinator and sends back their float tiles.
+     *
+     * The scene of the last position is kept between units, so following bands and frames of the same position
+     * only pay for the ray tracing. See Coordinator.h for the protocol.
+     */
+    class RenderWorker{
+    public:
+        /// \brief Scenes of all positions are created with options, e.g. to map them from snapshots
+        explicit RenderWorker(const RT::SceneOptions& options = {}) : sceneOptions_(options) {}
+
+        /// \brief Serves units until the coordinator sends DONE or disconnects, returns the amount of rendered units
+        size_t Run(RT::Socket& coordinator);
+
+    private:
+        RT::Scene& GetScene(const std::string& fen);
+
+        RT::SceneOptions sceneOptions_;
+        std::string sceneFen_;
+        std::unique_ptr<RT::Scene> pScene_;
+        RT::Framebuffer band_;
+    };
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "RenderServer.h"
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    void PrintUsage(const char* program) {
+        std::cout << "Usage: " << program << " [--host HOST] [--port PORT] [--unix PATH]"
+                  << " [--queue N] [--connections N] [--scenes N]"
+                  << " [--cache-memory MB] [--cache-dir PATH] [--cache-disk MB] [--pieces DIR]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]){
+    RT::ServerOptions options;
+    for (int i = 1; i < argc; ++i){
+        std::string argument = argv[i];
+        if (argument == "--help"){
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc){
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        // std::stoi and std::stoul throw std::invalid_argument or std::out_of_range on bad numbers
+        try {
+            if (argument == "--host") options.host = value;
+            else if (argument == "--port") options.port = std::stoi(value);
+            else if (argument == "--unix") options.unixPath = value;
+            else if (argument == "--queue") options.queueCapacity = std::stoul(value);
+            else if (argument == "--connections") options.maxConnections = std::stoul(value);
+            else if (argument == "--scenes") options.sceneCacheSize = std::stoul(value);
+            else if (argument == "--cache-memory") options.cacheOptions.memoryLimitBytes = std::stoull(value) << 20;
+            else if (argument == "--cache-dir") options.cacheOptions.diskDirectory = value;
+            else if (argument == "--cache-disk") options.cacheOptions.diskLimitBytes = std::stoull(value) << 20;
+            else if (argument == "--pieces") RT::Chessboard::SetPieceDirectory(value);
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::logic_error&) {
+            std::cerr << "Invalid value of " << argument << ": " << value << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        RT::RenderServer server(options);
+        server.Run();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
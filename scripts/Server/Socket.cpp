@@ -0,0 +1,244 @@
+#include "Socket.h"
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using SocketLength = int;
+#define CLOSE_SOCKET closesocket
+#define INVALID_SOCKET_HANDLE(handle) ((handle) == INVALID_SOCKET)
+#define SEND_FLAGS 0
+#define LAST_SOCKET_ERROR WSAGetLastError()
+#define TRANSIENT_ACCEPT_ERROR(error) ((error) == WSAEINTR || (error) == WSAECONNRESET)
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+using SocketLength = socklen_t;
+#define CLOSE_SOCKET close
+#define INVALID_SOCKET_HANDLE(handle) ((handle) < 0)
+#define SEND_FLAGS MSG_NOSIGNAL
+#define LAST_SOCKET_ERROR errno
+#define TRANSIENT_ACCEPT_ERROR(error) ((error) == EINTR || (error) == ECONNABORTED)
+#endif
+
+namespace {
+    void InitializeSockets() {
+#ifdef _WIN32
+        static bool initialized = []() {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        if (!initialized) throw std::runtime_error("WSAStartup failed");
+#endif
+    }
+
+    addrinfo* Resolve(const std::string& host, int port, bool passive) {
+        InitializeSockets();
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = passive ? AI_PASSIVE : 0;
+        addrinfo* result = nullptr;
+        std::string service = std::to_string(port);
+        if (getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &result) != 0){
+            throw std::runtime_error("Cannot resolve address " + host + ":" + service);
+        }
+        return result;
+    }
+}
+
+RT::Socket::~Socket() {
+    Close();
+}
+
+RT::Socket::Socket(RT::Socket &&other) noexcept
+        : handle_(other.handle_), buffer_(std::move(other.buffer_)), bufferPos_(other.bufferPos_) {
+    other.handle_ = INVALID_HANDLE;
+    other.bufferPos_ = 0;
+}
+
+RT::Socket &RT::Socket::operator=(RT::Socket &&other) noexcept {
+    if (this != &other){
+        Close();
+        handle_ = other.handle_;
+        buffer_ = std::move(other.buffer_);
+        bufferPos_ = other.bufferPos_;
+        other.handle_ = INVALID_HANDLE;
+        other.bufferPos_ = 0;
+    }
+    return *this;
+}
+
+RT::Socket RT::Socket::ListenTcp(const std::string &host, int port, int backlog) {
+    addrinfo* addresses = Resolve(host, port, true);
+    for (addrinfo* address = addresses; address != nullptr; address = address->ai_next){
+        auto handle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (INVALID_SOCKET_HANDLE(handle)) continue;
+        int reuse = 1;
+        setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+        if (bind(handle, address->ai_addr, static_cast<SocketLength>(address->ai_addrlen)) == 0 &&
+            listen(handle, backlog) == 0){
+            freeaddrinfo(addresses);
+            return Socket(static_cast<intptr_t>(handle));
+        }
+        CLOSE_SOCKET(handle);
+    }
+    freeaddrinfo(addresses);
+    throw std::runtime_error("Cannot listen on " + host + ":" + std::to_string(port));
+}
+
+RT::Socket RT::Socket::ConnectTcp(const std::string &host, int port) {
+    addrinfo* addresses = Resolve(host, port, false);
+    for (addrinfo* address = addresses; address != nullptr; address = address->ai_next){
+        auto handle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (INVALID_SOCKET_HANDLE(handle)) continue;
+        if (connect(handle, address->ai_addr, static_cast<SocketLength>(address->ai_addrlen)) == 0){
+            int noDelay = 1;
+            setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+            freeaddrinfo(addresses);
+            return Socket(static_cast<intptr_t>(handle));
+        }
+        CLOSE_SOCKET(handle);
+    }
+    freeaddrinfo(addresses);
+    throw std::runtime_error("Cannot connect to " + host + ":" + std::to_string(port));
+}
+
+#ifdef _WIN32
+RT::Socket RT::Socket::ListenUnix(const std::string &path, int backlog) {
+    throw std::runtime_error("Unix domain sockets are not supported on this platform");
+}
+
+RT::Socket RT::Socket::ConnectUnix(const std::string &path) {
+    throw std::runtime_error("Unix domain sockets are not supported on this platform");
+}
+#else
+RT::Socket RT::Socket::ListenUnix(const std::string &path, int backlog) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path too long: " + path);
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    int handle = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (handle < 0) throw std::runtime_error("Cannot create socket");
+    // Stale socket file of a previous run would make bind fail
+    unlink(path.c_str());
+    if (bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(handle, backlog) != 0){
+        close(handle);
+        throw std::runtime_error("Cannot listen on " + path);
+    }
+    return Socket(handle);
+}
+
+RT::Socket RT::Socket::ConnectUnix(const std::string &path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path too long: " + path);
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    int handle = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (handle < 0) throw std::runtime_error("Cannot create socket");
+    if (connect(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0){
+        close(handle);
+        throw std::runtime_error("Cannot connect to " + path);
+    }
+    return Socket(handle);
+}
+#endif
+
+RT::Socket RT::Socket::Accept(int* pError) {
+    while (true){
+        auto handle = accept(handle_, nullptr, nullptr);
+        if (!INVALID_SOCKET_HANDLE(handle)) return Socket(static_cast<intptr_t>(handle));
+        int error = LAST_SOCKET_ERROR;
+        // Interrupted calls and clients gone before being accepted don't affect the next connection
+        if (TRANSIENT_ACCEPT_ERROR(error)) continue;
+        if (pError) *pError = error;
+        return Socket();
+    }
+}
+
+bool RT::Socket::FillBuffer() {
+    if (bufferPos_ > 0){
+        buffer_.erase(0, bufferPos_);
+        bufferPos_ = 0;
+    }
+    char chunk[64 * 1024];
+    auto received = recv(handle_, chunk, sizeof(chunk), 0);
+    if (received <= 0) return false;
+    buffer_.append(chunk, received);
+    return true;
+}
+
+bool RT::Socket::ReadLine(std::string &line, size_t maxLength) {
+    while (true){
+        size_t end = buffer_.find('\n', bufferPos_);
+        if (end != std::string::npos){
+            line.assign(buffer_, bufferPos_, end - bufferPos_);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            bufferPos_ = end + 1;
+            return true;
+        }
+        if (buffer_.size() - bufferPos_ > maxLength) return false;
+        if (!FillBuffer()) return false;
+    }
+}
+
+bool RT::Socket::ReadExact(void *data, size_t size) {
+    auto* out = static_cast<char*>(data);
+    while (size > 0){
+        if (bufferPos_ == buffer_.size() && !FillBuffer()) return false;
+        size_t amount = std::min(size, buffer_.size() - bufferPos_);
+        std::memcpy(out, buffer_.data() + bufferPos_, amount);
+        bufferPos_ += amount;
+        out += amount;
+        size -= amount;
+    }
+    return true;
+}
+
+bool RT::Socket::WriteAll(const void *data, size_t size) {
+    const auto* in = static_cast<const char*>(data);
+    while (size > 0){
+        int chunk = static_cast<int>(std::min<size_t>(size, 1 << 30));
+        auto sent = send(handle_, in, chunk, SEND_FLAGS);
+        if (sent <= 0) return false;
+        in += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+void RT::Socket::SetReceiveTimeout(int milliseconds) {
+#ifdef _WIN32
+    DWORD timeout = milliseconds;
+#else
+    timeval timeout{milliseconds / 1000, (milliseconds % 1000) * 1000};
+#endif
+    setsockopt(handle_, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+void RT::Socket::Shutdown() {
+    if (handle_ != INVALID_HANDLE){
+#ifdef _WIN32
+        shutdown(handle_, SD_BOTH);
+#else
+        shutdown(handle_, SHUT_RDWR);
+#endif
+    }
+}
+
+void RT::Socket::Close() {
+    if (handle_ != INVALID_HANDLE){
+        CLOSE_SOCKET(handle_);
+        handle_ = INVALID_HANDLE;
+    }
+    buffer_.clear();
+    bufferPos_ = 0;
+}
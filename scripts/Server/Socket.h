@@ -0,0 +1,67 @@
+/**
+ * @file Socket.h
+ * @brief Defines a minimal blocking stream socket wrapper (TCP or Unix domain).
+ */
+#ifndef MAIN_CPP_SOCKET_H
+#define MAIN_CPP_SOCKET_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace RT{
+    /**
+     * @class Socket
+     * @brief Owns a socket handle, closes it on destruction. Movable, not copyable.
+     *
+     * Reads are buffered so that line based headers and binary payloads can be mixed on one connection.
+     */
+    class Socket{
+    public:
+        Socket() = default;
+        ~Socket();
+        Socket(Socket&& other) noexcept;
+        Socket& operator=(Socket&& other) noexcept;
+        Socket(const Socket&) = delete;
+        Socket& operator=(const Socket&) = delete;
+
+        /// \brief Creates a socket listening on host:port, throws std::runtime_error on failure
+        static Socket ListenTcp(const std::string& host, int port, int backlog = 64);
+        /// \brief Creates a socket listening on a Unix domain socket path (not available on Windows)
+        static Socket ListenUnix(const std::string& path, int backlog = 64);
+        /// \brief Connects to host:port, throws std::runtime_error on failure
+        static Socket ConnectTcp(const std::string& host, int port);
+        /// \brief Connects to a Unix domain socket path
+        static Socket ConnectUnix(const std::string& path);
+
+        /// \brief Waits for a new connection, retries interrupted ones. Returns an invalid socket if the listener was shut
+        /// down or accepting failed, the system error code is stored into pError then
+        Socket Accept(int* pError = nullptr);
+        bool IsValid() const { return handle_ != INVALID_HANDLE; }
+
+        /// \brief Reads one '\n' terminated line (without the terminator), false on EOF, error or too long line
+        bool ReadLine(std::string& line, size_t maxLength = 4096);
+        /// \brief Reads exactly size bytes, false on EOF or error
+        bool ReadExact(void* data, size_t size);
+        /// \brief Writes all bytes, false on error
+        bool WriteAll(const void* data, size_t size);
+        bool WriteString(const std::string& text) { return WriteAll(text.data(), text.size()); }
+        /// \brief Sets timeout of blocking receives in milliseconds, 0 disables it
+        void SetReceiveTimeout(int milliseconds);
+
+        /// \brief Wakes up threads blocked on this socket, without releasing the handle
+        void Shutdown();
+        void Close();
+
+    private:
+        static constexpr intptr_t INVALID_HANDLE = -1;
+        explicit Socket(intptr_t handle) : handle_(handle) {}
+        bool FillBuffer();
+
+        intptr_t handle_ = INVALID_HANDLE;
+        std::string buffer_;
+        size_t bufferPos_ = 0;
+    };
+}
+
+#endif
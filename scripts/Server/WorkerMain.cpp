@@ -0,0 +1,82 @@
+#include "RenderWorker.h"
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    void PrintUsage(const char* program) {
+        std::cout << "Usage: " << program << " [--host HOST] [--port PORT] [--unix PATH] [--retry SECONDS]\n"
+                  << "       [--scene-cache DIR] [--pieces DIR]\n"
+                  << "  Connects to RealChess-Coordinator and renders its bands until all frames are done.\n"
+                  << "  --retry keeps trying to connect, so workers can be started before the coordinator\n"
+                  << "  --scene-cache maps scenes from snapshots in DIR, missing ones are built and saved there\n"
+                  << "  --pieces loads the piece OBJ files from DIR instead of the ones built into the program"
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]){
+    std::string host = "127.0.0.1";
+    int port = 5556;
+    std::string unixPath;
+    double retrySeconds = 10.;
+    RT::SceneOptions sceneOptions;
+    for (int i = 1; i < argc; ++i){
+        std::string argument = argv[i];
+        if (argument == "--help"){
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc){
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        // std::stoi and std::stod throw std::invalid_argument or std::out_of_range on bad numbers
+        try {
+            if (argument == "--host") host = value;
+            else if (argument == "--port") port = std::stoi(value);
+            else if (argument == "--unix") unixPath = value;
+            else if (argument == "--retry") retrySeconds = std::stod(value);
+            else if (argument == "--scene-cache") sceneOptions.snapshotDirectory = value;
+            else if (argument == "--pieces") RT::Chessboard::SetPieceDirectory(value);
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::logic_error&) {
+            std::cerr << "Invalid value of " << argument << ": " << value << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        // Every new position builds a scene, pieces are parsed only once. Snapshots don't need the pieces, they
+        // are loaded on the first position without one
+        if (sceneOptions.snapshotDirectory.empty()) RT::Chessboard::PrewarmPieces();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    RT::Socket coordinator;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(retrySeconds);
+    while (!coordinator.IsValid()){
+        try {
+            coordinator = unixPath.empty() ? RT::Socket::ConnectTcp(host, port) : RT::Socket::ConnectUnix(unixPath);
+        } catch (const std::exception& e) {
+            if (std::chrono::steady_clock::now() >= deadline){
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+    }
+
+    RT::RenderWorker worker(sceneOptions);
+    size_t rendered = worker.Run(coordinator);
+    std::cout << "Rendered " << rendered << " band(s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "ThreadPool.h"
+#include "../RayTrace/Trace.h"
+#include <atomic>
+#include <exception>
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i){
+        workers_.emplace_back([this, i]() {
+            RT::Trace::SetThreadName("pool worker " + std::to_string(i));
+            WorkerLoop();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    for (auto& worker : workers_){
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::Shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true){
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) return;
+
+    // Shared with the helper tasks, which may still be queued after this call returns
+    struct State{
+        std::atomic<size_t> next{0};
+        size_t active = 0;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+
+    auto work = [state, count, &task]() {
+        size_t index;
+        while ((index = state->next.fetch_add(1)) < count){
+            try {
+                task(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error) state->error = std::current_exception();
+            }
+        }
+    };
+
+    size_t helpers = std::min(workers_.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i){
+        Submit([state, work, count]() {
+            {
+                // Helpers which start after all indices were taken must not touch the task anymore
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->next >= count) return;
+                ++state->active;
+            }
+            work();
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (--state->active == 0) state->done.notify_all();
+        });
+    }
+    work();
+
+    // Only helpers that actually started are waited for, so nested calls can't deadlock on queued helpers
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->active == 0; });
+    if (state->error) std::rethrow_exception(state->error);
+}
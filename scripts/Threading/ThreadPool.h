@@ -0,0 +1,55 @@
+/**
+ * @file ThreadPool.h
+ * @brief Defines the ThreadPool class used to spread rendering work over the available cores.
+ */
+#ifndef MAIN_CPP_THREADPOOL_H
+#define MAIN_CPP_THREADPOOL_H
+
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads executing queued tasks.
+ *
+ * Replaces spawning one std::thread per image row, threads are created once and reused for every render.
+ */
+class ThreadPool{
+public:
+    /// \brief Creates the pool, 0 threads means one per hardware thread
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// \brief Process-wide pool used by the renderer
+    static ThreadPool& Shared();
+
+    size_t GetThreadCount() const { return workers_.size(); }
+    /// \brief Queues a task, which will be executed by one of the workers
+    void Submit(std::function<void()> task);
+    /**
+     * @brief Calls task(i) for every i in [0, count) and blocks until all calls are done.
+     *
+     * Indices are handed out dynamically, so uneven work (e.g. rows with many pieces) stays balanced.
+     * The calling thread helps with the work, so it is safe to call from inside a pool task.
+     * The first exception thrown by a task is rethrown to the caller.
+     */
+    void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_ = false;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "../ObjectLoader/MeshFile.h"
+#include "../RayTrace/Chessboard.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+namespace {
+    const char* const PIECES[] = {"pawn", "rook", "knight", "bishop", "queen", "king"};
+    /// \brief Bytes per line of the generated arrays
+    constexpr size_t LINE_BYTES = 24;
+
+    void PrintUsage(const char* program) {
+        std::cout << "Usage: " << program << " OBJECTS_DIR OUTPUT.cpp\n"
+                  << "  Loads and fits the piece OBJ files of OBJECTS_DIR like Chessboard::LoadPieceFile() and writes\n"
+                  << "  them as " << MeshFile::EXTENSION << " images in constant arrays registered with EmbeddedMeshes.\n"
+                  << "  Run by the build, executables linking the output find the pieces without any file."
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]){
+    if (argc != 3){
+        PrintUsage(argv[0]);
+        return argc == 2 && std::string(argv[1]) == "--help" ? 0 : 1;
+    }
+    std::string directory = argv[1];
+    std::string outputPath = argv[2];
+
+    try {
+        std::string source = "// Generated by RealChess-EmbedPieces from the piece OBJ files, don't edit\n"
+                             "#include \"ObjectLoader/EmbeddedMeshes.h\"\n\n"
+                             "namespace {\n";
+        size_t totalBytes = 0;
+        for (const char* piece : PIECES){
+            uint64_t sourceChecksum = MeshFile::SourceChecksum(directory + "/" + piece + ".obj",
+                                                               RT::Chessboard::GetPieceLoadOptions());
+            std::vector<uint8_t> image;
+            MeshFile::Append(*RT::Chessboard::LoadPieceFile(piece, directory), image, sourceChecksum);
+            totalBytes += image.size();
+            std::string name = std::string(piece) + "Image";
+            source += "    alignas(64) const unsigned char " + name + "[] = {";
+            char byte[8];
+            for (size_t i = 0; i < image.size(); ++i){
+                if (i % LINE_BYTES == 0) source += "\n            ";
+                std::snprintf(byte, sizeof(byte), "%u,", image[i]);
+                source += byte;
+            }
+            char checksum[32];
+            std::snprintf(checksum, sizeof(checksum), "0x%016llxull",
+                          static_cast<unsigned long long>(sourceChecksum));
+            source += "\n    };\n    const EmbeddedMeshes::Registration " + std::string(piece) + "Registration(\"" + piece +
+                      "\", " + name + ", sizeof(" + name + "), " + checksum + ");\n";
+        }
+        source += "}\n";
+
+        // Written next to the output and renamed, so an interrupted build never leaves half a file
+        std::string temporaryPath = outputPath + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary);
+            if (!file.is_open()) throw std::runtime_error("Error opening file: " + temporaryPath);
+            file << source;
+            if (!file) throw std::runtime_error("Error writing file: " + temporaryPath);
+        }
+        std::filesystem::rename(temporaryPath, outputPath);
+        std::printf("Embedded %zu pieces, %zu KiB of mesh images\n", std::size(PIECES), totalBytes >> 10);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
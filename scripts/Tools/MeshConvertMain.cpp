@@ -0,0 +1,125 @@
+#include "../ObjectLoader/MeshFile.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    void PrintUsage(const char* program) {
+        std::cout << "Usage: " << program << " [--flip] [--no-normals] [--no-texcoords] [--weld TOLERANCE]\n"
+                  << "       [--no-reorder] [--no-lod] [--force] INPUT.obj [OUTPUT]\n"
+                  << "       " << program << " --check MESH.rtmesh\n"
+                  << "  Converts an OBJ file into a " << MeshFile::EXTENSION << " file with edges, normals and the\n"
+                  << "  triangle BVH precomputed, loaded by memory mapping without parsing.\n"
+                  << "  OUTPUT         defaults to INPUT with the extension replaced\n"
+                  << "  --flip         flips the y and z axis of vertices and normals (same as ObjLoadOptions)\n"
+                  << "  --no-normals   ignores vn records, vertex normals are averaged from faces\n"
+                  << "  --no-texcoords ignores vt records\n"
+                  << "  --weld TOLERANCE\n"
+                  << "                 merges positions closer than TOLERANCE, negative keeps all (default "
+                  << Utils::WELD_TOLERANCE << ")\n"
+                  << "  --no-reorder   keeps the file order of triangles and vertices instead of a Morton order\n"
+                  << "  --no-lod       skips the simplified levels of detail of meshes above "
+                  << Utils::LOD_MIN_TRIANGLES * Utils::LOD_REDUCTION << " triangles\n"
+                  << "  --force        converts even if OUTPUT is up to date with INPUT and the options\n"
+                  << "  --check        loads the mesh, verifies its data checksum and prints its sizes"
+                  << std::endl;
+    }
+
+    void PrintMesh(const RT::TriangleMesh& mesh) {
+        std::printf("%zu vertices, %zu triangles, %zu BVH nodes%s%s\n", mesh.GetVertices().size(),
+                    mesh.GetTriangles().size(), mesh.GetBvh().size(), mesh.HasAuthoredNormals() ? ", authored normals" : "",
+                    mesh.GetTexCoords().empty() ? "" : ", texture coordinates");
+        for (size_t i = 0; i < mesh.GetLods().size(); ++i){
+            const RT::TriangleMesh& lod = *mesh.GetLods()[i];
+            std::printf("  level of detail %zu: %zu vertices, %zu triangles, feature size %g\n", i + 1,
+                        lod.GetVertices().size(), lod.GetTriangles().size(), lod.GetFeatureSize());
+        }
+    }
+}
+
+int main(int argc, char* argv[]){
+    ObjLoadOptions options;
+    bool force = false;
+    bool check = false;
+    std::string inputPath;
+    std::string outputPath;
+    for (int i = 1; i < argc; ++i){
+        std::string argument = argv[i];
+        if (argument == "--help" || argument == "-h"){
+            PrintUsage(argv[0]);
+            return 0;
+        } else if (argument == "--flip"){
+            options.flipVertices = true;
+        } else if (argument == "--no-normals"){
+            options.normals = false;
+        } else if (argument == "--no-texcoords"){
+            options.texCoords = false;
+        } else if (argument == "--weld" && i + 1 < argc){
+            try {
+                options.weldTolerance = std::stod(argv[++i]);
+            } catch (const std::logic_error&) {
+                std::cerr << "Invalid value of --weld: " << argv[i] << std::endl;
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } else if (argument == "--no-reorder"){
+            options.optimizeLayout = false;
+        } else if (argument == "--no-lod"){
+            options.lods = false;
+        } else if (argument == "--force"){
+            force = true;
+        } else if (argument == "--check"){
+            check = true;
+        } else if (!argument.empty() && argument[0] == '-'){
+            std::cerr << "Unknown option " << argument << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        } else if (inputPath.empty()){
+            inputPath = argument;
+        } else if (outputPath.empty()){
+            outputPath = argument;
+        } else{
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (inputPath.empty() || (check && !outputPath.empty())){
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        if (check){
+            auto start = std::chrono::steady_clock::now();
+            auto pMesh = MeshFile::Load(inputPath, true);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::printf("%s: valid, ", inputPath.c_str());
+            PrintMesh(*pMesh);
+            std::printf("Loaded and verified in %.3f s\n", seconds);
+            return 0;
+        }
+
+        if (outputPath.empty()){
+            size_t dot = inputPath.find_last_of('.');
+            size_t separator = inputPath.find_last_of("/\\");
+            if (dot == std::string::npos || (separator != std::string::npos && dot < separator)) dot = inputPath.size();
+            outputPath = inputPath.substr(0, dot) + MeshFile::EXTENSION;
+        }
+        if (!force && MeshFile::IsUpToDate(outputPath, inputPath, options)){
+            std::printf("%s is up to date\n", outputPath.c_str());
+            return 0;
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto pMesh = MeshFile::Convert(inputPath, outputPath, options);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%s: ", outputPath.c_str());
+        PrintMesh(*pMesh);
+        std::printf("Converted in %.3f s\n", seconds);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
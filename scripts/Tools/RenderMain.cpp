@@ -0,0 +1,212 @@
+#include "../Server/RenderJob.h"
+#include "../Image/ImageWriter.h"
+#include "../RayTrace/Trace.h"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    /// \brief Posters are limited only by the image formats, not by the network limit of the server
+    constexpr size_t MAX_POSTER_RESOLUTION = 1 << 20;
+
+    RT::Scene* pRunningScene = nullptr;
+
+    void HandleInterrupt(int) {
+        // Only sets an atomic flag, the render stops after its current tiles
+        if (pRunningScene) pRunningScene->RequestStop();
+    }
+
+    void PrintUsage(const char* program) {
+        std::cout << "Usage: " << program << " [--output PATH] [--band-rows N] [--bands N] [--checkpoint PATH]\n"
+                  << "       [--checkpoint-interval SECONDS] [--stats PATH] [--trace PATH] [--capture-rays PATH]\n"
+                  << "       [--capture-every N] [--heatmap] [--memory] [--memory-budget MB] [--scene-cache DIR]\n"
+                  << "       [--compact-meshes] [--analytic-pieces] [--pieces DIR] [key=value ...]\n"
+                  << "  Renders one image without a window, band by band straight into the output file,\n"
+                  << "  so memory stays bounded even for poster sizes. Keys are the same as in server jobs:\n"
+                  << "  fen, pos, lookat, up, aspect, width, height, samples, bounces, seed, lod (0 or 1).\n"
+                  << "  --output PATH  .bmp, .qoi or .png (default output.png)\n"
+                  << "  --band-rows N  rows rendered at once, 0 picks about 1M pixels (default 0)\n"
+                  << "  --bands N      bands kept in memory, rendering overlaps encoding when > 1 (default 2)\n"
+                  << "  --checkpoint PATH\n"
+                  << "                 renders the whole image in passes of one sample per pixel and saves the\n"
+                  << "                 progress into PATH, an existing checkpoint is resumed. Ctrl+C stops after\n"
+                  << "                 saving, the checkpoint is deleted once the image is written\n"
+                  << "  --checkpoint-interval SECONDS\n"
+                  << "                 minimal time between checkpoints (default " << Utils::CHECKPOINT_INTERVAL << ")\n"
+                  << "  --stats PATH   writes render statistics (rays, intersection tests, paths) as JSON\n"
+                  << "  --trace PATH   writes a timeline of scene build, OBJ loads, tiles and encoding of every\n"
+                  << "                 thread as a Chrome trace (open in chrome://tracing or ui.perfetto.dev)\n"
+                  << "  --capture-rays PATH\n"
+                  << "                 records traced rays with their closest hits for RealChess-Bench --replay\n"
+                  << "  --capture-every N\n"
+                  << "                 records every N-th ray (default 16), at most " << Utils::RAY_CAPTURE_LIMIT
+                  << " rays\n"
+                  << "  --heatmap      saves box tests, triangle tests and time per pixel as false-colour images\n"
+                  << "                 next to the output (e.g. output.boxes.png), the cost map takes 24 B per pixel\n"
+                  << "  --memory       prints bytes used by meshes, bounding boxes, materials, buffers and threads\n"
+                  << "  --memory-budget MB\n"
+                  << "                 fails before rendering when the scene with its buffers needs more than MB\n"
+                  << "  --scene-cache DIR\n"
+                  << "                 maps the built scene from a snapshot in DIR, the first run of a position\n"
+                  << "                 builds it and saves the snapshot\n"
+                  << "  --compact-meshes\n"
+                  << "                 quantises placed meshes to 16-bit positions, octahedral normals and 16-bit\n"
+                  << "                 indices, decoded while tracing, for a sixth of the mesh memory\n"
+                  << "  --analytic-pieces\n"
+                  << "                 places pawns, rooks, queens and kings as surfaces of revolution fitted to\n"
+                  << "                 their meshes, intersected exactly with smooth silhouettes and normals\n"
+                  << "  --pieces DIR   loads the piece OBJ files from DIR instead of the ones built into the program"
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]){
+    std::string outputPath = "output.png";
+    size_t bandRows = 0;
+    size_t bands = 2;
+    RT::CheckpointOptions checkpoint;
+    std::string statsPath;
+    std::string tracePath;
+    std::string capturePath;
+    size_t captureEvery = 16;
+    bool heatmaps = false;
+    bool memoryReport = false;
+    RT::SceneOptions sceneOptions;
+    std::string jobLine = "RENDER";
+    for (int i = 1; i < argc; ++i){
+        std::string argument = argv[i];
+        if (argument == "--help"){
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        if (argument == "--heatmap"){
+            heatmaps = true;
+            continue;
+        }
+        if (argument == "--memory"){
+            memoryReport = true;
+            continue;
+        }
+        if (argument == "--compact-meshes"){
+            sceneOptions.compactMeshes = true;
+            continue;
+        }
+        if (argument == "--analytic-pieces"){
+            sceneOptions.analyticPieces = true;
+            continue;
+        }
+        if (argument.rfind("--", 0) != 0){
+            jobLine += " " + argument;
+            continue;
+        }
+        if (i + 1 >= argc){
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        // std::stoul and std::stod throw std::invalid_argument or std::out_of_range on bad numbers
+        try {
+            if (argument == "--output") outputPath = value;
+            else if (argument == "--band-rows") bandRows = std::stoul(value);
+            else if (argument == "--bands") bands = std::stoul(value);
+            else if (argument == "--checkpoint") checkpoint.path = value;
+            else if (argument == "--checkpoint-interval") checkpoint.intervalSeconds = std::stod(value);
+            else if (argument == "--stats") statsPath = value;
+            else if (argument == "--trace") tracePath = value;
+            else if (argument == "--capture-rays") capturePath = value;
+            else if (argument == "--capture-every") captureEvery = std::stoul(value);
+            else if (argument == "--memory-budget"){
+                // std::stoul is 32 bits on Windows, the shift mustn't drop high bits either
+                unsigned long long megabytes = std::stoull(value);
+                if (megabytes > std::numeric_limits<size_t>::max() >> 20) throw std::out_of_range("--memory-budget");
+                sceneOptions.memoryBudget.total = static_cast<size_t>(megabytes) << 20;
+            }
+            else if (argument == "--scene-cache") sceneOptions.snapshotDirectory = value;
+            else if (argument == "--pieces") RT::Chessboard::SetPieceDirectory(value);
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::logic_error&) {
+            std::cerr << "Invalid value of " << argument << ": " << value << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!tracePath.empty()){
+        RT::Trace::SetThreadName("main");
+        RT::Trace::Start();
+    }
+    auto saveTrace = [&tracePath]() {
+        if (!tracePath.empty()) RT::Trace::Save(tracePath);
+    };
+    try {
+        RT::RenderJob job = RT::RenderJob::Parse(jobLine, MAX_POSTER_RESOLUTION);
+        RT::ImageFormat format = RT::ImageFormatFromPath(outputPath);
+
+        auto start = std::chrono::steady_clock::now();
+        RT::Scene scene(job.GetFigures(), sceneOptions);
+        job.ConfigureCamera(scene.GetCamera());
+        scene.SetRenderSettings(job.settings);
+        scene.EnableCostMap(heatmaps);
+        std::shared_ptr<RT::RayCapture> pCapture;
+        if (!capturePath.empty()){
+            pCapture = std::make_shared<RT::RayCapture>(captureEvery);
+            scene.SetRayCapture(pCapture);
+        }
+        pRunningScene = &scene;
+        std::signal(SIGINT, HandleInterrupt);
+
+        if (!checkpoint.path.empty()){
+            // Checkpoints need the accumulated samples of the whole image, so the image isn't streamed
+            scene.Initialize(job.width, job.height);
+            if (!scene.RenderProgressive(checkpoint)){
+                std::cout << "Stopped, run the same command again to resume from " << checkpoint.path << std::endl;
+                saveTrace();
+                return 2;
+            }
+            scene.SaveImage(outputPath);
+            std::remove(checkpoint.path.c_str());
+        } else{
+            std::ofstream image(outputPath, std::ios::binary | std::ios::out);
+            if (!image.is_open()) throw std::runtime_error("Error opening file: " + outputPath);
+            scene.SetResolution(job.width, job.height);
+            auto pWriter = RT::ImageWriter::Create(format, image, job.width, job.height);
+            if (!scene.RenderToImage(*pWriter, bandRows, bands)){
+                std::cout << "Stopped, " << outputPath << " is incomplete" << std::endl;
+                saveTrace();
+                return 2;
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Rendered " << job.width << "x" << job.height << " into " << outputPath << " in "
+                  << seconds << " s" << std::endl;
+        scene.GetRenderStats().WriteSummary(std::cout);
+        if (memoryReport){
+            std::cout << "Memory:" << std::endl;
+            scene.GetMemoryReport().WriteSummary(std::cout);
+        }
+        if (heatmaps) scene.GetCostMap().SaveHeatmaps(outputPath);
+        if (!statsPath.empty()){
+            std::ofstream stats(statsPath);
+            if (!stats.is_open()) throw std::runtime_error("Error opening file: " + statsPath);
+            scene.GetRenderStats().WriteJson(stats);
+        }
+        if (pCapture){
+            pCapture->Save(capturePath, job.ToString());
+            std::cout << "Captured " << pCapture->GetRays().size() << " rays into " << capturePath << std::endl;
+        }
+        saveTrace();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
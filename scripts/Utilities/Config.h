@@ -23,6 +23,8 @@ namespace Config
     const auto KING_MATERIAL = std::make_shared<RT::Metal>(Vec3D{0.9, 0.6, 0.9}, 0.);
     const auto BISHOP_MATERIAL = std::make_shared<RT::Dielectric>(1., Vec3D{1., 1., 1.}, Vec3D{0.7, 0.7, 1.});
     const auto ROOK_MATERIAL = std::make_shared<RT::Metal>(Utils::BLACK_PIECE_COLOR, 0.01);
+    /// \brief Material of all pieces in scenes with RT::SceneOptions::glassPieces
+    const auto GLASS_PIECE_MATERIAL = std::make_shared<RT::Dielectric>(1.5, Vec3D{1., 1., 1.}, Vec3D{0.9, 0.9, 0.9});
     const auto BLACK_BOARD_MATERIAL = std::make_shared<RT::Lambertian>(RT::Lambertian(Utils::BLACK_BOARD_COLOR));
     const auto WHITE_BOARD_MATERIAL = std::make_shared<RT::Lambertian>(RT::Lambertian(Utils::WHITE_BOARD_COLOR));
     /**
@@ -2,16 +2,42 @@
 #define MAIN_CPP_UTILS_H
 
 #include "../LinearAlgebra/Vector.h"
+#include <cstdint>
 
 namespace Utils{
     /** @file */
     /**
      * @{ \name RayTrace params
      */
+    /**
+     * \brief Version of the rendered output, bump it with every change of the kernels, materials, light or piece fitting
+     * that changes images. Cached renders, scene snapshots and checkpoints of another version are not reused.
+     */
+    constexpr const uint64_t RENDERER_VERSION = 1;
     /// \brief Amount of ray bounces in the scene
     constexpr const int BOUNCES = 20;
     /// \brief Squared amount of rays shot into scene for each pixel
     constexpr const int SQRT_SAMPLES = 3;
+    /// \brief Approximate size of one band in pixels when rendering straight into a file (posters)
+    constexpr const size_t STREAMED_BAND_PIXELS = 1 << 20;
+    /// \brief Default minimal time in seconds between two checkpoints of a progressive render
+    constexpr const double CHECKPOINT_INTERVAL = 60.;
+    /// \brief Approximate size of one work unit in pixels when a frame is split between worker processes
+    constexpr const size_t DISTRIBUTED_BAND_PIXELS = 1 << 15;
+    /// \brief Delay before a server accepts again after a failure like running out of file descriptors
+    constexpr const int ACCEPT_RETRY_MILLISECONDS = 100;
+    /// \brief Default maximum of rays recorded by RayCapture, 64 B each
+    constexpr const size_t RAY_CAPTURE_LIMIT = 1 << 20;
+    /// \brief Directory of the piece meshes, relative to the build directory the programs are run from
+    constexpr const char OBJECTS_DIRECTORY[] = "../objects/";
+    /// \brief Default distance under which ObjLoader merges vertex positions, in model units
+    constexpr const double WELD_TOLERANCE = 1e-6;
+    /// \brief Meshes get levels of detail down to about this many triangles, smaller meshes get none
+    constexpr const size_t LOD_MIN_TRIANGLES = 10000;
+    /// \brief Every level of detail has this many times fewer triangles than the previous one
+    constexpr const size_t LOD_REDUCTION = 4;
+    /// \brief Farthest a mesh vertex may lie from a fitted surface of revolution, relative to the height of the mesh
+    constexpr const double REVOLUTION_FIT_TOLERANCE = 0.02;
     /**
      * @}
      */
@@ -21,6 +47,8 @@ namespace Utils{
      */
     /// \brief Ray parallel detection precision
     constexpr const double PARALLEL_PRECISION = 1e-3;
+    /// \brief Spread angle in radians of rays scattered diffusely, their footprint picks the mesh level of detail
+    constexpr const double DIFFUSE_CONE_SPREAD = 0.2;
     /**
      * @}
      */
@@ -84,6 +112,10 @@ namespace Utils{
      */
      /// \brief RGB max
     constexpr const double RGB_MAX = 255.;
+    /// \brief Multiplier of rendered colors before they are displayed
+    constexpr const double DISPLAY_EXPOSURE = 1.;
+    /// \brief Display gamma, 1 shows rendered colors unchanged
+    constexpr const double DISPLAY_GAMMA = 1.;
     /**
      * @}
      */
@@ -108,6 +140,10 @@ namespace Utils{
      */
     /// \brief Multithreading
     #define __MT__
+    /// \brief Render statistics (ray, box and triangle counters), see RenderStats.h
+    #define __STATS__
+    /// \brief Timeline tracing (Chrome trace of render threads), see Trace.h, it records only when started
+    #define __TRACE__
     /** @} */
 }
 